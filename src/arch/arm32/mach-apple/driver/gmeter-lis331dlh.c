@@ -28,6 +28,7 @@
 
 #include <xboot.h>
 #include <i2c/i2c.h>
+#include <regmap/regmap.h>
 #include <gmeter/gmeter.h>
 
 enum {
@@ -55,69 +56,40 @@ enum {
 	REG_INT2_DURATION	= 0x37,
 };
 
-struct gmeter_lis331dlh_pdata_t {
-	struct i2c_device_t * dev;
+static const struct regmap_range_t lis331dlh_volatile[] = {
+	{ REG_WHOAMI,			REG_WHOAMI },
+	{ REG_REFERENCE,		REG_OUTZ_H },
+	{ REG_INT1_SOURCE,		REG_INT1_SOURCE },
+	{ REG_INT2_SOURCE,		REG_INT2_SOURCE },
 };
 
-static bool_t lis331dlh_read(struct i2c_device_t * dev, u8_t reg, u8_t * val)
-{
-	struct i2c_msg_t msgs[2];
-	u8_t buf;
-
-	msgs[0].addr = dev->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = 1;
-	msgs[0].buf = &reg;
-
-	msgs[1].addr = dev->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = 1;
-	msgs[1].buf = &buf;
-
-	if(i2c_transfer(dev->i2c, msgs, 2) != 2)
-		return FALSE;
-
-	if(val)
-		*val = buf;
-	return TRUE;
-}
+static const struct regmap_config_t lis331dlh_regmap = {
+	.reg_bits		= 8,
+	.val_bits		= 8,
+	.max_register	= REG_INT2_DURATION,
+	.bulk_flag_mask	= (1 << 7),
+	.cache_type		= REGCACHE_FLAT,
+	.volatile_table	= lis331dlh_volatile,
+	.num_volatile	= ARRAY_SIZE(lis331dlh_volatile),
+};
 
-static bool_t lis331dlh_write(struct i2c_device_t * dev, u8_t reg, u8_t val)
-{
-	struct i2c_msg_t msg;
-	u8_t buf[2];
-
-	buf[0] = reg;
-	buf[1] = val;
-    msg.addr = dev->addr;
-    msg.flags = 0;
-    msg.len = 2;
-    msg.buf = &buf[0];
-
-    if(i2c_transfer(dev->i2c, &msg, 1) != 1)
-    	return FALSE;
-    return TRUE;
-}
+struct gmeter_lis331dlh_pdata_t {
+	struct i2c_device_t * dev;
+	struct regmap_t * map;
+};
 
 static bool_t gmeter_lis331dlh_get(struct gmeter_t * g, int * x, int * y, int * z)
 {
 	struct gmeter_lis331dlh_pdata_t * pdat = (struct gmeter_lis331dlh_pdata_t *)g->priv;
-	u8_t s, l = 0, h = 0;
+	unsigned int s;
+	u8_t buf[6];
 	s16_t tx, ty, tz;
 
-	if(lis331dlh_read(pdat->dev, REG_STATUS, &s) && (s & (1 << 3)))
+	if(regmap_read(pdat->map, REG_STATUS, &s) && (s & (1 << 3)) && regmap_raw_read(pdat->map, REG_OUTX_L, buf, 6))
 	{
-		lis331dlh_read(pdat->dev, REG_OUTX_L, &l);
-		lis331dlh_read(pdat->dev, REG_OUTX_H, &h);
-		tx = (h << 8) | (l << 0);
-
-		lis331dlh_read(pdat->dev, REG_OUTY_L, &l);
-		lis331dlh_read(pdat->dev, REG_OUTY_H, &h);
-		ty = (h << 8) | (l << 0);
-
-		lis331dlh_read(pdat->dev, REG_OUTZ_L, &l);
-		lis331dlh_read(pdat->dev, REG_OUTZ_H, &h);
-		tz = (h << 8) | (l << 0);
+		tx = (buf[1] << 8) | (buf[0] << 0);
+		ty = (buf[3] << 8) | (buf[2] << 0);
+		tz = (buf[5] << 8) | (buf[4] << 0);
 
 		*x = (s64_t)tx * 2 * 9806650 / 32768;
 		*y = (s64_t)ty * 2 * 9806650 / 32768;
@@ -133,20 +105,29 @@ static struct device_t * gmeter_lis331dlh_probe(struct driver_t * drv, struct dt
 	struct gmeter_t * g;
 	struct device_t * dev;
 	struct i2c_device_t * i2cdev;
-	u8_t val;
+	struct regmap_t * map;
+	unsigned int val;
 
 	i2cdev = i2c_device_alloc(dt_read_string(n, "i2c-bus", NULL), dt_read_int(n, "slave-address", 0x18), 0);
 	if(!i2cdev)
 		return NULL;
 
-	if(lis331dlh_read(i2cdev, REG_WHOAMI, &val) && (val == 0x32))
+	map = regmap_alloc_i2c(i2cdev, &lis331dlh_regmap);
+	if(!map)
+	{
+		i2c_device_free(i2cdev);
+		return NULL;
+	}
+
+	if(regmap_read(map, REG_WHOAMI, &val) && (val == 0x32))
 	{
-		lis331dlh_write(i2cdev, REG_CTRL2, (1 << 7));
-		lis331dlh_write(i2cdev, REG_CTRL1, (1 << 5) | (1 << 3) | (1 << 2) | (1 << 1) | (1 << 0));
-		lis331dlh_write(i2cdev, REG_CTRL2, (0 << 7));
+		regmap_write(map, REG_CTRL2, (1 << 7));
+		regmap_write(map, REG_CTRL1, (1 << 5) | (1 << 3) | (1 << 2) | (1 << 1) | (1 << 0));
+		regmap_write(map, REG_CTRL2, (0 << 7));
 	}
 	else
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -154,6 +135,7 @@ static struct device_t * gmeter_lis331dlh_probe(struct driver_t * drv, struct dt
 	pdat = malloc(sizeof(struct gmeter_lis331dlh_pdata_t));
 	if(!pdat)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -161,12 +143,14 @@ static struct device_t * gmeter_lis331dlh_probe(struct driver_t * drv, struct dt
 	g = malloc(sizeof(struct gmeter_t));
 	if(!g)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		free(pdat);
 		return NULL;
 	}
 
 	pdat->dev = i2cdev;
+	pdat->map = map;
 
 	g->name = alloc_device_name(dt_read_name(n), -1);
 	g->get = gmeter_lis331dlh_get;
@@ -174,6 +158,7 @@ static struct device_t * gmeter_lis331dlh_probe(struct driver_t * drv, struct dt
 
 	if(!register_gmeter(&dev, g))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(g->name);
@@ -193,6 +178,7 @@ static void gmeter_lis331dlh_remove(struct device_t * dev)
 
 	if(g && unregister_gmeter(g))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(g->name);
@@ -203,10 +189,20 @@ static void gmeter_lis331dlh_remove(struct device_t * dev)
 
 static void gmeter_lis331dlh_suspend(struct device_t * dev)
 {
+	struct gmeter_t * g = (struct gmeter_t *)dev->priv;
+	struct gmeter_lis331dlh_pdata_t * pdat = (struct gmeter_lis331dlh_pdata_t *)g->priv;
+
+	regmap_cache_only(pdat->map, TRUE);
 }
 
 static void gmeter_lis331dlh_resume(struct device_t * dev)
 {
+	struct gmeter_t * g = (struct gmeter_t *)dev->priv;
+	struct gmeter_lis331dlh_pdata_t * pdat = (struct gmeter_lis331dlh_pdata_t *)g->priv;
+
+	regmap_cache_only(pdat->map, FALSE);
+	regmap_mark_dirty(pdat->map);
+	regmap_sync(pdat->map);
 }
 
 static struct driver_t gmeter_lis331dlh = {
@@ -260,6 +260,8 @@ static struct device_t * gpio_s5l8930_probe(struct driver_t * drv, struct dtnode
 	chip->set_value = gpio_s5l8930_set_value;
 	chip->get_value = gpio_s5l8930_get_value;
 	chip->to_irq = gpio_s5l8930_to_irq;
+	chip->set_port = NULL;
+	chip->get_port = NULL;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
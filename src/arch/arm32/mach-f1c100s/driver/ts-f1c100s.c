@@ -171,7 +171,7 @@ static void ts_f1c100s_interrupt(void * data)
 
 		if(!pdat->ignore_fifo_data)
 		{
-			tsfilter_update(pdat->filter, &x, &y);
+			tsfilter_update_at(pdat->filter, &x, &y, ktime_to_us(ktime_get()));
 
 			if(!pdat->press)
 			{
@@ -220,8 +220,6 @@ static struct device_t * ts_f1c100s_probe(struct driver_t * drv, struct dtnode_t
 	virtual_addr_t virt = phys_to_virt(dt_read_address(n));
 	char * clk = dt_read_string(n, "clock-name", NULL);
 	int irq = dt_read_int(n, "interrupt", -1);
-	int cal[7] = {1, 0, 0, 0, 1, 0, 1};
-	int i;
 
 	if(!irq_is_valid(irq))
 		return NULL;
@@ -238,13 +236,7 @@ static struct device_t * ts_f1c100s_probe(struct driver_t * drv, struct dtnode_t
 	}
 
 	pdat->virt = virt;
-	pdat->filter = tsfilter_alloc(dt_read_int(n, "median-filter-length", 5), dt_read_int(n, "mean-filter-length", 5));
-	if(dt_read_array_length(n, "calibration") == 7)
-	{
-		for(i = 0; i < 7; i++)
-			cal[i] = dt_read_array_int(n, "calibration", i, cal[i]);
-		tsfilter_setcal(pdat->filter, &cal[0]);
-	}
+	pdat->filter = input_tsfilter_alloc(n, 0);
 	pdat->clk = strdup(clk);
 	pdat->irq = irq;
 	pdat->reset = dt_read_int(n, "reset", -1);
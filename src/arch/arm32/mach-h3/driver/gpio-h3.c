@@ -279,6 +279,23 @@ static int gpio_h3_get_value(struct gpiochip_t * chip, int offset)
 	return !!(val & (1 << offset));
 }
 
+static void gpio_h3_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_h3_pdata_t * pdat = (struct gpio_h3_pdata_t *)chip->priv;
+	u32_t val;
+
+	val = read32(pdat->virt + GPIO_DAT);
+	val &= ~mask;
+	val |= value & mask;
+	write32(pdat->virt + GPIO_DAT, val);
+}
+
+static u32_t gpio_h3_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_h3_pdata_t * pdat = (struct gpio_h3_pdata_t *)chip->priv;
+	return read32(pdat->virt + GPIO_DAT);
+}
+
 static int gpio_h3_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_h3_pdata_t * pdat = (struct gpio_h3_pdata_t *)chip->priv;
@@ -332,6 +349,8 @@ static struct device_t * gpio_h3_probe(struct driver_t * drv, struct dtnode_t *
 	chip->set_value = gpio_h3_set_value;
 	chip->get_value = gpio_h3_get_value;
 	chip->to_irq = gpio_h3_to_irq;
+	chip->set_port = gpio_h3_set_port;
+	chip->get_port = gpio_h3_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
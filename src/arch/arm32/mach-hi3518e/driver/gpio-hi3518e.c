@@ -156,6 +156,18 @@ static int gpio_hi3518e_get_value(struct gpiochip_t * chip, int offset)
 	return !!read8(pdat->virt + (1 << (offset + 2)));
 }
 
+static void gpio_hi3518e_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_hi3518e_pdata_t * pdat = (struct gpio_hi3518e_pdata_t *)chip->priv;
+	write8(pdat->virt + ((mask & 0xff) << 2), value & 0xff);
+}
+
+static u32_t gpio_hi3518e_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_hi3518e_pdata_t * pdat = (struct gpio_hi3518e_pdata_t *)chip->priv;
+	return read8(pdat->virt + (0xff << 2));
+}
+
 static int gpio_hi3518e_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_hi3518e_pdata_t * pdat = (struct gpio_hi3518e_pdata_t *)chip->priv;
@@ -217,6 +229,8 @@ static struct device_t * gpio_hi3518e_probe(struct driver_t * drv, struct dtnode
 	chip->set_value = gpio_hi3518e_set_value;
 	chip->get_value = gpio_hi3518e_get_value;
 	chip->to_irq = gpio_hi3518e_to_irq;
+	chip->set_port = gpio_hi3518e_set_port;
+	chip->get_port = gpio_hi3518e_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
@@ -137,6 +137,18 @@ static int gpio_pl061_get_value(struct gpiochip_t * chip, int offset)
 	return !!read8(pdat->virt + (1 << (offset + 2)));
 }
 
+static void gpio_pl061_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_pl061_pdata_t * pdat = (struct gpio_pl061_pdata_t *)chip->priv;
+	write8(pdat->virt + ((mask & 0xff) << 2), value & 0xff);
+}
+
+static u32_t gpio_pl061_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_pl061_pdata_t * pdat = (struct gpio_pl061_pdata_t *)chip->priv;
+	return read8(pdat->virt + (0xff << 2));
+}
+
 static int gpio_pl061_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_pl061_pdata_t * pdat = (struct gpio_pl061_pdata_t *)chip->priv;
@@ -197,6 +209,8 @@ static struct device_t * gpio_pl061_probe(struct driver_t * drv, struct dtnode_t
 	chip->set_value = gpio_pl061_set_value;
 	chip->get_value = gpio_pl061_get_value;
 	chip->to_irq = gpio_pl061_to_irq;
+	chip->set_port = gpio_pl061_set_port;
+	chip->get_port = gpio_pl061_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
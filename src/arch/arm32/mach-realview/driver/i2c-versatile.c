@@ -87,6 +87,13 @@ static int i2c_versatile_xfer(struct i2c_t * i2c, struct i2c_msg_t * msgs, int n
 	return i2c_algo_bit_xfer(bdat, msgs, num);
 }
 
+static int i2c_versatile_xfer_async(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data)
+{
+	struct i2c_versatile_pdata_t * pdat = (struct i2c_versatile_pdata_t *)i2c->priv;
+	struct i2c_algo_bit_data_t * bdat = (struct i2c_algo_bit_data_t *)(&pdat->bdat);
+	return i2c_algo_bit_xfer_async(bdat, msgs, num, complete, data);
+}
+
 static struct device_t * i2c_versatile_probe(struct driver_t * drv, struct dtnode_t * n)
 {
 	struct i2c_versatile_pdata_t * pdat;
@@ -112,9 +119,11 @@ static struct device_t * i2c_versatile_probe(struct driver_t * drv, struct dtnod
 	pdat->bdat.getscl = i2c_versatile_getscl;
 	pdat->bdat.udelay = dt_read_int(n, "delay-us", 5);
 	pdat->bdat.priv = pdat;
+	i2c_algo_bit_init(&pdat->bdat);
 
 	i2c->name = alloc_device_name(dt_read_name(n), -1);
 	i2c->xfer = i2c_versatile_xfer;
+	i2c->xfer_async = i2c_versatile_xfer_async;
 	i2c->priv = pdat;
 
 	i2c_versatile_setsda(&pdat->bdat, 1);
@@ -135,9 +144,11 @@ static struct device_t * i2c_versatile_probe(struct driver_t * drv, struct dtnod
 static void i2c_versatile_remove(struct device_t * dev)
 {
 	struct i2c_t * i2c = (struct i2c_t *)dev->priv;
+	struct i2c_versatile_pdata_t * pdat = (struct i2c_versatile_pdata_t *)i2c->priv;
 
 	if(i2c && unregister_i2c(i2c))
 	{
+		timer_cancel(&pdat->bdat.timer);
 		free_device_name(i2c->name);
 		free(i2c->priv);
 		free(i2c);
@@ -28,6 +28,7 @@
 
 #include <xboot.h>
 #include <i2c/i2c.h>
+#include <regmap/regmap.h>
 #include <gmeter/gmeter.h>
 
 enum {
@@ -75,69 +76,40 @@ enum {
 	REG_OFF_Z			= 0x31,
 };
 
-struct gmeter_mma8452_pdata_t {
-	struct i2c_device_t * dev;
+static const struct regmap_range_t mma8452_volatile[] = {
+	{ REG_STATUS,			REG_OUT_Z_LSB },
+	{ REG_SYSMOD,			REG_WHOAMI },
+	{ REG_PL_STATUS,		REG_PL_STATUS },
+	{ REG_FF_MT_SRC,		REG_FF_MT_SRC },
+	{ REG_TRANSIENT_SRC,	REG_TRANSIENT_SRC },
+	{ REG_PULSE_SRC,		REG_PULSE_SRC },
 };
 
-static bool_t mma8452_read(struct i2c_device_t * dev, u8_t reg, u8_t * val)
-{
-	struct i2c_msg_t msgs[2];
-	u8_t buf;
-
-	msgs[0].addr = dev->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = 1;
-	msgs[0].buf = &reg;
-
-	msgs[1].addr = dev->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = 1;
-	msgs[1].buf = &buf;
-
-	if(i2c_transfer(dev->i2c, msgs, 2) != 2)
-		return FALSE;
-
-	if(val)
-		*val = buf;
-	return TRUE;
-}
+static const struct regmap_config_t mma8452_regmap = {
+	.reg_bits		= 8,
+	.val_bits		= 8,
+	.max_register	= REG_OFF_Z,
+	.cache_type		= REGCACHE_FLAT,
+	.volatile_table	= mma8452_volatile,
+	.num_volatile	= ARRAY_SIZE(mma8452_volatile),
+};
 
-static bool_t mma8452_write(struct i2c_device_t * dev, u8_t reg, u8_t val)
-{
-	struct i2c_msg_t msg;
-	u8_t buf[2];
-
-	buf[0] = reg;
-	buf[1] = val;
-    msg.addr = dev->addr;
-    msg.flags = 0;
-    msg.len = 2;
-    msg.buf = &buf[0];
-
-    if(i2c_transfer(dev->i2c, &msg, 1) != 1)
-    	return FALSE;
-    return TRUE;
-}
+struct gmeter_mma8452_pdata_t {
+	struct i2c_device_t * dev;
+	struct regmap_t * map;
+};
 
 static bool_t gmeter_mma8452_get(struct gmeter_t * g, int * x, int * y, int * z)
 {
 	struct gmeter_mma8452_pdata_t * pdat = (struct gmeter_mma8452_pdata_t *)g->priv;
-	u8_t s, l = 0, h = 0;
+	u8_t buf[7];
 	s16_t tx, ty, tz;
 
-	if(mma8452_read(pdat->dev, REG_STATUS, &s) && (s & (1 << 3)))
+	if(regmap_raw_read(pdat->map, REG_STATUS, buf, 7) && (buf[0] & (1 << 3)))
 	{
-		mma8452_read(pdat->dev, REG_OUT_X_MSB, &h);
-		mma8452_read(pdat->dev, REG_OUT_X_LSB, &l);
-		tx = (h << 8) | (l << 0);
-
-		mma8452_read(pdat->dev, REG_OUT_Y_MSB, &h);
-		mma8452_read(pdat->dev, REG_OUT_Y_LSB, &l);
-		ty = (h << 8) | (l << 0);
-
-		mma8452_read(pdat->dev, REG_OUT_Z_MSB, &h);
-		mma8452_read(pdat->dev, REG_OUT_Z_LSB, &l);
-		tz = (h << 8) | (l << 0);
+		tx = (buf[1] << 8) | (buf[2] << 0);
+		ty = (buf[3] << 8) | (buf[4] << 0);
+		tz = (buf[5] << 8) | (buf[6] << 0);
 
 		*x = (s64_t)tx * 2 * 9806650 / 32768;
 		*y = (s64_t)ty * 2 * 9806650 / 32768;
@@ -153,37 +125,37 @@ static struct device_t * gmeter_mma8452_probe(struct driver_t * drv, struct dtno
 	struct gmeter_t * g;
 	struct device_t * dev;
 	struct i2c_device_t * i2cdev;
-	u8_t val;
+	struct regmap_t * map;
+	unsigned int val;
 
 	i2cdev = i2c_device_alloc(dt_read_string(n, "i2c-bus", NULL), dt_read_int(n, "slave-address", 0x1d), 0);
 	if(!i2cdev)
 		return NULL;
 
-	if(mma8452_read(i2cdev, REG_WHOAMI, &val) && (val == 0x2a))
+	map = regmap_alloc_i2c(i2cdev, &mma8452_regmap);
+	if(!map)
+	{
+		i2c_device_free(i2cdev);
+		return NULL;
+	}
+
+	if(regmap_read(map, REG_WHOAMI, &val) && (val == 0x2a))
 	{
 		/* Standby */
-		mma8452_read(i2cdev, REG_CTRL1, &val);
-		val &= ~(1 << 0);
-		mma8452_write(i2cdev, REG_CTRL1, val);
+		regmap_update_bits(map, REG_CTRL1, (1 << 0), (0 << 0));
 
 		/* Full scale range, 2G */
-		mma8452_read(i2cdev, REG_XYZ_DATA_CFG, &val);
-		val &= ~(3 << 0);
-		mma8452_write(i2cdev, REG_XYZ_DATA_CFG, val);
+		regmap_update_bits(map, REG_XYZ_DATA_CFG, (3 << 0), (0 << 0));
 
 		/* Data rate, 100HZ */
-		mma8452_read(i2cdev, REG_CTRL1, &val);
-		val &= ~(7 << 3);
-		val |= 3 << 3;
-		mma8452_write(i2cdev, REG_CTRL1, val);
+		regmap_update_bits(map, REG_CTRL1, (7 << 3), (3 << 3));
 
 		/* Active */
-		mma8452_read(i2cdev, REG_CTRL1, &val);
-		val |= 1 << 0;
-		mma8452_write(i2cdev, REG_CTRL1, val);
+		regmap_update_bits(map, REG_CTRL1, (1 << 0), (1 << 0));
 	}
 	else
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -191,6 +163,7 @@ static struct device_t * gmeter_mma8452_probe(struct driver_t * drv, struct dtno
 	pdat = malloc(sizeof(struct gmeter_mma8452_pdata_t));
 	if(!pdat)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -198,12 +171,14 @@ static struct device_t * gmeter_mma8452_probe(struct driver_t * drv, struct dtno
 	g = malloc(sizeof(struct gmeter_t));
 	if(!g)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		free(pdat);
 		return NULL;
 	}
 
 	pdat->dev = i2cdev;
+	pdat->map = map;
 
 	g->name = alloc_device_name(dt_read_name(n), -1);
 	g->get = gmeter_mma8452_get;
@@ -211,6 +186,7 @@ static struct device_t * gmeter_mma8452_probe(struct driver_t * drv, struct dtno
 
 	if(!register_gmeter(&dev, g))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(g->name);
@@ -230,6 +206,7 @@ static void gmeter_mma8452_remove(struct device_t * dev)
 
 	if(g && unregister_gmeter(g))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(g->name);
@@ -240,10 +217,20 @@ static void gmeter_mma8452_remove(struct device_t * dev)
 
 static void gmeter_mma8452_suspend(struct device_t * dev)
 {
+	struct gmeter_t * g = (struct gmeter_t *)dev->priv;
+	struct gmeter_mma8452_pdata_t * pdat = (struct gmeter_mma8452_pdata_t *)g->priv;
+
+	regmap_cache_only(pdat->map, TRUE);
 }
 
 static void gmeter_mma8452_resume(struct device_t * dev)
 {
+	struct gmeter_t * g = (struct gmeter_t *)dev->priv;
+	struct gmeter_mma8452_pdata_t * pdat = (struct gmeter_mma8452_pdata_t *)g->priv;
+
+	regmap_cache_only(pdat->map, FALSE);
+	regmap_mark_dirty(pdat->map);
+	regmap_sync(pdat->map);
 }
 
 static struct driver_t gmeter_mma8452 = {
@@ -138,7 +138,7 @@ static int tsc2007_timer_function(struct timer_t * timer, void * data)
 	}
 	else if(rt > 0)
 	{
-		tsfilter_update(pdat->filter, &x, &y);
+		tsfilter_update_at(pdat->filter, &x, &y, ktime_to_us(ktime_get()));
 		if(!pdat->press)
 		{
 			push_event_touch_begin(input, x, y, 0);
@@ -200,8 +200,6 @@ static struct device_t * ts_tsc2007_probe(struct driver_t * drv, struct dtnode_t
 	int gpio = dt_read_int(n, "interrupt-gpio", -1);
 	int gpiocfg = dt_read_int(n, "interrupt-gpio-config", -1);
 	int irq = gpio_to_irq(gpio);
-	int cal[7] = {1, 0, 0, 0, 1, 0, 1};
-	int i;
 
 	if(!gpio_is_valid(gpio) || !irq_is_valid(irq))
 		return NULL;
@@ -233,13 +231,7 @@ static struct device_t * ts_tsc2007_probe(struct driver_t * drv, struct dtnode_t
 
 	timer_init(&pdat->timer, tsc2007_timer_function, input);
 	pdat->dev = i2cdev;
-	pdat->filter = tsfilter_alloc(dt_read_int(n, "median-filter-length", 5), dt_read_int(n, "mean-filter-length", 5));
-	if(dt_read_array_length(n, "calibration") == 7)
-	{
-		for(i = 0; i < 7; i++)
-			cal[i] = dt_read_array_int(n, "calibration", i, cal[i]);
-		tsfilter_setcal(pdat->filter, &cal[0]);
-	}
+	pdat->filter = input_tsfilter_alloc(n, dt_read_int(n, "poll-interval-ms", 10));
 	pdat->irq = irq;
 	pdat->interval = dt_read_int(n, "poll-interval-ms", 10);
 	pdat->x_plate_ohms = dt_read_int(n, "x-plate-ohms", 600);
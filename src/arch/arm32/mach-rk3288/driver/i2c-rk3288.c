@@ -279,6 +279,7 @@ static struct device_t * i2c_rk3288_probe(struct driver_t * drv, struct dtnode_t
 
 	i2c->name = alloc_device_name(dt_read_name(n), -1);
 	i2c->xfer = i2c_rk3288_xfer;
+	i2c->xfer_async = NULL;
 	i2c->priv = pdat;
 
 	clk_enable(pdat->clk);
@@ -28,6 +28,7 @@
 
 #include <xboot.h>
 #include <i2c/i2c.h>
+#include <regmap/regmap.h>
 #include <compass/compass.h>
 
 enum {
@@ -46,69 +47,44 @@ enum {
 	REG_IDC		= 0x0c,
 };
 
-struct compass_hmc5883l_pdata_t {
-	struct i2c_device_t * dev;
+static const struct regmap_range_t hmc5883l_volatile[] = {
+	{ REG_DATAXH,	REG_IDC },
 };
 
-static bool_t hmc5883l_read(struct i2c_device_t * dev, u8_t reg, u8_t * val)
-{
-	struct i2c_msg_t msgs[2];
-	u8_t buf;
-
-	msgs[0].addr = dev->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = 1;
-	msgs[0].buf = &reg;
-
-	msgs[1].addr = dev->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = 1;
-	msgs[1].buf = &buf;
-
-	if(i2c_transfer(dev->i2c, msgs, 2) != 2)
-		return FALSE;
+static const struct regmap_reg_t hmc5883l_defaults[] = {
+	{ REG_CFGA,		0x10 },
+	{ REG_CFGB,		0x20 },
+	{ REG_MODE,		0x01 },
+};
 
-	if(val)
-		*val = buf;
-	return TRUE;
-}
+static const struct regmap_config_t hmc5883l_regmap = {
+	.reg_bits		= 8,
+	.val_bits		= 8,
+	.max_register	= REG_IDC,
+	.cache_type		= REGCACHE_FLAT,
+	.volatile_table	= hmc5883l_volatile,
+	.num_volatile	= ARRAY_SIZE(hmc5883l_volatile),
+	.defaults		= hmc5883l_defaults,
+	.num_defaults	= ARRAY_SIZE(hmc5883l_defaults),
+};
 
-static bool_t hmc5883l_write(struct i2c_device_t * dev, u8_t reg, u8_t val)
-{
-	struct i2c_msg_t msg;
-	u8_t buf[2];
-
-	buf[0] = reg;
-	buf[1] = val;
-	msg.addr = dev->addr;
-	msg.flags = 0;
-	msg.len = 2;
-	msg.buf = &buf[0];
-
-    if(i2c_transfer(dev->i2c, &msg, 1) != 1)
-    	return FALSE;
-    return TRUE;
-}
+struct compass_hmc5883l_pdata_t {
+	struct i2c_device_t * dev;
+	struct regmap_t * map;
+};
 
 static bool_t compass_hmc5883l_get(struct compass_t * c, int * x, int * y, int * z)
 {
 	struct compass_hmc5883l_pdata_t * pdat = (struct compass_hmc5883l_pdata_t *)c->priv;
-	u8_t s, l = 0, h = 0;
+	unsigned int s;
+	u8_t buf[6];
 	s16_t tx, ty, tz;
 
-	if(hmc5883l_read(pdat->dev, REG_STATUS, &s) && (s & (1 << 0)))
+	if(regmap_read(pdat->map, REG_STATUS, &s) && (s & (1 << 0)) && regmap_raw_read(pdat->map, REG_DATAXH, buf, 6))
 	{
-		hmc5883l_read(pdat->dev, REG_DATAXH, &h);
-		hmc5883l_read(pdat->dev, REG_DATAXL, &l);
-		tx = (h << 8) | (l << 0);
-
-		hmc5883l_read(pdat->dev, REG_DATAZH, &h);
-		hmc5883l_read(pdat->dev, REG_DATAZL, &l);
-		tz = (h << 8) | (l << 0);
-
-		hmc5883l_read(pdat->dev, REG_DATAYH, &h);
-		hmc5883l_read(pdat->dev, REG_DATAYL, &l);
-		ty = (h << 8) | (l << 0);
+		tx = (buf[0] << 8) | (buf[1] << 0);
+		tz = (buf[2] << 8) | (buf[3] << 0);
+		ty = (buf[4] << 8) | (buf[5] << 0);
 
 		*x = (s64_t)tx * 1000000 / 1090;
 		*y = (s64_t)ty * 1000000 / 1090;
@@ -124,25 +100,32 @@ static struct device_t * compass_hmc5883l_probe(struct driver_t * drv, struct dt
 	struct compass_t * c;
 	struct device_t * dev;
 	struct i2c_device_t * i2cdev;
-	u8_t ida, idb, idc;
+	struct regmap_t * map;
+	u8_t id[3];
 
 	i2cdev = i2c_device_alloc(dt_read_string(n, "i2c-bus", NULL), dt_read_int(n, "slave-address", 0x1e), 0);
 	if(!i2cdev)
 		return NULL;
 
-	if(hmc5883l_read(i2cdev, REG_IDA, &ida)
-		&& hmc5883l_read(i2cdev, REG_IDB, &idb)
-		&& hmc5883l_read(i2cdev, REG_IDC, &idc)
-		&& (ida == 0x48)
-		&& (idb == 0x34)
-		&& (idc == 0x33))
+	map = regmap_alloc_i2c(i2cdev, &hmc5883l_regmap);
+	if(!map)
+	{
+		i2c_device_free(i2cdev);
+		return NULL;
+	}
+
+	if(regmap_raw_read(map, REG_IDA, id, 3)
+		&& (id[0] == 0x48)
+		&& (id[1] == 0x34)
+		&& (id[2] == 0x33))
 	{
-		hmc5883l_write(i2cdev, REG_CFGA, 0x70);
-		hmc5883l_write(i2cdev, REG_CFGB, 0x20);
-		hmc5883l_write(i2cdev, REG_MODE, 0x00);
+		regmap_write(map, REG_CFGA, 0x70);
+		regmap_write(map, REG_CFGB, 0x20);
+		regmap_write(map, REG_MODE, 0x00);
 	}
 	else
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -150,6 +133,7 @@ static struct device_t * compass_hmc5883l_probe(struct driver_t * drv, struct dt
 	pdat = malloc(sizeof(struct compass_hmc5883l_pdata_t));
 	if(!pdat)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -157,12 +141,14 @@ static struct device_t * compass_hmc5883l_probe(struct driver_t * drv, struct dt
 	c = malloc(sizeof(struct compass_t));
 	if(!c)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		free(pdat);
 		return NULL;
 	}
 
 	pdat->dev = i2cdev;
+	pdat->map = map;
 
 	c->name = alloc_device_name(dt_read_name(n), -1);
 	c->ox = 0;
@@ -173,6 +159,7 @@ static struct device_t * compass_hmc5883l_probe(struct driver_t * drv, struct dt
 
 	if(!register_compass(&dev, c))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(c->name);
@@ -192,6 +179,7 @@ static void compass_hmc5883l_remove(struct device_t * dev)
 
 	if(c && unregister_compass(c))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(c->name);
@@ -202,10 +190,20 @@ static void compass_hmc5883l_remove(struct device_t * dev)
 
 static void compass_hmc5883l_suspend(struct device_t * dev)
 {
+	struct compass_t * c = (struct compass_t *)dev->priv;
+	struct compass_hmc5883l_pdata_t * pdat = (struct compass_hmc5883l_pdata_t *)c->priv;
+
+	regmap_cache_only(pdat->map, TRUE);
 }
 
 static void compass_hmc5883l_resume(struct device_t * dev)
 {
+	struct compass_t * c = (struct compass_t *)dev->priv;
+	struct compass_hmc5883l_pdata_t * pdat = (struct compass_hmc5883l_pdata_t *)c->priv;
+
+	regmap_cache_only(pdat->map, FALSE);
+	regmap_mark_dirty(pdat->map);
+	regmap_sync(pdat->map);
 }
 
 static struct driver_t compass_hmc5883l = {
@@ -28,6 +28,7 @@
 
 #include <xboot.h>
 #include <i2c/i2c.h>
+#include <regmap/regmap.h>
 #include <gmeter/gmeter.h>
 
 enum {
@@ -63,69 +64,40 @@ enum {
 	REG_FIFO_STATUS		= 0x39,
 };
 
-struct gmeter_axdl345_pdata_t {
-	struct i2c_device_t * dev;
+static const struct regmap_range_t axdl345_volatile[] = {
+	{ REG_DEVID,			REG_DEVID },
+	{ REG_ACT_TAP_STATUS,	REG_ACT_TAP_STATUS },
+	{ REG_INT_SOURCE,		REG_INT_SOURCE },
+	{ REG_DATAX0,			REG_DATAZ1 },
+	{ REG_FIFO_STATUS,		REG_FIFO_STATUS },
 };
 
-static bool_t axdl345_read(struct i2c_device_t * dev, u8_t reg, u8_t * val)
-{
-	struct i2c_msg_t msgs[2];
-	u8_t buf;
-
-	msgs[0].addr = dev->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = 1;
-	msgs[0].buf = &reg;
-
-	msgs[1].addr = dev->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = 1;
-	msgs[1].buf = &buf;
-
-	if(i2c_transfer(dev->i2c, msgs, 2) != 2)
-		return FALSE;
-
-	if(val)
-		*val = buf;
-	return TRUE;
-}
+static const struct regmap_config_t axdl345_regmap = {
+	.reg_bits		= 8,
+	.val_bits		= 8,
+	.max_register	= REG_FIFO_STATUS,
+	.cache_type		= REGCACHE_FLAT,
+	.volatile_table	= axdl345_volatile,
+	.num_volatile	= ARRAY_SIZE(axdl345_volatile),
+};
 
-static bool_t axdl345_write(struct i2c_device_t * dev, u8_t reg, u8_t val)
-{
-	struct i2c_msg_t msg;
-	u8_t buf[2];
-
-	buf[0] = reg;
-	buf[1] = val;
-	msg.addr = dev->addr;
-	msg.flags = 0;
-	msg.len = 2;
-	msg.buf = &buf[0];
-
-    if(i2c_transfer(dev->i2c, &msg, 1) != 1)
-    	return FALSE;
-    return TRUE;
-}
+struct gmeter_axdl345_pdata_t {
+	struct i2c_device_t * dev;
+	struct regmap_t * map;
+};
 
 static bool_t gmeter_axdl345_get(struct gmeter_t * g, int * x, int * y, int * z)
 {
 	struct gmeter_axdl345_pdata_t * pdat = (struct gmeter_axdl345_pdata_t *)g->priv;
-	u8_t s, l = 0, h = 0;
+	unsigned int s;
+	u8_t buf[6];
 	s16_t tx, ty, tz;
 
-	if(axdl345_read(pdat->dev, REG_INT_SOURCE, &s) && (s & (1 << 7)))
+	if(regmap_read(pdat->map, REG_INT_SOURCE, &s) && (s & (1 << 7)) && regmap_raw_read(pdat->map, REG_DATAX0, buf, 6))
 	{
-		axdl345_read(pdat->dev, REG_DATAX0, &l);
-		axdl345_read(pdat->dev, REG_DATAX1, &h);
-		tx = (h << 8) | (l << 0);
-
-		axdl345_read(pdat->dev, REG_DATAY0, &l);
-		axdl345_read(pdat->dev, REG_DATAY1, &h);
-		ty = (h << 8) | (l << 0);
-
-		axdl345_read(pdat->dev, REG_DATAZ0, &l);
-		axdl345_read(pdat->dev, REG_DATAZ1, &h);
-		tz = (h << 8) | (l << 0);
+		tx = (buf[1] << 8) | (buf[0] << 0);
+		ty = (buf[3] << 8) | (buf[2] << 0);
+		tz = (buf[5] << 8) | (buf[4] << 0);
 
 		*x = (s64_t)tx * 39 * 9806650 / 10000;
 		*y = (s64_t)ty * 39 * 9806650 / 10000;
@@ -141,20 +113,29 @@ static struct device_t * gmeter_axdl345_probe(struct driver_t * drv, struct dtno
 	struct gmeter_t * g;
 	struct device_t * dev;
 	struct i2c_device_t * i2cdev;
-	u8_t val;
+	struct regmap_t * map;
+	unsigned int val;
 
 	i2cdev = i2c_device_alloc(dt_read_string(n, "i2c-bus", NULL), dt_read_int(n, "slave-address", 0x53), 0);
 	if(!i2cdev)
 		return NULL;
 
-	if(axdl345_read(i2cdev, REG_DEVID, &val) && (val == 0xe5))
+	map = regmap_alloc_i2c(i2cdev, &axdl345_regmap);
+	if(!map)
+	{
+		i2c_device_free(i2cdev);
+		return NULL;
+	}
+
+	if(regmap_read(map, REG_DEVID, &val) && (val == 0xe5))
 	{
-		axdl345_write(i2cdev, REG_DATA_FORMAT, 0x0b);
-		axdl345_write(i2cdev, REG_POWER_CTL, 0x08);
-		axdl345_write(i2cdev, REG_INT_ENABLE, 0x80);
+		regmap_write(map, REG_DATA_FORMAT, 0x0b);
+		regmap_write(map, REG_POWER_CTL, 0x08);
+		regmap_write(map, REG_INT_ENABLE, 0x80);
 	}
 	else
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -162,6 +143,7 @@ static struct device_t * gmeter_axdl345_probe(struct driver_t * drv, struct dtno
 	pdat = malloc(sizeof(struct gmeter_axdl345_pdata_t));
 	if(!pdat)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -169,12 +151,14 @@ static struct device_t * gmeter_axdl345_probe(struct driver_t * drv, struct dtno
 	g = malloc(sizeof(struct gmeter_t));
 	if(!g)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		free(pdat);
 		return NULL;
 	}
 
 	pdat->dev = i2cdev;
+	pdat->map = map;
 
 	g->name = alloc_device_name(dt_read_name(n), -1);
 	g->get = gmeter_axdl345_get;
@@ -182,6 +166,7 @@ static struct device_t * gmeter_axdl345_probe(struct driver_t * drv, struct dtno
 
 	if(!register_gmeter(&dev, g))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(g->name);
@@ -201,6 +186,7 @@ static void gmeter_axdl345_remove(struct device_t * dev)
 
 	if(g && unregister_gmeter(g))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(g->name);
@@ -211,10 +197,20 @@ static void gmeter_axdl345_remove(struct device_t * dev)
 
 static void gmeter_axdl345_suspend(struct device_t * dev)
 {
+	struct gmeter_t * g = (struct gmeter_t *)dev->priv;
+	struct gmeter_axdl345_pdata_t * pdat = (struct gmeter_axdl345_pdata_t *)g->priv;
+
+	regmap_cache_only(pdat->map, TRUE);
 }
 
 static void gmeter_axdl345_resume(struct device_t * dev)
 {
+	struct gmeter_t * g = (struct gmeter_t *)dev->priv;
+	struct gmeter_axdl345_pdata_t * pdat = (struct gmeter_axdl345_pdata_t *)g->priv;
+
+	regmap_cache_only(pdat->map, FALSE);
+	regmap_mark_dirty(pdat->map);
+	regmap_sync(pdat->map);
 }
 
 static struct driver_t gmeter_axdl345 = {
@@ -83,7 +83,7 @@ static int ns2009_timer_function(struct timer_t * timer, void * data)
 		{
 			ns2009_read(pdat->dev, NS2009_LOW_POWER_READ_X, &x);
 			ns2009_read(pdat->dev, NS2009_LOW_POWER_READ_Y, &y);
-			tsfilter_update(pdat->filter, &x, &y);
+			tsfilter_update_at(pdat->filter, &x, &y, ktime_to_us(ktime_get()));
 
 			if(!pdat->press)
 			{
@@ -135,8 +135,6 @@ static struct device_t * ts_ns2009_probe(struct driver_t * drv, struct dtnode_t
 	struct input_t * input;
 	struct device_t * dev;
 	struct i2c_device_t * i2cdev;
-	int cal[7] = {1, 0, 0, 0, 1, 0, 1};
-	int i;
 
 	i2cdev = i2c_device_alloc(dt_read_string(n, "i2c-bus", NULL), dt_read_int(n, "slave-address", 0x48), 0);
 	if(!i2cdev)
@@ -165,13 +163,7 @@ static struct device_t * ts_ns2009_probe(struct driver_t * drv, struct dtnode_t
 
 	timer_init(&pdat->timer, ns2009_timer_function, input);
 	pdat->dev = i2cdev;
-	pdat->filter = tsfilter_alloc(dt_read_int(n, "median-filter-length", 5), dt_read_int(n, "mean-filter-length", 5));
-	if(dt_read_array_length(n, "calibration") == 7)
-	{
-		for(i = 0; i < 7; i++)
-			cal[i] = dt_read_array_int(n, "calibration", i, cal[i]);
-		tsfilter_setcal(pdat->filter, &cal[0]);
-	}
+	pdat->filter = input_tsfilter_alloc(n, dt_read_int(n, "poll-interval-ms", 10));
 	pdat->interval = dt_read_int(n, "poll-interval-ms", 10);
 	pdat->x = 0;
 	pdat->y = 0;
@@ -285,6 +285,24 @@ static int gpio_s5p4418_alv_get_value(struct gpiochip_t * chip, int offset)
 	return !!(val & (1 << offset));
 }
 
+static void gpio_s5p4418_alv_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_s5p4418_alv_pdata_t * pdat = (struct gpio_s5p4418_alv_pdata_t *)chip->priv;
+
+	gpiochip_write_enable(chip);
+	if(mask & value)
+		write32(pdat->virt + GPIOALV_PADOUTSETREG, mask & value);
+	if(mask & ~value)
+		write32(pdat->virt + GPIOALV_PADOUTRSTREG, mask & ~value);
+	gpiochip_write_disable(chip);
+}
+
+static u32_t gpio_s5p4418_alv_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_s5p4418_alv_pdata_t * pdat = (struct gpio_s5p4418_alv_pdata_t *)chip->priv;
+	return read32(pdat->virt + GPIOALV_GPIOINPUTVALUE);
+}
+
 static int gpio_s5p4418_alv_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_s5p4418_alv_pdata_t * pdat = (struct gpio_s5p4418_alv_pdata_t *)chip->priv;
@@ -338,6 +356,8 @@ static struct device_t * gpio_s5p4418_alv_probe(struct driver_t * drv, struct dt
 	chip->set_value = gpio_s5p4418_alv_set_value;
 	chip->get_value = gpio_s5p4418_alv_get_value;
 	chip->to_irq = gpio_s5p4418_alv_to_irq;
+	chip->set_port = gpio_s5p4418_alv_set_port;
+	chip->get_port = gpio_s5p4418_alv_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
@@ -664,6 +664,8 @@ static struct device_t * gpio_nswitch_probe(struct driver_t * drv, struct dtnode
 	chip->set_value = gpio_nswitch_set_value;
 	chip->get_value = gpio_nswitch_get_value;
 	chip->to_irq = gpio_nswitch_to_irq;
+	chip->set_port = NULL;
+	chip->get_port = NULL;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
@@ -166,6 +166,8 @@ static struct device_t * gpio_bcm2837_virt_probe(struct driver_t * drv, struct d
 	chip->set_value = gpio_bcm2837_virt_set_value;
 	chip->get_value = gpio_bcm2837_virt_get_value;
 	chip->to_irq = gpio_bcm2837_virt_to_irq;
+	chip->set_port = NULL;
+	chip->get_port = NULL;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
@@ -240,6 +240,22 @@ static int gpio_bcm2837_get_value(struct gpiochip_t * chip, int offset)
 	return (lev & (1 << field)) ? 1 : 0;
 }
 
+static void gpio_bcm2837_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_bcm2837_pdata_t * pdat = (struct gpio_bcm2837_pdata_t *)chip->priv;
+
+	if(mask & value)
+		write32(pdat->virt + GPIO_SET(0), mask & value);
+	if(mask & ~value)
+		write32(pdat->virt + GPIO_CLR(0), mask & ~value);
+}
+
+static u32_t gpio_bcm2837_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_bcm2837_pdata_t * pdat = (struct gpio_bcm2837_pdata_t *)chip->priv;
+	return read32(pdat->virt + GPIO_LEV(0));
+}
+
 static int gpio_bcm2837_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_bcm2837_pdata_t * pdat = (struct gpio_bcm2837_pdata_t *)chip->priv;
@@ -293,6 +309,8 @@ static struct device_t * gpio_bcm2837_probe(struct driver_t * drv, struct dtnode
 	chip->set_value = gpio_bcm2837_set_value;
 	chip->get_value = gpio_bcm2837_get_value;
 	chip->to_irq = gpio_bcm2837_to_irq;
+	chip->set_port = gpio_bcm2837_set_port;
+	chip->get_port = gpio_bcm2837_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
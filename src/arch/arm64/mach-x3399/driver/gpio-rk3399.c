@@ -627,6 +627,23 @@ static int gpio_rk3399_get_value(struct gpiochip_t * chip, int offset)
 	return !!(val & (1 << offset));
 }
 
+static void gpio_rk3399_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_rk3399_pdata_t * pdat = (struct gpio_rk3399_pdata_t *)chip->priv;
+	u32_t val;
+
+	val = read32(pdat->virt + GPIO_SWPORT_DR);
+	val &= ~mask;
+	val |= value & mask;
+	write32(pdat->virt + GPIO_SWPORT_DR, val);
+}
+
+static u32_t gpio_rk3399_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_rk3399_pdata_t * pdat = (struct gpio_rk3399_pdata_t *)chip->priv;
+	return read32(pdat->virt + GPIO_EXT_PORT);
+}
+
 static int gpio_rk3399_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_rk3399_pdata_t * pdat = (struct gpio_rk3399_pdata_t *)chip->priv;
@@ -682,6 +699,8 @@ static struct device_t * gpio_rk3399_probe(struct driver_t * drv, struct dtnode_
 	chip->set_value = gpio_rk3399_set_value;
 	chip->get_value = gpio_rk3399_get_value;
 	chip->to_irq = gpio_rk3399_to_irq;
+	chip->set_port = gpio_rk3399_set_port;
+	chip->get_port = gpio_rk3399_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
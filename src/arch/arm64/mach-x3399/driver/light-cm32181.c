@@ -28,6 +28,7 @@
 
 #include <xboot.h>
 #include <i2c/i2c.h>
+#include <regmap/regmap.h>
 #include <light/light.h>
 
 enum {
@@ -37,57 +38,32 @@ enum {
 	CM32181_REG_ID		= 0x07,
 };
 
-struct light_cm32181_pdata_t {
-	struct i2c_device_t * dev;
+static const struct regmap_range_t cm32181_volatile[] = {
+	{ CM32181_REG_ALS,	CM32181_REG_ID },
 };
 
-static bool_t cm32181_read(struct i2c_device_t * dev, u8_t reg, u16_t * val)
-{
-	struct i2c_msg_t msgs[2];
-	u8_t buf[2];
-
-	msgs[0].addr = dev->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = 1;
-	msgs[0].buf = &reg;
-
-	msgs[1].addr = dev->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = 2;
-	msgs[1].buf = &buf[0];
-
-	if(i2c_transfer(dev->i2c, msgs, 2) != 2)
-		return FALSE;
-
-    if(val)
-    	*val = ((u16_t)buf[1] << 8) | buf[0];
-    return TRUE;
-}
+static const struct regmap_config_t cm32181_regmap = {
+	.reg_bits		= 8,
+	.val_bits		= 16,
+	.little_endian	= TRUE,
+	.max_register	= CM32181_REG_ID,
+	.use_single_rw	= TRUE,
+	.cache_type		= REGCACHE_FLAT,
+	.volatile_table	= cm32181_volatile,
+	.num_volatile	= ARRAY_SIZE(cm32181_volatile),
+};
 
-static bool_t cm32181_write(struct i2c_device_t * dev, u8_t reg, u16_t val)
-{
-	struct i2c_msg_t msg;
-	u8_t buf[3];
-
-	buf[0] = reg;
-	buf[1] = (val >> 0) & 0xff;
-	buf[2] = (val >> 8) & 0xff;
-	msg.addr = dev->addr;
-	msg.flags = 0;
-	msg.len = 3;
-	msg.buf = &buf[0];
-
-    if(i2c_transfer(dev->i2c, &msg, 1) != 1)
-    	return FALSE;
-    return TRUE;
-}
+struct light_cm32181_pdata_t {
+	struct i2c_device_t * dev;
+	struct regmap_t * map;
+};
 
 static int light_cm32181_get(struct light_t * light)
 {
 	struct light_cm32181_pdata_t * pdat = (struct light_cm32181_pdata_t *)light->priv;
-	u16_t val;
+	unsigned int val;
 
-	if(cm32181_read(pdat->dev, CM32181_REG_ALS, &val))
+	if(regmap_read(pdat->map, CM32181_REG_ALS, &val))
 		return val * 42;
 	return 0;
 }
@@ -98,18 +74,27 @@ static struct device_t * light_cm32181_probe(struct driver_t * drv, struct dtnod
 	struct light_t * light;
 	struct device_t * dev;
 	struct i2c_device_t * i2cdev;
-	u16_t val;
+	struct regmap_t * map;
+	unsigned int val;
 
 	i2cdev = i2c_device_alloc(dt_read_string(n, "i2c-bus", NULL), dt_read_int(n, "slave-address", 0x10), 0);
 	if(!i2cdev)
 		return NULL;
 
-	if(cm32181_read(i2cdev, CM32181_REG_ID, &val) && ((val & 0xff) == 0x81))
+	map = regmap_alloc_i2c(i2cdev, &cm32181_regmap);
+	if(!map)
+	{
+		i2c_device_free(i2cdev);
+		return NULL;
+	}
+
+	if(regmap_read(map, CM32181_REG_ID, &val) && ((val & 0xff) == 0x81))
 	{
-		cm32181_write(i2cdev, CM32181_REG_CMD, (1 << 12) | (0 << 6) | (0 << 4) | (0 << 1) | (0 << 0));
+		regmap_write(map, CM32181_REG_CMD, (1 << 12) | (0 << 6) | (0 << 4) | (0 << 1) | (0 << 0));
 	}
 	else
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -117,6 +102,7 @@ static struct device_t * light_cm32181_probe(struct driver_t * drv, struct dtnod
 	pdat = malloc(sizeof(struct light_cm32181_pdata_t));
 	if(!pdat)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		return NULL;
 	}
@@ -124,12 +110,14 @@ static struct device_t * light_cm32181_probe(struct driver_t * drv, struct dtnod
 	light = malloc(sizeof(struct light_t));
 	if(!light)
 	{
+		regmap_free(map);
 		i2c_device_free(i2cdev);
 		free(pdat);
 		return NULL;
 	}
 
 	pdat->dev = i2cdev;
+	pdat->map = map;
 
 	light->name = alloc_device_name(dt_read_name(n), -1);
 	light->get = light_cm32181_get;
@@ -137,6 +125,7 @@ static struct device_t * light_cm32181_probe(struct driver_t * drv, struct dtnod
 
 	if(!register_light(&dev, light))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(light->name);
@@ -156,6 +145,7 @@ static void light_cm32181_remove(struct device_t * dev)
 
 	if(light && unregister_light(light))
 	{
+		regmap_free(pdat->map);
 		i2c_device_free(pdat->dev);
 
 		free_device_name(light->name);
@@ -166,10 +156,20 @@ static void light_cm32181_remove(struct device_t * dev)
 
 static void light_cm32181_suspend(struct device_t * dev)
 {
+	struct light_t * light = (struct light_t *)dev->priv;
+	struct light_cm32181_pdata_t * pdat = (struct light_cm32181_pdata_t *)light->priv;
+
+	regmap_cache_only(pdat->map, TRUE);
 }
 
 static void light_cm32181_resume(struct device_t * dev)
 {
+	struct light_t * light = (struct light_t *)dev->priv;
+	struct light_cm32181_pdata_t * pdat = (struct light_cm32181_pdata_t *)light->priv;
+
+	regmap_cache_only(pdat->map, FALSE);
+	regmap_mark_dirty(pdat->map);
+	regmap_sync(pdat->map);
 }
 
 static struct driver_t light_cm32181 = {
@@ -385,6 +385,23 @@ static int gpio_s5p6818_get_value(struct gpiochip_t * chip, int offset)
 	return !!(val & (1 << offset));
 }
 
+static void gpio_s5p6818_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	struct gpio_s5p6818_pdata_t * pdat = (struct gpio_s5p6818_pdata_t *)chip->priv;
+	u32_t val;
+
+	val = read32(pdat->virt + GPIO_OUT);
+	val &= ~mask;
+	val |= value & mask;
+	write32(pdat->virt + GPIO_OUT, val);
+}
+
+static u32_t gpio_s5p6818_get_port(struct gpiochip_t * chip)
+{
+	struct gpio_s5p6818_pdata_t * pdat = (struct gpio_s5p6818_pdata_t *)chip->priv;
+	return read32(pdat->virt + GPIO_PAD);
+}
+
 static int gpio_s5p6818_to_irq(struct gpiochip_t * chip, int offset)
 {
 	struct gpio_s5p6818_pdata_t * pdat = (struct gpio_s5p6818_pdata_t *)chip->priv;
@@ -438,6 +455,8 @@ static struct device_t * gpio_s5p6818_probe(struct driver_t * drv, struct dtnode
 	chip->set_value = gpio_s5p6818_set_value;
 	chip->get_value = gpio_s5p6818_get_value;
 	chip->to_irq = gpio_s5p6818_to_irq;
+	chip->set_port = gpio_s5p6818_set_port;
+	chip->get_port = gpio_s5p6818_get_port;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
@@ -5182,9 +5182,10 @@ static void gslx680_interrupt(void * data)
 	struct input_t * input = (struct input_t *)data;
 	struct ts_gslx680_pdata_t * pdat = (struct ts_gslx680_pdata_t *)input->priv;
 	int fingers = pdat->fingers;
+	struct event_touch_contact_t contact[CONFIG_EVENT_TOUCH_CONTACTS];
 	u8_t buf[44];
 	int x, y, id;
-	int n, i;
+	int n, i, end = 0;
 
 	disable_irq(pdat->irq);
 
@@ -5217,6 +5218,12 @@ static void gslx680_interrupt(void * data)
 			pdat->node[id].x = x;
 			pdat->node[id].y = y;
 			pdat->node[id].valid = 1;
+			if(i < CONFIG_EVENT_TOUCH_CONTACTS)
+			{
+				contact[i].x = x;
+				contact[i].y = y;
+				contact[i].id = id;
+			}
 		}
 
 		for(i = 0; i < fingers; i++)
@@ -5225,8 +5232,12 @@ static void gslx680_interrupt(void * data)
 			{
 				push_event_touch_end(input, pdat->node[i].x, pdat->node[i].y, i);
 				pdat->node[i].press = 0;
+				end++;
 			}
 		}
+
+		if((n > 0) || (end > 0))
+			push_event_touch_frame(input, contact, n);
 	}
 
 	enable_irq(pdat->irq);
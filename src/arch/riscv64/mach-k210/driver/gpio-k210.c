@@ -746,6 +746,8 @@ static struct device_t * gpio_k210_probe(struct driver_t * drv, struct dtnode_t
 	chip->set_value = gpio_k210_set_value;
 	chip->get_value = gpio_k210_get_value;
 	chip->to_irq = gpio_k210_to_irq;
+	chip->set_port = NULL;
+	chip->get_port = NULL;
 	chip->priv = pdat;
 
 	if(!register_gpiochip(&dev, chip))
@@ -28,12 +28,16 @@
 
 #include <xboot.h>
 #include <clockevent/clockevent.h>
+#include <interrupt/interrupt.h>
 #include <sandbox.h>
 
 static void ce_sandbox_interrupt(void * data)
 {
 	struct clockevent_t * ce = (struct clockevent_t *)data;
+
+	interrupt_enter();
 	ce->handler(ce, ce->data);
+	interrupt_exit();
 }
 
 static bool_t ce_sandbox_next(struct clockevent_t * ce, u64_t evt)
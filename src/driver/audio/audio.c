@@ -27,8 +27,66 @@
  */
 
 #include <xboot.h>
+#include <xboot/idle.h>
 #include <audio/pool.h>
+#include <audio/pcm.h>
 #include <audio/audio.h>
+#include <audio/stream.h>
+
+/*
+ * Software mixer, every playing sound in the pool is a voice. The output
+ * runs at the format of the voice that started it, each voice's stream is
+ * kept decoded and converted to that format ahead of the callback. Decoding
+ * reads files, so the refill timer only flags that a refill is due and the
+ * idle poll hook does it in thread context, from the event pump, the shell
+ * loop or a running script. Once no voice is left the output stops and the
+ * next audio_playback restarts it.
+ */
+#define MIXER_CHUNK_FRAMES		(128)
+#define MIXER_MAX_CHANNELS		(SOUND_STREAM_MAX_CHANNELS)
+#define MIXER_REFILL_MS			(10)
+
+static struct {
+	enum pcm_rate_t rate;
+	enum pcm_format_t fmt;
+	int channel;
+	int running;
+	int voices;
+	int fill;
+	unsigned int underruns;
+	s64_t mix_time;
+	s64_t mix_time_max;
+	struct timer_t timer;
+	int timer_ready;
+	volatile int pending;
+} __mixer;
+static u8_t __mixer_voice[MIXER_CHUNK_FRAMES * MIXER_MAX_CHANNELS * 4];
+static s32_t __mixer_acc[MIXER_CHUNK_FRAMES * MIXER_MAX_CHANNELS];
+
+static ssize_t audio_read_voices(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __mixer.voices);
+}
+
+static ssize_t audio_read_underruns(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%u", __mixer.underruns);
+}
+
+static ssize_t audio_read_fill(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d%%", __mixer.fill);
+}
+
+static ssize_t audio_read_mix_time(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%lldns", __mixer.mix_time);
+}
+
+static ssize_t audio_read_mix_time_max(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%lldns", __mixer.mix_time_max);
+}
 
 struct audio_t * search_audio(const char * name)
 {
@@ -66,6 +124,11 @@ bool_t register_audio(struct device_t ** device, struct audio_t * audio)
 	dev->driver = NULL;
 	dev->priv = audio;
 	dev->kobj = kobj_alloc_directory(dev->name);
+	kobj_add_regular(dev->kobj, "voices", audio_read_voices, NULL, audio);
+	kobj_add_regular(dev->kobj, "underruns", audio_read_underruns, NULL, audio);
+	kobj_add_regular(dev->kobj, "fill", audio_read_fill, NULL, audio);
+	kobj_add_regular(dev->kobj, "mix-time", audio_read_mix_time, NULL, audio);
+	kobj_add_regular(dev->kobj, "mix-time-max", audio_read_mix_time_max, NULL, audio);
 
 	if(!register_device(dev))
 	{
@@ -100,122 +163,204 @@ bool_t unregister_audio(struct audio_t * audio)
 	return TRUE;
 }
 
-static int sound_read(struct sound_t * snd, void * buf, int count)
+static inline int mixer_voice_active(struct sound_t * snd)
 {
-	int i, len = 0;
+	struct sound_stream_t * s;
 
-	if(snd && snd->read)
-	{
-		len = snd->read(snd, buf, count);
+	if(!snd || (snd->status != SOUND_STATUS_PLAY) || !(s = snd->stream) || !s->fifo)
+		return 0;
+	return (s->rate == __mixer.rate) && (s->fmt == __mixer.fmt) && (s->channel == __mixer.channel);
+}
 
-		if(snd->volume == 100)
-		{
-		}
-		else if(snd->volume == 0)
-		{
-			memset(buf, 0, len);
-		}
-		else
-		{
-			s8_t * p8; s16_t * p16; s32_t * p32;
-			s32_t v;
-			switch(snd->info.fmt)
-			{
-			case PCM_FORMAT_BIT8:
-				p8 = buf;
-				for(i = 0; i < len; i++)
-				{
-					v = ((s32_t)(p8[i])) * snd->volume / 100;
-					p8[i] = (s8_t)v;
-				}
-				break;
+static inline void mixer_voice_gain(struct sound_t * snd, int * gl, int * gr)
+{
+	int pan = (__mixer.channel == 2) ? snd->pan : 0;
 
-			case PCM_FORMAT_BIT16:
-				p16 = buf;
-				for(i = 0; i < len / 2; i++)
-				{
-					v = ((s32_t)be16_to_cpu(p16[i])) * snd->volume / 100;
-					p16[i] = cpu_to_be16((s16_t)v);
-				}
-				break;
+	*gl = (pan > 0) ? (100 - pan) * PCM_GAIN_UNITY / 100 : PCM_GAIN_UNITY;
+	*gr = (pan < 0) ? (100 + pan) * PCM_GAIN_UNITY / 100 : PCM_GAIN_UNITY;
+}
 
-			case PCM_FORMAT_BIT24:
-			case PCM_FORMAT_BIT32:
-				p32 = buf;
-				for(i = 0; i < len / 4; i++)
-				{
-					v = ((s32_t)be32_to_cpu(p32[i])) * snd->volume / 100;
-					p32[i] = cpu_to_be32(v);
-				}
-				break;
+static void mixer_accumulate(s32_t * acc, const u8_t * src, int frames, int shift, int gl, int gr)
+{
+	int bytes = pcm_sample_bytes(__mixer.fmt);
+	int i, c;
 
-			default:
-				break;
-			}
-		}
+	for(i = 0; i < frames; i++)
+	{
+		for(c = 0; c < __mixer.channel; c++, src += bytes)
+			*acc++ += (s32_t)(((s64_t)(pcm_get_sample(src, __mixer.fmt) >> shift) * ((c == 1) ? gr : gl)) >> 15);
 	}
+}
+
+/*
+ * Bring the stream of every playing sound to the output format and top up
+ * its ring buffer.
+ */
+static void mixer_refill(void)
+{
+	struct sound_list_t * pos, * n;
+	struct sound_t * snd;
 
-	return len;
+	list_for_each_entry_safe(pos, n, &__sound_pool.entry, entry)
+	{
+		snd = pos->snd;
+		if(snd && (snd->status == SOUND_STATUS_PLAY) && sound_stream_config(snd->stream, __mixer.rate, __mixer.fmt, __mixer.channel))
+			sound_stream_refill(snd->stream);
+	}
+}
+
+static int mixer_refill_timer_function(struct timer_t * timer, void * data)
+{
+	if(!__mixer.running)
+		return 0;
+	__mixer.pending = 1;
+	timer_forward_now(timer, ms_to_ktime(MIXER_REFILL_MS));
+	return 1;
 }
 
 static int audio_playback_callback(void * data, void * buf, int count)
 {
 	struct audio_t * audio = (struct audio_t *)data;
-	struct sound_list_t * sp = &__sound_pool;
-	struct list_head * pos = sp->entry.next;
-	int len = 0;
+	struct sound_list_t * pos, * n;
+	struct sound_t * snd;
+	ktime_t begin = ktime_get();
+	int bits = (__mixer.fmt > PCM_FORMAT_BIT24) ? PCM_FORMAT_BIT24 : __mixer.fmt;
+	int shift = 32 - bits;
+	s32_t max = (1 << (bits - 1)) - 1;
+	s32_t min = -(1 << (bits - 1));
+	int dbytes = pcm_sample_bytes(__mixer.fmt) * __mixer.channel;
+	int frames = count / dbytes;
+	int fast = (__mixer.fmt == PCM_FORMAT_BIT16);
+	int voices = 0;
+	int fill = 100;
+	int done, chunk, len, gl, gr, i;
+	s32_t * acc;
+	u8_t * dst;
+	s64_t t;
+
+	list_for_each_entry_safe(pos, n, &__sound_pool.entry, entry)
+	{
+		snd = pos->snd;
+		if(!mixer_voice_active(snd))
+			continue;
+		i = sound_stream_fill(snd->stream);
+		if(i < fill)
+			fill = i;
+		voices++;
+	}
 
-	if(list_empty_careful(&sp->entry))
+	__mixer.voices = voices;
+	if(voices == 0)
 	{
+		__mixer.running = 0;
+		__mixer.fill = 0;
 		if(audio->playback_stop)
 			audio->playback_stop(audio);
 		return 0;
 	}
+	__mixer.fill = fill;
 
-	if(list_is_last(pos, &sp->entry))
+	for(done = 0; done < frames; done += chunk)
 	{
-		struct sound_list_t * sl = list_entry(pos, struct sound_list_t, entry);
-		struct sound_t * snd = sl->snd;
-		if(snd && (sound_get_status(snd) == SOUND_STATUS_PLAY))
+		chunk = (frames - done < MIXER_CHUNK_FRAMES) ? frames - done : MIXER_CHUNK_FRAMES;
+		dst = (u8_t *)buf + done * dbytes;
+		if(fast)
+			memset(dst, 0, chunk * dbytes);
+		else
+			memset(__mixer_acc, 0, chunk * __mixer.channel * sizeof(s32_t));
+
+		list_for_each_entry_safe(pos, n, &__sound_pool.entry, entry)
 		{
-			if((len = sound_read(snd, buf, count)) < count)
+			snd = pos->snd;
+			if(!mixer_voice_active(snd))
+				continue;
+			len = sound_stream_read(snd->stream, __mixer_voice, chunk * dbytes) / dbytes;
+			mixer_voice_gain(snd, &gl, &gr);
+			if(fast)
+				pcm_mix_s16((s16_t *)dst, (s16_t *)__mixer_voice, len * __mixer.channel, __mixer.channel, gl, gr);
+			else
+				mixer_accumulate(__mixer_acc, __mixer_voice, len, shift, gl, gr);
+			if(len < chunk)
 			{
-				if(sound_get_position(snd) >= snd->info.length)
+				if(sound_stream_finished(snd->stream))
 				{
+					push_event_sound_finish(snd, snd->info.title, sound_get_position(snd));
 					sound_stop(snd);
 				}
+				else
+				{
+					__mixer.underruns++;
+				}
+			}
+		}
+
+		if(!fast)
+		{
+			for(i = 0, acc = __mixer_acc; i < chunk * __mixer.channel; i++, acc++, dst += dbytes / __mixer.channel)
+			{
+				if(*acc > max)
+					*acc = max;
+				else if(*acc < min)
+					*acc = min;
+				pcm_put_sample(dst, __mixer.fmt, *acc << shift);
 			}
 		}
 	}
 
-	return len;
+	t = ktime_to_ns(ktime_sub(ktime_get(), begin));
+	__mixer.mix_time = t;
+	if(t > __mixer.mix_time_max)
+		__mixer.mix_time_max = t;
+	return frames * dbytes;
+}
+
+static void mixer_idle_poll(void * data)
+{
+	if(__mixer.running && __mixer.pending)
+	{
+		__mixer.pending = 0;
+		mixer_refill();
+	}
 }
 
+static struct idle_hook_t __mixer_idle = {
+	.poll = mixer_idle_poll,
+};
+
 void audio_playback(struct audio_t * audio)
 {
-	struct sound_list_t * sp = &__sound_pool;
-	struct list_head * pos = sp->entry.next;
+	struct sound_list_t * pos, * n;
+	struct sound_t * snd;
 
 	if(!audio)
 		return;
 
-	if(list_empty_careful(&sp->entry))
+	if(__mixer.running)
+	{
+		mixer_refill();
 		return;
+	}
 
-	/* Just one sound */
-	if(list_is_last(pos, &sp->entry))
+	list_for_each_entry_safe(pos, n, &__sound_pool.entry, entry)
 	{
-		struct sound_list_t * sl = list_entry(pos, struct sound_list_t, entry);
-		struct sound_t * snd = sl->snd;
-		if(snd)
+		snd = pos->snd;
+		if(snd && (snd->status == SOUND_STATUS_PLAY) && (snd->info.channel > 0) && (snd->info.channel <= MIXER_MAX_CHANNELS))
 		{
+			__mixer.rate = snd->info.rate;
+			__mixer.fmt = snd->info.fmt;
+			__mixer.channel = snd->info.channel;
+			__mixer.running = 1;
+			mixer_refill();
+			if(!__mixer.timer_ready)
+			{
+				timer_init(&__mixer.timer, mixer_refill_timer_function, NULL);
+				register_idle_hook(&__mixer_idle);
+				__mixer.timer_ready = 1;
+			}
+			timer_start_now(&__mixer.timer, ms_to_ktime(MIXER_REFILL_MS));
 			if(audio->playback_start)
-				audio->playback_start(audio, snd->info.rate, snd->info.fmt, snd->info.channel, audio_playback_callback, audio);
+				audio->playback_start(audio, __mixer.rate, __mixer.fmt, __mixer.channel, audio_playback_callback, audio);
+			return;
 		}
 	}
-	/* More than one sound */
-	else
-	{
-
-	}
 }
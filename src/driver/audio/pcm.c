@@ -0,0 +1,197 @@
+/*
+ * driver/audio/pcm.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <audio/pcm.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+static void pcm_scale_s8(s8_t * p, int n, int g)
+{
+	int i = 0;
+
+#if defined(__SSSE3__)
+	__m128i gv = _mm_set1_epi16(g);
+	for(; i + 16 <= n; i += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)&p[i]);
+		__m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+		__m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+		lo = _mm_mulhrs_epi16(lo, gv);
+		hi = _mm_mulhrs_epi16(hi, gv);
+		_mm_storeu_si128((__m128i *)&p[i], _mm_packs_epi16(lo, hi));
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	int16x8_t gv = vdupq_n_s16(g);
+	for(; i + 16 <= n; i += 16)
+	{
+		int8x16_t v = vld1q_s8(&p[i]);
+		int16x8_t lo = vqrdmulhq_s16(vmovl_s8(vget_low_s8(v)), gv);
+		int16x8_t hi = vqrdmulhq_s16(vmovl_s8(vget_high_s8(v)), gv);
+		vst1q_s8(&p[i], vcombine_s8(vqmovn_s16(lo), vqmovn_s16(hi)));
+	}
+#endif
+	for(; i < n; i++)
+		p[i] = (p[i] * g + 0x4000) >> 15;
+}
+
+static void pcm_scale_s16(s16_t * p, int n, int g)
+{
+	int i = 0;
+
+#if defined(__SSSE3__)
+	__m128i gv = _mm_set1_epi16(g);
+	for(; i + 8 <= n; i += 8)
+		_mm_storeu_si128((__m128i *)&p[i], _mm_mulhrs_epi16(_mm_loadu_si128((const __m128i *)&p[i]), gv));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	int16x8_t gv = vdupq_n_s16(g);
+	for(; i + 8 <= n; i += 8)
+		vst1q_s16(&p[i], vqrdmulhq_s16(vld1q_s16(&p[i]), gv));
+#endif
+	for(; i < n; i++)
+		p[i] = (p[i] * g + 0x4000) >> 15;
+}
+
+static void pcm_scale_s24(u8_t * p, int n, int g)
+{
+	s32_t v;
+	int i;
+
+	for(i = 0; i < n; i++, p += 3)
+	{
+		v = pcm_get_sample(p, PCM_FORMAT_BIT24) >> 8;
+		v = ((s64_t)v * g + 0x4000) >> 15;
+		pcm_put_sample(p, PCM_FORMAT_BIT24, v << 8);
+	}
+}
+
+static void pcm_scale_s32(s32_t * p, int n, int g)
+{
+	int i = 0;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	int32x4_t gv = vdupq_n_s32(g << 16);
+	for(; i + 4 <= n; i += 4)
+		vst1q_s32(&p[i], vqrdmulhq_s32(vld1q_s32(&p[i]), gv));
+#endif
+	for(; i < n; i++)
+		p[i] = ((s64_t)p[i] * g + 0x4000) >> 15;
+}
+
+/*
+ * Scale len bytes of native endian samples in place by a Q15 gain. Gains at
+ * or above unity leave the data untouched, a zero gain clears it.
+ */
+void pcm_scale(void * buf, int len, enum pcm_format_t fmt, int gain)
+{
+	if(!buf || (len <= 0) || (gain >= PCM_GAIN_UNITY))
+		return;
+	if(gain <= 0)
+	{
+		memset(buf, 0, len);
+		return;
+	}
+
+	switch(fmt)
+	{
+	case PCM_FORMAT_BIT8:
+		pcm_scale_s8(buf, len, gain);
+		break;
+	case PCM_FORMAT_BIT16:
+		pcm_scale_s16(buf, len >> 1, gain);
+		break;
+	case PCM_FORMAT_BIT24:
+		pcm_scale_s24(buf, len / 3, gain);
+		break;
+	case PCM_FORMAT_BIT32:
+		pcm_scale_s32(buf, len >> 2, gain);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Saturating mix of n native endian s16 samples from src into dst. With
+ * two channels gl and gr are the left and right Q15 gains, otherwise gl
+ * applies to every channel.
+ */
+void pcm_mix_s16(s16_t * dst, const s16_t * src, int n, int ch, int gl, int gr)
+{
+	int i = 0;
+
+	if(ch != 2)
+		gr = gl;
+
+	if((gl >= PCM_GAIN_UNITY) && (gr >= PCM_GAIN_UNITY))
+	{
+#if defined(__SSE2__)
+		for(; i + 8 <= n; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *)&dst[i]);
+			__m128i b = _mm_loadu_si128((const __m128i *)&src[i]);
+			_mm_storeu_si128((__m128i *)&dst[i], _mm_adds_epi16(a, b));
+		}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		for(; i + 8 <= n; i += 8)
+			vst1q_s16(&dst[i], vqaddq_s16(vld1q_s16(&dst[i]), vld1q_s16(&src[i])));
+#endif
+		for(; i < n; i++)
+			dst[i] = pcm_sat16((s32_t)dst[i] + src[i]);
+	}
+	else
+	{
+		if(gl > PCM_GAIN_UNITY - 1)
+			gl = PCM_GAIN_UNITY - 1;
+		if(gr > PCM_GAIN_UNITY - 1)
+			gr = PCM_GAIN_UNITY - 1;
+#if defined(__SSSE3__)
+		__m128i g = _mm_set_epi16(gr, gl, gr, gl, gr, gl, gr, gl);
+		for(; i + 8 <= n; i += 8)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *)&dst[i]);
+			__m128i b = _mm_loadu_si128((const __m128i *)&src[i]);
+			_mm_storeu_si128((__m128i *)&dst[i], _mm_adds_epi16(a, _mm_mulhrs_epi16(b, g)));
+		}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+		const s16_t gv[8] = { gl, gr, gl, gr, gl, gr, gl, gr };
+		int16x8_t g = vld1q_s16(gv);
+		for(; i + 8 <= n; i += 8)
+			vst1q_s16(&dst[i], vqaddq_s16(vld1q_s16(&dst[i]), vqrdmulhq_s16(vld1q_s16(&src[i]), g)));
+#endif
+		for(; i < n; i++)
+			dst[i] = pcm_sat16((s32_t)dst[i] + ((src[i] * ((i & 0x1) ? gr : gl) + 0x4000) >> 15));
+	}
+}
@@ -25,29 +25,322 @@
  * SOFTWARE.
  *
  */
-
+#include <xboot.h>
+#include <xfs/xfs.h>
 #include <audio/sound.h>
 
-struct wav_header_t {
-	uint8_t		riff[4];
-	uint32_t	riffsz;
-	uint8_t		wave[4];
-	uint8_t    	fmt[4];
-	uint32_t	fmtsz;
-	uint16_t   	fmttag;
+/*
+ * RIFF WAVE container, the data chunk is handed to a codec picked by the
+ * format tag. The file is read through the runtime's xfs context, falling
+ * back to the plain file system for absolute paths.
+ */
+struct wav_fmt_t {
+	uint16_t	fmttag;
 	uint16_t	channel;
 	uint32_t	samplerate;
 	uint32_t	byterate;
 	uint16_t	align;
 	uint16_t	bps;
-	uint8_t		data[4];
-	uint32_t	datasz;
+} __attribute__ ((packed));
+
+struct sound_data_wav_t;
+
+struct wav_codec_t {
+	uint16_t tag;
+	bool_t (*setup)(struct sound_t * snd, struct sound_data_wav_t * dat, struct wav_fmt_t * fmt);
+	int (*read)(struct sound_t * snd, void * buf, int count);
+	int (*seek)(struct sound_t * snd, int offset);
 };
 
 struct sound_data_wav_t {
+	struct xfs_file_t * file;
 	int fd;
+	const struct wav_codec_t * codec;
+	s64_t data;
+	s64_t datasz;
+	s64_t offset;
+	int channel;
+	int align;
+	int spb;
+
+	/* Block codec state, raw blocks read ahead and the decoded block */
+	u8_t * blk;
+	int blklen;
+	int blkpos;
+	s16_t * pcm;
+	int pcmlen;
+	int pcmpos;
+};
+
+/*
+ * Raw blocks are read in chunks of about this many bytes.
+ */
+#define WAV_READ_AHEAD		(8192)
+
+static s64_t wav_io_read(struct sound_data_wav_t * dat, void * buf, s64_t len)
+{
+	if(dat->file)
+		return xfs_read(dat->file, buf, len);
+	return read(dat->fd, buf, len);
+}
+
+static s64_t wav_io_seek(struct sound_data_wav_t * dat, s64_t offset)
+{
+	if(dat->file)
+		return xfs_seek(dat->file, offset);
+	return lseek(dat->fd, offset, SEEK_SET);
+}
+
+static void wav_io_close(struct sound_data_wav_t * dat)
+{
+	if(dat->file)
+		xfs_close(dat->file);
+	else if(dat->fd >= 0)
+		close(dat->fd);
+}
+
+static bool_t wav_io_data(struct sound_data_wav_t * dat, s64_t offset)
+{
+	if(offset > dat->datasz)
+		offset = dat->datasz;
+	if(wav_io_seek(dat, dat->data + offset) != dat->data + offset)
+		return FALSE;
+	dat->offset = offset;
+	return TRUE;
+}
+
+static int wav_io_read_data(struct sound_data_wav_t * dat, void * buf, int count)
+{
+	s64_t n;
+
+	if(count > dat->datasz - dat->offset)
+		count = dat->datasz - dat->offset;
+	if(count <= 0)
+		return 0;
+	n = wav_io_read(dat, buf, count);
+	if(n <= 0)
+		return 0;
+	dat->offset += n;
+	return n;
+}
+
+/*
+ * Linear PCM, 8 bits samples are unsigned in WAV files and get flipped to
+ * signed, wider samples are little endian and used as they are.
+ */
+static bool_t wav_pcm_setup(struct sound_t * snd, struct sound_data_wav_t * dat, struct wav_fmt_t * fmt)
+{
+	if((fmt->bps != 8) && (fmt->bps != 16) && (fmt->bps != 24) && (fmt->bps != 32))
+		return FALSE;
+	if(fmt->align != (fmt->bps / 8) * fmt->channel)
+		return FALSE;
+	snd->info.fmt = (enum pcm_format_t)fmt->bps;
+	snd->info.length = dat->datasz - (dat->datasz % fmt->align);
+	return TRUE;
+}
+
+static int wav_pcm_read(struct sound_t * snd, void * buf, int count)
+{
+	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
+	u8_t * p = buf;
+	int len, i;
+
+	len = wav_io_read_data(dat, buf, count);
+	if(snd->info.fmt == PCM_FORMAT_BIT8)
+	{
+		for(i = 0; i < len; i++)
+			p[i] ^= 0x80;
+	}
+	snd->position += len;
+	return len;
+}
+
+static int wav_pcm_seek(struct sound_t * snd, int offset)
+{
+	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
+
+	offset -= offset % dat->align;
+	if(wav_io_data(dat, offset))
+		snd->position = offset;
+	return snd->position;
+}
+
+/*
+ * IMA ADPCM, 4 bits per sample decoded to 16 bits. Every block starts with
+ * a predictor and step index per channel followed by groups of four bytes
+ * per channel, eight samples each, low nibble first.
+ */
+static const s16_t ima_step_table[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+	34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+	157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+	724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+	3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
 };
 
+static const s8_t ima_index_table[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static inline s16_t ima_decode_nibble(int * pred, int * index, int nibble)
+{
+	int step = ima_step_table[*index];
+	int diff = step >> 3;
+
+	if(nibble & 0x4)
+		diff += step;
+	if(nibble & 0x2)
+		diff += step >> 1;
+	if(nibble & 0x1)
+		diff += step >> 2;
+	if(nibble & 0x8)
+		*pred -= diff;
+	else
+		*pred += diff;
+	if(*pred > 32767)
+		*pred = 32767;
+	else if(*pred < -32768)
+		*pred = -32768;
+	*index += ima_index_table[nibble];
+	if(*index < 0)
+		*index = 0;
+	else if(*index > 88)
+		*index = 88;
+	return *pred;
+}
+
+static int ima_block_samples(int len, int ch)
+{
+	if(len < 4 * ch)
+		return 0;
+	return 1 + (len - 4 * ch) * 2 / ch;
+}
+
+static int ima_decode_block(const u8_t * blk, int len, int ch, s16_t * out)
+{
+	int pred, index;
+	int n = ima_block_samples(len, ch);
+	const u8_t * p;
+	int c, g, i, k;
+
+	for(c = 0; c < ch; c++)
+	{
+		pred = (s16_t)(blk[c * 4] | (blk[c * 4 + 1] << 8));
+		index = blk[c * 4 + 2];
+		if(index > 88)
+			index = 88;
+		out[c] = pred;
+		p = blk + 4 * ch + c * 4;
+		for(g = 0, k = 1; k < n; g++, p += 4 * ch)
+		{
+			for(i = 0; (i < 8) && (k < n); i++, k++)
+				out[k * ch + c] = ima_decode_nibble(&pred, &index, (p[i >> 1] >> ((i & 0x1) << 2)) & 0xf);
+		}
+	}
+	return n;
+}
+
+static bool_t wav_ima_setup(struct sound_t * snd, struct sound_data_wav_t * dat, struct wav_fmt_t * fmt)
+{
+	int frame = 2 * fmt->channel;
+	s64_t rem;
+
+	if((fmt->bps != 4) || (fmt->align < 4 * fmt->channel) || ((fmt->align / fmt->channel) & 0x3))
+		return FALSE;
+	dat->spb = ima_block_samples(fmt->align, fmt->channel);
+	dat->blk = malloc(((WAV_READ_AHEAD / fmt->align) + 1) * fmt->align);
+	dat->pcm = malloc(dat->spb * frame);
+	if(!dat->blk || !dat->pcm)
+		return FALSE;
+	rem = dat->datasz % fmt->align;
+	snd->info.fmt = PCM_FORMAT_BIT16;
+	snd->info.length = (dat->datasz / fmt->align) * dat->spb * frame + ima_block_samples(rem, fmt->channel) * frame;
+	return TRUE;
+}
+
+static bool_t wav_ima_next_block(struct sound_data_wav_t * dat)
+{
+	int len;
+
+	if(dat->blkpos >= dat->blklen)
+	{
+		dat->blklen = wav_io_read_data(dat, dat->blk, ((WAV_READ_AHEAD / dat->align) + 1) * dat->align);
+		dat->blkpos = 0;
+		if(dat->blklen <= 0)
+			return FALSE;
+	}
+	len = dat->blklen - dat->blkpos;
+	if(len > dat->align)
+		len = dat->align;
+	dat->pcmlen = ima_decode_block(dat->blk + dat->blkpos, len, dat->channel, dat->pcm) * dat->channel;
+	dat->pcmpos = 0;
+	dat->blkpos += len;
+	return (dat->pcmlen > 0) ? TRUE : FALSE;
+}
+
+static int wav_ima_read(struct sound_t * snd, void * buf, int count)
+{
+	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
+	s16_t * out = buf;
+	int n = count >> 1;
+	int done = 0;
+	int len;
+
+	while(done < n)
+	{
+		if((dat->pcmpos >= dat->pcmlen) && !wav_ima_next_block(dat))
+			break;
+		len = dat->pcmlen - dat->pcmpos;
+		if(len > n - done)
+			len = n - done;
+		memcpy(&out[done], &dat->pcm[dat->pcmpos], len << 1);
+		dat->pcmpos += len;
+		done += len;
+	}
+	snd->position += done << 1;
+	return done << 1;
+}
+
+static int wav_ima_seek(struct sound_t * snd, int offset)
+{
+	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
+	int bsize = dat->spb * dat->channel * 2;
+	int block = offset / bsize;
+
+	if(!wav_io_data(dat, (s64_t)block * dat->align))
+		return snd->position;
+	dat->blklen = dat->blkpos = 0;
+	dat->pcmlen = dat->pcmpos = 0;
+	snd->position = block * bsize;
+	if(wav_ima_next_block(dat))
+	{
+		dat->pcmpos = ((offset - snd->position) >> 1) / dat->channel * dat->channel;
+		if(dat->pcmpos > dat->pcmlen)
+			dat->pcmpos = dat->pcmlen;
+		snd->position += dat->pcmpos << 1;
+	}
+	return snd->position;
+}
+
+static const struct wav_codec_t __wav_codec[] = {
+	{ 0x0001,	wav_pcm_setup,	wav_pcm_read,	wav_pcm_seek },
+	{ 0x0011,	wav_ima_setup,	wav_ima_read,	wav_ima_seek },
+};
+
+static const struct wav_codec_t * search_wav_codec(uint16_t tag)
+{
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(__wav_codec); i++)
+	{
+		if(__wav_codec[i].tag == tag)
+			return &__wav_codec[i];
+	}
+	return NULL;
+}
+
 static int sound_seek_wav(struct sound_t * snd, int offset)
 {
 	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
@@ -56,20 +349,21 @@ static int sound_seek_wav(struct sound_t * snd, int offset)
 		offset = 0;
 	if(offset > snd->info.length)
 		offset = snd->info.length;
-
-	if(lseek(dat->fd, sizeof(struct wav_header_t) + offset, SEEK_SET) > 0)
-		snd->position = offset;
-	return snd->position;
+	return dat->codec->seek(snd, offset);
 }
 
 static int sound_read_wav(struct sound_t * snd, void * buf, int count)
 {
 	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
-	int len;
+	return dat->codec->read(snd, buf, count);
+}
 
-	len = read(dat->fd, buf, count);
-	snd->position += len;
-	return len;
+static void wav_data_free(struct sound_data_wav_t * dat)
+{
+	wav_io_close(dat);
+	free(dat->blk);
+	free(dat->pcm);
+	free(dat);
 }
 
 static void sound_close_wav(struct sound_t * snd)
@@ -77,64 +371,98 @@ static void sound_close_wav(struct sound_t * snd)
 	struct sound_data_wav_t * dat = (struct sound_data_wav_t *)snd->priv;
 	free(snd->info.title);
 	free(snd->info.singer);
-	close(dat->fd);
-	free(dat);
+	wav_data_free(dat);
+}
+
+/*
+ * Walk the RIFF chunks up to the data chunk, the format chunk has to come
+ * first and unknown chunks such as LIST are skipped.
+ */
+static bool_t wav_parse(struct sound_data_wav_t * dat, struct wav_fmt_t * fmt)
+{
+	uint8_t hdr[12];
+	uint32_t size;
+	s64_t pos = 12;
+	int hasfmt = 0;
+
+	if(wav_io_read(dat, hdr, 12) != 12)
+		return FALSE;
+	if((memcmp(&hdr[0], "RIFF", 4) != 0) || (memcmp(&hdr[8], "WAVE", 4) != 0))
+		return FALSE;
+
+	while(wav_io_read(dat, hdr, 8) == 8)
+	{
+		size = le32_to_cpu(*((uint32_t *)&hdr[4]));
+		pos += 8;
+		if(memcmp(&hdr[0], "fmt ", 4) == 0)
+		{
+			memset(fmt, 0, sizeof(struct wav_fmt_t));
+			if(size < 16)
+				return FALSE;
+			if(wav_io_read(dat, fmt, (size < sizeof(struct wav_fmt_t)) ? size : sizeof(struct wav_fmt_t)) < 16)
+				return FALSE;
+			fmt->fmttag = le16_to_cpu(fmt->fmttag);
+			fmt->channel = le16_to_cpu(fmt->channel);
+			fmt->samplerate = le32_to_cpu(fmt->samplerate);
+			fmt->byterate = le32_to_cpu(fmt->byterate);
+			fmt->align = le16_to_cpu(fmt->align);
+			fmt->bps = le16_to_cpu(fmt->bps);
+			hasfmt = 1;
+		}
+		else if(memcmp(&hdr[0], "data", 4) == 0)
+		{
+			dat->data = pos;
+			dat->datasz = size;
+			return hasfmt ? TRUE : FALSE;
+		}
+		pos += size + (size & 0x1);
+		if(wav_io_seek(dat, pos) != pos)
+			return FALSE;
+	}
+	return FALSE;
 }
 
 bool_t sound_load_wav(struct sound_t * snd, const char * filename)
 {
+	struct xfs_context_t * ctx = runtime_get()->__xfs_ctx;
 	struct sound_data_wav_t * dat;
-	struct wav_header_t header;
-	int fd;
+	struct wav_fmt_t fmt;
 
 	if(!snd)
 		return FALSE;
 
-	fd = open(filename, O_RDONLY, (S_IRUSR|S_IRGRP|S_IROTH));
-	if(fd < 0)
+	dat = (struct sound_data_wav_t *)malloc(sizeof(struct sound_data_wav_t));
+	if(!dat)
 		return FALSE;
+	memset(dat, 0, sizeof(struct sound_data_wav_t));
 
-	if(read(fd, &header, sizeof(struct wav_header_t)) != sizeof(struct wav_header_t))
+	dat->file = ctx ? xfs_open_read(ctx, filename) : NULL;
+	dat->fd = dat->file ? -1 : open(filename, O_RDONLY, (S_IRUSR|S_IRGRP|S_IROTH));
+	if(!dat->file && (dat->fd < 0))
 	{
-		close(fd);
+		free(dat);
 		return FALSE;
 	}
 
-	header.riffsz = be32_to_cpu(header.riffsz);
-	header.fmtsz = be32_to_cpu(header.fmtsz);
-	header.fmttag = be16_to_cpu(header.fmttag);
-	header.channel = be16_to_cpu(header.channel);
-	header.samplerate = be32_to_cpu(header.samplerate);
-	header.byterate = be32_to_cpu(header.byterate);
-	header.align = be16_to_cpu(header.align);
-	header.bps = be16_to_cpu(header.bps);
-	header.datasz = be32_to_cpu(header.datasz);
-
-	if(	(memcmp(header.riff, "RIFF", 4) != 0) ||
-		(memcmp(header.wave, "WAVE", 4) != 0) ||
-		(memcmp(header.fmt,  "fmt ", 4) != 0) ||
-		(memcmp(header.data, "data", 4) != 0) ||
-		(header.fmttag != 1) || (header.datasz < header.align) )
+	if(!wav_parse(dat, &fmt) || (fmt.channel == 0) || (fmt.align == 0) || (dat->datasz < fmt.align))
 	{
-		close(fd);
+		wav_data_free(dat);
 		return FALSE;
 	}
 
-	dat = (struct sound_data_wav_t *)malloc(sizeof(struct sound_data_wav_t));
-	if(!dat)
+	dat->codec = search_wav_codec(fmt.fmttag);
+	dat->channel = fmt.channel;
+	dat->align = fmt.align;
+	if(!dat->codec || !dat->codec->setup(snd, dat, &fmt) || !wav_io_data(dat, 0))
 	{
-		close(fd);
+		wav_data_free(dat);
 		return FALSE;
 	}
 
-	dat->fd = fd;
-
 	snd->info.title = strdup(filename);
 	snd->info.singer = strdup("unknown");
-	snd->info.rate = (enum pcm_rate_t)header.samplerate;
-	snd->info.fmt = (enum pcm_format_t)header.bps;
-	snd->info.channel = header.channel;
-	snd->info.length = header.datasz;
+	snd->info.rate = (enum pcm_rate_t)fmt.samplerate;
+	snd->info.channel = fmt.channel;
 	snd->status = SOUND_STATUS_STOP;
 	snd->volume = 100;
 	snd->position = 0;
@@ -27,6 +27,8 @@
  */
 
 #include <audio/pool.h>
+#include <audio/pcm.h>
+#include <audio/stream.h>
 #include <audio/audio.h>
 #include <audio/sound.h>
 
@@ -92,8 +94,18 @@ struct sound_t * sound_alloc(const char * filename)
 	if(!snd)
 		return NULL;
 
+	snd->pan = 0;
 	if(loader->load(snd, filename))
-		return snd;
+	{
+		snd->stream = sound_stream_alloc(snd);
+		if(snd->stream)
+		{
+			sound_set_volume(snd, snd->volume);
+			return snd;
+		}
+		if(snd->close)
+			snd->close(snd);
+	}
 
 	free(snd);
 	return NULL;
@@ -106,6 +118,7 @@ void sound_free(struct sound_t * snd)
 		sound_stop(snd);
 		if(snd->close)
 			snd->close(snd);
+		sound_stream_free(snd->stream);
 		free(snd);
 	}
 }
@@ -133,6 +146,7 @@ void sound_set_volume(struct sound_t * snd, int percent)
 		if(percent > 100)
 			percent = 100;
 		snd->volume = percent;
+		snd->gain = percent * PCM_GAIN_UNITY / 100;
 	}
 }
 
@@ -143,6 +157,25 @@ int sound_get_volume(struct sound_t * snd)
 	return 0;
 }
 
+void sound_set_pan(struct sound_t * snd, int pan)
+{
+	if(snd)
+	{
+		if(pan < -100)
+			pan = -100;
+		if(pan > 100)
+			pan = 100;
+		snd->pan = pan;
+	}
+}
+
+int sound_get_pan(struct sound_t * snd)
+{
+	if(snd)
+		return snd->pan;
+	return 0;
+}
+
 void sound_set_position(struct sound_t * snd, int position)
 {
 	if(snd && snd->seek)
@@ -152,6 +185,7 @@ void sound_set_position(struct sound_t * snd, int position)
 		if(position > snd->info.length)
 			position = snd->info.length;
 		snd->seek(snd, position);
+		sound_stream_reset(snd->stream);
 	}
 }
 
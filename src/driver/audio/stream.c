@@ -0,0 +1,261 @@
+/*
+ * driver/audio/stream.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <audio/pcm.h>
+#include <audio/stream.h>
+
+/*
+ * The ring holds about 85ms of output at 48KHz, every decode pulls at most
+ * one block from the decoder and converts it chunk by chunk.
+ */
+#define STREAM_RING_FRAMES		(4096)
+#define STREAM_CHUNK_FRAMES		(1024)
+#define STREAM_BLOCK_BYTES		(16384)
+
+struct sound_stream_t * sound_stream_alloc(struct sound_t * snd)
+{
+	struct sound_stream_t * s;
+
+	if(!snd)
+		return NULL;
+
+	s = malloc(sizeof(struct sound_stream_t));
+	if(!s)
+		return NULL;
+
+	memset(s, 0, sizeof(struct sound_stream_t));
+	s->snd = snd;
+	return s;
+}
+
+void sound_stream_free(struct sound_stream_t * s)
+{
+	if(s)
+	{
+		if(s->fifo)
+			fifo_free(s->fifo);
+		free(s->src);
+		free(s->dst);
+		free(s);
+	}
+}
+
+bool_t sound_stream_config(struct sound_stream_t * s, enum pcm_rate_t rate, enum pcm_format_t fmt, int ch)
+{
+	struct sound_info_t * info;
+	int dbytes;
+
+	if(!s || (ch <= 0) || (ch > SOUND_STREAM_MAX_CHANNELS) || (rate <= 0))
+		return FALSE;
+
+	info = &s->snd->info;
+	if((info->channel <= 0) || (info->rate <= 0) || (pcm_sample_bytes(info->fmt) * info->channel > STREAM_BLOCK_BYTES))
+		return FALSE;
+
+	if(s->fifo && (s->rate == rate) && (s->fmt == fmt) && (s->channel == ch))
+		return TRUE;
+
+	dbytes = pcm_sample_bytes(fmt) * ch;
+	if(s->fifo)
+		fifo_free(s->fifo);
+	free(s->dst);
+	s->fifo = fifo_alloc(STREAM_RING_FRAMES * dbytes);
+	s->dst = malloc((STREAM_CHUNK_FRAMES + 2) * dbytes);
+	if(!s->src)
+		s->src = malloc(STREAM_BLOCK_BYTES);
+	if(!s->fifo || !s->dst || !s->src)
+	{
+		if(s->fifo)
+			fifo_free(s->fifo);
+		s->fifo = NULL;
+		return FALSE;
+	}
+
+	s->rate = rate;
+	s->fmt = fmt;
+	s->channel = ch;
+	s->step = ((u64_t)info->rate << 16) / rate;
+	s->passthrough = (info->rate == rate) && (info->fmt == fmt) && (info->channel == ch);
+	sound_stream_reset(s);
+	return TRUE;
+}
+
+void sound_stream_reset(struct sound_stream_t * s)
+{
+	if(s)
+	{
+		if(s->fifo)
+			fifo_reset(s->fifo);
+		s->phase = 0;
+		s->primed = 0;
+		s->eof = 0;
+	}
+}
+
+static int stream_decode(struct sound_t * snd, void * buf, int count)
+{
+	int len = 0;
+
+	if(snd->read)
+	{
+		len = snd->read(snd, buf, count);
+		if(len > 0)
+			pcm_scale(buf, len, snd->info.fmt, snd->gain);
+	}
+	return len;
+}
+
+static void stream_load_frame(struct sound_stream_t * s, const u8_t * p, s32_t * f)
+{
+	enum pcm_format_t fmt = s->snd->info.fmt;
+	int bytes = pcm_sample_bytes(fmt);
+	int vch = s->snd->info.channel;
+	int c;
+
+	if((s->channel == 1) && (vch > 1))
+	{
+		f[0] = (pcm_get_sample(p, fmt) >> 1) + (pcm_get_sample(p + bytes, fmt) >> 1);
+	}
+	else
+	{
+		for(c = 0; c < s->channel; c++)
+			f[c] = pcm_get_sample(p + ((c < vch) ? c : vch - 1) * bytes, fmt);
+	}
+}
+
+/*
+ * Linear interpolating resampler with channel and format conversion, the
+ * output for a phase between two source frames is their weighted sum.
+ */
+static int stream_resample(struct sound_stream_t * s, const u8_t * src, int frames, u8_t * dst)
+{
+	int sbytes = pcm_sample_bytes(s->snd->info.fmt) * s->snd->info.channel;
+	int bytes = pcm_sample_bytes(s->fmt);
+	int n = 0;
+	int i, c;
+	s32_t v;
+
+	for(i = 0; i < frames; i++, src += sbytes)
+	{
+		memcpy(s->prev, s->next, sizeof(s32_t) * s->channel);
+		stream_load_frame(s, src, s->next);
+		if(!s->primed)
+		{
+			memcpy(s->prev, s->next, sizeof(s32_t) * s->channel);
+			s->primed = 1;
+		}
+		while(s->phase < 0x10000)
+		{
+			for(c = 0; c < s->channel; c++, dst += bytes)
+			{
+				v = s->prev[c] + (s32_t)((((s64_t)s->next[c] - s->prev[c]) * s->phase) >> 16);
+				pcm_put_sample(dst, s->fmt, v);
+			}
+			s->phase += s->step;
+			n++;
+		}
+		s->phase -= 0x10000;
+	}
+	return n;
+}
+
+/*
+ * Decode and convert until the ring is full or the sound ends, returns the
+ * number of source frames consumed.
+ */
+int sound_stream_refill(struct sound_stream_t * s)
+{
+	struct sound_t * snd;
+	int sbytes, dbytes;
+	int space, limit, in, len, n;
+	int total = 0;
+
+	if(!s || !s->fifo)
+		return 0;
+
+	snd = s->snd;
+	sbytes = pcm_sample_bytes(snd->info.fmt) * snd->info.channel;
+	dbytes = pcm_sample_bytes(s->fmt) * s->channel;
+
+	while(!s->eof)
+	{
+		space = (s->fifo->size - fifo_len(s->fifo)) / dbytes;
+		limit = (space < STREAM_CHUNK_FRAMES) ? space : STREAM_CHUNK_FRAMES;
+		if(s->passthrough)
+			in = limit;
+		else
+			in = ((u64_t)(limit - 2) * s->step) >> 16;
+		if((limit < 4) || (in < 1))
+			break;
+		if(in > STREAM_BLOCK_BYTES / sbytes)
+			in = STREAM_BLOCK_BYTES / sbytes;
+
+		len = stream_decode(snd, s->src, in * sbytes);
+		n = (len > 0) ? len / sbytes : 0;
+		if(n <= 0)
+		{
+			s->eof = 1;
+			break;
+		}
+		if(s->passthrough)
+			fifo_put(s->fifo, s->src, n * sbytes);
+		else
+			fifo_put(s->fifo, s->dst, stream_resample(s, s->src, n, s->dst) * dbytes);
+		total += n;
+	}
+	return total;
+}
+
+int sound_stream_read(struct sound_stream_t * s, void * buf, int count)
+{
+	if(!s || !s->fifo)
+		return 0;
+	return fifo_get(s->fifo, buf, count);
+}
+
+/*
+ * Ring fill level in percent.
+ */
+int sound_stream_fill(struct sound_stream_t * s)
+{
+	int dbytes;
+
+	if(!s || !s->fifo)
+		return 0;
+
+	dbytes = pcm_sample_bytes(s->fmt) * s->channel;
+	return fifo_len(s->fifo) * 100 / ((s->fifo->size / dbytes) * dbytes);
+}
+
+bool_t sound_stream_finished(struct sound_stream_t * s)
+{
+	if(!s || !s->fifo)
+		return TRUE;
+	return (s->eof && (fifo_len(s->fifo) == 0)) ? TRUE : FALSE;
+}
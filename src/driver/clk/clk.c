@@ -32,17 +32,16 @@
 static ssize_t clk_read_summary(struct kobj_t * kobj, void * buf, size_t size)
 {
 	struct clk_t * clk = (struct clk_t *)kobj->priv;
-	const char * name = clk->name;
 	char * p = buf;
 	int len = 0;
 	u64_t rate;
 
 	len += sprintf((char *)(p + len), "%-16s %16s %8s\r\n", "name", "rate", "enable");
-	while(name)
+	while(clk)
 	{
-		rate = clk_get_rate(name);
-		len += sprintf((char *)(p + len), "%-16s %6Ld.%06LdMHZ %8d\r\n", name, rate / (u64_t)(1000 * 1000), rate % (u64_t)(1000 * 1000), clk_status(name) ? 1 : 0);
-		name = clk_get_parent(name);
+		rate = clk_handle_get_rate(clk);
+		len += sprintf((char *)(p + len), "%-16s %6Ld.%06LdMHZ %8d\r\n", clk->name, rate / (u64_t)(1000 * 1000), rate % (u64_t)(1000 * 1000), clk_handle_status(clk) ? 1 : 0);
+		clk = clk_handle_get_parent(clk);
 	}
 	return len;
 }
@@ -103,9 +102,42 @@ struct clk_t * search_clk(const char * name)
 	return (struct clk_t *)dev->priv;
 }
 
+struct clk_t * clk_handle_get_parent(struct clk_t * clk)
+{
+	const char * pname;
+
+	if(!clk)
+		return NULL;
+
+	/*
+	 * A named parent that is not registered yet is looked up again on the
+	 * next call, everything else stays cached until set_parent.
+	 */
+	if(!clk->pvalid)
+	{
+		pname = clk->get_parent ? clk->get_parent(clk) : NULL;
+		clk->parent = pname ? search_clk(pname) : NULL;
+		clk->pvalid = (!pname || clk->parent) ? TRUE : FALSE;
+	}
+	return clk->parent;
+}
+
+static bool_t clk_in_subtree(struct clk_t * clk, struct clk_t * root)
+{
+	while(clk)
+	{
+		if(clk == root)
+			return TRUE;
+		clk = clk_handle_get_parent(clk);
+	}
+	return FALSE;
+}
+
 bool_t register_clk(struct device_t ** device, struct clk_t * clk)
 {
-	struct device_t * dev;
+	struct device_t * dev, * pos, * n;
+	const char * pname;
+	struct clk_t * c;
 
 	if(!clk || !clk->name)
 		return FALSE;
@@ -117,6 +149,13 @@ bool_t register_clk(struct device_t ** device, struct clk_t * clk)
 	if(!dev)
 		return FALSE;
 
+	clk->parent = NULL;
+	clk->pvalid = FALSE;
+	clk->rvalid = FALSE;
+	clk->rate = 0;
+	clk->orate = 0;
+	notifier_chain_init(&clk->nc);
+
 	dev->name = strdup(clk->name);
 	dev->type = DEVICE_TYPE_CLK;
 	dev->driver = NULL;
@@ -135,6 +174,24 @@ bool_t register_clk(struct device_t ** device, struct clk_t * clk)
 		return FALSE;
 	}
 
+	/*
+	 * Clocks waiting on this name pick it up as parent, and their
+	 * subtrees drop any rate cached while it was missing.
+	 */
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		c = (struct clk_t *)pos->priv;
+		pname = (c != clk) && c->get_parent ? c->get_parent(c) : NULL;
+		if(pname && (strcmp(pname, clk->name) == 0))
+			c->pvalid = FALSE;
+	}
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		c = (struct clk_t *)pos->priv;
+		if((c != clk) && clk_in_subtree(c, clk))
+			c->rvalid = FALSE;
+	}
+
 	if(device)
 		*device = dev;
 	return TRUE;
@@ -142,7 +199,8 @@ bool_t register_clk(struct device_t ** device, struct clk_t * clk)
 
 bool_t unregister_clk(struct clk_t * clk)
 {
-	struct device_t * dev;
+	struct device_t * dev, * pos, * n;
+	struct clk_t * c;
 
 	if(!clk || !clk->name)
 		return FALSE;
@@ -151,6 +209,22 @@ bool_t unregister_clk(struct clk_t * clk)
 	if(!dev)
 		return FALSE;
 
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		c = (struct clk_t *)pos->priv;
+		if((c != clk) && clk_in_subtree(c, clk))
+			c->rvalid = FALSE;
+	}
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		c = (struct clk_t *)pos->priv;
+		if(c->parent == clk)
+		{
+			c->parent = NULL;
+			c->pvalid = FALSE;
+		}
+	}
+
 	if(!unregister_device(dev))
 		return FALSE;
 
@@ -160,33 +234,62 @@ bool_t unregister_clk(struct clk_t * clk)
 	return TRUE;
 }
 
-void clk_set_parent(const char * name, const char * pname)
+static void clk_change_begin(struct clk_t * root)
 {
-	struct clk_t * clk = search_clk(name);
-	struct clk_t * pclk = search_clk(pname);
+	struct device_t * pos, * n;
+	struct clk_t * clk;
 
-	if(pclk && clk && clk->set_parent)
-		clk->set_parent(clk, pname);
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		clk = (struct clk_t *)pos->priv;
+		if(clk_in_subtree(clk, root))
+			clk->orate = clk_handle_get_rate(clk);
+	}
 }
 
-const char * clk_get_parent(const char * name)
+static void clk_change_end(struct clk_t * root)
 {
-	struct clk_t * clk = search_clk(name);
+	struct device_t * pos, * n;
+	struct clk_notifier_data_t data;
+	struct clk_t * clk;
 
-	if(clk && clk->get_parent)
-		return clk->get_parent(clk);
-	return NULL;
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		clk = (struct clk_t *)pos->priv;
+		if(clk_in_subtree(clk, root))
+			clk->rvalid = FALSE;
+	}
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_CLK], head)
+	{
+		clk = (struct clk_t *)pos->priv;
+		if(clk_in_subtree(clk, root))
+		{
+			data.clk = clk;
+			data.orate = clk->orate;
+			data.nrate = clk_handle_get_rate(clk);
+			if(data.nrate != data.orate)
+				notifier_chain_call(&clk->nc, NOTIFIER_CLK_RATE_CHANGE, &data);
+		}
+	}
 }
 
-void clk_enable(const char * name)
+void clk_handle_set_parent(struct clk_t * clk, struct clk_t * pclk)
 {
-	struct clk_t * clk = search_clk(name);
+	if(clk && pclk && clk->set_parent)
+	{
+		clk_change_begin(clk);
+		clk->set_parent(clk, pclk->name);
+		clk->pvalid = FALSE;
+		clk_change_end(clk);
+	}
+}
 
+void clk_handle_enable(struct clk_t * clk)
+{
 	if(!clk)
 		return;
 
-	if(clk->get_parent)
-		clk_enable(clk->get_parent(clk));
+	clk_handle_enable(clk_handle_get_parent(clk));
 
 	if(clk->set_enable)
 		clk->set_enable(clk, TRUE);
@@ -194,10 +297,8 @@ void clk_enable(const char * name)
 	clk->count++;
 }
 
-void clk_disable(const char * name)
+void clk_handle_disable(struct clk_t * clk)
 {
-	struct clk_t * clk = search_clk(name);
-
 	if(!clk)
 		return;
 
@@ -206,62 +307,120 @@ void clk_disable(const char * name)
 
 	if(clk->count == 0)
 	{
-		if(clk->get_parent)
-			clk_disable(clk->get_parent(clk));
+		clk_handle_disable(clk_handle_get_parent(clk));
 
 		if(clk->set_enable)
 			clk->set_enable(clk, FALSE);
 	}
 }
 
-bool_t clk_status(const char * name)
+bool_t clk_handle_status(struct clk_t * clk)
 {
-	struct clk_t * clk = search_clk(name);
-
-	if(!clk)
-		return FALSE;
+	struct clk_t * pclk;
 
-	if(!clk->get_parent(clk))
-		return clk->get_enable(clk);
+	while(clk)
+	{
+		if(clk->get_enable && !clk->get_enable(clk))
+			return FALSE;
+		pclk = clk_handle_get_parent(clk);
+		if(!pclk)
+			return TRUE;
+		clk = pclk;
+	}
+	return FALSE;
+}
 
-	if(clk->get_enable(clk))
-		return clk_status(clk->get_parent(clk));
+void clk_handle_set_rate(struct clk_t * clk, u64_t rate)
+{
+	struct clk_t * pclk;
 
-	return FALSE;
+	if(clk && clk->set_rate)
+	{
+		pclk = clk_handle_get_parent(clk);
+		clk_change_begin(clk);
+		clk->set_rate(clk, pclk ? clk_handle_get_rate(pclk) : 0, rate);
+		clk_change_end(clk);
+	}
 }
 
-void clk_set_rate(const char * name, u64_t rate)
+u64_t clk_handle_get_rate(struct clk_t * clk)
 {
-	struct clk_t * clk = search_clk(name);
+	struct clk_t * pclk;
 	u64_t prate;
 
 	if(!clk)
-		return;
+		return 0;
 
-	if(clk->get_parent)
-		prate = clk_get_rate(clk->get_parent(clk));
-	else
-		prate = 0;
+	if(!clk->rvalid)
+	{
+		pclk = clk_handle_get_parent(clk);
+		prate = pclk ? clk_handle_get_rate(pclk) : 0;
+		clk->rate = clk->get_rate ? clk->get_rate(clk, prate) : 0;
+		clk->rvalid = (clk->pvalid && (!pclk || pclk->rvalid)) ? TRUE : FALSE;
+	}
+	return clk->rate;
+}
 
-	if(clk->set_rate)
-		clk->set_rate(clk, prate, rate);
+/*
+ * For code that reprograms clock registers behind the framework's back,
+ * reread the subtree and notify the consumers whose rate has moved.
+ */
+void clk_handle_recalc_rate(struct clk_t * clk)
+{
+	if(clk)
+	{
+		clk_change_begin(clk);
+		clk->pvalid = FALSE;
+		clk_change_end(clk);
+	}
 }
 
-u64_t clk_get_rate(const char * name)
+bool_t clk_handle_register_notifier(struct clk_t * clk, struct notifier_t * n)
 {
-	struct clk_t * clk = search_clk(name);
-	u64_t prate;
+	if(!clk || !n || !n->call)
+		return FALSE;
+	return notifier_chain_register(&clk->nc, n);
+}
 
-	if(!clk)
-		return 0;
+bool_t clk_handle_unregister_notifier(struct clk_t * clk, struct notifier_t * n)
+{
+	if(!clk || !n)
+		return FALSE;
+	return notifier_chain_unregister(&clk->nc, n);
+}
 
-	if(clk->get_parent)
-		prate = clk_get_rate(clk->get_parent(clk));
-	else
-		prate = 0;
+void clk_set_parent(const char * name, const char * pname)
+{
+	clk_handle_set_parent(search_clk(name), search_clk(pname));
+}
 
-	if(clk->get_rate)
-		return clk->get_rate(clk, prate);
+const char * clk_get_parent(const char * name)
+{
+	struct clk_t * pclk = clk_handle_get_parent(search_clk(name));
+	return pclk ? pclk->name : NULL;
+}
 
-	return 0;
+void clk_enable(const char * name)
+{
+	clk_handle_enable(search_clk(name));
+}
+
+void clk_disable(const char * name)
+{
+	clk_handle_disable(search_clk(name));
+}
+
+bool_t clk_status(const char * name)
+{
+	return clk_handle_status(search_clk(name));
+}
+
+void clk_set_rate(const char * name, u64_t rate)
+{
+	clk_handle_set_rate(search_clk(name), rate);
+}
+
+u64_t clk_get_rate(const char * name)
+{
+	return clk_handle_get_rate(search_clk(name));
 }
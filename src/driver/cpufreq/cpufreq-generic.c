@@ -0,0 +1,258 @@
+/*
+ * driver/cpufreq/cpufreq-generic.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <clk/clk.h>
+#include <regulator/regulator.h>
+#include <cpufreq/cpufreq.h>
+
+/*
+ * Generic cpu frequency scaling on a clk and an optional regulator
+ *
+ * Without a clock the table is only simulated, transitions always succeed
+ * and nothing is touched, which is how the sandbox exercises the governor.
+ *
+ * Required properties:
+ * - opp: operating points, frequency in hz and voltage in uv
+ *
+ * Optional properties:
+ * - clock-name: cpu clock, the table is simulated without it
+ * - regulator-name: cpu supply
+ * - voltage-step-uv: largest single voltage change, zero for one step
+ * - sampling-ms: load sampling interval
+ * - up-threshold: load percentage that jumps to the top point
+ * - down-threshold: load percentage under which to step down
+ *
+ * Example:
+ *   "cpufreq-generic@0": {
+ *       "clock-name": "pll-cpu",
+ *       "regulator-name": "dcdc2",
+ *       "voltage-step-uv": 50000,
+ *       "sampling-ms": 50,
+ *       "up-threshold": 80,
+ *       "down-threshold": 30,
+ *       "opp": [
+ *           { "frequency": 408000000, "voltage": 1000000 },
+ *           { "frequency": 816000000, "voltage": 1100000 },
+ *           { "frequency": 1200000000, "voltage": 1320000 }
+ *       ]
+ *   }
+ */
+
+struct cpufreq_generic_pdata_t {
+	struct clk_t * clk;
+	char * regulator;
+	int step;
+};
+
+static void cpufreq_generic_set_voltage(struct cpufreq_generic_pdata_t * pdat, int voltage)
+{
+	int v;
+
+	if(!pdat->regulator || (voltage <= 0))
+		return;
+
+	v = regulator_get_voltage(pdat->regulator);
+	if((pdat->step > 0) && (v > 0))
+	{
+		while(v + pdat->step < voltage)
+		{
+			v += pdat->step;
+			regulator_set_voltage(pdat->regulator, v);
+		}
+		while(v - pdat->step > voltage)
+		{
+			v -= pdat->step;
+			regulator_set_voltage(pdat->regulator, v);
+		}
+	}
+	regulator_set_voltage(pdat->regulator, voltage);
+}
+
+static bool_t cpufreq_generic_transition(struct cpufreq_t * f, int from, int to)
+{
+	struct cpufreq_generic_pdata_t * pdat = (struct cpufreq_generic_pdata_t *)f->priv;
+
+	if(!pdat->clk)
+		return TRUE;
+
+	/*
+	 * Raise the voltage before the clock and lower it after.
+	 */
+	if(to > from)
+		cpufreq_generic_set_voltage(pdat, f->opp[to].voltage);
+	clk_handle_set_rate(pdat->clk, f->opp[to].frequency);
+	if(to < from)
+		cpufreq_generic_set_voltage(pdat, f->opp[to].voltage);
+	return TRUE;
+}
+
+static struct device_t * cpufreq_generic_probe(struct driver_t * drv, struct dtnode_t * n)
+{
+	struct cpufreq_generic_pdata_t * pdat;
+	struct cpufreq_opp_t * opp, t;
+	struct cpufreq_t * f;
+	struct device_t * dev;
+	struct dtnode_t o;
+	char * clock = dt_read_string(n, "clock-name", NULL);
+	char * regulator = dt_read_string(n, "regulator-name", NULL);
+	struct clk_t * clk = NULL;
+	int nopp = dt_read_array_length(n, "opp");
+	u64_t rate;
+	int i, j;
+
+	if(nopp <= 0)
+		return NULL;
+
+	if(clock && !(clk = search_clk(clock)))
+		return NULL;
+
+	if(regulator && !search_regulator(regulator))
+		return NULL;
+
+	opp = malloc(sizeof(struct cpufreq_opp_t) * nopp);
+	if(!opp)
+		return NULL;
+
+	for(i = 0; i < nopp; i++)
+	{
+		if(!dt_read_array_object(n, "opp", i, &o))
+		{
+			free(opp);
+			return NULL;
+		}
+		t.frequency = (u64_t)dt_read_long(&o, "frequency", 0);
+		t.voltage = dt_read_int(&o, "voltage", 0);
+		if(t.frequency == 0)
+		{
+			free(opp);
+			return NULL;
+		}
+		for(j = i; (j > 0) && (opp[j - 1].frequency > t.frequency); j--)
+			opp[j] = opp[j - 1];
+		opp[j] = t;
+	}
+
+	pdat = malloc(sizeof(struct cpufreq_generic_pdata_t));
+	if(!pdat)
+	{
+		free(opp);
+		return NULL;
+	}
+
+	f = malloc(sizeof(struct cpufreq_t));
+	if(!f)
+	{
+		free(pdat);
+		free(opp);
+		return NULL;
+	}
+
+	pdat->clk = clk;
+	pdat->regulator = regulator ? strdup(regulator) : NULL;
+	pdat->step = dt_read_int(n, "voltage-step-uv", 0);
+
+	f->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
+	f->opp = opp;
+	f->nopp = nopp;
+	f->transition = cpufreq_generic_transition;
+	f->priv = pdat;
+
+	/*
+	 * Start from the highest point not above the current rate, simulated
+	 * tables start from the top as a board would after boot.
+	 */
+	f->cur = nopp - 1;
+	if(clk)
+	{
+		rate = clk_handle_get_rate(clk);
+		for(i = nopp - 1; (i > 0) && (opp[i].frequency > rate); i--);
+		f->cur = i;
+	}
+
+	if(!register_cpufreq(&dev, f, dt_read_int(n, "sampling-ms", 50), dt_read_int(n, "up-threshold", 80), dt_read_int(n, "down-threshold", 30)))
+	{
+		if(pdat->regulator)
+			free(pdat->regulator);
+
+		free_device_name(f->name);
+		free(f->opp);
+		free(f->priv);
+		free(f);
+		return NULL;
+	}
+	dev->driver = drv;
+
+	return dev;
+}
+
+static void cpufreq_generic_remove(struct device_t * dev)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)dev->priv;
+	struct cpufreq_generic_pdata_t * pdat = (struct cpufreq_generic_pdata_t *)f->priv;
+
+	if(f && unregister_cpufreq(f))
+	{
+		if(pdat->regulator)
+			free(pdat->regulator);
+
+		free_device_name(f->name);
+		free(f->opp);
+		free(f->priv);
+		free(f);
+	}
+}
+
+static void cpufreq_generic_suspend(struct device_t * dev)
+{
+}
+
+static void cpufreq_generic_resume(struct device_t * dev)
+{
+}
+
+static struct driver_t cpufreq_generic = {
+	.name		= "cpufreq-generic",
+	.probe		= cpufreq_generic_probe,
+	.remove		= cpufreq_generic_remove,
+	.suspend	= cpufreq_generic_suspend,
+	.resume		= cpufreq_generic_resume,
+};
+
+static __init void cpufreq_generic_driver_init(void)
+{
+	register_driver(&cpufreq_generic);
+}
+
+static __exit void cpufreq_generic_driver_exit(void)
+{
+	unregister_driver(&cpufreq_generic);
+}
+
+driver_initcall(cpufreq_generic_driver_init);
+driver_exitcall(cpufreq_generic_driver_exit);
@@ -0,0 +1,374 @@
+/*
+ * driver/cpufreq/cpufreq.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <xboot/idle.h>
+#include <cpufreq/cpufreq.h>
+
+static struct cpufreq_t * __cpufreq = NULL;
+
+static void cpufreq_residency_update(struct cpufreq_t * f, ktime_t now)
+{
+	f->residency[f->cur] += ktime_to_ns(ktime_sub(now, f->residency_stamp));
+	f->residency_stamp = now;
+}
+
+static int cpufreq_timer_function(struct timer_t * timer, void * data)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)(data);
+	ktime_t now = ktime_get();
+	s64_t window = ktime_to_ns(ktime_sub(now, f->window_stamp));
+	s64_t idle = f->idle_ns;
+	u64_t need;
+	int load, i;
+
+	if(f->idle)
+	{
+		idle += ktime_to_ns(ktime_sub(now, f->idle_stamp));
+		f->idle_stamp = now;
+	}
+	f->idle_ns = 0;
+	f->window_stamp = now;
+	if(window <= 0)
+		return 1;
+	if(idle > window)
+		idle = window;
+
+	load = (f->simulate >= 0) ? f->simulate : (int)(100 - idle * 100 / window);
+	f->load = load;
+	cpufreq_residency_update(f, now);
+
+	if(ktime_before(now, f->boost) || (load >= f->up))
+	{
+		f->target = f->nopp - 1;
+	}
+	else if(load < f->down)
+	{
+		need = f->opp[f->cur].frequency * load / f->up;
+		for(i = 0; i < f->cur; i++)
+		{
+			if(f->opp[i].frequency >= need)
+				break;
+		}
+		f->target = i;
+	}
+
+	timer_forward_now(timer, f->interval);
+	return 1;
+}
+
+/*
+ * Runs from the idle hooks, in thread context.
+ */
+static void cpufreq_update(struct cpufreq_t * f)
+{
+	irq_flags_t flags;
+	int from, to;
+
+	from = f->cur;
+	to = f->target;
+	if(from == to)
+		return;
+
+	if(f->transition && !f->transition(f, from, to))
+	{
+		f->target = from;
+		return;
+	}
+
+	spin_lock_irqsave(&f->lock, flags);
+	cpufreq_residency_update(f, ktime_get());
+	f->cur = to;
+	f->transitions++;
+	spin_unlock_irqrestore(&f->lock, flags);
+}
+
+void cpufreq_idle_enter(void)
+{
+	struct cpufreq_t * f = __cpufreq;
+
+	if(f && !f->idle)
+	{
+		cpufreq_update(f);
+		f->idle_stamp = ktime_get();
+		f->idle = 1;
+	}
+}
+
+void cpufreq_idle_exit(void)
+{
+	struct cpufreq_t * f = __cpufreq;
+	irq_flags_t flags;
+
+	if(f && f->idle)
+	{
+		spin_lock_irqsave(&f->lock, flags);
+		f->idle_ns += ktime_to_ns(ktime_sub(ktime_get(), f->idle_stamp));
+		f->idle = 0;
+		spin_unlock_irqrestore(&f->lock, flags);
+		cpufreq_update(f);
+	}
+}
+
+static void cpufreq_idle_hook_enter(void * data)
+{
+	cpufreq_idle_enter();
+}
+
+static void cpufreq_idle_hook_exit(void * data)
+{
+	cpufreq_idle_exit();
+}
+
+static struct idle_hook_t __cpufreq_idle = {
+	.enter = cpufreq_idle_hook_enter,
+	.exit = cpufreq_idle_hook_exit,
+};
+
+void cpufreq_boost(int ms)
+{
+	struct cpufreq_t * f = __cpufreq;
+	irq_flags_t flags;
+	ktime_t until;
+
+	if(f && (ms > 0))
+	{
+		until = ktime_add_ms(ktime_get(), ms);
+		spin_lock_irqsave(&f->lock, flags);
+		if(ktime_after(until, f->boost))
+			f->boost = until;
+		f->target = f->nopp - 1;
+		spin_unlock_irqrestore(&f->lock, flags);
+	}
+}
+
+/*
+ * A frame that overran its deadline by more than a quarter boosts for a
+ * few frames, so that the next ones get the headroom before the load
+ * figure of the current window catches up.
+ */
+void cpufreq_frame_hint(s64_t frame_ns, s64_t deadline_ns)
+{
+	if((deadline_ns > 0) && (frame_ns > deadline_ns + (deadline_ns >> 2)))
+		cpufreq_boost((int)(deadline_ns * 8 / 1000000));
+}
+
+static ssize_t cpufreq_read_frequency(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)kobj->priv;
+	u64_t rate = f->opp[f->cur].frequency;
+	return sprintf(buf, "%Ld.%06LdMHZ", rate / (u64_t)(1000 * 1000), rate % (u64_t)(1000 * 1000));
+}
+
+static ssize_t cpufreq_read_load(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)kobj->priv;
+	return sprintf(buf, "%d%%", f->load);
+}
+
+static ssize_t cpufreq_read_opp(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)kobj->priv;
+	char * p = buf;
+	int len = 0;
+	int i;
+
+	len += sprintf((char *)(p + len), " %-2s %16s %10s\r\n", "", "frequency", "voltage");
+	for(i = 0; i < f->nopp; i++)
+		len += sprintf((char *)(p + len), "%c%-2d %6Ld.%06LdMHZ %8duV\r\n", (i == f->cur) ? '*' : ' ', i, f->opp[i].frequency / (u64_t)(1000 * 1000), f->opp[i].frequency % (u64_t)(1000 * 1000), f->opp[i].voltage);
+	return len;
+}
+
+static ssize_t cpufreq_read_residency(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)kobj->priv;
+	irq_flags_t flags;
+	char * p = buf;
+	u64_t total = 0;
+	int len = 0;
+	int i;
+
+	spin_lock_irqsave(&f->lock, flags);
+	cpufreq_residency_update(f, ktime_get());
+	spin_unlock_irqrestore(&f->lock, flags);
+
+	for(i = 0; i < f->nopp; i++)
+		total += f->residency[i];
+	if(total == 0)
+		total = 1;
+	len += sprintf((char *)(p + len), "%-3s %16s %12s %6s\r\n", "opp", "frequency", "time", "ratio");
+	for(i = 0; i < f->nopp; i++)
+		len += sprintf((char *)(p + len), "%-3d %6Ld.%06LdMHZ %10Ldms %5Ld%%\r\n", i, f->opp[i].frequency / (u64_t)(1000 * 1000), f->opp[i].frequency % (u64_t)(1000 * 1000), f->residency[i] / (u64_t)(1000 * 1000), f->residency[i] * 100 / total);
+	len += sprintf((char *)(p + len), "transitions %d\r\n", f->transitions);
+	return len;
+}
+
+static ssize_t cpufreq_write_boost(struct kobj_t * kobj, void * buf, size_t size)
+{
+	cpufreq_boost(strtol(buf, NULL, 0));
+	return size;
+}
+
+static ssize_t cpufreq_read_simulate(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)kobj->priv;
+	return sprintf(buf, "%d", f->simulate);
+}
+
+/*
+ * Replace the measured load by a fixed percentage, a negative value goes
+ * back to measuring. Meant for exercising the policy without real load.
+ */
+static ssize_t cpufreq_write_simulate(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct cpufreq_t * f = (struct cpufreq_t *)kobj->priv;
+	int load = strtol(buf, NULL, 0);
+	f->simulate = (load > 100) ? 100 : ((load < 0) ? -1 : load);
+	return size;
+}
+
+struct cpufreq_t * search_cpufreq(const char * name)
+{
+	struct device_t * dev;
+
+	dev = search_device(name, DEVICE_TYPE_CPUFREQ);
+	if(!dev)
+		return NULL;
+	return (struct cpufreq_t *)dev->priv;
+}
+
+struct cpufreq_t * search_first_cpufreq(void)
+{
+	struct device_t * dev;
+
+	dev = search_first_device(DEVICE_TYPE_CPUFREQ);
+	if(!dev)
+		return NULL;
+	return (struct cpufreq_t *)dev->priv;
+}
+
+bool_t register_cpufreq(struct device_t ** device, struct cpufreq_t * f, int ms, int up, int down)
+{
+	struct device_t * dev;
+	int i;
+
+	if(!f || !f->name || !f->opp || (f->nopp <= 0))
+		return FALSE;
+
+	f->residency = malloc(sizeof(u64_t) * f->nopp);
+	if(!f->residency)
+		return FALSE;
+
+	dev = malloc(sizeof(struct device_t));
+	if(!dev)
+	{
+		free(f->residency);
+		return FALSE;
+	}
+
+	for(i = 0; i < f->nopp; i++)
+		f->residency[i] = 0;
+	f->interval = ms_to_ktime(ms > 0 ? ms : 50);
+	spin_lock_init(&f->lock);
+	f->up = (up > 0 && up <= 100) ? up : 80;
+	f->down = (down >= 0 && down <= f->up) ? down : f->up / 2;
+	f->target = f->cur;
+	f->load = 0;
+	f->simulate = -1;
+	f->boost = ktime_get();
+	f->idle = 0;
+	f->idle_stamp = f->boost;
+	f->window_stamp = f->boost;
+	f->idle_ns = 0;
+	f->residency_stamp = f->boost;
+	f->transitions = 0;
+	timer_init(&f->timer, cpufreq_timer_function, f);
+
+	dev->name = strdup(f->name);
+	dev->type = DEVICE_TYPE_CPUFREQ;
+	dev->driver = NULL;
+	dev->priv = f;
+	dev->kobj = kobj_alloc_directory(dev->name);
+	kobj_add_regular(dev->kobj, "frequency", cpufreq_read_frequency, NULL, f);
+	kobj_add_regular(dev->kobj, "load", cpufreq_read_load, NULL, f);
+	kobj_add_regular(dev->kobj, "opp", cpufreq_read_opp, NULL, f);
+	kobj_add_regular(dev->kobj, "residency", cpufreq_read_residency, NULL, f);
+	kobj_add_regular(dev->kobj, "boost", NULL, cpufreq_write_boost, f);
+	kobj_add_regular(dev->kobj, "simulate", cpufreq_read_simulate, cpufreq_write_simulate, f);
+
+	if(!register_device(dev))
+	{
+		kobj_remove_self(dev->kobj);
+		free(dev->name);
+		free(dev);
+		free(f->residency);
+		return FALSE;
+	}
+
+	/*
+	 * There is one cpu, the first governor registered drives it.
+	 */
+	if(!__cpufreq)
+	{
+		__cpufreq = f;
+		timer_start_now(&f->timer, f->interval);
+		register_idle_hook(&__cpufreq_idle);
+	}
+
+	if(device)
+		*device = dev;
+	return TRUE;
+}
+
+bool_t unregister_cpufreq(struct cpufreq_t * f)
+{
+	struct device_t * dev;
+
+	if(!f || !f->name)
+		return FALSE;
+
+	dev = search_device(f->name, DEVICE_TYPE_CPUFREQ);
+	if(!dev)
+		return FALSE;
+
+	if(!unregister_device(dev))
+		return FALSE;
+
+	if(__cpufreq == f)
+	{
+		unregister_idle_hook(&__cpufreq_idle);
+		timer_cancel(&f->timer);
+		__cpufreq = NULL;
+	}
+
+	kobj_remove_self(dev->kobj);
+	free(dev->name);
+	free(dev);
+	free(f->residency);
+	return TRUE;
+}
@@ -0,0 +1,312 @@
+/*
+ * driver/dac/waveform.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <dac/waveform.h>
+
+static inline u32_t waveform_next_stream(struct dac_waveform_t * w, u32_t last)
+{
+	int b = w->cur;
+	u32_t v;
+
+	if(!w->ready[b])
+	{
+		if(!w->starved)
+		{
+			w->starved = 1;
+			w->underrun++;
+		}
+		return last;
+	}
+	w->starved = 0;
+	v = w->block[b][w->pos++];
+	if(w->pos >= w->len[b])
+	{
+		w->pos = 0;
+		w->ready[b] = 0;
+		w->cur = b ^ 1;
+		if(w->refill)
+		{
+			w->refill(w, w->block[b], w->size);
+			w->len[b] = w->size;
+			w->ready[b] = 1;
+		}
+	}
+	return v;
+}
+
+static int waveform_timer_function(struct timer_t * timer, void * data)
+{
+	struct dac_waveform_t * w = (struct dac_waveform_t *)(data);
+	irq_flags_t flags;
+	ktime_t now;
+	u32_t v;
+
+	if(!w->running)
+		return 0;
+
+	if(w->mode == DAC_WAVEFORM_DDS)
+	{
+		v = w->table[w->acc >> w->shift];
+		w->acc += w->tuning;
+	}
+	else
+	{
+		spin_lock_irqsave(&w->lock, flags);
+		v = waveform_next_stream(w, w->level);
+		spin_unlock_irqrestore(&w->lock, flags);
+	}
+	if((v != w->level) || (w->count == 0))
+		w->dac->write(w->dac, w->channel, v);
+	w->level = v;
+	w->count++;
+
+	now = ktime_get();
+	timer_forward(timer, timer->expires, w->interval);
+	if(ktime_before(timer->expires, now))
+	{
+		w->missed++;
+		timer_forward(timer, now, w->interval);
+	}
+	return 1;
+}
+
+struct dac_waveform_t * dac_waveform_alloc(struct dac_t * dac, int channel)
+{
+	struct dac_waveform_t * w;
+
+	if(!dac || !dac->write || (channel < 0) || (channel >= dac->nchannel))
+		return NULL;
+
+	w = malloc(sizeof(struct dac_waveform_t));
+	if(!w)
+		return NULL;
+
+	memset(w, 0, sizeof(struct dac_waveform_t));
+	w->dac = dac;
+	w->channel = channel;
+	w->max = (dac->resolution >= 32) ? 0xffffffff : (u32_t)((1ULL << dac->resolution) - 1);
+	spin_lock_init(&w->lock);
+	timer_init(&w->timer, waveform_timer_function, w);
+	return w;
+}
+
+void dac_waveform_free(struct dac_waveform_t * w)
+{
+	if(w)
+	{
+		dac_waveform_stop(w);
+		free(w->block[0]);
+		free((void *)w->table);
+		free(w);
+	}
+}
+
+static void waveform_run(struct dac_waveform_t * w, int rate)
+{
+	w->rate = rate;
+	w->interval = ns_to_ktime(1000000000ULL / rate);
+	w->count = 0;
+	w->underrun = 0;
+	w->missed = 0;
+	w->running = 1;
+	timer_start_now(&w->timer, w->interval);
+}
+
+/*
+ * Stream mode with two blocks of size samples. With a refill callback both
+ * blocks are filled up front, otherwise output starts once the first block
+ * has been written.
+ */
+bool_t dac_waveform_start(struct dac_waveform_t * w, int rate, int size)
+{
+	u32_t * buf;
+
+	if(!w || (rate <= 0) || (size <= 0))
+		return FALSE;
+
+	dac_waveform_stop(w);
+	if(size != w->size)
+	{
+		buf = malloc(sizeof(u32_t) * size * 2);
+		if(!buf)
+			return FALSE;
+		free(w->block[0]);
+		w->block[0] = buf;
+		w->block[1] = buf + size;
+		w->size = size;
+	}
+	w->mode = DAC_WAVEFORM_STREAM;
+	w->ready[0] = w->ready[1] = 0;
+	w->len[0] = w->len[1] = 0;
+	w->cur = w->pos = 0;
+	w->fill = w->fillpos = 0;
+	w->starved = 1;
+	if(w->refill)
+	{
+		w->refill(w, w->block[0], size);
+		w->refill(w, w->block[1], size);
+		w->len[0] = w->len[1] = size;
+		w->ready[0] = w->ready[1] = 1;
+	}
+	waveform_run(w, rate);
+	return TRUE;
+}
+
+/*
+ * DDS mode, table holds len raw samples of one period and len must be a
+ * power of two. Frequency is in millihertz, phase in 1/2^32 of a period.
+ */
+bool_t dac_waveform_start_dds(struct dac_waveform_t * w, int rate, const u32_t * table, int len, u32_t mhz, u32_t phase)
+{
+	u32_t * t;
+	int i;
+
+	if(!w || !table || (rate <= 0) || (len < 2) || (len & (len - 1)))
+		return FALSE;
+
+	dac_waveform_stop(w);
+	t = malloc(sizeof(u32_t) * len);
+	if(!t)
+		return FALSE;
+	for(i = 0; i < len; i++)
+		t[i] = (table[i] > w->max) ? w->max : table[i];
+	free((void *)w->table);
+	w->table = t;
+	w->shift = 32 - __ffs(len);
+	w->mode = DAC_WAVEFORM_DDS;
+	w->rate = rate;
+	w->acc = phase;
+	dac_waveform_set_frequency(w, mhz);
+	waveform_run(w, rate);
+	return TRUE;
+}
+
+void dac_waveform_stop(struct dac_waveform_t * w)
+{
+	if(w && w->running)
+	{
+		w->running = 0;
+		timer_cancel(&w->timer);
+	}
+}
+
+/*
+ * Queue samples into the idle block, returns how many were taken. A block
+ * goes out once full, dac_waveform_flush sends a partial one.
+ */
+int dac_waveform_write(struct dac_waveform_t * w, const u32_t * samples, int n)
+{
+	irq_flags_t flags;
+	u32_t * p;
+	int done = 0;
+	int b, c, i;
+
+	if(!w || !samples || (w->mode != DAC_WAVEFORM_STREAM) || !w->size)
+		return 0;
+
+	spin_lock_irqsave(&w->lock, flags);
+	while(done < n)
+	{
+		b = w->fill;
+		if(w->ready[b])
+			break;
+		c = w->size - w->fillpos;
+		if(c > n - done)
+			c = n - done;
+		p = &w->block[b][w->fillpos];
+		for(i = 0; i < c; i++)
+			p[i] = (samples[done + i] > w->max) ? w->max : samples[done + i];
+		w->fillpos += c;
+		done += c;
+		if(w->fillpos >= w->size)
+		{
+			w->len[b] = w->size;
+			w->ready[b] = 1;
+			w->fill = b ^ 1;
+			w->fillpos = 0;
+		}
+	}
+	spin_unlock_irqrestore(&w->lock, flags);
+	return done;
+}
+
+void dac_waveform_flush(struct dac_waveform_t * w)
+{
+	irq_flags_t flags;
+	int b;
+
+	if(!w || (w->mode != DAC_WAVEFORM_STREAM))
+		return;
+
+	spin_lock_irqsave(&w->lock, flags);
+	b = w->fill;
+	if(!w->ready[b] && (w->fillpos > 0))
+	{
+		w->len[b] = w->fillpos;
+		w->ready[b] = 1;
+		w->fill = b ^ 1;
+		w->fillpos = 0;
+	}
+	spin_unlock_irqrestore(&w->lock, flags);
+}
+
+/*
+ * Samples dac_waveform_write would take right now
+ */
+int dac_waveform_space(struct dac_waveform_t * w)
+{
+	irq_flags_t flags;
+	int b, space = 0;
+
+	if(!w || (w->mode != DAC_WAVEFORM_STREAM))
+		return 0;
+
+	spin_lock_irqsave(&w->lock, flags);
+	b = w->fill;
+	if(!w->ready[b])
+	{
+		space = w->size - w->fillpos;
+		if(!w->ready[b ^ 1])
+			space += w->size;
+	}
+	spin_unlock_irqrestore(&w->lock, flags);
+	return space;
+}
+
+void dac_waveform_set_frequency(struct dac_waveform_t * w, u32_t mhz)
+{
+	if(w && (w->rate > 0))
+		w->tuning = (u32_t)(((u64_t)mhz << 32) / ((u64_t)w->rate * 1000));
+}
+
+void dac_waveform_set_phase(struct dac_waveform_t * w, u32_t phase)
+{
+	if(w)
+		w->acc = phase;
+}
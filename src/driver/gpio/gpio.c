@@ -40,16 +40,27 @@ static ssize_t gpiochip_read_ngpio(struct kobj_t * kobj, void * buf, size_t size
 	return sprintf(buf, "%d", chip->ngpio);
 }
 
+/*
+ * Consecutive calls mostly hit the same chip, remember the last match.
+ */
+static struct gpiochip_t * __gpiochip_last = NULL;
+
 struct gpiochip_t * search_gpiochip(int gpio)
 {
 	struct device_t * pos, * n;
-	struct gpiochip_t * chip;
+	struct gpiochip_t * chip = __gpiochip_last;
+
+	if(chip && (gpio >= chip->base) && (gpio < (chip->base + chip->ngpio)))
+		return chip;
 
 	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_GPIOCHIP], head)
 	{
 		chip = (struct gpiochip_t *)(pos->priv);
 		if((gpio >= chip->base) && (gpio < (chip->base + chip->ngpio)))
+		{
+			__gpiochip_last = chip;
 			return chip;
+		}
 	}
 	return NULL;
 }
@@ -106,6 +117,9 @@ bool_t unregister_gpiochip(struct gpiochip_t * chip)
 	if(!unregister_device(dev))
 		return FALSE;
 
+	if(__gpiochip_last == chip)
+		__gpiochip_last = NULL;
+
 	kobj_remove_self(dev->kobj);
 	free(dev->name);
 	free(dev);
@@ -254,3 +268,157 @@ int gpio_to_irq(int gpio)
 		return chip->to_irq(chip, gpio - chip->base);
 	return -1;
 }
+
+static void gpio_event_interrupt(void * data)
+{
+	int gpio = (int)(unsigned long)data;
+	push_event_gpio_edge(search_gpiochip(gpio), gpio, gpio_get_value(gpio));
+}
+
+/*
+ * Publish edges of an input gpio as EVENT_TYPE_GPIO_EDGE, the gpio chip
+ * must be able to route the pin to an interrupt.
+ */
+bool_t gpio_event_enable(int gpio, enum irq_type_t type)
+{
+	int irq = gpio_to_irq(gpio);
+
+	if(irq < 0)
+		return FALSE;
+	return request_irq(irq, gpio_event_interrupt, type, (void *)(unsigned long)gpio);
+}
+
+void gpio_event_disable(int gpio)
+{
+	int irq = gpio_to_irq(gpio);
+
+	if(irq >= 0)
+		free_irq(irq);
+}
+
+bool_t gpio_desc_init(struct gpio_desc_t * desc, int gpio)
+{
+	struct gpiochip_t * chip = (gpio >= 0) ? search_gpiochip(gpio) : NULL;
+
+	desc->chip = chip;
+	desc->offset = chip ? gpio - chip->base : 0;
+	desc->gpio = gpio;
+	return chip ? TRUE : FALSE;
+}
+
+void gpio_desc_set_cfg(struct gpio_desc_t * desc, int cfg)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(chip && chip->set_cfg)
+		chip->set_cfg(chip, desc->offset, cfg);
+}
+
+void gpio_desc_set_pull(struct gpio_desc_t * desc, enum gpio_pull_t pull)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(chip && chip->set_pull)
+		chip->set_pull(chip, desc->offset, pull);
+}
+
+void gpio_desc_set_direction(struct gpio_desc_t * desc, enum gpio_direction_t dir)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(chip && chip->set_dir)
+		chip->set_dir(chip, desc->offset, dir);
+}
+
+void gpio_desc_direction_output(struct gpio_desc_t * desc, int value)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(!chip)
+		return;
+
+	if(chip->set_dir)
+		chip->set_dir(chip, desc->offset, GPIO_DIRECTION_OUTPUT);
+	if(chip->set_value)
+		chip->set_value(chip, desc->offset, value);
+}
+
+int gpio_desc_direction_input(struct gpio_desc_t * desc)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(chip)
+	{
+		if(chip->set_dir)
+			chip->set_dir(chip, desc->offset, GPIO_DIRECTION_INPUT);
+		if(chip->get_value)
+			return chip->get_value(chip, desc->offset);
+	}
+	return 0;
+}
+
+static inline u32_t gpiochip_port_mask(struct gpiochip_t * chip)
+{
+	return (chip->ngpio >= 32) ? 0xffffffff : ((1 << chip->ngpio) - 1);
+}
+
+/*
+ * Drive the pins selected by mask to the matching bits of value, pins
+ * outside of mask keep their level.
+ */
+void gpiochip_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value)
+{
+	int offset;
+
+	if(!chip)
+		return;
+
+	mask &= gpiochip_port_mask(chip);
+	if(!mask)
+		return;
+
+	if(chip->set_port)
+	{
+		chip->set_port(chip, mask, value);
+	}
+	else if(chip->set_value)
+	{
+		while(mask)
+		{
+			offset = __ffs(mask);
+			chip->set_value(chip, offset, (value >> offset) & 0x1);
+			mask &= mask - 1;
+		}
+	}
+}
+
+/*
+ * Sample the pins selected by mask, the other bits read as zero.
+ */
+u32_t gpiochip_get_port(struct gpiochip_t * chip, u32_t mask)
+{
+	u32_t value = 0;
+	int offset;
+
+	if(!chip)
+		return 0;
+
+	mask &= gpiochip_port_mask(chip);
+	if(!mask)
+		return 0;
+
+	if(chip->get_port)
+		return chip->get_port(chip) & mask;
+
+	if(chip->get_value)
+	{
+		while(mask)
+		{
+			offset = __ffs(mask);
+			if(chip->get_value(chip, offset))
+				value |= 1 << offset;
+			mask &= mask - 1;
+		}
+	}
+	return value;
+}
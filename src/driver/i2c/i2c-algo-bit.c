@@ -27,6 +27,7 @@
  */
 
 #include <xboot.h>
+#include <interrupt/interrupt.h>
 #include <i2c/i2c-algo-bit.h>
 
 static inline void sdalo(struct i2c_algo_bit_data_t * bdat)
@@ -307,12 +308,40 @@ static int bit_do_address(struct i2c_algo_bit_data_t * bdat, struct i2c_msg_t *
 	return 0;
 }
 
+/*
+ * Wait for a transfer on the asynchronous engine to finish and hold the
+ * engine off while the synchronous transfer runs. The engine only moves
+ * from its timer, so in interrupt context a busy bus fails at once.
+ */
+static int algo_bit_claim(struct i2c_algo_bit_data_t * bdat)
+{
+	ktime_t timeout = ktime_add_ms(ktime_get(), 1000);
+	irq_flags_t flags;
+
+	for(;;)
+	{
+		local_irq_save(flags);
+		if(!bdat->busy)
+		{
+			bdat->busy = 1;
+			local_irq_restore(flags);
+			return 1;
+		}
+		local_irq_restore(flags);
+		if(in_interrupt() || ktime_after(ktime_get(), timeout))
+			return 0;
+	}
+}
+
 int i2c_algo_bit_xfer(struct i2c_algo_bit_data_t * bdat, struct i2c_msg_t * msgs, int num)
 {
 	struct i2c_msg_t * pmsg;
 	int i, ret;
 	unsigned short nak_ok;
 
+	if(!algo_bit_claim(bdat))
+		return -1;
+
 	i2c_start(bdat);
 	for(i = 0; i < num; i++)
 	{
@@ -355,5 +384,349 @@ int i2c_algo_bit_xfer(struct i2c_algo_bit_data_t * bdat, struct i2c_msg_t * msgs
 
 bailout:
 	i2c_stop(bdat);
+	bdat->busy = 0;
 	return ret;
 }
+
+/*
+ * Asynchronous engine. A bit goes through four phases, data setup, clock
+ * high, sample and clock low, one phase per timer tick and no delay within
+ * a tick. The tick interval is the half cycle with a floor, so the bus
+ * runs slower than the udelay based code instead of raising the interrupt
+ * rate. A stretched clock is checked again on the next tick.
+ */
+#define ALGO_BIT_MIN_INTERVAL_US	(50)
+
+enum {
+	ALGO_BIT_START,
+	ALGO_BIT_ADDRESS,
+	ALGO_BIT_WRITE,
+	ALGO_BIT_READ,
+	ALGO_BIT_STOP,
+};
+
+static void algo_bit_fail(struct i2c_algo_bit_data_t * bdat)
+{
+	bdat->ret = -1;
+	bdat->state = ALGO_BIT_STOP;
+	bdat->phase = 0;
+}
+
+static void algo_bit_next_msg(struct i2c_algo_bit_data_t * bdat);
+
+static void algo_bit_begin_data(struct i2c_algo_bit_data_t * bdat)
+{
+	struct i2c_msg_t * msg = &bdat->msgs[bdat->index];
+
+	bdat->count = 0;
+	if(msg->len <= 0)
+	{
+		algo_bit_next_msg(bdat);
+		return;
+	}
+	bdat->state = (msg->flags & I2C_M_RD) ? ALGO_BIT_READ : ALGO_BIT_WRITE;
+	bdat->shift = (msg->flags & I2C_M_RD) ? 0 : ((u8_t *)msg->buf)[0];
+	bdat->bit = 7;
+	bdat->phase = 0;
+}
+
+static void algo_bit_next_msg(struct i2c_algo_bit_data_t * bdat)
+{
+	struct i2c_msg_t * msg;
+
+	if(++bdat->index >= bdat->num)
+	{
+		bdat->ret = bdat->num;
+		bdat->state = ALGO_BIT_STOP;
+		bdat->phase = 0;
+		return;
+	}
+	msg = &bdat->msgs[bdat->index];
+	if(msg->flags & I2C_M_NOSTART)
+	{
+		algo_bit_begin_data(bdat);
+	}
+	else
+	{
+		bdat->state = ALGO_BIT_START;
+		bdat->phase = 0;
+	}
+}
+
+static void algo_bit_load_address(struct i2c_algo_bit_data_t * bdat)
+{
+	struct i2c_msg_t * msg = &bdat->msgs[bdat->index];
+	u8_t addr = msg->addr << 1;
+
+	if(msg->flags & I2C_M_RD)
+		addr |= 1;
+	if(msg->flags & I2C_M_REV_DIR_ADDR)
+		addr ^= 1;
+	bdat->state = ALGO_BIT_ADDRESS;
+	bdat->shift = addr;
+	bdat->bit = 7;
+	bdat->phase = 0;
+}
+
+/*
+ * Raise the clock and arm the stretching timeout, the next phase waits
+ * for the slave to release it.
+ */
+static void algo_bit_scl_rise(struct i2c_algo_bit_data_t * bdat)
+{
+	bdat->setscl(bdat, 1);
+	if(bdat->getscl)
+		bdat->timeout = ktime_add_ms(ktime_get(), 100);
+}
+
+static int algo_bit_scl_stretched(struct i2c_algo_bit_data_t * bdat)
+{
+	if(!bdat->getscl || bdat->getscl(bdat))
+		return 0;
+	if(ktime_after(ktime_get(), bdat->timeout))
+	{
+		if(bdat->getscl(bdat))
+			return 0;
+		return -1;
+	}
+	return 1;
+}
+
+static void algo_bit_byte_done(struct i2c_algo_bit_data_t * bdat)
+{
+	struct i2c_msg_t * msg = &bdat->msgs[bdat->index];
+	int nak_ok = msg->flags & I2C_M_IGNORE_NAK;
+
+	switch(bdat->state)
+	{
+	case ALGO_BIT_ADDRESS:
+		if(!bdat->ack && !nak_ok)
+			algo_bit_fail(bdat);
+		else
+			algo_bit_begin_data(bdat);
+		break;
+
+	case ALGO_BIT_WRITE:
+		if(!bdat->ack && !nak_ok)
+		{
+			algo_bit_fail(bdat);
+			break;
+		}
+		if(++bdat->count >= msg->len)
+		{
+			algo_bit_next_msg(bdat);
+			break;
+		}
+		bdat->shift = ((u8_t *)msg->buf)[bdat->count];
+		bdat->bit = 7;
+		break;
+
+	case ALGO_BIT_READ:
+		if(bdat->count >= msg->len)
+		{
+			algo_bit_next_msg(bdat);
+			break;
+		}
+		bdat->shift = 0;
+		bdat->bit = 7;
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*
+ * The last data bit of a read, store the byte and decide on the ack bit.
+ */
+static void algo_bit_read_done(struct i2c_algo_bit_data_t * bdat)
+{
+	struct i2c_msg_t * msg = &bdat->msgs[bdat->index];
+
+	((u8_t *)msg->buf)[bdat->count++] = bdat->shift;
+	if((bdat->count == 1) && (msg->flags & I2C_M_RECV_LEN))
+	{
+		if((bdat->shift == 0) || (bdat->shift > 32))
+		{
+			algo_bit_fail(bdat);
+			return;
+		}
+		msg->len += bdat->shift;
+	}
+	bdat->ack = (bdat->count < msg->len) ? 1 : 0;
+	if(msg->flags & I2C_M_NO_RD_ACK)
+		algo_bit_byte_done(bdat);
+	else
+		bdat->bit = -1;
+}
+
+static int algo_bit_step(struct i2c_algo_bit_data_t * bdat)
+{
+	int r;
+
+	switch(bdat->state)
+	{
+	case ALGO_BIT_START:
+		switch(bdat->phase)
+		{
+		case 0:
+			bdat->setsda(bdat, 1);
+			break;
+		case 1:
+			algo_bit_scl_rise(bdat);
+			break;
+		case 2:
+			if((r = algo_bit_scl_stretched(bdat)) != 0)
+			{
+				if(r < 0)
+					algo_bit_fail(bdat);
+				return 1;
+			}
+			break;
+		case 3:
+			bdat->setsda(bdat, 0);
+			break;
+		default:
+			bdat->setscl(bdat, 0);
+			algo_bit_load_address(bdat);
+			return 1;
+		}
+		bdat->phase++;
+		return 1;
+
+	case ALGO_BIT_ADDRESS:
+	case ALGO_BIT_WRITE:
+	case ALGO_BIT_READ:
+		switch(bdat->phase)
+		{
+		case 0:
+			if(bdat->state == ALGO_BIT_READ)
+				bdat->setsda(bdat, (bdat->bit >= 0) ? 1 : !bdat->ack);
+			else
+				bdat->setsda(bdat, (bdat->bit >= 0) ? (bdat->shift >> bdat->bit) & 0x1 : 1);
+			break;
+		case 1:
+			algo_bit_scl_rise(bdat);
+			break;
+		case 2:
+			if((r = algo_bit_scl_stretched(bdat)) != 0)
+			{
+				if(r < 0)
+					algo_bit_fail(bdat);
+				return 1;
+			}
+			if(bdat->bit >= 0)
+			{
+				if(bdat->state == ALGO_BIT_READ)
+					bdat->shift = (bdat->shift << 1) | (bdat->getsda(bdat) ? 1 : 0);
+			}
+			else if(bdat->state != ALGO_BIT_READ)
+			{
+				bdat->ack = !bdat->getsda(bdat);
+			}
+			break;
+		default:
+			bdat->setscl(bdat, 0);
+			bdat->phase = 0;
+			if(bdat->bit > 0)
+				bdat->bit--;
+			else if((bdat->bit == 0) && (bdat->state == ALGO_BIT_READ))
+				algo_bit_read_done(bdat);
+			else if(bdat->bit == 0)
+				bdat->bit = -1;
+			else
+				algo_bit_byte_done(bdat);
+			return 1;
+		}
+		bdat->phase++;
+		return 1;
+
+	case ALGO_BIT_STOP:
+		switch(bdat->phase)
+		{
+		case 0:
+			bdat->setsda(bdat, 0);
+			break;
+		case 1:
+			algo_bit_scl_rise(bdat);
+			break;
+		case 2:
+			if(algo_bit_scl_stretched(bdat) > 0)
+				return 1;
+			break;
+		default:
+			bdat->setsda(bdat, 1);
+			return 0;
+		}
+		bdat->phase++;
+		return 1;
+
+	default:
+		break;
+	}
+	return 0;
+}
+
+static int algo_bit_timer_function(struct timer_t * timer, void * data)
+{
+	struct i2c_algo_bit_data_t * bdat = (struct i2c_algo_bit_data_t *)data;
+
+	if(!algo_bit_step(bdat))
+	{
+		bdat->busy = 0;
+		if(bdat->complete)
+			bdat->complete(bdat->data, bdat->ret);
+		if(!bdat->busy)
+			return 0;
+	}
+	timer_forward_now(timer, bdat->interval);
+	return 1;
+}
+
+void i2c_algo_bit_init(struct i2c_algo_bit_data_t * bdat)
+{
+	timer_init(&bdat->timer, algo_bit_timer_function, bdat);
+	bdat->busy = 0;
+}
+
+/*
+ * Queue a transfer on the timer driven engine and return at once, complete
+ * gets the number of messages done or a negative value on failure, it runs
+ * in timer context and may start the next transfer. Ten bit addresses are
+ * only handled by the synchronous xfer.
+ */
+int i2c_algo_bit_xfer_async(struct i2c_algo_bit_data_t * bdat, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data)
+{
+	irq_flags_t flags;
+	int i;
+
+	if(!msgs || (num <= 0))
+		return -1;
+	for(i = 0; i < num; i++)
+	{
+		if(msgs[i].flags & I2C_M_TEN)
+			return -1;
+	}
+
+	local_irq_save(flags);
+	if(bdat->busy)
+	{
+		local_irq_restore(flags);
+		return -1;
+	}
+	bdat->busy = 1;
+	local_irq_restore(flags);
+
+	bdat->msgs = msgs;
+	bdat->num = num;
+	bdat->complete = complete;
+	bdat->data = data;
+	bdat->interval = us_to_ktime(((bdat->udelay + 1) / 2 > ALGO_BIT_MIN_INTERVAL_US) ? (bdat->udelay + 1) / 2 : ALGO_BIT_MIN_INTERVAL_US);
+	bdat->index = 0;
+	bdat->ret = -1;
+	bdat->state = ALGO_BIT_START;
+	bdat->phase = 3;
+	if(bdat->timer.state != TIMER_STATE_CALLBACK)
+		timer_start_now(&bdat->timer, bdat->interval);
+	return 0;
+}
@@ -62,9 +62,9 @@
 
 struct i2c_gpio_pdata_t {
 	struct i2c_algo_bit_data_t bdat;
-	int sda;
+	struct gpio_desc_t sda;
 	int sdacfg;
-	int scl;
+	struct gpio_desc_t scl;
 	int sclcfg;
 	int sda_open_drain;
 	int scl_open_drain;
@@ -76,42 +76,42 @@ static void i2c_gpio_setsda_dir(struct i2c_algo_bit_data_t * bdat, int state)
 {
 	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)bdat->priv;
 	if(state)
-		gpio_direction_input(pdat->sda);
+		gpio_desc_direction_input(&pdat->sda);
 	else
-		gpio_direction_output(pdat->sda, 0);
+		gpio_desc_direction_output(&pdat->sda, 0);
 }
 
 static void i2c_gpio_setsda_val(struct i2c_algo_bit_data_t * bdat, int state)
 {
 	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)bdat->priv;
-	gpio_set_value(pdat->sda, state);
+	gpio_desc_set_value(&pdat->sda, state);
 }
 
 static void i2c_gpio_setscl_dir(struct i2c_algo_bit_data_t * bdat, int state)
 {
 	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)bdat->priv;
 	if(state)
-		gpio_direction_input(pdat->scl);
+		gpio_desc_direction_input(&pdat->scl);
 	else
-		gpio_direction_output(pdat->scl, 0);
+		gpio_desc_direction_output(&pdat->scl, 0);
 }
 
 static void i2c_gpio_setscl_val(struct i2c_algo_bit_data_t * bdat, int state)
 {
 	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)bdat->priv;
-	gpio_set_value(pdat->scl, state);
+	gpio_desc_set_value(&pdat->scl, state);
 }
 
 static int i2c_gpio_getsda(struct i2c_algo_bit_data_t * bdat)
 {
 	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)bdat->priv;
-	return gpio_get_value(pdat->sda);
+	return gpio_desc_get_value(&pdat->sda);
 }
 
 static int i2c_gpio_getscl(struct i2c_algo_bit_data_t * bdat)
 {
 	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)bdat->priv;
-	return gpio_get_value(pdat->scl);
+	return gpio_desc_get_value(&pdat->scl);
 }
 
 static int i2c_gpio_xfer(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num)
@@ -121,6 +121,13 @@ static int i2c_gpio_xfer(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num)
 	return i2c_algo_bit_xfer(bdat, msgs, num);
 }
 
+static int i2c_gpio_xfer_async(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data)
+{
+	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)i2c->priv;
+	struct i2c_algo_bit_data_t * bdat = (struct i2c_algo_bit_data_t *)&(pdat->bdat);
+	return i2c_algo_bit_xfer_async(bdat, msgs, num, complete, data);
+}
+
 static struct device_t * i2c_gpio_probe(struct driver_t * drv, struct dtnode_t * n)
 {
 	struct i2c_gpio_pdata_t * pdat;
@@ -143,39 +150,40 @@ static struct device_t * i2c_gpio_probe(struct driver_t * drv, struct dtnode_t *
 		return FALSE;
 	}
 
-	pdat->sda = sda;
+	gpio_desc_init(&pdat->sda, sda);
 	pdat->sdacfg = dt_read_int(n, "sda-gpio-config", -1);
-	pdat->scl = scl;
+	gpio_desc_init(&pdat->scl, scl);
 	pdat->sclcfg = dt_read_int(n, "scl-gpio-config", -1);
 	pdat->sda_open_drain = dt_read_bool(n, "sda-open-drain", 0);
 	pdat->scl_open_drain = dt_read_bool(n, "scl-open-drain", 0);
 	pdat->scl_output_only = dt_read_bool(n, "sda-output-only", 0);
 	pdat->udelay = dt_read_int(n, "delay-us", 5);
 	pdat->bdat.priv = pdat;
+	i2c_algo_bit_init(&pdat->bdat);
 
 	if(pdat->sdacfg >= 0)
-		gpio_set_cfg(pdat->sda, pdat->sdacfg);
+		gpio_desc_set_cfg(&pdat->sda, pdat->sdacfg);
 	if(pdat->sda_open_drain)
 	{
-		gpio_direction_output(pdat->sda, 1);
+		gpio_desc_direction_output(&pdat->sda, 1);
 		pdat->bdat.setsda = i2c_gpio_setsda_val;
 	}
 	else
 	{
-		gpio_direction_input(pdat->sda);
+		gpio_desc_direction_input(&pdat->sda);
 		pdat->bdat.setsda = i2c_gpio_setsda_dir;
 	}
 
 	if(pdat->sclcfg >= 0)
-		gpio_set_cfg(pdat->scl, pdat->sclcfg);
+		gpio_desc_set_cfg(&pdat->scl, pdat->sclcfg);
 	if(pdat->scl_open_drain || pdat->scl_output_only)
 	{
-		gpio_direction_output(pdat->scl, 1);
+		gpio_desc_direction_output(&pdat->scl, 1);
 		pdat->bdat.setscl = i2c_gpio_setscl_val;
 	}
 	else
 	{
-		gpio_direction_input(pdat->scl);
+		gpio_desc_direction_input(&pdat->scl);
 		pdat->bdat.setscl = i2c_gpio_setscl_dir;
 	}
 
@@ -194,6 +202,7 @@ static struct device_t * i2c_gpio_probe(struct driver_t * drv, struct dtnode_t *
 
 	i2c->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
 	i2c->xfer = i2c_gpio_xfer;
+	i2c->xfer_async = i2c_gpio_xfer_async;
 	i2c->priv = pdat;
 
 	if(!register_i2c(&dev, i2c))
@@ -211,9 +220,11 @@ static struct device_t * i2c_gpio_probe(struct driver_t * drv, struct dtnode_t *
 static void i2c_gpio_remove(struct device_t * dev)
 {
 	struct i2c_t * i2c = (struct i2c_t *)dev->priv;
+	struct i2c_gpio_pdata_t * pdat = (struct i2c_gpio_pdata_t *)i2c->priv;
 
 	if(i2c && unregister_i2c(i2c))
 	{
+		timer_cancel(&pdat->bdat.timer);
 		free_device_name(i2c->name);
 		free(i2c->priv);
 		free(i2c);
@@ -240,3 +240,60 @@ int i2c_master_recv(const struct i2c_device_t * dev, void * buf, int count)
 	ret = i2c_transfer(dev->i2c, &msg, 1);
 	return (ret == 1) ? count : ret;
 }
+
+/*
+ * Start a transfer and return, buses without an asynchronous xfer run it
+ * right here and complete before returning. The messages must stay valid
+ * until complete is called.
+ */
+int i2c_transfer_async(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data)
+{
+	int ret;
+
+	if(!i2c || !i2c->xfer)
+		return -1;
+	if(i2c->xfer_async)
+		return i2c->xfer_async(i2c, msgs, num, complete, data);
+
+	ret = i2c_transfer(i2c, msgs, num);
+	if(complete)
+		complete(data, ret);
+	return 0;
+}
+
+/*
+ * Read several register blocks in one transfer, each as a register write
+ * and a read joined by repeated starts, with a single stop at the end.
+ */
+int i2c_device_read_regs(const struct i2c_device_t * dev, struct i2c_reg_read_t * regs, int num)
+{
+	struct i2c_msg_t stack[16];
+	struct i2c_msg_t * msgs = stack;
+	int flags = dev->flags & I2C_M_TEN;
+	int i, ret;
+
+	if(num <= 0)
+		return 0;
+	if(num * 2 > ARRAY_SIZE(stack))
+	{
+		msgs = malloc(sizeof(struct i2c_msg_t) * num * 2);
+		if(!msgs)
+			return -1;
+	}
+	for(i = 0; i < num; i++)
+	{
+		msgs[i * 2 + 0].addr = dev->addr;
+		msgs[i * 2 + 0].flags = flags;
+		msgs[i * 2 + 0].len = 1;
+		msgs[i * 2 + 0].buf = &regs[i].reg;
+
+		msgs[i * 2 + 1].addr = dev->addr;
+		msgs[i * 2 + 1].flags = flags | I2C_M_RD;
+		msgs[i * 2 + 1].len = regs[i].len;
+		msgs[i * 2 + 1].buf = regs[i].buf;
+	}
+	ret = i2c_transfer(dev->i2c, msgs, num * 2);
+	if(msgs != stack)
+		free(msgs);
+	return (ret == num * 2) ? num : -1;
+}
@@ -126,3 +126,35 @@ int input_ioctl(struct input_t * input, int cmd, void * arg)
 		return input->ioctl(input, cmd, arg);
 	return -1;
 }
+
+/*
+ * Touch filter from the device node, the former "mean-filter-length" still
+ * sets a fixed smoothing weight when no speed adaptive one is given.
+ */
+struct tsfilter_t * input_tsfilter_alloc(struct dtnode_t * n, int interval)
+{
+	struct tsfilter_config_t cfg;
+	struct tsfilter_t * filter;
+	int cal[7] = {1, 0, 0, 0, 1, 0, 1};
+	int nl, i;
+
+	tsfilter_config_default(&cfg);
+	nl = dt_read_int(n, "mean-filter-length", 5);
+	cfg.median = dt_read_int(n, "median-filter-length", cfg.median);
+	cfg.jitter = dt_read_int(n, "jitter-threshold", cfg.jitter);
+	cfg.slow = dt_read_int(n, "smooth-slow", (nl > 0) ? 200 / (nl + 1) : 100);
+	cfg.fast = dt_read_int(n, "smooth-fast", cfg.slow);
+	cfg.speed = dt_read_int(n, "smooth-speed", cfg.speed);
+	cfg.interval = interval * 1000;
+	cfg.refresh = dt_read_int(n, "refresh-rate", cfg.refresh);
+	cfg.predict = dt_read_int(n, "prediction-us", cfg.predict);
+
+	filter = tsfilter_alloc_config(&cfg);
+	if(filter && (dt_read_array_length(n, "calibration") == 7))
+	{
+		for(i = 0; i < 7; i++)
+			cal[i] = dt_read_array_int(n, "calibration", i, cal[i]);
+		tsfilter_setcal(filter, &cal[0]);
+	}
+	return filter;
+}
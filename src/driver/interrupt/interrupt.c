@@ -26,8 +26,11 @@
  *
  */
 
+#include <rng/random.h>
 #include <interrupt/interrupt.h>
 
+static int __interrupt_nest = 0;
+
 static void null_interrupt_function(void * data)
 {
 }
@@ -247,15 +250,38 @@ void disable_irq(int irq)
 		chip->disable(chip, irq - chip->base);
 }
 
+/*
+ * Interrupt context, nothing in it can wait for a timer or another
+ * interrupt to make progress. Sources that do not come through
+ * interrupt_handle_exception bracket their handler themselves.
+ */
+void interrupt_enter(void)
+{
+	__interrupt_nest++;
+}
+
+void interrupt_exit(void)
+{
+	__interrupt_nest--;
+}
+
+bool_t in_interrupt(void)
+{
+	return (__interrupt_nest > 0) ? TRUE : FALSE;
+}
+
 void interrupt_handle_exception(void * regs)
 {
 	struct device_t * pos, * n;
 	struct irqchip_t * chip;
 
+	interrupt_enter();
 	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_IRQCHIP], head)
 	{
 		chip = (struct irqchip_t *)(pos->priv);
 		if(chip->dispatch)
 			chip->dispatch(chip);
 	}
+	random_add_interrupt();
+	interrupt_exit();
 }
@@ -28,11 +28,26 @@
 
 #include <xboot.h>
 #include <gpio/gpio.h>
+#include <spi/spi.h>
 #include <led/ledstrip.h>
 
 /*
  * SK9822 - SK9822 LED Strip Driver
  *
+ * The strip is driven by an spi bus when "spi-bus" is given, otherwise the
+ * data and clock gpios are bit banged. The whole frame, start and end
+ * frames included, is built in one buffer with the gamma table applied.
+ * On spi two frame buffers alternate, refresh queues the frame and returns
+ * while the bus sends it, so the next frame can be built meanwhile. A
+ * refresh only stalls when it comes faster than the bus sends frames, it
+ * then waits for the older frame to go out, at most one frame time, with a
+ * 100ms timeout that drops the frame if the bus is stuck.
+ *
+ * Optional properties:
+ * - type: spi bus width, 0 single, 1 dual, 2 quad, 3 octal
+ * - gamma: gamma correction of the color channels, 1.0 is linear
+ * - level: color scale applied along with the gamma, 0 to 255
+ *
  * Example:
  *   "ledstrip-sk9822@0": {
  *       "dat-gpio": 10,
@@ -42,49 +57,178 @@
  *       "clk-gpio-config": -1,
  *       "clk-gpio-inverted": 0,
  *       "brightness": 31,
+ *       "gamma": 1.0,
+ *       "level": 255,
  *       "count": 64
  *   }
+ *
+ *   "ledstrip-sk9822@1": {
+ *       "spi-bus": "spi-gpio.0",
+ *       "chip-select": 0,
+ *       "mode": 0,
+ *       "speed": 8000000,
+ *       "brightness": 31,
+ *       "gamma": 2.2,
+ *       "level": 255,
+ *       "count": 300
+ *   }
  */
 
 struct ledstrip_sk9822_pdata_t {
-	int dat;
+	struct gpio_desc_t dat;
 	int datcfg;
 	int datinv;
-	int clk;
+	struct gpio_desc_t clk;
 	int clkcfg;
 	int clkinv;
+	struct gpiochip_t * port;
+	u32_t datmask;
+	u32_t clkmask;
+	struct spi_device_t * spidev;
 	int brightness;
 	int count;
 	uint32_t * buffer;
+	u8_t lut[256];
+
+	/* Frame buffers, the second one is only used on spi */
+	u8_t * frame[2];
+	struct spi_message_t msg[2];
+	struct spi_transfer_t xfer[2];
+	int flen;
+	int back;
 };
 
 static void ledstrip_sk9822_send(struct ledstrip_t * strip, uint8_t byte)
 {
 	struct ledstrip_sk9822_pdata_t * pdat = (struct ledstrip_sk9822_pdata_t *)strip->priv;
 	unsigned char mask;
+	u32_t inv, val;
+
+	if(pdat->port)
+	{
+		/*
+		 * Clock low and the next data bit go out in one port write
+		 */
+		inv = (pdat->datinv ? pdat->datmask : 0) | (pdat->clkinv ? pdat->clkmask : 0);
+		for(mask = 0x80; mask; mask >>= 1)
+		{
+			val = (byte & mask) ? pdat->datmask : 0;
+			gpiochip_set_port(pdat->port, pdat->datmask | pdat->clkmask, val ^ inv);
+			gpiochip_set_port(pdat->port, pdat->clkmask, pdat->clkmask ^ inv);
+		}
+		return;
+	}
 
 	for(mask = 0x80; mask; mask >>= 1)
 	{
 		if(byte & mask)
-			gpio_set_value(pdat->dat, pdat->datinv ? 0 : 1);
+			gpio_desc_set_value(&pdat->dat, pdat->datinv ? 0 : 1);
 		else
-			gpio_set_value(pdat->dat, pdat->datinv ? 1 : 0);
-		gpio_set_value(pdat->clk, pdat->clkinv ? 1 : 0);
-		gpio_set_value(pdat->clk, pdat->clkinv ? 0 : 1);
+			gpio_desc_set_value(&pdat->dat, pdat->datinv ? 1 : 0);
+		gpio_desc_set_value(&pdat->clk, pdat->clkinv ? 1 : 0);
+		gpio_desc_set_value(&pdat->clk, pdat->clkinv ? 0 : 1);
+	}
+}
+
+/*
+ * Wait until the spi queue is done with a frame buffer, it may only be
+ * rewritten afterwards.
+ */
+static bool_t ledstrip_sk9822_wait(struct ledstrip_sk9822_pdata_t * pdat, int i)
+{
+	ktime_t timeout = ktime_add_ms(ktime_get(), 100);
+
+	while(pdat->msg[i].status > 0)
+	{
+		if(ktime_after(ktime_get(), timeout))
+			return FALSE;
 	}
+	return TRUE;
+}
+
+/*
+ * Take the frames back from the spi queue, a queued one is cancelled and a
+ * running one waited for. Fails with the frames kept when the bus does not
+ * let go of them, they can not be freed then.
+ */
+static bool_t ledstrip_sk9822_drain_frames(struct ledstrip_sk9822_pdata_t * pdat)
+{
+	int i;
+
+	if(!pdat->spidev)
+		return TRUE;
+	for(i = 0; i < 2; i++)
+	{
+		if(!pdat->frame[i])
+			continue;
+		if((spi_cancel(pdat->spidev, &pdat->msg[i]) < 0) && !ledstrip_sk9822_wait(pdat, i))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void ledstrip_sk9822_free_frames(struct ledstrip_sk9822_pdata_t * pdat)
+{
+	int i;
+
+	for(i = 0; i < 2; i++)
+	{
+		if(!pdat->frame[i])
+			continue;
+		if(pdat->spidev)
+			spi_dma_free(pdat->frame[i]);
+		else
+			free(pdat->frame[i]);
+		pdat->frame[i] = NULL;
+	}
+}
+
+/*
+ * A start frame of 32 zero bits, four bytes per led and an end frame of
+ * at least half a clock per led to push the data through the chain.
+ */
+static bool_t ledstrip_sk9822_alloc_frames(struct ledstrip_sk9822_pdata_t * pdat, int count)
+{
+	int elen = (count + 15) / 16;
+	int flen;
+	int i;
+
+	if(elen < 4)
+		elen = 4;
+	flen = 4 + count * 4 + elen;
+
+	pdat->flen = flen;
+	for(i = 0; i < (pdat->spidev ? 2 : 1); i++)
+	{
+		pdat->frame[i] = pdat->spidev ? spi_dma_alloc(flen) : malloc(flen);
+		if(!pdat->frame[i])
+			return FALSE;
+		memset(&pdat->frame[i][0], 0x00, 4);
+		memset(&pdat->frame[i][flen - elen], 0xff, elen);
+	}
+	return TRUE;
 }
 
 static void ledstrip_sk9822_set_count(struct ledstrip_t * strip, int n)
 {
 	struct ledstrip_sk9822_pdata_t * pdat = (struct ledstrip_sk9822_pdata_t *)strip->priv;
+	uint32_t * buffer;
 
 	if((n != pdat->count) && (n > 0))
 	{
+		if(!ledstrip_sk9822_drain_frames(pdat))
+			return;
+		buffer = memalign(sizeof(uint32_t), n * sizeof(uint32_t));
+		if(!buffer)
+			return;
+		memset(buffer, 0, n * sizeof(uint32_t));
+		ledstrip_sk9822_free_frames(pdat);
 		if(pdat->buffer)
 			free(pdat->buffer);
 		pdat->count = n;
-		pdat->buffer = memalign(sizeof(uint32_t), pdat->count * sizeof(uint32_t));
-		memset(pdat->buffer, 0, pdat->count * sizeof(uint32_t));
+		pdat->buffer = buffer;
+		if(!ledstrip_sk9822_alloc_frames(pdat, n))
+			ledstrip_sk9822_free_frames(pdat);
 	}
 }
 
@@ -109,23 +253,47 @@ static uint32_t ledstrip_sk9822_get_color(struct ledstrip_t * strip, int i)
 static void ledstrip_sk9822_refresh(struct ledstrip_t * strip)
 {
 	struct ledstrip_sk9822_pdata_t * pdat = (struct ledstrip_sk9822_pdata_t *)strip->priv;
+	int back = pdat->back;
+	u8_t * f = pdat->frame[back];
+	u8_t * lut = pdat->lut;
+	u8_t head = (0x7 << 5) | (pdat->brightness & 0x1f);
+	uint32_t c;
 	int i;
 
-	ledstrip_sk9822_send(strip, 0x00);
-	ledstrip_sk9822_send(strip, 0x00);
-	ledstrip_sk9822_send(strip, 0x00);
-	ledstrip_sk9822_send(strip, 0x00);
-	for(i = 0; i < pdat->count; i++)
+	if(!f)
+		return;
+
+	/*
+	 * Drop the frame if the bus still holds this buffer
+	 */
+	if(pdat->spidev && !ledstrip_sk9822_wait(pdat, back))
+		return;
+
+	for(i = 0, f += 4; i < pdat->count; i++, f += 4)
+	{
+		c = pdat->buffer[i];
+		f[0] = head;
+		f[1] = lut[(c >>  0) & 0xff];
+		f[2] = lut[(c >>  8) & 0xff];
+		f[3] = lut[(c >> 16) & 0xff];
+	}
+	f = pdat->frame[back];
+
+	if(pdat->spidev)
+	{
+		spi_message_init(&pdat->msg[back]);
+		memset(&pdat->xfer[back], 0, sizeof(struct spi_transfer_t));
+		pdat->xfer[back].txbuf = f;
+		pdat->xfer[back].len = pdat->flen;
+		spi_message_add_tail(&pdat->xfer[back], &pdat->msg[back]);
+		if(spi_async(pdat->spidev, &pdat->msg[back]) == 0)
+			pdat->back = back ^ 1;
+	}
+	else
 	{
-		ledstrip_sk9822_send(strip, (0x7 << 5) | (pdat->brightness & 0x1f));
-		ledstrip_sk9822_send(strip, (pdat->buffer[i] >>  0) & 0xff);
-		ledstrip_sk9822_send(strip, (pdat->buffer[i] >>  8) & 0xff);
-		ledstrip_sk9822_send(strip, (pdat->buffer[i] >> 16) & 0xff);
+		for(i = 0; i < pdat->flen; i++)
+			ledstrip_sk9822_send(strip, f[i]);
 	}
-	ledstrip_sk9822_send(strip, 0xff);
-	ledstrip_sk9822_send(strip, 0xff);
-	ledstrip_sk9822_send(strip, 0xff);
-	ledstrip_sk9822_send(strip, 0xff);
 }
 
 static struct device_t * ledstrip_sk9822_probe(struct driver_t * drv, struct dtnode_t * n)
@@ -133,32 +301,56 @@ static struct device_t * ledstrip_sk9822_probe(struct driver_t * drv, struct dtn
 	struct ledstrip_sk9822_pdata_t * pdat;
 	struct ledstrip_t * strip;
 	struct device_t * dev;
+	struct spi_device_t * spidev = NULL;
 	int dat = dt_read_int(n, "dat-gpio", -1);
 	int clk = dt_read_int(n, "clk-gpio", -1);
+	char * bus = dt_read_string(n, "spi-bus", NULL);
 
-	if(!gpio_is_valid(dat) || !gpio_is_valid(clk))
+	if(bus)
+	{
+		spidev = spi_device_alloc(bus, dt_read_int(n, "chip-select", 0), dt_read_int(n, "type", 0), dt_read_int(n, "mode", 0), 8, dt_read_int(n, "speed", 0));
+		if(!spidev)
+			return NULL;
+	}
+	else if(!gpio_is_valid(dat) || !gpio_is_valid(clk))
 		return NULL;
 
 	pdat = malloc(sizeof(struct ledstrip_sk9822_pdata_t));
 	if(!pdat)
+	{
+		spi_device_free(spidev);
 		return NULL;
+	}
 
 	strip = malloc(sizeof(struct ledstrip_t));
 	if(!strip)
 	{
+		spi_device_free(spidev);
 		free(pdat);
 		return NULL;
 	}
 
-	pdat->dat = dat;
+	memset(pdat, 0, sizeof(struct ledstrip_sk9822_pdata_t));
+	gpio_desc_init(&pdat->dat, spidev ? -1 : dat);
 	pdat->datcfg = dt_read_int(n, "dat-gpio-config", -1);
 	pdat->datinv = dt_read_int(n, "dat-gpio-inverted", 0);
-	pdat->clk = clk;
+	gpio_desc_init(&pdat->clk, spidev ? -1 : clk);
 	pdat->clkcfg = dt_read_int(n, "clk-gpio-config", -1);
 	pdat->clkinv = dt_read_int(n, "clk-gpio-inverted", 0);
+	pdat->datmask = gpio_desc_mask(&pdat->dat);
+	pdat->clkmask = gpio_desc_mask(&pdat->clk);
+	if((pdat->dat.chip == pdat->clk.chip) && pdat->datmask && pdat->clkmask && pdat->dat.chip->set_port)
+		pdat->port = pdat->dat.chip;
+	else
+		pdat->port = NULL;
+	pdat->spidev = spidev;
 	pdat->brightness = dt_read_int(n, "brightness", 31);
 	pdat->count = 0;
 	pdat->buffer = NULL;
+	pdat->back = 0;
+	spi_message_init(&pdat->msg[0]);
+	spi_message_init(&pdat->msg[1]);
+	ledstrip_gamma_lut(pdat->lut, dt_read_double(n, "gamma", 1.0), dt_read_int(n, "level", 255));
 
 	strip->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
 	strip->set_count = ledstrip_sk9822_set_count;
@@ -168,26 +360,29 @@ static struct device_t * ledstrip_sk9822_probe(struct driver_t * drv, struct dtn
 	strip->refresh = ledstrip_sk9822_refresh;
 	strip->priv = pdat;
 
-	if(pdat->dat >= 0)
+	if(pdat->dat.chip)
 	{
 		if(pdat->datcfg >= 0)
-			gpio_set_cfg(pdat->dat, pdat->datcfg);
-		gpio_set_pull(pdat->dat, pdat->datinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
-		gpio_set_direction(pdat->dat, GPIO_DIRECTION_OUTPUT);
-		gpio_set_value(pdat->dat, pdat->datinv ? 1 : 0);
+			gpio_desc_set_cfg(&pdat->dat, pdat->datcfg);
+		gpio_desc_set_pull(&pdat->dat, pdat->datinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
+		gpio_desc_direction_output(&pdat->dat, pdat->datinv ? 1 : 0);
 	}
-	if(pdat->clk >= 0)
+	if(pdat->clk.chip)
 	{
 		if(pdat->clkcfg >= 0)
-			gpio_set_cfg(pdat->clk, pdat->clkcfg);
-		gpio_set_pull(pdat->clk, pdat->clkinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
-		gpio_set_direction(pdat->clk, GPIO_DIRECTION_OUTPUT);
-		gpio_set_value(pdat->clk, pdat->clkinv ? 1 : 0);
+			gpio_desc_set_cfg(&pdat->clk, pdat->clkcfg);
+		gpio_desc_set_pull(&pdat->clk, pdat->clkinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
+		gpio_desc_direction_output(&pdat->clk, pdat->clkinv ? 1 : 0);
 	}
 	ledstrip_sk9822_set_count(strip, dt_read_int(n, "count", 1));
 
-	if(!register_ledstrip(&dev, strip))
+	if(!pdat->buffer || !register_ledstrip(&dev, strip))
 	{
+		ledstrip_sk9822_free_frames(pdat);
+		if(pdat->buffer)
+			free(pdat->buffer);
+		spi_device_free(pdat->spidev);
+
 		free_device_name(strip->name);
 		free(strip->priv);
 		free(strip);
@@ -205,8 +400,16 @@ static void ledstrip_sk9822_remove(struct device_t * dev)
 
 	if(strip && unregister_ledstrip(strip))
 	{
+		/*
+		 * The spi queue still points into pdat, leak it rather than free
+		 * it under the bus
+		 */
+		if(!ledstrip_sk9822_drain_frames(pdat))
+			return;
+		ledstrip_sk9822_free_frames(pdat);
 		if(pdat->buffer)
 			free(pdat->buffer);
+		spi_device_free(pdat->spidev);
 
 		free_device_name(strip->name);
 		free(strip->priv);
@@ -27,6 +27,7 @@
  */
 
 #include <xboot.h>
+#include <math.h>
 #include <led/ledstrip.h>
 
 static ssize_t ledstrip_read_count(struct kobj_t * kobj, void * buf, size_t size)
@@ -183,3 +184,22 @@ void ledstrip_refresh(struct ledstrip_t * strip)
 	if(strip && strip->refresh)
 		strip->refresh(strip);
 }
+
+/*
+ * Fill a 256 entry table mapping color channels through the gamma curve,
+ * scaled to level. Drivers apply it while building a frame.
+ */
+void ledstrip_gamma_lut(u8_t * lut, double gamma, int level)
+{
+	int i;
+
+	if(gamma <= 0.0)
+		gamma = 1.0;
+	if(level < 0)
+		level = 0;
+	else if(level > 255)
+		level = 255;
+
+	for(i = 0; i < 256; i++)
+		lut[i] = (u8_t)(pow(i / 255.0, gamma) * level + 0.5);
+}
@@ -276,6 +276,21 @@ char * kvdb_to_string(struct kvdb_t * db)
 	return str;
 }
 
+bool_t kvdb_foreach(struct kvdb_t * db, bool_t (*fn)(const char * key, const char * value, void * data), void * data)
+{
+	struct record_t * pos, * n;
+
+	if(!db || !fn)
+		return FALSE;
+
+	list_for_each_entry_safe(pos, n, &db->list, head)
+	{
+		if(!fn(pos->key, pos->value, data))
+			return FALSE;
+	}
+	return TRUE;
+}
+
 int kvdb_summary(struct kvdb_t * db, void * buf)
 {
 	struct record_t * pos, * n;
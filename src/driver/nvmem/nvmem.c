@@ -29,6 +29,12 @@
 #include <crc32.h>
 #include <nvmem/nvmem.h>
 
+#define NVMEM_LOG_MAGIC			(0x314c564b)
+#define NVMEM_LOG_HEADER		(12)
+#define NVMEM_RECORD_HEADER		(8)
+#define NVMEM_RECORD_COMMIT		(1 << 0)
+#define NVMEM_RECORD_DELETE		(0xffff)
+
 static ssize_t nvmem_read_summary(struct kobj_t * kobj, void * buf, size_t size)
 {
 	struct nvmem_t * m = (struct nvmem_t *)kobj->priv;
@@ -41,6 +47,20 @@ static ssize_t nvmem_read_capacity(struct kobj_t * kobj, void * buf, size_t size
 	return sprintf(buf, "%d", nvmem_capacity(m));
 }
 
+static ssize_t nvmem_read_statistics(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct nvmem_t * m = (struct nvmem_t *)kobj->priv;
+	char * p = buf;
+	int len = 0;
+
+	len += sprintf((char *)(p + len), "writes      %d\r\n", m->writes);
+	len += sprintf((char *)(p + len), "bytes       %d\r\n", m->wbytes);
+	len += sprintf((char *)(p + len), "compactions %d\r\n", m->compactions);
+	len += sprintf((char *)(p + len), "generation  %d\r\n", m->gen);
+	len += sprintf((char *)(p + len), "log         %d/%d\r\n", m->tail, m->hsize);
+	return len;
+}
+
 struct nvmem_t * search_nvmem(const char * name)
 {
 	struct device_t * dev;
@@ -61,56 +81,399 @@ struct nvmem_t * search_first_nvmem(void)
 	return (struct nvmem_t *)dev->priv;
 }
 
-static bool_t nvmem_init_kvdb(struct nvmem_t * m)
+static u32_t nvmem_log_crc(u32_t gen, const u8_t * hdr, const u8_t * data, int len)
 {
-	uint32_t c, crc = 0;
-	char h[8];
-	char * s;
-	int l, size;
+	u32_t crc = 0;
+	u8_t g[4];
+
+	g[0] = (gen >>  0) & 0xff;
+	g[1] = (gen >>  8) & 0xff;
+	g[2] = (gen >> 16) & 0xff;
+	g[3] = (gen >> 24) & 0xff;
+	crc = crc32_sum(crc, g, 4);
+	crc = crc32_sum(crc, hdr, 4);
+	crc = crc32_sum(crc, data, len);
+	return crc;
+}
 
-	if(!m)
+static inline int nvmem_log_datalen(const u8_t * p)
+{
+	int vlen = (p[3] << 8) | (p[2] << 0);
+	return p[1] + ((vlen == NVMEM_RECORD_DELETE) ? 0 : vlen);
+}
+
+/*
+ * Record layout is flags, key length, 16 bits value length and the crc,
+ * followed by key and value without terminators. A value length of
+ * NVMEM_RECORD_DELETE removes the key.
+ */
+static int nvmem_log_encode(u8_t * p, const char * key, const char * value)
+{
+	int klen = strlen(key);
+	int vlen = value ? strlen(value) : NVMEM_RECORD_DELETE;
+
+	p[0] = 0;
+	p[1] = klen;
+	p[2] = (vlen >> 0) & 0xff;
+	p[3] = (vlen >> 8) & 0xff;
+	memcpy(&p[NVMEM_RECORD_HEADER], key, klen);
+	if(value)
+		memcpy(&p[NVMEM_RECORD_HEADER + klen], value, vlen);
+	return NVMEM_RECORD_HEADER + nvmem_log_datalen(p);
+}
+
+/*
+ * Stamp a batch of encoded records with the generation and flag the last
+ * one as commit.
+ */
+static void nvmem_log_seal(u8_t * buf, int len, u32_t gen)
+{
+	u32_t crc;
+	int pos = 0, dlen;
+
+	while(pos < len)
+	{
+		dlen = nvmem_log_datalen(&buf[pos]);
+		buf[pos] = (pos + NVMEM_RECORD_HEADER + dlen >= len) ? NVMEM_RECORD_COMMIT : 0;
+		crc = nvmem_log_crc(gen, &buf[pos], &buf[pos + NVMEM_RECORD_HEADER], dlen);
+		buf[pos + 4] = (crc >>  0) & 0xff;
+		buf[pos + 5] = (crc >>  8) & 0xff;
+		buf[pos + 6] = (crc >> 16) & 0xff;
+		buf[pos + 7] = (crc >> 24) & 0xff;
+		pos += NVMEM_RECORD_HEADER + dlen;
+	}
+}
+
+/*
+ * Returns the end of the last committed batch, anything behind it is a
+ * torn or unfinished write, or stale data of an older generation.
+ */
+static int nvmem_log_scan(const u8_t * buf, int size, u32_t gen)
+{
+	int pos = NVMEM_LOG_HEADER, tail = NVMEM_LOG_HEADER;
+	int dlen;
+	u32_t crc;
+
+	while(pos + NVMEM_RECORD_HEADER <= size)
+	{
+		if(buf[pos + 1] == 0)
+			break;
+		dlen = nvmem_log_datalen(&buf[pos]);
+		if(pos + NVMEM_RECORD_HEADER + dlen > size)
+			break;
+		crc = (buf[pos + 7] << 24) | (buf[pos + 6] << 16) | (buf[pos + 5] << 8) | (buf[pos + 4] << 0);
+		if(crc != nvmem_log_crc(gen, &buf[pos], &buf[pos + NVMEM_RECORD_HEADER], dlen))
+			break;
+		if(buf[pos] & NVMEM_RECORD_COMMIT)
+			tail = pos + NVMEM_RECORD_HEADER + dlen;
+		pos += NVMEM_RECORD_HEADER + dlen;
+	}
+	return tail;
+}
+
+static void nvmem_log_replay(struct nvmem_t * m, const u8_t * buf, int tail)
+{
+	char * key, * value;
+	int pos = NVMEM_LOG_HEADER;
+	int klen, vlen;
+
+	key = malloc(tail + 2);
+	if(!key)
+		return;
+	while(pos < tail)
+	{
+		klen = buf[pos + 1];
+		vlen = (buf[pos + 3] << 8) | (buf[pos + 2] << 0);
+		memcpy(key, &buf[pos + NVMEM_RECORD_HEADER], klen);
+		key[klen] = 0;
+		if(vlen == NVMEM_RECORD_DELETE)
+		{
+			kvdb_set(m->db, key, NULL);
+		}
+		else
+		{
+			value = &key[klen + 1];
+			memcpy(value, &buf[pos + NVMEM_RECORD_HEADER + klen], vlen);
+			value[vlen] = 0;
+			kvdb_set(m->db, key, value);
+		}
+		pos += NVMEM_RECORD_HEADER + nvmem_log_datalen(&buf[pos]);
+	}
+	free(key);
+}
+
+static void nvmem_log_drop(struct nvmem_t * m)
+{
+	m->plen = 0;
+}
+
+static void nvmem_log_append(struct nvmem_t * m, const char * key, const char * value)
+{
+	int len = NVMEM_RECORD_HEADER + strlen(key) + (value ? strlen(value) : 0);
+	int size;
+	u8_t * p;
+
+	if(m->compact)
+		return;
+
+	/*
+	 * A batch that can never fit behind a header goes through compaction,
+	 * which writes the database as it is and needs no pending records.
+	 */
+	if(m->plen + len > m->hsize - NVMEM_LOG_HEADER)
+	{
+		nvmem_log_drop(m);
+		m->compact = TRUE;
+		return;
+	}
+
+	if(m->plen + len > m->psize)
+	{
+		size = (m->psize > 0) ? m->psize * 2 : 64;
+		if(size < m->plen + len)
+			size = m->plen + len;
+		p = realloc(m->pending, size);
+		if(!p)
+		{
+			nvmem_log_drop(m);
+			m->compact = TRUE;
+			return;
+		}
+		m->pending = p;
+		m->psize = size;
+	}
+	m->plen += nvmem_log_encode(&m->pending[m->plen], key, value);
+}
+
+static bool_t nvmem_image_count(const char * key, const char * value, void * data)
+{
+	*((int *)data) += NVMEM_RECORD_HEADER + strlen(key) + strlen(value);
+	return TRUE;
+}
+
+/*
+ * Size of the database compacted into a log half, header included.
+ */
+static int nvmem_image_size(struct nvmem_t * m)
+{
+	int len = NVMEM_LOG_HEADER;
+
+	kvdb_foreach(m->db, nvmem_image_count, &len);
+	return len;
+}
+
+struct nvmem_image_t {
+	u8_t * buf;
+	int len;
+	int size;
+};
+
+static bool_t nvmem_image_add(const char * key, const char * value, void * data)
+{
+	struct nvmem_image_t * img = (struct nvmem_image_t *)data;
+
+	if(img->len + NVMEM_RECORD_HEADER + strlen(key) + strlen(value) > img->size)
 		return FALSE;
-	m->db = NULL;
+	img->len += nvmem_log_encode(&img->buf[img->len], key, value);
+	return TRUE;
+}
 
-	size = nvmem_capacity(m);
-	if(size < (8 + 1))
+/*
+ * Write the whole database into the other half with the next generation,
+ * records first and header last, so the old half stays live until the new
+ * one is complete.
+ */
+static bool_t nvmem_log_compact(struct nvmem_t * m)
+{
+	struct nvmem_image_t img;
+	u32_t gen = m->gen + 1;
+	u32_t crc;
+	int half = m->half ^ 1;
+	int base = half * m->hsize;
+
+	img.buf = malloc(m->hsize);
+	if(!img.buf)
 		return FALSE;
+	img.len = NVMEM_LOG_HEADER;
+	img.size = m->hsize;
+	if(!kvdb_foreach(m->db, nvmem_image_add, &img))
+	{
+		free(img.buf);
+		return FALSE;
+	}
+	nvmem_log_seal(&img.buf[NVMEM_LOG_HEADER], img.len - NVMEM_LOG_HEADER, gen);
+
+	img.buf[0] = (NVMEM_LOG_MAGIC >>  0) & 0xff;
+	img.buf[1] = (NVMEM_LOG_MAGIC >>  8) & 0xff;
+	img.buf[2] = (NVMEM_LOG_MAGIC >> 16) & 0xff;
+	img.buf[3] = (NVMEM_LOG_MAGIC >> 24) & 0xff;
+	img.buf[4] = (gen >>  0) & 0xff;
+	img.buf[5] = (gen >>  8) & 0xff;
+	img.buf[6] = (gen >> 16) & 0xff;
+	img.buf[7] = (gen >> 24) & 0xff;
+	crc = crc32_sum(0, img.buf, 8);
+	img.buf[8] = (crc >>  0) & 0xff;
+	img.buf[9] = (crc >>  8) & 0xff;
+	img.buf[10] = (crc >> 16) & 0xff;
+	img.buf[11] = (crc >> 24) & 0xff;
+
+	if(img.len > NVMEM_LOG_HEADER)
+	{
+		if(nvmem_write(m, &img.buf[NVMEM_LOG_HEADER], base + NVMEM_LOG_HEADER, img.len - NVMEM_LOG_HEADER) != img.len - NVMEM_LOG_HEADER)
+		{
+			free(img.buf);
+			return FALSE;
+		}
+	}
+	if(nvmem_write(m, img.buf, base, NVMEM_LOG_HEADER) != NVMEM_LOG_HEADER)
+	{
+		free(img.buf);
+		return FALSE;
+	}
+	free(img.buf);
+
+	m->half = half;
+	m->gen = gen;
+	m->tail = img.len;
+	m->compact = FALSE;
+	m->compactions++;
+	nvmem_log_drop(m);
+	return TRUE;
+}
+
+/*
+ * Older images hold the whole database as one string behind a crc and
+ * length header, they are imported once and then compacted into a log.
+ * One whose records do not fit in a log half keeps this format.
+ */
+static void nvmem_init_legacy(struct nvmem_t * m, int size)
+{
+	uint32_t c, crc = 0;
+	u8_t h[8];
+	char * s;
+	int l;
 
 	if(nvmem_read(m, h, 0, 8) != 8)
-		return FALSE;
+		return;
 	c = (h[3] << 24) | (h[2] << 16) | (h[1] << 8) | (h[0] << 0);
 	l = (h[7] << 24) | (h[6] << 16) | (h[5] << 8) | (h[4] << 0);
 
-	m->db = kvdb_alloc(size);
-	if(m->db)
+	if((l > 0) && (l + 8 < size))
 	{
-		if((l > 0) && (l + 8 < size))
+		s = malloc(l);
+		if(!s)
+			return;
+		if(nvmem_read(m, s, 8, l) == l)
 		{
-			s = malloc(l);
-			if(!s)
-			{
-				kvdb_free(m->db);
-				return FALSE;
-			}
-			if(nvmem_read(m, s, 8, l) != l)
-			{
-				kvdb_free(m->db);
-				free(s);
-				return FALSE;
-			}
 			crc = crc32_sum(crc, (const uint8_t *)(&h[4]), 4);
 			crc = crc32_sum(crc, (const uint8_t *)s, l);
-			if(crc == c)
+			if((crc == c) && (s[l - 1] == 0))
 				kvdb_from_string(m->db, s);
-			else
-				nvmem_sync(m);
-			free(s);
 		}
-		else
+		free(s);
+	}
+}
+
+static bool_t nvmem_sync_legacy(struct nvmem_t * m)
+{
+	uint32_t c = 0;
+	u8_t h[8];
+	char * s;
+	int l;
+	bool_t ret;
+
+	s = kvdb_to_string(m->db);
+	if(!s)
+		return FALSE;
+	l = strlen(s) + 1;
+	h[4] = (l >>  0) & 0xff;
+	h[5] = (l >>  8) & 0xff;
+	h[6] = (l >> 16) & 0xff;
+	h[7] = (l >> 24) & 0xff;
+	c = crc32_sum(c, (const uint8_t *)(&h[4]), 4);
+	c = crc32_sum(c, (const uint8_t *)s, l);
+	h[0] = (c >>  0) & 0xff;
+	h[1] = (c >>  8) & 0xff;
+	h[2] = (c >> 16) & 0xff;
+	h[3] = (c >> 24) & 0xff;
+	ret = ((nvmem_write(m, h, 0, 8) == 8) && (nvmem_write(m, s, 8, l) == l)) ? TRUE : FALSE;
+	free(s);
+	return ret;
+}
+
+static bool_t nvmem_init_kvdb(struct nvmem_t * m)
+{
+	u32_t magic, gen = 0, crc;
+	u8_t * buf;
+	int size, best = -1, i;
+
+	if(!m)
+		return FALSE;
+	m->db = NULL;
+
+	size = nvmem_capacity(m);
+	if(size < 2 * (NVMEM_LOG_HEADER + NVMEM_RECORD_HEADER + 2))
+		return FALSE;
+	m->hsize = size / 2;
+
+	/*
+	 * The kvdb bounds a legacy string, log sets are bounded in record
+	 * bytes by nvmem_set.
+	 */
+	m->db = kvdb_alloc(size);
+	if(!m->db)
+		return FALSE;
+
+	buf = malloc(m->hsize);
+	if(!buf)
+	{
+		kvdb_free(m->db);
+		m->db = NULL;
+		return FALSE;
+	}
+
+	for(i = 0; i < 2; i++)
+	{
+		if(nvmem_read(m, buf, i * m->hsize, NVMEM_LOG_HEADER) != NVMEM_LOG_HEADER)
+			continue;
+		magic = (buf[3] << 24) | (buf[2] << 16) | (buf[1] << 8) | (buf[0] << 0);
+		crc = (buf[11] << 24) | (buf[10] << 16) | (buf[9] << 8) | (buf[8] << 0);
+		if((magic != NVMEM_LOG_MAGIC) || (crc != crc32_sum(0, buf, 8)))
+			continue;
+		magic = (buf[7] << 24) | (buf[6] << 16) | (buf[5] << 8) | (buf[4] << 0);
+		if((best < 0) || ((s32_t)(magic - gen) > 0))
+		{
+			best = i;
+			gen = magic;
+		}
+	}
+
+	if(best >= 0)
+	{
+		m->half = best;
+		m->gen = gen;
+		m->tail = NVMEM_LOG_HEADER;
+		if(nvmem_read(m, buf, best * m->hsize, m->hsize) == m->hsize)
 		{
-			nvmem_sync(m);
+			m->tail = nvmem_log_scan(buf, m->hsize, gen);
+			nvmem_log_replay(m, buf, m->tail);
 		}
 	}
+	else
+	{
+		m->half = 0;
+		m->gen = 0;
+		nvmem_init_legacy(m, size);
+		/*
+		 * Until a first compaction succeeds no half has a header, syncs
+		 * retry it rather than append behind nothing.
+		 */
+		if(nvmem_image_size(m) > m->hsize)
+			m->legacy = TRUE;
+		else if(!nvmem_log_compact(m))
+			m->compact = TRUE;
+	}
+	free(buf);
 	return TRUE;
 }
 
@@ -128,6 +491,18 @@ bool_t register_nvmem(struct device_t ** device, struct nvmem_t * m)
 	if(!dev)
 		return FALSE;
 
+	m->half = 0;
+	m->hsize = 0;
+	m->gen = 0;
+	m->tail = 0;
+	m->pending = NULL;
+	m->plen = 0;
+	m->psize = 0;
+	m->compact = FALSE;
+	m->legacy = FALSE;
+	m->writes = 0;
+	m->wbytes = 0;
+	m->compactions = 0;
 	nvmem_init_kvdb(m);
 	dev->name = strdup(m->name);
 	dev->type = DEVICE_TYPE_NVMEM;
@@ -136,11 +511,14 @@ bool_t register_nvmem(struct device_t ** device, struct nvmem_t * m)
 	dev->kobj = kobj_alloc_directory(dev->name);
 	kobj_add_regular(dev->kobj, "summary", nvmem_read_summary, NULL, m);
 	kobj_add_regular(dev->kobj, "capacity", nvmem_read_capacity, NULL, m);
+	kobj_add_regular(dev->kobj, "statistics", nvmem_read_statistics, NULL, m);
 
 	if(!register_device(dev))
 	{
 		if(m->db)
 			kvdb_free(m->db);
+		if(m->pending)
+			free(m->pending);
 		kobj_remove_self(dev->kobj);
 		free(dev->name);
 		free(dev);
@@ -168,6 +546,8 @@ bool_t unregister_nvmem(struct nvmem_t * m)
 
 	if(m->db)
 		kvdb_free(m->db);
+	if(m->pending)
+		free(m->pending);
 	kobj_remove_self(dev->kobj);
 	free(dev->name);
 	free(dev);
@@ -216,15 +596,46 @@ int nvmem_write(struct nvmem_t * m, void * buf, int offset, int count)
 			count = 0;
 		else if(count > capacity - offset)
 			count = capacity - offset;
+		m->writes++;
+		m->wbytes += count;
 		return m->write(m, buf, offset, count);
 	}
 	return 0;
 }
 
-void nvmem_set(struct nvmem_t * m, const char * key, const char * value)
+/*
+ * A set is refused when the database would no longer fit, compacted into
+ * a log half or as a legacy string.
+ */
+bool_t nvmem_set(struct nvmem_t * m, const char * key, const char * value)
 {
-	if(m && m->db)
-		kvdb_set(m->db, key, value);
+	char * old;
+	int klen, over, len, limit;
+
+	if(!m || !m->db || !key)
+		return FALSE;
+
+	klen = strlen(key);
+	if((klen == 0) || (klen > 255) || (value && (strlen(value) >= NVMEM_RECORD_DELETE)))
+		return FALSE;
+
+	if(value)
+	{
+		over = m->legacy ? 2 : NVMEM_RECORD_HEADER;
+		len = (m->legacy ? 8 + m->db->store_size : nvmem_image_size(m)) + over + klen + strlen(value);
+		old = kvdb_get(m->db, key, NULL);
+		if(old)
+			len -= over + klen + strlen(old);
+		limit = m->legacy ? nvmem_capacity(m) - 1 : m->hsize;
+		if(len > limit)
+			return FALSE;
+	}
+
+	kvdb_set(m->db, key, value);
+	old = kvdb_get(m->db, key, NULL);
+	if(!m->legacy)
+		nvmem_log_append(m, key, old);
+	return (!value || old) ? TRUE : FALSE;
 }
 
 char * nvmem_get(struct nvmem_t * m, const char * key, const char * def)
@@ -237,35 +648,37 @@ char * nvmem_get(struct nvmem_t * m, const char * key, const char * def)
 void nvmem_clear(struct nvmem_t * m)
 {
 	if(m && m->db)
-		return kvdb_clear(m->db);
+	{
+		kvdb_clear(m->db);
+		nvmem_log_drop(m);
+		m->compact = TRUE;
+	}
 }
 
-void nvmem_sync(struct nvmem_t * m)
+
+/*
+ * Commit the changes since the last sync, a batch that fits behind the log
+ * costs a single write. Returns FALSE if the write or the compaction
+ * failed, the changes stay pending for the next sync.
+ */
+bool_t nvmem_sync(struct nvmem_t * m)
 {
-	uint32_t c = 0;
-	char h[8];
-	char * s;
-	int l;
+	if(!m || !m->db)
+		return FALSE;
 
-	if(m && m->db)
+	if(m->legacy)
+		return nvmem_sync_legacy(m);
+
+	if(m->compact || (m->tail + m->plen > m->hsize))
+		return nvmem_log_compact(m);
+
+	if(m->plen > 0)
 	{
-		s = kvdb_to_string(m->db);
-		if(s)
-		{
-			l = strlen(s) + 1;
-			h[4] = (l >>  0) & 0xff;
-			h[5] = (l >>  8) & 0xff;
-			h[6] = (l >> 16) & 0xff;
-			h[7] = (l >> 24) & 0xff;
-			c = crc32_sum(c, (const uint8_t *)(&h[4]), 4);
-			c = crc32_sum(c, (const uint8_t *)s, l);
-			h[0] = (c >>  0) & 0xff;
-			h[1] = (c >>  8) & 0xff;
-			h[2] = (c >> 16) & 0xff;
-			h[3] = (c >> 24) & 0xff;
-			nvmem_write(m, h, 0, 8);
-			nvmem_write(m, s, 8, l);
-			free(s);
-		}
+		nvmem_log_seal(m->pending, m->plen, m->gen);
+		if(nvmem_write(m, m->pending, m->half * m->hsize + m->tail, m->plen) != m->plen)
+			return FALSE;
+		m->tail += m->plen;
+		nvmem_log_drop(m);
 	}
+	return TRUE;
 }
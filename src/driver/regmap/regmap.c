@@ -0,0 +1,608 @@
+/*
+ * driver/regmap/regmap.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <regmap/regmap.h>
+
+#define REGMAP_STACK_BUF	(64)
+
+static bool_t regmap_volatile(struct regmap_t * map, unsigned int reg)
+{
+	const struct regmap_range_t * r = map->cfg.volatile_table;
+	int i;
+
+	for(i = 0; i < map->cfg.num_volatile; i++)
+	{
+		if((reg >= r[i].min) && (reg <= r[i].max))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static bool_t regmap_cacheable(struct regmap_t * map, unsigned int reg)
+{
+	if((map->cfg.cache_type == REGCACHE_NONE) || map->cache_bypass)
+		return FALSE;
+	if(reg > map->cfg.max_register)
+		return FALSE;
+	return !regmap_volatile(map, reg);
+}
+
+static bool_t regmap_default(struct regmap_t * map, unsigned int reg, unsigned int * val)
+{
+	const struct regmap_reg_t * d = map->cfg.defaults;
+	int i;
+
+	for(i = 0; i < map->cfg.num_defaults; i++)
+	{
+		if(d[i].reg == reg)
+		{
+			*val = d[i].val;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static struct regcache_block_t * regcache_block(struct regmap_t * map, unsigned int reg, bool_t create)
+{
+	struct rb_node ** p = &map->tree.rb_node;
+	struct rb_node * parent = NULL;
+	struct regcache_block_t * blk;
+	unsigned int base = reg & ~(REGCACHE_BLOCK_SIZE - 1);
+
+	if(map->cfg.cache_type == REGCACHE_FLAT)
+		return &map->flat[reg / REGCACHE_BLOCK_SIZE];
+
+	while(*p)
+	{
+		parent = *p;
+		blk = rb_entry(parent, struct regcache_block_t, node);
+		if(base < blk->base)
+			p = &(*p)->rb_left;
+		else if(base > blk->base)
+			p = &(*p)->rb_right;
+		else
+			return blk;
+	}
+	if(!create)
+		return NULL;
+
+	blk = calloc(1, sizeof(struct regcache_block_t));
+	if(!blk)
+		return NULL;
+	blk->base = base;
+	rb_link_node(&blk->node, parent, p);
+	rb_insert_color(&blk->node, &map->tree);
+	return blk;
+}
+
+static bool_t regcache_get(struct regmap_t * map, unsigned int reg, unsigned int * val)
+{
+	struct regcache_block_t * blk = regcache_block(map, reg, FALSE);
+	int i = reg % REGCACHE_BLOCK_SIZE;
+
+	if(!blk || !(blk->valid & (1 << i)))
+		return FALSE;
+	*val = blk->val[i];
+	return TRUE;
+}
+
+static void regcache_set(struct regmap_t * map, unsigned int reg, unsigned int val, bool_t dirty)
+{
+	struct regcache_block_t * blk = regcache_block(map, reg, TRUE);
+	int i = reg % REGCACHE_BLOCK_SIZE;
+
+	if(blk)
+	{
+		blk->val[i] = val;
+		blk->valid |= (1 << i);
+		if(dirty)
+			blk->dirty |= (1 << i);
+		else
+			blk->dirty &= ~(1 << i);
+	}
+}
+
+static int regmap_encode_reg(struct regmap_t * map, u8_t * buf, unsigned int reg, unsigned int flags)
+{
+	int i;
+
+	for(i = map->reg_bytes - 1; i >= 0; i--)
+	{
+		buf[i] = reg & 0xff;
+		reg >>= 8;
+	}
+	buf[0] |= flags;
+	return map->reg_bytes;
+}
+
+static void regmap_encode_val(struct regmap_t * map, u8_t * buf, unsigned int val)
+{
+	int i;
+
+	for(i = 0; i < map->val_bytes; i++)
+	{
+		if(map->cfg.little_endian)
+			buf[i] = (val >> (i * 8)) & 0xff;
+		else
+			buf[map->val_bytes - 1 - i] = (val >> (i * 8)) & 0xff;
+	}
+}
+
+static unsigned int regmap_decode_val(struct regmap_t * map, const u8_t * buf)
+{
+	unsigned int val = 0;
+	int i;
+
+	for(i = 0; i < map->val_bytes; i++)
+	{
+		if(map->cfg.little_endian)
+			val |= (unsigned int)buf[i] << (i * 8);
+		else
+			val = (val << 8) | buf[i];
+	}
+	return val;
+}
+
+static bool_t regmap_bus_read(struct regmap_t * map, unsigned int reg, void * buf, int len)
+{
+	u8_t r[4];
+	unsigned int flags = map->cfg.read_flag_mask;
+
+	if(len > map->val_bytes)
+		flags |= map->cfg.bulk_flag_mask;
+	regmap_encode_reg(map, r, reg, flags);
+	map->reads++;
+	return map->read(map, r, map->reg_bytes, buf, len);
+}
+
+static bool_t regmap_bus_write(struct regmap_t * map, unsigned int reg, const unsigned int * val, int count)
+{
+	u8_t stack[REGMAP_STACK_BUF];
+	u8_t * buf = stack;
+	unsigned int flags = map->cfg.write_flag_mask;
+	int len = map->reg_bytes + count * map->val_bytes;
+	bool_t ret;
+	int i;
+
+	if(len > sizeof(stack))
+	{
+		buf = malloc(len);
+		if(!buf)
+			return FALSE;
+	}
+	if(count > 1)
+		flags |= map->cfg.bulk_flag_mask;
+	regmap_encode_reg(map, buf, reg, flags);
+	for(i = 0; i < count; i++)
+		regmap_encode_val(map, &buf[map->reg_bytes + i * map->val_bytes], val[i]);
+	map->writes++;
+	ret = map->write(map, buf, len);
+	if(buf != stack)
+		free(buf);
+	return ret;
+}
+
+static bool_t regmap_i2c_read(struct regmap_t * map, const u8_t * reg, int rlen, void * val, int vlen)
+{
+	struct i2c_device_t * dev = map->bus;
+	struct i2c_msg_t msgs[2];
+
+	msgs[0].addr = dev->addr;
+	msgs[0].flags = dev->flags & I2C_M_TEN;
+	msgs[0].len = rlen;
+	msgs[0].buf = (void *)reg;
+
+	msgs[1].addr = dev->addr;
+	msgs[1].flags = (dev->flags & I2C_M_TEN) | I2C_M_RD;
+	msgs[1].len = vlen;
+	msgs[1].buf = val;
+
+	return (i2c_transfer(dev->i2c, msgs, 2) == 2) ? TRUE : FALSE;
+}
+
+static bool_t regmap_i2c_write(struct regmap_t * map, const void * buf, int len)
+{
+	return (i2c_master_send(map->bus, (void *)buf, len) == len) ? TRUE : FALSE;
+}
+
+static bool_t regmap_spi_read(struct regmap_t * map, const u8_t * reg, int rlen, void * val, int vlen)
+{
+	struct spi_device_t * dev = map->bus;
+	int ret;
+
+	spi_device_select(dev);
+	ret = spi_device_write_then_read(dev, (void *)reg, rlen, val, vlen);
+	spi_device_deselect(dev);
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static bool_t regmap_spi_write(struct regmap_t * map, const void * buf, int len)
+{
+	struct spi_device_t * dev = map->bus;
+	int ret;
+
+	spi_device_select(dev);
+	ret = spi_device_write_then_read(dev, (void *)buf, len, NULL, 0);
+	spi_device_deselect(dev);
+	return (ret == 0) ? TRUE : FALSE;
+}
+
+static struct regmap_t * regmap_alloc(const struct regmap_config_t * cfg, void * bus,
+	bool_t (*read)(struct regmap_t *, const u8_t *, int, void *, int),
+	bool_t (*write)(struct regmap_t *, const void *, int))
+{
+	struct regmap_t * map;
+	int i;
+
+	if(!cfg || !bus)
+		return NULL;
+	if((cfg->reg_bits != 8) && (cfg->reg_bits != 16))
+		return NULL;
+	if((cfg->val_bits != 8) && (cfg->val_bits != 16) && (cfg->val_bits != 32))
+		return NULL;
+
+	map = malloc(sizeof(struct regmap_t));
+	if(!map)
+		return NULL;
+	memset(map, 0, sizeof(struct regmap_t));
+	memcpy(&map->cfg, cfg, sizeof(struct regmap_config_t));
+	map->reg_bytes = cfg->reg_bits / 8;
+	map->val_bytes = cfg->val_bits / 8;
+	map->read = read;
+	map->write = write;
+	map->bus = bus;
+	map->tree = RB_ROOT;
+
+	if(cfg->cache_type == REGCACHE_FLAT)
+	{
+		map->flat = calloc(cfg->max_register / REGCACHE_BLOCK_SIZE + 1, sizeof(struct regcache_block_t));
+		if(!map->flat)
+		{
+			free(map);
+			return NULL;
+		}
+		for(i = 0; i <= cfg->max_register / REGCACHE_BLOCK_SIZE; i++)
+			map->flat[i].base = i * REGCACHE_BLOCK_SIZE;
+	}
+	for(i = 0; i < cfg->num_defaults; i++)
+	{
+		if(regmap_cacheable(map, cfg->defaults[i].reg))
+			regcache_set(map, cfg->defaults[i].reg, cfg->defaults[i].val, FALSE);
+	}
+	return map;
+}
+
+struct regmap_t * regmap_alloc_i2c(struct i2c_device_t * dev, const struct regmap_config_t * cfg)
+{
+	return regmap_alloc(cfg, dev, regmap_i2c_read, regmap_i2c_write);
+}
+
+struct regmap_t * regmap_alloc_spi(struct spi_device_t * dev, const struct regmap_config_t * cfg)
+{
+	return regmap_alloc(cfg, dev, regmap_spi_read, regmap_spi_write);
+}
+
+void regmap_drop(struct regmap_t * map)
+{
+	struct regcache_block_t * pos, * n;
+	int i;
+
+	if(!map)
+		return;
+	if(map->flat)
+	{
+		for(i = 0; i <= map->cfg.max_register / REGCACHE_BLOCK_SIZE; i++)
+		{
+			map->flat[i].valid = 0;
+			map->flat[i].dirty = 0;
+		}
+	}
+	else
+	{
+		rbtree_postorder_for_each_entry_safe(pos, n, &map->tree, node)
+			free(pos);
+		map->tree = RB_ROOT;
+	}
+	map->cache_dirty = FALSE;
+}
+
+void regmap_free(struct regmap_t * map)
+{
+	if(map)
+	{
+		regmap_drop(map);
+		if(map->flat)
+			free(map->flat);
+		free(map);
+	}
+}
+
+bool_t regmap_read(struct regmap_t * map, unsigned int reg, unsigned int * val)
+{
+	u8_t buf[4];
+	unsigned int v;
+
+	if(!map || !val)
+		return FALSE;
+	if(regmap_cacheable(map, reg) && regcache_get(map, reg, val))
+	{
+		map->hits++;
+		return TRUE;
+	}
+	if(map->cache_only)
+		return FALSE;
+	if(!regmap_bus_read(map, reg, buf, map->val_bytes))
+		return FALSE;
+	v = regmap_decode_val(map, buf);
+	if(regmap_cacheable(map, reg))
+		regcache_set(map, reg, v, FALSE);
+	*val = v;
+	return TRUE;
+}
+
+bool_t regmap_write(struct regmap_t * map, unsigned int reg, unsigned int val)
+{
+	return regmap_bulk_write(map, reg, &val, 1);
+}
+
+/*
+ * Read-modify-write, the bus write is skipped when the value is already
+ * there, so with a warm cache an unchanged field costs no traffic at all.
+ */
+bool_t regmap_update_bits(struct regmap_t * map, unsigned int reg, unsigned int mask, unsigned int val)
+{
+	unsigned int old, new;
+
+	if(!regmap_read(map, reg, &old))
+		return FALSE;
+	new = (old & ~mask) | (val & mask);
+	if(new == old)
+		return TRUE;
+	return regmap_write(map, reg, new);
+}
+
+bool_t regmap_raw_read(struct regmap_t * map, unsigned int reg, void * buf, int len)
+{
+	if(!map || !buf || (len <= 0) || map->cache_only)
+		return FALSE;
+	return regmap_bus_read(map, reg, buf, len);
+}
+
+bool_t regmap_bulk_read(struct regmap_t * map, unsigned int reg, unsigned int * val, int count)
+{
+	u8_t stack[REGMAP_STACK_BUF];
+	u8_t * buf = stack;
+	int len, i;
+
+	if(!map || !val || (count <= 0))
+		return FALSE;
+	for(i = 0; i < count; i++)
+	{
+		if(!regmap_cacheable(map, reg + i) || !regcache_get(map, reg + i, &val[i]))
+			break;
+	}
+	if(i >= count)
+	{
+		map->hits += count;
+		return TRUE;
+	}
+	if(map->cfg.use_single_rw)
+	{
+		for(i = 0; i < count; i++)
+		{
+			if(!regmap_read(map, reg + i, &val[i]))
+				return FALSE;
+		}
+		return TRUE;
+	}
+
+	len = count * map->val_bytes;
+	if(len > sizeof(stack))
+	{
+		buf = malloc(len);
+		if(!buf)
+			return FALSE;
+	}
+	if(!regmap_raw_read(map, reg, buf, len))
+	{
+		if(buf != stack)
+			free(buf);
+		return FALSE;
+	}
+	for(i = 0; i < count; i++)
+	{
+		val[i] = regmap_decode_val(map, &buf[i * map->val_bytes]);
+		if(regmap_cacheable(map, reg + i))
+			regcache_set(map, reg + i, val[i], FALSE);
+	}
+	if(buf != stack)
+		free(buf);
+	return TRUE;
+}
+
+bool_t regmap_bulk_write(struct regmap_t * map, unsigned int reg, const unsigned int * val, int count)
+{
+	int i;
+
+	if(!map || !val || (count <= 0))
+		return FALSE;
+	if(map->cache_only)
+	{
+		for(i = 0; i < count; i++)
+		{
+			if(!regmap_cacheable(map, reg + i))
+				return FALSE;
+		}
+		for(i = 0; i < count; i++)
+			regcache_set(map, reg + i, val[i], TRUE);
+		map->cache_dirty = TRUE;
+		return TRUE;
+	}
+	if(map->cfg.use_single_rw && (count > 1))
+	{
+		for(i = 0; i < count; i++)
+		{
+			if(!regmap_bulk_write(map, reg + i, &val[i], 1))
+				return FALSE;
+		}
+		return TRUE;
+	}
+	if(!regmap_bus_write(map, reg, val, count))
+		return FALSE;
+	for(i = 0; i < count; i++)
+	{
+		if(regmap_cacheable(map, reg + i))
+			regcache_set(map, reg + i, val[i], FALSE);
+	}
+	return TRUE;
+}
+
+/*
+ * Write a register sequence, runs of consecutive registers are merged
+ * into one bus transaction each.
+ */
+bool_t regmap_multi_reg_write(struct regmap_t * map, const struct regmap_reg_t * regs, int count)
+{
+	unsigned int val[REGCACHE_BLOCK_SIZE];
+	int i, n;
+
+	if(!map || !regs)
+		return FALSE;
+	for(i = 0; i < count; i += n)
+	{
+		val[0] = regs[i].val;
+		for(n = 1; (i + n < count) && (n < REGCACHE_BLOCK_SIZE) && (regs[i + n].reg == regs[i].reg + n); n++)
+			val[n] = regs[i + n].val;
+		if(!regmap_bulk_write(map, regs[i].reg, val, n))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+void regmap_cache_only(struct regmap_t * map, bool_t enable)
+{
+	if(map)
+		map->cache_only = enable;
+}
+
+void regmap_cache_bypass(struct regmap_t * map, bool_t enable)
+{
+	if(map)
+		map->cache_bypass = enable;
+}
+
+/*
+ * Flag every cached register for the next sync, for when the hardware
+ * lost its state, such as across a suspend with the supply switched off.
+ */
+void regmap_mark_dirty(struct regmap_t * map)
+{
+	struct rb_node * rb;
+	struct regcache_block_t * blk;
+	int i;
+
+	if(!map)
+		return;
+	if(map->flat)
+	{
+		for(i = 0; i <= map->cfg.max_register / REGCACHE_BLOCK_SIZE; i++)
+			map->flat[i].dirty = map->flat[i].valid;
+	}
+	else
+	{
+		for(rb = rb_first(&map->tree); rb; rb = rb_next(rb))
+		{
+			blk = rb_entry(rb, struct regcache_block_t, node);
+			blk->dirty = blk->valid;
+		}
+	}
+	map->cache_dirty = TRUE;
+}
+
+static bool_t regcache_sync_block(struct regmap_t * map, struct regcache_block_t * blk)
+{
+	unsigned int def;
+	int i, n;
+
+	for(i = 0; i < REGCACHE_BLOCK_SIZE; i++)
+	{
+		if(!(blk->dirty & (1 << i)))
+			continue;
+		if(regmap_default(map, blk->base + i, &def) && (def == blk->val[i]))
+		{
+			blk->dirty &= ~(1 << i);
+			continue;
+		}
+		n = 1;
+		if(!map->cfg.use_single_rw)
+		{
+			while((i + n < REGCACHE_BLOCK_SIZE) && (blk->dirty & (1 << (i + n))))
+				n++;
+		}
+		if(!regmap_bus_write(map, blk->base + i, &blk->val[i], n))
+			return FALSE;
+		blk->dirty &= ~(((1 << n) - 1) << i);
+		i += n - 1;
+	}
+	return TRUE;
+}
+
+/*
+ * Write back the dirty cache, registers still at their reset default are
+ * skipped and consecutive dirty registers go out as one bulk write.
+ */
+bool_t regmap_sync(struct regmap_t * map)
+{
+	struct rb_node * rb;
+	int i;
+
+	if(!map || map->cache_only)
+		return FALSE;
+	if(!map->cache_dirty)
+		return TRUE;
+	if(map->flat)
+	{
+		for(i = 0; i <= map->cfg.max_register / REGCACHE_BLOCK_SIZE; i++)
+		{
+			if(!regcache_sync_block(map, &map->flat[i]))
+				return FALSE;
+		}
+	}
+	else
+	{
+		for(rb = rb_first(&map->tree); rb; rb = rb_next(rb))
+		{
+			if(!regcache_sync_block(map, rb_entry(rb, struct regcache_block_t, node)))
+				return FALSE;
+		}
+	}
+	map->cache_dirty = FALSE;
+	return TRUE;
+}
@@ -242,7 +242,7 @@ int regulator_get_voltage(const char * name)
 {
 	struct regulator_t * supply = search_regulator(name);
 
-	if(supply && supply->get_parent)
+	if(supply && supply->get_voltage)
 		return supply->get_voltage(supply);
 	return 0;
 }
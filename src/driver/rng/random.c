@@ -0,0 +1,343 @@
+/*
+ * driver/rng/random.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <sha256.h>
+#include <chacha20.h>
+#include <rng/rng.h>
+#include <rng/random.h>
+
+/*
+ * Entropy is hashed into a sha256 pool, from hardware rngs, from the
+ * timing of interrupts and from clocksource jitter, and credited
+ * conservatively. Once the pool holds enough, its digest becomes the key
+ * of a chacha20 generator, which is reseeded from fresh entropy after a
+ * while. Every request takes one block under the lock, half of it
+ * replaces the generator key so earlier output can not be recovered and
+ * the other half keys a private stream the caller's bytes come from,
+ * which keeps interrupts enabled however much is asked for.
+ */
+#define RANDOM_POOL_BITS		(512)
+#define RANDOM_SEED_BITS		(256)
+#define RANDOM_RESEED_BYTES		(1024 * 1024)
+#define RANDOM_RESEED_MS		(60 * 1000)
+#define RANDOM_REQUEST_MAX		(0x7fffffc0)
+#define RANDOM_CHUNK_BYTES		(1 << 30)
+
+static struct random_state_t {
+	spinlock_t lock;
+	struct sha256_ctx_t pool;
+	int bits;
+	u32_t fast[4];
+	int fcount;
+	struct chacha20_ctx_t crng;
+	bool_t init;
+	bool_t seeded;
+	u64_t generated;
+	ktime_t reseeded;
+	u32_t reseeds;
+} __random = {
+	.lock = SPIN_LOCK_INIT(),
+};
+
+#define rol32(v, n)		(((v) << (n)) | ((v) >> (32 - (n))))
+
+static void random_credit(int bits)
+{
+	__random.bits += bits;
+	if(__random.bits > RANDOM_POOL_BITS)
+		__random.bits = RANDOM_POOL_BITS;
+}
+
+void random_add_entropy(const void * buf, int len, int bits)
+{
+	irq_flags_t flags;
+
+	if(!buf || (len <= 0))
+		return;
+	spin_lock_irqsave(&__random.lock, flags);
+	sha256_update(&__random.pool, buf, len);
+	random_credit((bits < len * 8) ? bits : len * 8);
+	spin_unlock_irqrestore(&__random.lock, flags);
+}
+
+/*
+ * Called on every interrupt, folds the arrival time into a small pool that
+ * is hashed in later from thread context. One bit is credited per 64
+ * interrupts.
+ */
+void random_add_interrupt(void)
+{
+	u32_t t = (u32_t)ktime_to_ns(ktime_get());
+	u32_t * f = __random.fast;
+
+	f[0] += t;
+	f[1] ^= rol32(f[0], 7);
+	f[2] += rol32(f[1], 13) ^ t;
+	f[3] ^= rol32(f[2], 17) + f[0];
+	f[0] = rol32(f[0], 5) ^ f[3];
+	__random.fcount++;
+}
+
+static void random_drain_interrupt(void)
+{
+	irq_flags_t flags;
+	u32_t fast[4];
+	int count;
+
+	spin_lock_irqsave(&__random.lock, flags);
+	memcpy(fast, __random.fast, sizeof(fast));
+	count = __random.fcount;
+	__random.fcount = 0;
+	if(count >= 64)
+	{
+		sha256_update(&__random.pool, fast, sizeof(fast));
+		random_credit(count / 64);
+	}
+	else
+	{
+		__random.fcount = count;
+	}
+	spin_unlock_irqrestore(&__random.lock, flags);
+}
+
+/*
+ * Time a short memory walk whose path depends on the previous timing.
+ * Only samples whose delta differs from the one before are credited, at
+ * one bit per eight, so a coarse or stuck clocksource credits nothing.
+ */
+void random_add_jitter(int samples)
+{
+	u8_t mem[256];
+	u32_t delta[16];
+	u32_t last = 0, d;
+	ktime_t t0, t1;
+	int i, j, n, idx = 0, changes = 0;
+
+	for(i = 0; i < sizeof(mem); i++)
+		mem[i] = i;
+	for(i = 0; i < samples; i++)
+	{
+		t0 = ktime_get();
+		for(j = 0; j < 64; j++)
+		{
+			idx = (idx + mem[idx] + j + last) & (sizeof(mem) - 1);
+			mem[idx] ^= (u8_t)(j + idx);
+		}
+		t1 = ktime_get();
+		d = (u32_t)ktime_to_ns(ktime_sub(t1, t0));
+		if(d != last)
+			changes++;
+		last = d;
+		delta[i & 15] = d ^ ((u32_t)ktime_to_ns(t1) << 8);
+		if(((i & 15) == 15) && (i + 1 < samples))
+			random_add_entropy(delta, sizeof(delta), 0);
+	}
+	n = (samples > 0) ? ((samples - 1) & 15) + 1 : 0;
+	random_add_entropy(delta, n * sizeof(u32_t), changes / 8);
+}
+
+static void random_add_hardware(void)
+{
+	struct device_t * pos, * n;
+	u8_t buf[32];
+	int len;
+
+	list_for_each_entry_safe(pos, n, &__device_head[DEVICE_TYPE_RNG], head)
+	{
+		len = rng_read_data((struct rng_t *)pos->priv, buf, sizeof(buf), 0);
+		if(len > 0)
+			random_add_entropy(buf, len, len * 8 / 2);
+	}
+	memset(buf, 0, sizeof(buf));
+}
+
+static void random_reseed(void)
+{
+	static const u8_t nonce[CHACHA20_NONCE_SIZE] = { 0 };
+	irq_flags_t flags;
+	u8_t key[CHACHA20_BLOCK_SIZE];
+	const u8_t * digest;
+
+	spin_lock_irqsave(&__random.lock, flags);
+	chacha20_block(__random.crng.state, key);
+	sha256_update(&__random.pool, key, sizeof(key));
+	digest = sha256_final(&__random.pool);
+	memcpy(key, digest, SHA256_DIGEST_SIZE);
+	sha256_init(&__random.pool);
+	sha256_update(&__random.pool, &key[0], SHA256_DIGEST_SIZE);
+	chacha20_init(&__random.crng, key, nonce, 0);
+	__random.bits = 0;
+	__random.seeded = TRUE;
+	__random.generated = 0;
+	__random.reseeded = ktime_get();
+	__random.reseeds++;
+	spin_unlock_irqrestore(&__random.lock, flags);
+	memset(key, 0, sizeof(key));
+}
+
+static void random_init(void)
+{
+	static const u8_t zero[CHACHA20_KEY_SIZE + CHACHA20_NONCE_SIZE] = { 0 };
+	const char * id;
+	ktime_t now;
+
+	sha256_init(&__random.pool);
+	chacha20_init(&__random.crng, &zero[0], &zero[CHACHA20_KEY_SIZE], 0);
+	now = ktime_get();
+	sha256_update(&__random.pool, &now, sizeof(now));
+	id = machine_uniqueid();
+	if(id)
+		sha256_update(&__random.pool, id, strlen(id));
+	__random.init = TRUE;
+}
+
+/*
+ * Returns FALSE only if not seeded yet and the caller does not want to
+ * wait. Waiting gathers jitter until the pool is credited enough, and
+ * gives up crediting after a bounded number of rounds rather than hang on
+ * a board without a usable clocksource.
+ */
+static bool_t random_prepare(bool_t wait)
+{
+	int i;
+
+	if(!__random.init)
+		random_init();
+	random_drain_interrupt();
+
+	if(!__random.seeded)
+	{
+		random_add_hardware();
+		for(i = 0; wait && (__random.bits < RANDOM_SEED_BITS) && (i < 64); i++)
+			random_add_jitter(256);
+		if(__random.bits < RANDOM_SEED_BITS)
+		{
+			if(!wait)
+				return FALSE;
+			LOG("random: seeded with less than %d bits of entropy", RANDOM_SEED_BITS);
+		}
+		random_reseed();
+	}
+	else if((__random.generated >= RANDOM_RESEED_BYTES) || (ktime_ms_delta(ktime_get(), __random.reseeded) >= RANDOM_RESEED_MS))
+	{
+		random_add_hardware();
+		if(__random.bits >= RANDOM_SEED_BITS)
+			random_reseed();
+	}
+	return TRUE;
+}
+
+bool_t random_seeded(void)
+{
+	return __random.seeded;
+}
+
+/*
+ * A request is capped at RANDOM_REQUEST_MAX bytes and returns the count
+ * filled, the keystream is produced in int sized chunks.
+ */
+int getrandom(void * buf, size_t len, unsigned int flags)
+{
+	static const u8_t nonce[CHACHA20_NONCE_SIZE] = { 0 };
+	struct chacha20_ctx_t ctx;
+	irq_flags_t irq;
+	u8_t block[CHACHA20_BLOCK_SIZE];
+	u8_t * p = buf;
+	size_t left;
+	int n;
+
+	if(!buf)
+		return -1;
+	if(len > RANDOM_REQUEST_MAX)
+		len = RANDOM_REQUEST_MAX;
+	if(!random_prepare((flags & GRND_NONBLOCK) ? FALSE : TRUE))
+		return -1;
+
+	spin_lock_irqsave(&__random.lock, irq);
+	chacha20_block(__random.crng.state, block);
+	chacha20_init(&__random.crng, &block[0], nonce, 0);
+	__random.generated += len;
+	spin_unlock_irqrestore(&__random.lock, irq);
+
+	chacha20_init(&ctx, &block[CHACHA20_KEY_SIZE], nonce, 0);
+	for(left = len; left > 0; left -= n, p += n)
+	{
+		n = (left > RANDOM_CHUNK_BYTES) ? RANDOM_CHUNK_BYTES : (int)left;
+		chacha20_keystream(&ctx, p, n);
+	}
+	memset(&ctx, 0, sizeof(ctx));
+	memset(block, 0, sizeof(block));
+	return len;
+}
+
+u32_t random_u32(void)
+{
+	u32_t v = 0;
+
+	getrandom(&v, sizeof(v), 0);
+	return v;
+}
+
+static ssize_t random_read_entropy(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __random.bits);
+}
+
+static ssize_t random_read_seeded(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __random.seeded ? 1 : 0);
+}
+
+static ssize_t random_read_reseeds(struct kobj_t * kobj, void * buf, size_t size)
+{
+	return sprintf(buf, "%d", __random.reseeds);
+}
+
+static ssize_t random_read_uuid(struct kobj_t * kobj, void * buf, size_t size)
+{
+	u8_t u[16];
+
+	getrandom(u, sizeof(u), 0);
+	u[6] = (u[6] & 0x0f) | 0x40;
+	u[8] = (u[8] & 0x3f) | 0x80;
+	return sprintf(buf, "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
+		u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7], u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+}
+
+static __init void random_kobj_init(void)
+{
+	struct kobj_t * kclass = kobj_search_directory_with_create(kobj_get_root(), "class");
+	struct kobj_t * kobj = kobj_search_directory_with_create(kclass, "random");
+
+	kobj_add_regular(kobj, "entropy", random_read_entropy, NULL, NULL);
+	kobj_add_regular(kobj, "seeded", random_read_seeded, NULL, NULL);
+	kobj_add_regular(kobj, "reseeds", random_read_reseeds, NULL, NULL);
+	kobj_add_regular(kobj, "uuid", random_read_uuid, NULL, NULL);
+}
+core_initcall(random_kobj_init);
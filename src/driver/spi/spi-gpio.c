@@ -31,29 +31,29 @@
 #include <spi/spi.h>
 
 struct spi_gpio_pdata_t {
-	int sclk;
+	struct gpio_desc_t sclk;
 	int sclkcfg;
-	int mosi;
+	struct gpio_desc_t mosi;
 	int mosicfg;
-	int miso;
+	struct gpio_desc_t miso;
 	int misocfg;
-	int cs;
+	struct gpio_desc_t cs;
 	int cscfg;
 };
 
 static inline void spi_gpio_setsclk(struct spi_gpio_pdata_t * pdat, int state)
 {
-	gpio_set_value(pdat->sclk, state);
+	gpio_desc_set_value(&pdat->sclk, state);
 }
 
 static inline void spi_gpio_setmosi(struct spi_gpio_pdata_t * pdat, int state)
 {
-	gpio_set_value(pdat->mosi, state);
+	gpio_desc_set_value(&pdat->mosi, state);
 }
 
 static inline int spi_gpio_getmiso(struct spi_gpio_pdata_t * pdat)
 {
-	return gpio_get_value(pdat->miso);
+	return gpio_desc_get_value(&pdat->miso);
 }
 
 /*
@@ -262,15 +262,13 @@ static int spi_gpio_transfer(struct spi_t * spi, struct spi_msg_t * msg)
 static void spi_gpio_select(struct spi_t * spi, int cs)
 {
 	struct spi_gpio_pdata_t * pdat = (struct spi_gpio_pdata_t *)spi->priv;
-	if(pdat->cs >= 0)
-		gpio_set_value(pdat->cs, 0);
+	gpio_desc_set_value(&pdat->cs, 0);
 }
 
 static void spi_gpio_deselect(struct spi_t * spi, int cs)
 {
 	struct spi_gpio_pdata_t * pdat = (struct spi_gpio_pdata_t *)spi->priv;
-	if(pdat->cs >= 0)
-		gpio_set_value(pdat->cs, 1);
+	gpio_desc_set_value(&pdat->cs, 1);
 }
 
 static struct device_t * spi_gpio_probe(struct driver_t * drv, struct dtnode_t * n)
@@ -296,42 +294,42 @@ static struct device_t * spi_gpio_probe(struct driver_t * drv, struct dtnode_t *
 		return FALSE;
 	}
 
-	pdat->sclk = sclk;
+	gpio_desc_init(&pdat->sclk, sclk);
 	pdat->sclkcfg = dt_read_int(n, "sclk-gpio-config", -1);
-	pdat->mosi = mosi;
+	gpio_desc_init(&pdat->mosi, mosi);
 	pdat->mosicfg = dt_read_int(n, "mosi-gpio-config", -1);
-	pdat->miso = miso;
+	gpio_desc_init(&pdat->miso, miso);
 	pdat->misocfg = dt_read_int(n, "miso-gpio-config", -1);
-	pdat->cs = dt_read_int(n, "cs-gpio", -1);
+	gpio_desc_init(&pdat->cs, dt_read_int(n, "cs-gpio", -1));
 	pdat->cscfg = dt_read_int(n, "cs-gpio-config", -1);
 
-	if(pdat->sclk >= 0)
+	if(pdat->sclk.chip)
 	{
 		if(pdat->sclkcfg >= 0)
-			gpio_set_cfg(pdat->sclk, pdat->sclkcfg);
-		gpio_set_pull(pdat->sclk, GPIO_PULL_UP);
-		gpio_direction_output(pdat->sclk, 0);
+			gpio_desc_set_cfg(&pdat->sclk, pdat->sclkcfg);
+		gpio_desc_set_pull(&pdat->sclk, GPIO_PULL_UP);
+		gpio_desc_direction_output(&pdat->sclk, 0);
 	}
-	if(pdat->mosi >= 0)
+	if(pdat->mosi.chip)
 	{
 		if(pdat->mosicfg >= 0)
-			gpio_set_cfg(pdat->mosi, pdat->mosicfg);
-		gpio_set_pull(pdat->mosi, GPIO_PULL_UP);
-		gpio_direction_output(pdat->mosi, 0);
+			gpio_desc_set_cfg(&pdat->mosi, pdat->mosicfg);
+		gpio_desc_set_pull(&pdat->mosi, GPIO_PULL_UP);
+		gpio_desc_direction_output(&pdat->mosi, 0);
 	}
-	if(pdat->miso >= 0)
+	if(pdat->miso.chip)
 	{
 		if(pdat->misocfg >= 0)
-			gpio_set_cfg(pdat->miso, pdat->misocfg);
-		gpio_set_pull(pdat->miso, GPIO_PULL_UP);
-		gpio_direction_input(pdat->miso);
+			gpio_desc_set_cfg(&pdat->miso, pdat->misocfg);
+		gpio_desc_set_pull(&pdat->miso, GPIO_PULL_UP);
+		gpio_desc_direction_input(&pdat->miso);
 	}
-	if(pdat->cs >= 0)
+	if(pdat->cs.chip)
 	{
 		if(pdat->cscfg >= 0)
-			gpio_set_cfg(pdat->cs, pdat->cscfg);
-		gpio_set_pull(pdat->cs, GPIO_PULL_UP);
-		gpio_direction_output(pdat->cs, 1);
+			gpio_desc_set_cfg(&pdat->cs, pdat->cscfg);
+		gpio_desc_set_pull(&pdat->cs, GPIO_PULL_UP);
+		gpio_desc_direction_output(&pdat->cs, 1);
 	}
 
 	spi->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
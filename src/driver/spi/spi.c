@@ -27,8 +27,19 @@
  */
 
 #include <xboot.h>
+#include <dma/dma.h>
+#include <time/delay.h>
 #include <spi/spi.h>
 
+/*
+ * Messages queued per bus are drained by a zero delay timer, at most
+ * SPI_PUMP_BATCH of them per run so that a client requeueing from its
+ * completion callback can not starve the other timers.
+ */
+#define SPI_PUMP_BATCH	(8)
+
+static int spi_pump_timer_function(struct timer_t * timer, void * data);
+
 struct spi_t * search_spi(const char * name)
 {
 	struct device_t * dev;
@@ -50,6 +61,13 @@ bool_t register_spi(struct device_t ** device, struct spi_t * spi)
 	if(!dev)
 		return FALSE;
 
+	init_list_head(&spi->queue);
+	timer_init(&spi->timer, spi_pump_timer_function, spi);
+	spin_lock_init(&spi->lock);
+	spi->busy = 0;
+	spi->pumping = 0;
+	spi->kicked = 0;
+
 	dev->name = strdup(spi->name);
 	dev->type = DEVICE_TYPE_SPI;
 	dev->driver = NULL;
@@ -83,6 +101,7 @@ bool_t unregister_spi(struct spi_t * spi)
 	if(!unregister_device(dev))
 		return FALSE;
 
+	timer_cancel(&spi->timer);
 	kobj_remove_self(dev->kobj);
 	free(dev->name);
 	free(dev);
@@ -132,6 +151,7 @@ struct spi_device_t * spi_device_alloc(const char * spibus, int cs, int type, in
 	dev->mode = mode & 0x3;
 	dev->bits = bits;
 	dev->speed = (speed > 0) ? speed : 0;
+	dev->claimed = 0;
 	return dev;
 }
 
@@ -141,13 +161,46 @@ void spi_device_free(struct spi_device_t * dev)
 		free(dev);
 }
 
+static bool_t spi_bus_claim(struct spi_t * spi)
+{
+	irq_flags_t flags;
+	bool_t ret = FALSE;
+
+	spin_lock_irqsave(&spi->lock, flags);
+	if(!spi->busy)
+	{
+		spi->busy = 1;
+		ret = TRUE;
+	}
+	spin_unlock_irqrestore(&spi->lock, flags);
+	return ret;
+}
+
+static void spi_bus_release(struct spi_t * spi)
+{
+	irq_flags_t flags;
+
+	spin_lock_irqsave(&spi->lock, flags);
+	spi->busy = 0;
+	spin_unlock_irqrestore(&spi->lock, flags);
+}
+
+/*
+ * Outside a select window the bus is claimed for the call, so it can not
+ * interleave with the queue pump.
+ */
 int spi_device_write_then_read(struct spi_device_t * dev, void * txbuf, int txlen, void * rxbuf, int rxlen)
 {
 	struct spi_msg_t msg;
+	int own, ret = 0;
 
 	if(!dev)
 		return -1;
 
+	own = dev->claimed ? 0 : 1;
+	if(own && !spi_bus_claim(dev->spi))
+		return -1;
+
 	msg.type = dev->type;
 	msg.mode = dev->mode;
 	msg.bits = dev->bits;
@@ -159,27 +212,217 @@ int spi_device_write_then_read(struct spi_device_t * dev, void * txbuf, int txle
 		msg.rxbuf = NULL;
 		msg.len = txlen;
 		if(dev->spi->transfer(dev->spi, &msg) != txlen)
-			return -1;
+			ret = -1;
 	}
-	if(rxlen > 0)
+	if((ret == 0) && (rxlen > 0))
 	{
 		msg.txbuf = NULL;
 		msg.rxbuf = rxbuf;
 		msg.len = rxlen;
 		if(dev->spi->transfer(dev->spi, &msg) != rxlen)
-			return -1;
+			ret = -1;
 	}
-	return 0;
+
+	if(own)
+		spi_bus_release(dev->spi);
+	return ret;
 }
 
+/*
+ * The chip select window of a direct user holds the bus, queued messages
+ * wait for the deselect. Only a select that got the bus releases it.
+ */
 void spi_device_select(struct spi_device_t * dev)
 {
-	if(dev && dev->spi && dev->spi->select)
-		dev->spi->select(dev->spi, dev->cs);
+	if(dev && dev->spi)
+	{
+		dev->claimed = spi_bus_claim(dev->spi) ? 1 : 0;
+		if(dev->spi->select)
+			dev->spi->select(dev->spi, dev->cs);
+	}
 }
 
 void spi_device_deselect(struct spi_device_t * dev)
 {
-	if(dev && dev->spi && dev->spi->deselect)
-		dev->spi->deselect(dev->spi, dev->cs);
+	if(dev && dev->spi)
+	{
+		if(dev->spi->deselect)
+			dev->spi->deselect(dev->spi, dev->cs);
+		if(dev->claimed)
+		{
+			dev->claimed = 0;
+			spi_bus_release(dev->spi);
+		}
+	}
+}
+
+static void spi_run_message(struct spi_t * spi, struct spi_message_t * m)
+{
+	struct spi_device_t * dev = m->dev;
+	struct spi_transfer_t * t;
+	struct spi_msg_t msg;
+	int status = 0;
+
+	m->actual = 0;
+	if(spi->select)
+		spi->select(spi, dev->cs);
+	list_for_each_entry(t, &m->transfers, list)
+	{
+		msg.txbuf = t->txbuf;
+		msg.rxbuf = t->rxbuf;
+		msg.len = t->len;
+		msg.type = dev->type;
+		msg.mode = dev->mode;
+		msg.bits = (t->bits > 0) ? t->bits : dev->bits;
+		msg.speed = (t->speed > 0) ? t->speed : dev->speed;
+		if((t->len > 0) && (spi->transfer(spi, &msg) != t->len))
+		{
+			status = -1;
+			break;
+		}
+		m->actual += t->len;
+		if(t->delay_us > 0)
+			udelay(t->delay_us);
+		if(t->cs_change && !list_is_last(&t->list, &m->transfers))
+		{
+			if(spi->deselect)
+				spi->deselect(spi, dev->cs);
+			if(spi->select)
+				spi->select(spi, dev->cs);
+		}
+	}
+	if(spi->deselect)
+		spi->deselect(spi, dev->cs);
+	m->status = status;
+}
+
+static int spi_pump_timer_function(struct timer_t * timer, void * data)
+{
+	struct spi_t * spi = (struct spi_t *)data;
+	struct spi_message_t * m;
+	irq_flags_t flags;
+	int n, restart;
+
+	spin_lock_irqsave(&spi->lock, flags);
+	if(spi->busy)
+	{
+		spin_unlock_irqrestore(&spi->lock, flags);
+		timer_forward_now(timer, us_to_ktime(100));
+		return 1;
+	}
+	spi->busy = 1;
+	spi->pumping = 1;
+	spi->kicked = 0;
+	spin_unlock_irqrestore(&spi->lock, flags);
+
+	for(n = 0; n < SPI_PUMP_BATCH; n++)
+	{
+		spin_lock_irqsave(&spi->lock, flags);
+		m = list_first_entry_or_null(&spi->queue, struct spi_message_t, queue);
+		if(m)
+			list_del_init(&m->queue);
+		spin_unlock_irqrestore(&spi->lock, flags);
+		if(!m)
+			break;
+		spi_run_message(spi, m);
+		if(m->complete)
+			m->complete(m);
+	}
+
+	spin_lock_irqsave(&spi->lock, flags);
+	spi->busy = 0;
+	spi->pumping = 0;
+	restart = list_empty(&spi->queue) ? 0 : 1;
+	spi->kicked = restart;
+	spin_unlock_irqrestore(&spi->lock, flags);
+	if(restart)
+		timer_forward_now(timer, ns_to_ktime(0));
+	return restart;
+}
+
+/*
+ * Run a message right away, fails when the bus is held by someone else,
+ * which also makes it unusable from a completion callback.
+ */
+int spi_sync(struct spi_device_t * dev, struct spi_message_t * m)
+{
+	struct spi_t * spi;
+
+	if(!dev || !m)
+		return -1;
+	spi = dev->spi;
+	if(!spi_bus_claim(spi))
+		return -1;
+	m->dev = dev;
+	spi_run_message(spi, m);
+	spi_bus_release(spi);
+	return (m->status < 0) ? m->status : m->actual;
+}
+
+/*
+ * Queue a message and return, the complete callback runs from timer
+ * context when it is done. Messages of one bus run in queue order.
+ */
+int spi_async(struct spi_device_t * dev, struct spi_message_t * m)
+{
+	struct spi_t * spi;
+	irq_flags_t flags;
+	int start;
+
+	if(!dev || !m)
+		return -1;
+	spi = dev->spi;
+	m->dev = dev;
+	m->status = 1;
+	m->actual = 0;
+
+	spin_lock_irqsave(&spi->lock, flags);
+	list_add_tail(&m->queue, &spi->queue);
+	start = (!spi->pumping && !spi->kicked) ? 1 : 0;
+	if(start)
+		spi->kicked = 1;
+	spin_unlock_irqrestore(&spi->lock, flags);
+	if(start)
+		timer_start_now(&spi->timer, ns_to_ktime(0));
+	return 0;
+}
+
+/*
+ * Take a queued message off the queue before it runs, the complete callback
+ * is not called. Fails while the pump is running the message, the caller
+ * then has to wait for its status.
+ */
+int spi_cancel(struct spi_device_t * dev, struct spi_message_t * m)
+{
+	struct spi_t * spi;
+	irq_flags_t flags;
+	int ret;
+
+	if(!dev || !m)
+		return -1;
+	spi = dev->spi;
+
+	spin_lock_irqsave(&spi->lock, flags);
+	if(!list_empty(&m->queue))
+	{
+		list_del_init(&m->queue);
+		m->status = -1;
+	}
+	ret = (m->status > 0) ? -1 : 0;
+	spin_unlock_irqrestore(&spi->lock, flags);
+	return ret;
+}
+
+/*
+ * Transfer buffers from the dma pool, for controllers that move data by
+ * dma instead of programmed io.
+ */
+void * spi_dma_alloc(int size)
+{
+	return dma_alloc_coherent(size);
+}
+
+void spi_dma_free(void * buf)
+{
+	dma_free_coherent(buf);
 }
@@ -0,0 +1,519 @@
+/*
+ * driver/stepper/planner.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <math.h>
+#include <stepper/planner.h>
+
+static inline int planner_min(int a, int b)
+{
+	return (a < b) ? a : b;
+}
+
+static inline int planner_max(int a, int b)
+{
+	return (a > b) ? a : b;
+}
+
+static inline struct stepper_segment_t * planner_seg(struct stepper_planner_t * p, unsigned int i)
+{
+	return &p->seg[i & (p->depth - 1)];
+}
+
+static inline u32_t planner_interval(struct stepper_planner_t * p, int k)
+{
+	return (k < p->nramp) ? p->ramp[k] : p->cruise;
+}
+
+/*
+ * Ramp position of a speed, the first table entry that is at least as fast
+ */
+static int planner_speed_to_k(struct stepper_planner_t * p, int speed)
+{
+	u32_t interval;
+	int lo = 0, hi = p->nramp, mid;
+
+	if(speed <= 0)
+		return 0;
+	if(speed >= p->vmax)
+		return p->nramp;
+	interval = 1000000000U / speed;
+	while(lo < hi)
+	{
+		mid = (lo + hi) >> 1;
+		if(p->ramp[mid] <= interval)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+struct planner_shape_t {
+	double j, a, vmax;
+	double t1, t2;
+	double v1, v2;
+	double s1, s2, s3;
+};
+
+/*
+ * Distance covered after t seconds of a ramp from rest to vmax, jerk
+ * limited phases around a constant acceleration phase, then cruise.
+ */
+static double planner_shape_position(struct planner_shape_t * r, double t)
+{
+	if(t < r->t1)
+		return r->j * t * t * t / 6;
+	t -= r->t1;
+	if(t < r->t2)
+		return r->s1 + r->v1 * t + r->a * t * t / 2;
+	t -= r->t2;
+	if(t < r->t1)
+		return r->s2 + r->v2 * t + r->a * t * t / 2 - r->j * t * t * t / 6;
+	t -= r->t1;
+	return r->s3 + r->vmax * t;
+}
+
+static void planner_shape_init(struct planner_shape_t * r, double vmax, double a, double j)
+{
+	r->vmax = vmax;
+	r->a = a;
+	r->j = j;
+	if(j > 0)
+	{
+		r->t1 = a / j;
+		if(a * r->t1 > vmax)
+		{
+			r->a = sqrt(vmax * j);
+			r->t1 = r->a / j;
+		}
+	}
+	else
+	{
+		r->t1 = 0;
+	}
+	r->v1 = r->j * r->t1 * r->t1 / 2;
+	r->s1 = r->j * r->t1 * r->t1 * r->t1 / 6;
+	r->t2 = (vmax - 2 * r->v1) / r->a;
+	if(r->t2 < 0)
+		r->t2 = 0;
+	r->v2 = r->v1 + r->a * r->t2;
+	r->s2 = r->s1 + r->v1 * r->t2 + r->a * r->t2 * r->t2 / 2;
+	r->s3 = r->s2 + r->v2 * r->t1 + r->a * r->t1 * r->t1 / 2 - r->j * r->t1 * r->t1 * r->t1 / 6;
+}
+
+/*
+ * Find the time of every whole step along the ramp by bisection and keep
+ * the differences. Runs once per profile, never in the timer. A ramp longer
+ * than the table is cut, set_profile then lowers vmax to its last entry.
+ */
+static u32_t * planner_ramp_build(struct planner_shape_t * r, u32_t cruise, int * count)
+{
+	u32_t * ramp;
+	double tend = 2 * r->t1 + r->t2 + 2.0 / r->vmax;
+	double tprev = 0, lo, hi, mid;
+	u32_t interval;
+	int n, k, i;
+
+	n = (int)ceil(r->s3);
+	if(n > STEPPER_PLANNER_MAX_RAMP)
+		n = STEPPER_PLANNER_MAX_RAMP;
+	if(n < 1)
+		n = 1;
+
+	ramp = malloc(sizeof(u32_t) * n);
+	if(!ramp)
+		return NULL;
+
+	for(k = 0; k < n; k++)
+	{
+		lo = tprev;
+		hi = tend;
+		for(i = 0; i < 48; i++)
+		{
+			mid = (lo + hi) / 2;
+			if(planner_shape_position(r, mid) < (double)(k + 1))
+				lo = mid;
+			else
+				hi = mid;
+		}
+		interval = (u32_t)((hi - tprev) * 1e9);
+		ramp[k] = (interval > cruise) ? interval : cruise;
+		tprev = hi;
+	}
+	*count = n;
+	return ramp;
+}
+
+/*
+ * Backward pass bounds entries by the room left to brake before the end
+ * of the queue, forward pass by the room to accelerate. The running
+ * segment keeps its entry and peak, its exit is raised towards the entry
+ * of the next one as long as it has not started braking yet.
+ */
+static void planner_replan(struct stepper_planner_t * p)
+{
+	struct stepper_segment_t * s;
+	unsigned int first = p->out + (p->running ? 1 : 0);
+	unsigned int i;
+	int k, kn, kp;
+
+	if(first == p->in)
+		return;
+
+	for(i = p->in, k = 0; i != first; )
+	{
+		s = planner_seg(p, --i);
+		s->kentry = planner_min(s->kmaxentry, k + s->steps);
+		k = s->kentry;
+	}
+
+	if(p->running)
+	{
+		s = planner_seg(p, p->out);
+		k = planner_min(k, s->kpeak);
+		if((k > s->kexit) && (p->index <= s->steps - s->decel))
+		{
+			s->kexit = k;
+			s->decel = planner_min(s->kpeak - k, s->steps - s->accel);
+		}
+	}
+
+	k = p->running ? planner_seg(p, p->out)->kexit : 0;
+	for(i = first; i != p->in; i++)
+	{
+		s = planner_seg(p, i);
+		s->kentry = k;
+		kn = (i + 1 != p->in) ? planner_min(planner_seg(p, i + 1)->kentry, k + s->steps) : 0;
+		s->kexit = kn;
+
+		kp = planner_min(s->knominal, (s->steps + s->kentry + s->kexit) / 2);
+		kp = planner_max(kp, planner_max(s->kentry, s->kexit));
+		s->kpeak = kp;
+		s->accel = kp - s->kentry;
+		s->decel = planner_min(kp - s->kexit, s->steps - s->accel);
+		k = kn;
+	}
+}
+
+static int planner_timer_function(struct timer_t * timer, void * data)
+{
+	struct stepper_planner_t * p = (struct stepper_planner_t *)(data);
+	struct stepper_segment_t * s;
+	irq_flags_t flags;
+	ktime_t now = ktime_get();
+	s64_t jitter, delta;
+	u32_t rate;
+	int i, k;
+
+	jitter = ktime_to_ns(ktime_sub(now, timer->expires));
+	if(jitter > p->jitter_max)
+		p->jitter_max = jitter;
+	p->jitter_sum += jitter;
+	if(p->steps > 0)
+	{
+		delta = ktime_to_ns(ktime_sub(now, p->stamp));
+		if(delta > 0)
+		{
+			rate = (u32_t)(1000000000LL / delta);
+			if(rate > p->rate_max)
+				p->rate_max = rate;
+		}
+	}
+	p->stamp = now;
+
+	spin_lock_irqsave(&p->lock, flags);
+	if(!p->running)
+	{
+		if(p->out == p->in)
+		{
+			p->active = 0;
+			spin_unlock_irqrestore(&p->lock, flags);
+			return 0;
+		}
+		s = planner_seg(p, p->out);
+		for(i = 0; i < p->naxis; i++)
+			p->err[i] = s->steps / 2;
+		p->index = 0;
+		p->running = 1;
+	}
+	s = planner_seg(p, p->out);
+
+	/*
+	 * Bresenham across the axes, the dominant one steps every tick
+	 */
+	for(i = 0; i < p->naxis; i++)
+	{
+		p->err[i] += s->delta[i];
+		if(p->err[i] >= s->steps)
+		{
+			p->err[i] -= s->steps;
+			stepper_step(p->axis[i], s->dir[i]);
+		}
+	}
+	p->steps++;
+
+	i = p->index++;
+	if(i < s->accel)
+		k = s->kentry + i;
+	else if(i >= s->steps - s->decel)
+		k = s->kpeak - 1 - (i - (s->steps - s->decel));
+	else
+		k = s->kpeak;
+	if(k < 0)
+		k = 0;
+
+	if(p->index >= s->steps)
+	{
+		p->running = 0;
+		p->out++;
+		p->segments++;
+		if(p->out == p->in)
+		{
+			p->active = 0;
+			spin_unlock_irqrestore(&p->lock, flags);
+			return 0;
+		}
+	}
+	spin_unlock_irqrestore(&p->lock, flags);
+
+	timer_forward(timer, timer->expires, ns_to_ktime(planner_interval(p, k)));
+	if(ktime_before(timer->expires, now))
+	{
+		p->missed++;
+		timer_forward(timer, now, ns_to_ktime(planner_interval(p, k)));
+	}
+	return 1;
+}
+
+struct stepper_planner_t * stepper_planner_alloc(struct stepper_t ** axis, int naxis, int depth)
+{
+	struct stepper_planner_t * p;
+	int i;
+
+	if(!axis || (naxis <= 0) || (naxis > STEPPER_PLANNER_MAX_AXES) || (depth <= 0))
+		return NULL;
+	for(i = 0; i < naxis; i++)
+	{
+		if(!axis[i] || !axis[i]->step)
+			return NULL;
+	}
+
+	p = malloc(sizeof(struct stepper_planner_t));
+	if(!p)
+		return NULL;
+	memset(p, 0, sizeof(struct stepper_planner_t));
+
+	if(depth & (depth - 1))
+		depth = roundup_pow_of_two(depth);
+	p->seg = malloc(sizeof(struct stepper_segment_t) * depth);
+	if(!p->seg)
+	{
+		free(p);
+		return NULL;
+	}
+	p->depth = depth;
+	for(i = 0; i < naxis; i++)
+		p->axis[i] = axis[i];
+	p->naxis = naxis;
+	spin_lock_init(&p->lock);
+	timer_init(&p->timer, planner_timer_function, p);
+
+	if(!stepper_planner_set_profile(p, STEPPER_PROFILE_TRAPEZOID, 1000, 2000, 0))
+	{
+		free(p->seg);
+		free(p);
+		return NULL;
+	}
+	return p;
+}
+
+void stepper_planner_free(struct stepper_planner_t * p)
+{
+	if(p)
+	{
+		stepper_planner_stop(p);
+		free(p->ramp);
+		free(p->seg);
+		free(p);
+	}
+}
+
+/*
+ * Speeds in steps per second of the dominant axis, accel in steps per
+ * second squared and jerk in steps per second cubed. The s-curve profile
+ * needs a jerk, ramps are cut at STEPPER_PLANNER_MAX_RAMP steps and vmax is
+ * lowered to the speed reached there.
+ */
+bool_t stepper_planner_set_profile(struct stepper_planner_t * p, enum stepper_profile_t profile, int vmax, int accel, int jerk)
+{
+	struct planner_shape_t r;
+	u32_t * ramp, cruise;
+	int n;
+
+	if(!p || (vmax <= 0) || (accel <= 0))
+		return FALSE;
+	if((profile == STEPPER_PROFILE_SCURVE) && (jerk <= 0))
+		return FALSE;
+	if(stepper_planner_busying(p))
+		return FALSE;
+
+	cruise = 1000000000U / vmax;
+	planner_shape_init(&r, vmax, accel, (profile == STEPPER_PROFILE_SCURVE) ? jerk : 0);
+	ramp = planner_ramp_build(&r, cruise, &n);
+	if(!ramp)
+		return FALSE;
+	if((n < ceil(r.s3)) && (ramp[n - 1] > cruise))
+	{
+		cruise = ramp[n - 1];
+		vmax = 1000000000U / cruise;
+	}
+
+	free(p->ramp);
+	p->ramp = ramp;
+	p->nramp = n;
+	p->cruise = cruise;
+	p->profile = profile;
+	p->vmax = vmax;
+	p->accel = accel;
+	p->jerk = jerk;
+	return TRUE;
+}
+
+/*
+ * Queue a relative move, speed in steps per second of its dominant axis,
+ * zero or less for the profile maximum. Returns FALSE on a full queue.
+ */
+bool_t stepper_planner_line(struct stepper_planner_t * p, const int * delta, int speed)
+{
+	struct stepper_segment_t * s;
+	irq_flags_t flags;
+	double dot = 0, la = 0, lb = 0, c;
+	int steps = 0;
+	int i;
+
+	if(!p || !delta)
+		return FALSE;
+	for(i = 0; i < p->naxis; i++)
+		steps = planner_max(steps, abs(delta[i]));
+	if(steps == 0)
+		return TRUE;
+	if((speed <= 0) || (speed > p->vmax))
+		speed = p->vmax;
+
+	spin_lock_irqsave(&p->lock, flags);
+	if(p->in - p->out >= p->depth)
+	{
+		spin_unlock_irqrestore(&p->lock, flags);
+		return FALSE;
+	}
+	s = planner_seg(p, p->in);
+	spin_unlock_irqrestore(&p->lock, flags);
+
+	for(i = 0; i < p->naxis; i++)
+	{
+		s->delta[i] = abs(delta[i]);
+		s->dir[i] = (delta[i] < 0) ? -1 : 1;
+	}
+	s->steps = steps;
+	s->knominal = planner_speed_to_k(p, speed);
+
+	/*
+	 * Corner speed scales with the cosine of the angle between the moves,
+	 * reversals and moves after an idle queue start from rest.
+	 */
+	s->kmaxentry = 0;
+	if(p->active)
+	{
+		for(i = 0; i < p->naxis; i++)
+		{
+			dot += (double)p->last[i] * delta[i];
+			la += (double)p->last[i] * p->last[i];
+			lb += (double)delta[i] * delta[i];
+		}
+		if((dot > 0) && (la > 0) && (lb > 0))
+		{
+			c = dot / sqrt(la * lb);
+			s->kmaxentry = planner_speed_to_k(p, (int)(planner_min(p->vlast, speed) * c));
+		}
+	}
+	for(i = 0; i < p->naxis; i++)
+		p->last[i] = delta[i];
+	p->vlast = speed;
+
+	spin_lock_irqsave(&p->lock, flags);
+	p->in++;
+	planner_replan(p);
+	if(!p->active)
+	{
+		p->active = 1;
+		spin_unlock_irqrestore(&p->lock, flags);
+		if(p->timer.state != TIMER_STATE_ENQUEUED)
+			timer_start_now(&p->timer, ns_to_ktime(0));
+	}
+	else
+	{
+		spin_unlock_irqrestore(&p->lock, flags);
+	}
+	return TRUE;
+}
+
+int stepper_planner_busying(struct stepper_planner_t * p)
+{
+	if(p)
+		return p->active;
+	return 0;
+}
+
+void stepper_planner_stop(struct stepper_planner_t * p)
+{
+	irq_flags_t flags;
+
+	if(p)
+	{
+		timer_cancel(&p->timer);
+		spin_lock_irqsave(&p->lock, flags);
+		p->out = p->in;
+		p->running = 0;
+		p->active = 0;
+		spin_unlock_irqrestore(&p->lock, flags);
+	}
+}
+
+void stepper_planner_reset_stats(struct stepper_planner_t * p)
+{
+	if(p)
+	{
+		p->steps = 0;
+		p->segments = 0;
+		p->missed = 0;
+		p->jitter_max = 0;
+		p->jitter_sum = 0;
+		p->rate_max = 0;
+	}
+}
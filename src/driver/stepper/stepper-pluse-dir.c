@@ -32,36 +32,48 @@
 
 struct stepper_pluse_dir_pdata_t {
 	struct timer_t timer;
-	int pluse;
+	struct timer_t ptimer;
+	int pstate;
+	struct gpio_desc_t pluse;
 	int plusecfg;
 	int pluseinv;
-	int dir;
+	struct gpio_desc_t dir;
 	int dircfg;
 	int dirinv;
-	int en;
+	struct gpio_desc_t en;
 	int encfg;
 	int eninv;
+	int width;
 	int dspeed;
 	int enable;
 	int step;
 	int flag;
 	int speed;
 	int busying;
+	int lastdir;
 };
 
+static int stepper_pluse_dir_set_dir(struct stepper_pluse_dir_pdata_t * pdat, int dir)
+{
+	dir = (dir < 0) ? -1 : 1;
+	if(dir == pdat->lastdir)
+		return 0;
+	gpio_desc_set_value(&pdat->dir, ((dir < 0) ^ pdat->dirinv) ? 0 : 1);
+	pdat->lastdir = dir;
+	return 1;
+}
+
 static void stepper_pluse_dir_enable(struct stepper_t * m)
 {
 	struct stepper_pluse_dir_pdata_t * pdat = (struct stepper_pluse_dir_pdata_t *)m->priv;
-	if(pdat->en >= 0)
-		gpio_set_value(pdat->en, pdat->eninv ? 0 : 1);
+	gpio_desc_set_value(&pdat->en, pdat->eninv ? 0 : 1);
 	pdat->enable = 1;
 }
 
 static void stepper_pluse_dir_disable(struct stepper_t * m)
 {
 	struct stepper_pluse_dir_pdata_t * pdat = (struct stepper_pluse_dir_pdata_t *)m->priv;
-	if(pdat->en >= 0)
-		gpio_set_value(pdat->en, pdat->eninv ? 1 : 0);
+	gpio_desc_set_value(&pdat->en, pdat->eninv ? 1 : 0);
 	pdat->enable = 0;
 }
 
@@ -70,13 +82,7 @@ static void stepper_pluse_dir_move(struct stepper_t * m, int step, int speed)
 	struct stepper_pluse_dir_pdata_t * pdat = (struct stepper_pluse_dir_pdata_t *)m->priv;
 	if(pdat->enable && !pdat->busying)
 	{
-		if(pdat->dir >= 0)
-		{
-			if(step < 0)
-				gpio_set_value(pdat->dir, pdat->dirinv ? 1 : 0);
-			else
-				gpio_set_value(pdat->dir, pdat->dirinv ? 0 : 1);
-		}
+		stepper_pluse_dir_set_dir(pdat, step);
 		pdat->step = abs(step);
 		pdat->speed = (speed > 0) ? speed : pdat->dspeed;
 		pdat->busying = 1;
@@ -84,6 +90,58 @@ static void stepper_pluse_dir_move(struct stepper_t * m, int step, int speed)
 	}
 }
 
+/*
+ * Single step pulses for the planner, which calls in from its timer. The
+ * pulse is raised at once and dropped by a one shot timer after
+ * pluse-width-us, a direction change first gets the same time to settle
+ * before the pulse is raised. A step arriving while the previous pulse is
+ * still out cuts that pulse short.
+ */
+enum {
+	PLUSE_STATE_IDLE	= 0,
+	PLUSE_STATE_RISE	= 1,
+	PLUSE_STATE_FALL	= 2,
+};
+
+static int stepper_pluse_dir_pulse_timer_function(struct timer_t * timer, void * data)
+{
+	struct stepper_pluse_dir_pdata_t * pdat = (struct stepper_pluse_dir_pdata_t *)(data);
+
+	if(pdat->pstate == PLUSE_STATE_RISE)
+	{
+		gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 0 : 1);
+		pdat->pstate = PLUSE_STATE_FALL;
+		timer_forward_now(timer, us_to_ktime(pdat->width));
+		return 1;
+	}
+	gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 1 : 0);
+	pdat->pstate = PLUSE_STATE_IDLE;
+	return 0;
+}
+
+static void stepper_pluse_dir_step(struct stepper_t * m, int dir)
+{
+	struct stepper_pluse_dir_pdata_t * pdat = (struct stepper_pluse_dir_pdata_t *)m->priv;
+	if(pdat->enable && !pdat->busying)
+	{
+		if(pdat->pstate != PLUSE_STATE_IDLE)
+		{
+			timer_cancel(&pdat->ptimer);
+			gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 1 : 0);
+		}
+		if(stepper_pluse_dir_set_dir(pdat, dir))
+		{
+			pdat->pstate = PLUSE_STATE_RISE;
+		}
+		else
+		{
+			gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 0 : 1);
+			pdat->pstate = PLUSE_STATE_FALL;
+		}
+		timer_start_now(&pdat->ptimer, us_to_ktime(pdat->width));
+	}
+}
+
 static int stepper_pluse_dir_busying(struct stepper_t * m)
 {
 	struct stepper_pluse_dir_pdata_t * pdat = (struct stepper_pluse_dir_pdata_t *)m->priv;
@@ -100,11 +158,11 @@ static int stepper_pluse_dir_timer_function(struct timer_t * timer, void * data)
 		pdat->flag = !pdat->flag;
 		if(pdat->flag)
 		{
-			gpio_set_value(pdat->pluse, pdat->pluseinv ? 0 : 1);
+			gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 0 : 1);
 		}
 		else
 		{
-			gpio_set_value(pdat->pluse, pdat->pluseinv ? 1 : 0);
+			gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 1 : 0);
 			pdat->step--;
 		}
 
@@ -115,7 +173,7 @@ static int stepper_pluse_dir_timer_function(struct timer_t * timer, void * data)
 			return 1;
 		}
 	}
-	gpio_set_value(pdat->pluse, pdat->pluseinv ? 1 : 0);
+	gpio_desc_set_value(&pdat->pluse, pdat->pluseinv ? 1 : 0);
 	pdat->step = 0;
 	pdat->busying = 0;
 	return 0;
@@ -145,57 +203,60 @@ static struct device_t * stepper_pluse_dir_probe(struct driver_t * drv, struct d
 	}
 
 	timer_init(&pdat->timer, stepper_pluse_dir_timer_function, m);
-	pdat->pluse = pluse;
+	timer_init(&pdat->ptimer, stepper_pluse_dir_pulse_timer_function, pdat);
+	pdat->pstate = PLUSE_STATE_IDLE;
+	gpio_desc_init(&pdat->pluse, pluse);
 	pdat->plusecfg = dt_read_int(n, "pluse-gpio-config", -1);
 	pdat->pluseinv = dt_read_int(n, "pluse-gpio-inverted", 0);
-	pdat->dir = dir;
+	gpio_desc_init(&pdat->dir, dir);
 	pdat->dircfg = dt_read_int(n, "dir-gpio-config", -1);
 	pdat->dirinv = dt_read_int(n, "dir-gpio-inverted", 0);
-	pdat->en = en;
+	gpio_desc_init(&pdat->en, en);
 	pdat->encfg = dt_read_int(n, "enable-gpio-config", -1);
 	pdat->eninv = dt_read_int(n, "enable-gpio-inverted", 0);
+	pdat->width = dt_read_int(n, "pluse-width-us", 2);
 	pdat->dspeed = dt_read_int(n, "default-speed", 100);
 	pdat->enable = 0;
 	pdat->step = 0;
 	pdat->flag = 0;
 	pdat->speed = 0;
 	pdat->busying = 0;
+	pdat->lastdir = -1;
 
 	m->name = alloc_device_name(dt_read_name(n), dt_read_id(n));
 	m->enable = stepper_pluse_dir_enable;
 	m->disable = stepper_pluse_dir_disable;
 	m->move = stepper_pluse_dir_move;
 	m->busying = stepper_pluse_dir_busying;
+	m->step = stepper_pluse_dir_step;
 	m->priv = pdat;
 
-	if(pdat->pluse >= 0)
+	if(pdat->pluse.chip)
 	{
 		if(pdat->plusecfg >= 0)
-			gpio_set_cfg(pdat->pluse, pdat->plusecfg);
-		gpio_set_pull(pdat->pluse, pdat->pluseinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
-		gpio_set_direction(pdat->pluse, GPIO_DIRECTION_OUTPUT);
-		gpio_set_value(pdat->pluse, pdat->pluseinv ? 1 : 0);
+			gpio_desc_set_cfg(&pdat->pluse, pdat->plusecfg);
+		gpio_desc_set_pull(&pdat->pluse, pdat->pluseinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
+		gpio_desc_direction_output(&pdat->pluse, pdat->pluseinv ? 1 : 0);
 	}
-	if(pdat->dir >= 0)
+	if(pdat->dir.chip)
 	{
 		if(pdat->dircfg >= 0)
-			gpio_set_cfg(pdat->dir, pdat->dircfg);
-		gpio_set_pull(pdat->dir, pdat->dirinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
-		gpio_set_direction(pdat->dir, GPIO_DIRECTION_OUTPUT);
-		gpio_set_value(pdat->dir, pdat->dirinv ? 1 : 0);
+			gpio_desc_set_cfg(&pdat->dir, pdat->dircfg);
+		gpio_desc_set_pull(&pdat->dir, pdat->dirinv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
+		gpio_desc_direction_output(&pdat->dir, pdat->dirinv ? 1 : 0);
 	}
-	if(pdat->en >= 0)
+	if(pdat->en.chip)
 	{
 		if(pdat->encfg >= 0)
-			gpio_set_cfg(pdat->en, pdat->encfg);
-		gpio_set_pull(pdat->en, pdat->eninv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
-		gpio_set_direction(pdat->en, GPIO_DIRECTION_OUTPUT);
-		gpio_set_value(pdat->en, pdat->eninv ? 1 : 0);
+			gpio_desc_set_cfg(&pdat->en, pdat->encfg);
+		gpio_desc_set_pull(&pdat->en, pdat->eninv ? GPIO_PULL_UP :GPIO_PULL_DOWN);
+		gpio_desc_direction_output(&pdat->en, pdat->eninv ? 1 : 0);
 	}
 
 	if(!register_stepper(&dev, m))
 	{
 		timer_cancel(&pdat->timer);
+		timer_cancel(&pdat->ptimer);
 
 		free_device_name(m->name);
 		free(m->priv);
@@ -215,6 +276,7 @@ static void stepper_pluse_dir_remove(struct device_t * dev)
 	if(m && unregister_stepper(m))
 	{
 		timer_cancel(&pdat->timer);
+		timer_cancel(&pdat->ptimer);
 
 		free_device_name(m->name);
 		free(m->priv);
@@ -195,6 +195,27 @@ static void stepper_halfstep(struct stepper_unipolar_gpio_pdata_t * pdat)
 	}
 }
 
+static void stepper_unipolar_gpio_advance(struct stepper_unipolar_gpio_pdata_t * pdat)
+{
+	switch(pdat->mode)
+	{
+	case STEPPER_MODE_WAVE:
+		pdat->index = (pdat->index + 4 + (pdat->dir ? 1 : -1)) % 4;
+		stepper_wave(pdat);
+		break;
+	case STEPPER_MODE_FULLSTEP:
+		pdat->index = (pdat->index + 4 + (pdat->dir ? 1 : -1)) % 4;
+		stepper_fullstep(pdat);
+		break;
+	case STEPPER_MODE_HALFSTEP:
+		pdat->index = (pdat->index + 8 + (pdat->dir ? 1 : -1)) % 8;
+		stepper_halfstep(pdat);
+		break;
+	default:
+		break;
+	}
+}
+
 static void stepper_unipolar_gpio_enable(struct stepper_t * m)
 {
 	struct stepper_unipolar_gpio_pdata_t * pdat = (struct stepper_unipolar_gpio_pdata_t *)m->priv;
@@ -241,6 +262,16 @@ static void stepper_unipolar_gpio_move(struct stepper_t * m, int step, int speed
 	}
 }
 
+static void stepper_unipolar_gpio_step(struct stepper_t * m, int dir)
+{
+	struct stepper_unipolar_gpio_pdata_t * pdat = (struct stepper_unipolar_gpio_pdata_t *)m->priv;
+	if(pdat->enable && !pdat->busying)
+	{
+		pdat->dir = (dir < 0) ? 0 : 1;
+		stepper_unipolar_gpio_advance(pdat);
+	}
+}
+
 static int stepper_unipolar_gpio_busying(struct stepper_t * m)
 {
 	struct stepper_unipolar_gpio_pdata_t * pdat = (struct stepper_unipolar_gpio_pdata_t *)m->priv;
@@ -254,23 +285,7 @@ static int stepper_unipolar_gpio_timer_function(struct timer_t * timer, void * d
 
 	if(pdat->enable && (pdat->step-- > 0))
 	{
-		switch(pdat->mode)
-		{
-		case STEPPER_MODE_WAVE:
-			pdat->index = (pdat->index + 4 + (pdat->dir ? 1 : -1)) % 4;
-			stepper_wave(pdat);
-			break;
-		case STEPPER_MODE_FULLSTEP:
-			pdat->index = (pdat->index + 4 + (pdat->dir ? 1 : -1)) % 4;
-			stepper_fullstep(pdat);
-			break;
-		case STEPPER_MODE_HALFSTEP:
-			pdat->index = (pdat->index + 8 + (pdat->dir ? 1 : -1)) % 8;
-			stepper_halfstep(pdat);
-			break;
-		default:
-			break;
-		}
+		stepper_unipolar_gpio_advance(pdat);
 		if(pdat->step > 0)
 		{
 			pdat->busying = 1;
@@ -338,6 +353,7 @@ static struct device_t * stepper_unipolar_gpio_probe(struct driver_t * drv, stru
 	m->disable = stepper_unipolar_gpio_disable;
 	m->move = stepper_unipolar_gpio_move;
 	m->busying = stepper_unipolar_gpio_busying;
+	m->step = stepper_unipolar_gpio_step;
 	m->priv = pdat;
 
 	if(pdat->a >= 0)
@@ -145,3 +145,8 @@ int stepper_busying(struct stepper_t * m)
 	return 0;
 }
 
+void stepper_step(struct stepper_t * m, int dir)
+{
+	if(m && m->step && (dir != 0))
+		m->step(m, dir);
+}
@@ -29,6 +29,89 @@
 #include <xboot.h>
 #include <uart/uart.h>
 
+/*
+ * The uart drivers have no receive interrupt path, so a monitor drains the
+ * hardware fifo from a kernel timer into a software fifo and publishes
+ * EVENT_TYPE_UART_RX. The uart_read always consumes the software fifo first.
+ * Both drain the hardware under the monitor lock, keeping the byte order.
+ * A full software fifo stops the monitor draining, the bytes stay in the
+ * hardware for the next uart_read and each stalled tick is counted.
+ */
+#define UART_MONITOR_FIFO_SIZE		(SZ_4K)
+#define UART_MONITOR_INTERVAL_MS	(2)
+
+struct uart_monitor_t {
+	struct timer_t timer;
+	struct uart_t * uart;
+	struct fifo_t * fifo;
+	unsigned int stalls;
+	struct list_head entry;
+};
+
+static LIST_HEAD(__uart_monitor_list);
+static spinlock_t __uart_monitor_lock = SPIN_LOCK_INIT();
+
+/* Must be called with the monitor lock held */
+static struct uart_monitor_t * search_uart_monitor(struct uart_t * uart)
+{
+	struct uart_monitor_t * pos, * n;
+
+	list_for_each_entry_safe(pos, n, &__uart_monitor_list, entry)
+	{
+		if(pos->uart == uart)
+			return pos;
+	}
+	return NULL;
+}
+
+static int uart_monitor_timer_function(struct timer_t * timer, void * data)
+{
+	struct uart_monitor_t * m = (struct uart_monitor_t *)(data);
+	irq_flags_t flags;
+	u8_t buf[64];
+	ssize_t n;
+	int count = 0, len, room;
+
+	spin_lock_irqsave(&__uart_monitor_lock, flags);
+	for(;;)
+	{
+		room = m->fifo->size - __fifo_len(m->fifo);
+		if(room > sizeof(buf))
+			room = sizeof(buf);
+		if(room <= 0)
+		{
+			m->stalls++;
+			break;
+		}
+		n = m->uart->read(m->uart, buf, room);
+		if(n <= 0)
+			break;
+		count += __fifo_put(m->fifo, buf, n);
+		if(n < room)
+			break;
+	}
+	len = __fifo_len(m->fifo);
+	spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+	if(count > 0)
+		push_event_uart_rx(m->uart, len);
+	timer_forward_now(timer, ms_to_ktime(UART_MONITOR_INTERVAL_MS));
+	return 1;
+}
+
+static ssize_t uart_read_stalls(struct kobj_t * kobj, void * buf, size_t size)
+{
+	struct uart_t * uart = (struct uart_t *)kobj->priv;
+	struct uart_monitor_t * m;
+	irq_flags_t flags;
+	unsigned int stalls;
+
+	spin_lock_irqsave(&__uart_monitor_lock, flags);
+	m = search_uart_monitor(uart);
+	stalls = m ? m->stalls : 0;
+	spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+	return sprintf(buf, "%u", stalls);
+}
+
 static ssize_t uart_read_baud(struct kobj_t * kobj, void * buf, size_t size)
 {
 	struct uart_t * uart = (struct uart_t *)kobj->priv;
@@ -127,6 +210,7 @@ bool_t register_uart(struct device_t ** device, struct uart_t * uart)
 	kobj_add_regular(dev->kobj, "data", uart_read_data, uart_write_data, uart);
 	kobj_add_regular(dev->kobj, "parity", uart_read_parity, uart_write_parity, uart);
 	kobj_add_regular(dev->kobj, "stop", uart_read_stop, uart_write_stop, uart);
+	kobj_add_regular(dev->kobj, "stalls", uart_read_stalls, NULL, uart);
 
 	if(!register_device(dev))
 	{
@@ -155,6 +239,8 @@ bool_t unregister_uart(struct uart_t * uart)
 	if(!unregister_device(dev))
 		return FALSE;
 
+	uart_event_disable(uart);
+
 	kobj_remove_self(dev->kobj);
 	free(dev->name);
 	free(dev);
@@ -177,8 +263,25 @@ bool_t uart_get(struct uart_t * uart, int * baud, int * data, int * parity, int
 
 ssize_t uart_read(struct uart_t * uart, u8_t * buf, size_t count)
 {
+	struct uart_monitor_t * m;
+	irq_flags_t flags;
+	ssize_t len;
+
 	if(uart && uart->read)
+	{
+		spin_lock_irqsave(&__uart_monitor_lock, flags);
+		m = search_uart_monitor(uart);
+		if(m)
+		{
+			len = __fifo_get(m->fifo, buf, count);
+			if(len < count)
+				len += uart->read(uart, buf + len, count - len);
+			spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+			return len;
+		}
+		spin_unlock_irqrestore(&__uart_monitor_lock, flags);
 		return uart->read(uart, buf, count);
+	}
 	return 0;
 }
 
@@ -188,3 +291,68 @@ ssize_t uart_write(struct uart_t * uart, const u8_t * buf, size_t count)
 		return uart->write(uart, buf, count);
 	return 0;
 }
+
+bool_t uart_event_enable(struct uart_t * uart)
+{
+	struct uart_monitor_t * m;
+	irq_flags_t flags;
+
+	if(!uart || !uart->read)
+		return FALSE;
+
+	spin_lock_irqsave(&__uart_monitor_lock, flags);
+	m = search_uart_monitor(uart);
+	spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+	if(m)
+		return TRUE;
+
+	m = malloc(sizeof(struct uart_monitor_t));
+	if(!m)
+		return FALSE;
+
+	m->fifo = fifo_alloc(UART_MONITOR_FIFO_SIZE);
+	if(!m->fifo)
+	{
+		free(m);
+		return FALSE;
+	}
+	m->uart = uart;
+	m->stalls = 0;
+	timer_init(&m->timer, uart_monitor_timer_function, m);
+
+	/*
+	 * The allocation ran unlocked, another caller may have enabled the
+	 * monitor meanwhile.
+	 */
+	spin_lock_irqsave(&__uart_monitor_lock, flags);
+	if(search_uart_monitor(uart))
+	{
+		spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+		fifo_free(m->fifo);
+		free(m);
+		return TRUE;
+	}
+	list_add_tail(&m->entry, &__uart_monitor_list);
+	spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+	timer_start_now(&m->timer, ms_to_ktime(UART_MONITOR_INTERVAL_MS));
+
+	return TRUE;
+}
+
+void uart_event_disable(struct uart_t * uart)
+{
+	struct uart_monitor_t * m;
+	irq_flags_t flags;
+
+	spin_lock_irqsave(&__uart_monitor_lock, flags);
+	m = search_uart_monitor(uart);
+	if(m)
+		list_del(&m->entry);
+	spin_unlock_irqrestore(&__uart_monitor_lock, flags);
+	if(!m)
+		return;
+
+	timer_cancel(&m->timer);
+	fifo_free(m->fifo);
+	free(m);
+}
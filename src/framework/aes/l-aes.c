@@ -0,0 +1,263 @@
+/*
+ * framework/aes/l-aes.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <aes.h>
+#include <framework/buffer/l-buffer.h>
+#include <framework/aes/l-aes.h>
+
+static void l_aes_checkkey(lua_State * L, int idx, const u8_t ** key, size_t * klen, const u8_t ** iv, size_t * ivlen)
+{
+	*key = (const u8_t *)luaL_checklstring(L, idx, klen);
+	luaL_argcheck(L, (*klen == 16) || (*klen == 24) || (*klen == 32), idx, "key must be 16, 24 or 32 bytes");
+	*iv = (const u8_t *)luaL_checklstring(L, idx + 1, ivlen);
+}
+
+/*
+ * Aes.ctr(key, iv), the iv is the initial sixteen byte counter block
+ */
+static int l_aes_ctr(lua_State * L)
+{
+	struct aes_ctr_t * c;
+	const u8_t * key, * iv;
+	size_t klen, ivlen;
+
+	l_aes_checkkey(L, 1, &key, &klen, &iv, &ivlen);
+	luaL_argcheck(L, ivlen == AES_BLOCK_SIZE, 2, "iv must be 16 bytes");
+	c = lua_newuserdata(L, sizeof(struct aes_ctr_t));
+	aes_ctr_init(c, key, klen, iv);
+	luaL_setmetatable(L, MT_AES_CTR);
+	return 1;
+}
+
+/*
+ * Aes.cbc(key, iv)
+ */
+static int l_aes_cbc(lua_State * L)
+{
+	struct aes_cbc_t * c;
+	const u8_t * key, * iv;
+	size_t klen, ivlen;
+
+	l_aes_checkkey(L, 1, &key, &klen, &iv, &ivlen);
+	luaL_argcheck(L, ivlen == AES_BLOCK_SIZE, 2, "iv must be 16 bytes");
+	c = lua_newuserdata(L, sizeof(struct aes_cbc_t));
+	aes_cbc_init(c, key, klen, iv);
+	luaL_setmetatable(L, MT_AES_CBC);
+	return 1;
+}
+
+/*
+ * Aes.gcm(key, iv), any non empty iv, twelve bytes is the usual choice
+ */
+static int l_aes_gcm(lua_State * L)
+{
+	struct aes_gcm_t * g;
+	const u8_t * key, * iv;
+	size_t klen, ivlen;
+
+	l_aes_checkkey(L, 1, &key, &klen, &iv, &ivlen);
+	luaL_argcheck(L, (ivlen > 0) && (ivlen <= 256), 2, "iv must be 1 to 256 bytes");
+	g = lua_newuserdata(L, sizeof(struct aes_gcm_t));
+	aes_gcm_init(g, key, klen, iv, ivlen);
+	luaL_setmetatable(L, MT_AES_GCM);
+	return 1;
+}
+
+static int l_aes_impl(lua_State * L)
+{
+	lua_pushstring(L, aes_impl());
+	return 1;
+}
+
+static const luaL_Reg l_aes[] = {
+	{"ctr",		l_aes_ctr},
+	{"cbc",		l_aes_cbc},
+	{"gcm",		l_aes_gcm},
+	{"impl",	l_aes_impl},
+	{NULL,		NULL}
+};
+
+static int m_ctr_update(lua_State * L)
+{
+	struct aes_ctr_t * c = luaL_checkudata(L, 1, MT_AES_CTR);
+	size_t len;
+	const u8_t * in = lbuffer_checkbytes(L, 2, &len);
+	luaL_Buffer b;
+	u8_t * out;
+
+	luaL_argcheck(L, len <= INT_MAX, 2, "data too large");
+	out = (u8_t *)luaL_buffinitsize(L, &b, len);
+	aes_ctr_update(c, in, out, len);
+	luaL_pushresultsize(&b, len);
+	return 1;
+}
+
+static int m_ctr_gc(lua_State * L)
+{
+	struct aes_ctr_t * c = luaL_checkudata(L, 1, MT_AES_CTR);
+	memset(c, 0, sizeof(struct aes_ctr_t));
+	return 0;
+}
+
+static const luaL_Reg m_aes_ctr[] = {
+	{"update",	m_ctr_update},
+	{"__gc",	m_ctr_gc},
+	{NULL,		NULL}
+};
+
+static int m_cbc_crypt(lua_State * L, int enc)
+{
+	struct aes_cbc_t * c = luaL_checkudata(L, 1, MT_AES_CBC);
+	size_t len;
+	const u8_t * in = lbuffer_checkbytes(L, 2, &len);
+	luaL_Buffer b;
+	u8_t * out;
+
+	luaL_argcheck(L, (len % AES_BLOCK_SIZE) == 0, 2, "length must be a multiple of 16");
+	luaL_argcheck(L, len <= INT_MAX, 2, "data too large");
+	out = (u8_t *)luaL_buffinitsize(L, &b, len);
+	if(enc)
+		aes_cbc_encrypt(c, in, out, len / AES_BLOCK_SIZE);
+	else
+		aes_cbc_decrypt(c, in, out, len / AES_BLOCK_SIZE);
+	luaL_pushresultsize(&b, len);
+	return 1;
+}
+
+static int m_cbc_encrypt(lua_State * L)
+{
+	return m_cbc_crypt(L, 1);
+}
+
+static int m_cbc_decrypt(lua_State * L)
+{
+	return m_cbc_crypt(L, 0);
+}
+
+static int m_cbc_gc(lua_State * L)
+{
+	struct aes_cbc_t * c = luaL_checkudata(L, 1, MT_AES_CBC);
+	memset(c, 0, sizeof(struct aes_cbc_t));
+	return 0;
+}
+
+static const luaL_Reg m_aes_cbc[] = {
+	{"encrypt",	m_cbc_encrypt},
+	{"decrypt",	m_cbc_decrypt},
+	{"__gc",	m_cbc_gc},
+	{NULL,		NULL}
+};
+
+static int m_gcm_aad(lua_State * L)
+{
+	struct aes_gcm_t * g = luaL_checkudata(L, 1, MT_AES_GCM);
+	size_t len;
+	const u8_t * aad = lbuffer_checkbytes(L, 2, &len);
+
+	luaL_argcheck(L, len <= INT_MAX, 2, "data too large");
+	if(g->data)
+		return luaL_error(L, "additional data after payload");
+	aes_gcm_aad(g, aad, len);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_gcm_crypt(lua_State * L, int enc)
+{
+	struct aes_gcm_t * g = luaL_checkudata(L, 1, MT_AES_GCM);
+	size_t len;
+	const u8_t * in = lbuffer_checkbytes(L, 2, &len);
+	luaL_Buffer b;
+	u8_t * out;
+
+	luaL_argcheck(L, len <= INT_MAX, 2, "data too large");
+	out = (u8_t *)luaL_buffinitsize(L, &b, len);
+	if(enc)
+		aes_gcm_encrypt(g, in, out, len);
+	else
+		aes_gcm_decrypt(g, in, out, len);
+	luaL_pushresultsize(&b, len);
+	return 1;
+}
+
+static int m_gcm_encrypt(lua_State * L)
+{
+	return m_gcm_crypt(L, 1);
+}
+
+static int m_gcm_decrypt(lua_State * L)
+{
+	return m_gcm_crypt(L, 0);
+}
+
+static int m_gcm_tag(lua_State * L)
+{
+	struct aes_gcm_t * g = luaL_checkudata(L, 1, MT_AES_GCM);
+	u8_t tag[AES_BLOCK_SIZE];
+
+	aes_gcm_tag(g, tag);
+	lua_pushlstring(L, (const char *)tag, sizeof(tag));
+	return 1;
+}
+
+static int m_gcm_verify(lua_State * L)
+{
+	struct aes_gcm_t * g = luaL_checkudata(L, 1, MT_AES_GCM);
+	size_t len;
+	const u8_t * tag = (const u8_t *)luaL_checklstring(L, 2, &len);
+
+	luaL_argcheck(L, (len >= 4) && (len <= AES_BLOCK_SIZE), 2, "tag must be 4 to 16 bytes");
+	lua_pushboolean(L, aes_gcm_verify(g, tag, len));
+	return 1;
+}
+
+static int m_gcm_gc(lua_State * L)
+{
+	struct aes_gcm_t * g = luaL_checkudata(L, 1, MT_AES_GCM);
+	memset(g, 0, sizeof(struct aes_gcm_t));
+	return 0;
+}
+
+static const luaL_Reg m_aes_gcm[] = {
+	{"aad",		m_gcm_aad},
+	{"encrypt",	m_gcm_encrypt},
+	{"decrypt",	m_gcm_decrypt},
+	{"tag",		m_gcm_tag},
+	{"verify",	m_gcm_verify},
+	{"__gc",	m_gcm_gc},
+	{NULL,		NULL}
+};
+
+int luaopen_aes(lua_State * L)
+{
+	luaL_newlib(L, l_aes);
+	luahelper_create_metatable(L, MT_AES_CTR, m_aes_ctr);
+	luahelper_create_metatable(L, MT_AES_CBC, m_aes_cbc);
+	luahelper_create_metatable(L, MT_AES_GCM, m_aes_gcm);
+	return 1;
+}
@@ -0,0 +1,406 @@
+/*
+ * framework/buffer/l-buffer.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <framework/buffer/l-buffer.h>
+
+struct lbuffer_t * lbuffer_new(lua_State * L, size_t size)
+{
+	struct lbuffer_t * buf = lua_newuserdata(L, sizeof(struct lbuffer_t) + size);
+	buf->data = (unsigned char *)(buf + 1);
+	buf->size = size;
+	luaL_setmetatable(L, MT_BUFFER);
+	return buf;
+}
+
+struct lbuffer_t * lbuffer_check(lua_State * L, int idx)
+{
+	return luaL_checkudata(L, idx, MT_BUFFER);
+}
+
+struct lbuffer_t * lbuffer_test(lua_State * L, int idx)
+{
+	return luaL_testudata(L, idx, MT_BUFFER);
+}
+
+/*
+ * Accept a lua string or a buffer as a read only byte source.
+ */
+const void * lbuffer_checkbytes(lua_State * L, int idx, size_t * len)
+{
+	struct lbuffer_t * buf = lbuffer_test(L, idx);
+	if(buf)
+	{
+		*len = buf->size;
+		return buf->data;
+	}
+	return luaL_checklstring(L, idx, len);
+}
+
+/*
+ * Buffer at idx with optional offset and count at idx + 1 and idx + 2,
+ * the count defaults to the rest of the buffer.
+ */
+void * lbuffer_checkrange(lua_State * L, int idx, size_t * len)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, idx);
+	lua_Integer offset = luaL_optinteger(L, idx + 1, 0);
+	lua_Integer count;
+
+	luaL_argcheck(L, (offset >= 0) && ((size_t)offset <= buf->size), idx + 1, "offset out of range");
+	count = luaL_optinteger(L, idx + 2, buf->size - offset);
+	luaL_argcheck(L, (count >= 0) && ((size_t)count <= buf->size - offset), idx + 2, "count out of range");
+	*len = count;
+	return buf->data + offset;
+}
+
+static void * __buffer_slot(lua_State * L, struct lbuffer_t * buf, size_t width)
+{
+	lua_Integer offset = luaL_checkinteger(L, 2);
+	luaL_argcheck(L, (offset >= 0) && ((size_t)offset + width <= buf->size), 2, "offset out of range");
+	return buf->data + offset;
+}
+
+static int l_buffer_new(lua_State * L)
+{
+	struct lbuffer_t * buf;
+	const char * str;
+	size_t len;
+
+	if(lua_type(L, 1) == LUA_TSTRING)
+	{
+		str = lua_tolstring(L, 1, &len);
+		buf = lbuffer_new(L, len);
+		memcpy(buf->data, str, len);
+	}
+	else
+	{
+		lua_Integer size = luaL_checkinteger(L, 1);
+		luaL_argcheck(L, size >= 0, 1, "negative size");
+		buf = lbuffer_new(L, size);
+		memset(buf->data, luaL_optinteger(L, 2, 0) & 0xff, size);
+	}
+	return 1;
+}
+
+static const luaL_Reg l_buffer[] = {
+	{"new",	l_buffer_new},
+	{NULL,	NULL}
+};
+
+static int m_buffer_len(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	lua_pushinteger(L, buf->size);
+	return 1;
+}
+
+static int m_buffer_tostring(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	lua_pushfstring(L, "buffer(%d): %p", (int)buf->size, buf->data);
+	return 1;
+}
+
+static int m_buffer_slice(lua_State * L)
+{
+	struct lbuffer_t * slice;
+	void * p;
+	size_t len;
+
+	p = lbuffer_checkrange(L, 1, &len);
+	slice = lua_newuserdata(L, sizeof(struct lbuffer_t));
+	slice->data = p;
+	slice->size = len;
+	luaL_setmetatable(L, MT_BUFFER);
+	lua_pushvalue(L, 1);
+	lua_setuservalue(L, -2);
+	return 1;
+}
+
+static int m_buffer_fill(lua_State * L)
+{
+	int c = luaL_checkinteger(L, 2) & 0xff;
+	void * p;
+	size_t len;
+
+	lua_remove(L, 2);
+	p = lbuffer_checkrange(L, 1, &len);
+	memset(p, c, len);
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_buffer_copy(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	lua_Integer offset = luaL_optinteger(L, 3, 0);
+	const void * src;
+	size_t len;
+
+	src = lbuffer_checkbytes(L, 2, &len);
+	luaL_argcheck(L, (offset >= 0) && ((size_t)offset <= buf->size), 3, "offset out of range");
+	if(len > buf->size - offset)
+		len = buf->size - offset;
+	memmove(buf->data + offset, src, len);
+	lua_pushinteger(L, len);
+	return 1;
+}
+
+static int m_buffer_tolstring(lua_State * L)
+{
+	void * p;
+	size_t len;
+
+	p = lbuffer_checkrange(L, 1, &len);
+	lua_pushlstring(L, p, len);
+	return 1;
+}
+
+static int m_buffer_swap16(lua_State * L)
+{
+	u16_t * p, v;
+	size_t len, i;
+
+	p = lbuffer_checkrange(L, 1, &len);
+	for(i = 0; i < len / 2; i++)
+	{
+		memcpy(&v, &p[i], 2);
+		v = __swab16(v);
+		memcpy(&p[i], &v, 2);
+	}
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_buffer_swap32(lua_State * L)
+{
+	u32_t * p, v;
+	size_t len, i;
+
+	p = lbuffer_checkrange(L, 1, &len);
+	for(i = 0; i < len / 4; i++)
+	{
+		memcpy(&v, &p[i], 4);
+		v = __swab32(v);
+		memcpy(&p[i], &v, 4);
+	}
+	lua_settop(L, 1);
+	return 1;
+}
+
+static inline u16_t __buffer_get16(void * p, int be)
+{
+	u16_t v;
+	memcpy(&v, p, 2);
+	return be ? be16_to_cpu(v) : le16_to_cpu(v);
+}
+
+static inline u32_t __buffer_get32(void * p, int be)
+{
+	u32_t v;
+	memcpy(&v, p, 4);
+	return be ? be32_to_cpu(v) : le32_to_cpu(v);
+}
+
+static inline u64_t __buffer_get64(void * p, int be)
+{
+	u64_t v;
+	memcpy(&v, p, 8);
+	return be ? be64_to_cpu(v) : le64_to_cpu(v);
+}
+
+static inline void __buffer_set16(void * p, u16_t v, int be)
+{
+	v = be ? cpu_to_be16(v) : cpu_to_le16(v);
+	memcpy(p, &v, 2);
+}
+
+static inline void __buffer_set32(void * p, u32_t v, int be)
+{
+	v = be ? cpu_to_be32(v) : cpu_to_le32(v);
+	memcpy(p, &v, 4);
+}
+
+static inline void __buffer_set64(void * p, u64_t v, int be)
+{
+	v = be ? cpu_to_be64(v) : cpu_to_le64(v);
+	memcpy(p, &v, 8);
+}
+
+static int m_buffer_get_u8(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	u8_t * p = __buffer_slot(L, buf, 1);
+	lua_pushinteger(L, *p);
+	return 1;
+}
+
+static int m_buffer_get_s8(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	s8_t * p = __buffer_slot(L, buf, 1);
+	lua_pushinteger(L, *p);
+	return 1;
+}
+
+static int m_buffer_get_u16(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 2);
+	lua_pushinteger(L, __buffer_get16(p, lua_toboolean(L, 3)));
+	return 1;
+}
+
+static int m_buffer_get_s16(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 2);
+	lua_pushinteger(L, (s16_t)__buffer_get16(p, lua_toboolean(L, 3)));
+	return 1;
+}
+
+static int m_buffer_get_u32(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 4);
+	lua_pushinteger(L, __buffer_get32(p, lua_toboolean(L, 3)));
+	return 1;
+}
+
+static int m_buffer_get_s32(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 4);
+	lua_pushinteger(L, (s32_t)__buffer_get32(p, lua_toboolean(L, 3)));
+	return 1;
+}
+
+static int m_buffer_get_f32(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 4);
+	union { u32_t u; float f; } v;
+	v.u = __buffer_get32(p, lua_toboolean(L, 3));
+	lua_pushnumber(L, v.f);
+	return 1;
+}
+
+static int m_buffer_get_f64(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 8);
+	union { u64_t u; double f; } v;
+	v.u = __buffer_get64(p, lua_toboolean(L, 3));
+	lua_pushnumber(L, v.f);
+	return 1;
+}
+
+static int m_buffer_set_u8(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	u8_t * p = __buffer_slot(L, buf, 1);
+	*p = luaL_checkinteger(L, 3) & 0xff;
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_buffer_set_u16(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 2);
+	__buffer_set16(p, luaL_checkinteger(L, 3), lua_toboolean(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_buffer_set_u32(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 4);
+	__buffer_set32(p, luaL_checkinteger(L, 3), lua_toboolean(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_buffer_set_f32(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 4);
+	union { u32_t u; float f; } v;
+	v.f = luaL_checknumber(L, 3);
+	__buffer_set32(p, v.u, lua_toboolean(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_buffer_set_f64(lua_State * L)
+{
+	struct lbuffer_t * buf = lbuffer_check(L, 1);
+	void * p = __buffer_slot(L, buf, 8);
+	union { u64_t u; double f; } v;
+	v.f = luaL_checknumber(L, 3);
+	__buffer_set64(p, v.u, lua_toboolean(L, 4));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static const luaL_Reg m_buffer[] = {
+	{"__len",		m_buffer_len},
+	{"__tostring",	m_buffer_tostring},
+	{"size",		m_buffer_len},
+	{"slice",		m_buffer_slice},
+	{"fill",		m_buffer_fill},
+	{"copy",		m_buffer_copy},
+	{"toString",	m_buffer_tolstring},
+	{"swap16",		m_buffer_swap16},
+	{"swap32",		m_buffer_swap32},
+	{"getU8",		m_buffer_get_u8},
+	{"getS8",		m_buffer_get_s8},
+	{"getU16",		m_buffer_get_u16},
+	{"getS16",		m_buffer_get_s16},
+	{"getU32",		m_buffer_get_u32},
+	{"getS32",		m_buffer_get_s32},
+	{"getF32",		m_buffer_get_f32},
+	{"getF64",		m_buffer_get_f64},
+	{"setU8",		m_buffer_set_u8},
+	{"setS8",		m_buffer_set_u8},
+	{"setU16",		m_buffer_set_u16},
+	{"setS16",		m_buffer_set_u16},
+	{"setU32",		m_buffer_set_u32},
+	{"setS32",		m_buffer_set_u32},
+	{"setF32",		m_buffer_set_f32},
+	{"setF64",		m_buffer_set_f64},
+	{NULL,			NULL}
+};
+
+int luaopen_buffer(lua_State * L)
+{
+	luaL_newlib(L, l_buffer);
+	luahelper_create_metatable(L, MT_BUFFER, m_buffer);
+	return 1;
+}
@@ -28,6 +28,8 @@
 
 #include <cairo.h>
 #include <cairo-xboot.h>
+#include <xboot/idle.h>
+#include <cpufreq/cpufreq.h>
 #include <framework/display/l-display.h>
 
 extern cairo_scaled_font_t * luaL_checkudata_scaled_font(lua_State * L, int ud, const char * tname);
@@ -42,8 +44,26 @@ struct ldisplay_t {
 	double fps;
 	u64_t frame;
 	ktime_t stamp;
+
+	int busy;
+	ktime_t begin;
+	s64_t deadline;
 };
 
+/*
+ * The first draw after a present starts the frame, a frame that takes longer
+ * to render than its deadline hints the cpu governor for more headroom.
+ */
+static inline void display_begin_frame(struct ldisplay_t * display)
+{
+	if(!display->busy)
+	{
+		display->busy = 1;
+		display->begin = ktime_get();
+		idle_exit();
+	}
+}
+
 static int l_display_new(lua_State * L)
 {
 	const char * name = luaL_optstring(L, 1, NULL);
@@ -60,6 +80,9 @@ static int l_display_new(lua_State * L)
 	display->fps = 60;
 	display->frame = 0;
 	display->stamp = ktime_get();
+	display->busy = 0;
+	display->begin = display->stamp;
+	display->deadline = 1000000000LL / 60;
 	luaL_setmetatable(L, MT_DISPLAY);
 	return 1;
 }
@@ -124,6 +147,7 @@ static int m_display_draw_shape(lua_State * L)
 	struct lobject_t * object = luaL_checkudata(L, 2, MT_OBJECT);
 	cairo_t ** shape = luaL_checkudata(L, 3, MT_SHAPE);
 	cairo_t * cr = display->cr;
+	display_begin_frame(display);
 	cairo_save(cr);
 	cairo_set_matrix(cr, &object->__transform_matrix);
 	cairo_surface_t * surface = cairo_surface_reference(cairo_get_target(*shape));
@@ -142,6 +166,7 @@ static int m_display_draw_text(lua_State * L)
 	struct lpattern_t * pattern = luaL_checkudata(L, 4, MT_PATTERN);
 	cairo_matrix_t * matrix = luaL_checkudata(L, 5, MT_MATRIX);
 	cairo_t * cr = display->cr;
+	display_begin_frame(display);
 	cairo_save(cr);
 	cairo_set_scaled_font(cr, sfont);
 	cairo_set_font_matrix(cr, matrix);
@@ -158,6 +183,7 @@ static int m_display_draw_texture(lua_State * L)
 	struct lobject_t * object = luaL_checkudata(L, 2, MT_OBJECT);
 	struct ltexture_t * texture = luaL_checkudata(L, 3, MT_TEXTURE);
 	cairo_t * cr = display->cr;
+	display_begin_frame(display);
 	cairo_save(cr);
 	cairo_set_matrix(cr, &object->__transform_matrix);
 	cairo_set_source_surface(cr, texture->surface, 0, 0);
@@ -174,6 +200,7 @@ static int m_display_draw_texture_mask(lua_State * L)
 	struct ltexture_t * texture = luaL_checkudata(L, 3, MT_TEXTURE);
 	struct lpattern_t * pattern = luaL_checkudata(L, 4, MT_PATTERN);
 	cairo_t * cr = display->cr;
+	display_begin_frame(display);
 	cairo_save(cr);
 	cairo_set_matrix(cr, &object->__transform_matrix);
 	cairo_set_source_surface(cr, texture->surface, 0, 0);
@@ -189,6 +216,7 @@ static int m_display_draw_ninepatch(lua_State * L)
 	struct lobject_t * object = luaL_checkudata(L, 2, MT_OBJECT);
 	struct lninepatch_t * ninepatch = luaL_checkudata(L, 3, MT_NINEPATCH);
 	cairo_t * cr = display->cr;
+	display_begin_frame(display);
 	cairo_save(cr);
 	cairo_set_matrix(cr, &object->__transform_matrix);
 	if(ninepatch->lt)
@@ -295,6 +323,11 @@ static int m_display_present(lua_State * L)
 {
 	struct ldisplay_t * display = luaL_checkudata(L, 1, MT_DISPLAY);
 	cairo_t * cr = display->cr;
+	if(display->busy)
+	{
+		cpufreq_frame_hint(ktime_to_ns(ktime_sub(ktime_get(), display->begin)), display->deadline);
+		display->busy = 0;
+	}
 	if(display->showfps)
 	{
 		char buf[32];
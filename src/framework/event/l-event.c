@@ -26,7 +26,11 @@
  *
  */
 
+#include <xboot/idle.h>
 #include <input/input.h>
+#include <uart/uart.h>
+#include <gpio/gpio.h>
+#include <adc/adc.h>
 #include <framework/event/l-event.h>
 
 #define EVT_KEY_DOWN				"KeyDown"
@@ -40,12 +44,17 @@
 #define EVT_TOUCH_BEGIN				"TouchBegin"
 #define EVT_TOUCH_MOVE				"TouchMove"
 #define EVT_TOUCH_END				"TouchEnd"
+#define EVT_TOUCH_FRAME				"TouchFrame"
 #define EVT_JOYSTICK_LEFTSTICK		"JoystickLeftStick"
 #define EVT_JOYSTICK_RIGHTSTICK		"JoystickRightStick"
 #define EVT_JOYSTICK_LEFTTRIGGER	"JoystickLeftTrigger"
 #define EVT_JOYSTICK_RIGHTTRIGGER	"JoystickRightTrigger"
 #define EVT_JOYSTICK_BUTTONDOWN		"JoystickButtonDown"
 #define EVT_JOYSTICK_BUTTONUP		"JoystickButtonUp"
+#define EVT_UART_RX					"UartRx"
+#define EVT_GPIO_EDGE				"GpioEdge"
+#define EVT_ADC_DONE				"AdcDone"
+#define EVT_SOUND_FINISH			"SoundFinish"
 #define EVT_ENTER_FRAME				"EnterFrame"
 #define EVT_ANIMATE_COMPLETE		"AnimateComplete"
 
@@ -75,9 +84,15 @@ static int l_event_new(lua_State * L)
 static int l_event_pump(lua_State * L)
 {
 	struct event_t event;
+	int i;
 
+	idle_poll();
 	if(!pump_event(runtime_get()->__event_base, &event))
+	{
+		idle_enter();
 		return 0;
+	}
+	idle_exit();
 
 	switch(event.type)
 	{
@@ -237,6 +252,31 @@ static int l_event_pump(lua_State * L)
 		lua_setfield(L, -2, "id");
 		return 1;
 
+	case EVENT_TYPE_TOUCH_FRAME:
+		lua_newtable(L);
+		lua_pushstring(L, ((struct input_t *)event.device)->name);
+		lua_setfield(L, -2, "device");
+		lua_pushstring(L, EVT_TOUCH_FRAME);
+		lua_setfield(L, -2, "type");
+		lua_pushnumber(L, ktime_to_ns(event.timestamp));
+		lua_setfield(L, -2, "time");
+		lua_pushinteger(L, event.e.touch_frame.count);
+		lua_setfield(L, -2, "count");
+		lua_createtable(L, event.e.touch_frame.count, 0);
+		for(i = 0; i < event.e.touch_frame.count; i++)
+		{
+			lua_createtable(L, 0, 3);
+			lua_pushinteger(L, event.e.touch_frame.contact[i].x);
+			lua_setfield(L, -2, "x");
+			lua_pushinteger(L, event.e.touch_frame.contact[i].y);
+			lua_setfield(L, -2, "y");
+			lua_pushinteger(L, event.e.touch_frame.contact[i].id);
+			lua_setfield(L, -2, "id");
+			lua_rawseti(L, -2, i + 1);
+		}
+		lua_setfield(L, -2, "contacts");
+		return 1;
+
 	case EVENT_TYPE_JOYSTICK_LEFTSTICK:
 		lua_newtable(L);
 		lua_pushstring(L, ((struct input_t *)event.device)->name);
@@ -313,6 +353,58 @@ static int l_event_pump(lua_State * L)
 		lua_setfield(L, -2, "button");
 		return 1;
 
+	case EVENT_TYPE_UART_RX:
+		lua_newtable(L);
+		lua_pushstring(L, ((struct uart_t *)event.device)->name);
+		lua_setfield(L, -2, "device");
+		lua_pushstring(L, EVT_UART_RX);
+		lua_setfield(L, -2, "type");
+		lua_pushnumber(L, ktime_to_ns(event.timestamp));
+		lua_setfield(L, -2, "time");
+		lua_pushinteger(L, event.e.uart_rx.count);
+		lua_setfield(L, -2, "count");
+		return 1;
+
+	case EVENT_TYPE_GPIO_EDGE:
+		lua_newtable(L);
+		lua_pushstring(L, event.device ? ((struct gpiochip_t *)event.device)->name : "gpio");
+		lua_setfield(L, -2, "device");
+		lua_pushstring(L, EVT_GPIO_EDGE);
+		lua_setfield(L, -2, "type");
+		lua_pushnumber(L, ktime_to_ns(event.timestamp));
+		lua_setfield(L, -2, "time");
+		lua_pushinteger(L, event.e.gpio_edge.gpio);
+		lua_setfield(L, -2, "gpio");
+		lua_pushinteger(L, event.e.gpio_edge.value);
+		lua_setfield(L, -2, "value");
+		return 1;
+
+	case EVENT_TYPE_ADC_DONE:
+		lua_newtable(L);
+		lua_pushstring(L, ((struct adc_t *)event.device)->name);
+		lua_setfield(L, -2, "device");
+		lua_pushstring(L, EVT_ADC_DONE);
+		lua_setfield(L, -2, "type");
+		lua_pushnumber(L, ktime_to_ns(event.timestamp));
+		lua_setfield(L, -2, "time");
+		lua_pushinteger(L, event.e.adc_done.channel);
+		lua_setfield(L, -2, "channel");
+		lua_pushinteger(L, event.e.adc_done.value);
+		lua_setfield(L, -2, "value");
+		return 1;
+
+	case EVENT_TYPE_SOUND_FINISH:
+		lua_newtable(L);
+		lua_pushstring(L, event.e.sound_finish.title);
+		lua_setfield(L, -2, "device");
+		lua_pushstring(L, EVT_SOUND_FINISH);
+		lua_setfield(L, -2, "type");
+		lua_pushnumber(L, ktime_to_ns(event.timestamp));
+		lua_setfield(L, -2, "time");
+		lua_pushinteger(L, event.e.sound_finish.position);
+		lua_setfield(L, -2, "position");
+		return 1;
+
 	default:
 		return 0;
 	}
@@ -320,10 +412,110 @@ static int l_event_pump(lua_State * L)
 	return 0;
 }
 
+static const struct {
+	const char * name;
+	enum event_type_t type;
+} __event_class[] = {
+	{ EVT_UART_RX,		EVENT_TYPE_UART_RX },
+	{ EVT_GPIO_EDGE,	EVENT_TYPE_GPIO_EDGE },
+	{ EVT_ADC_DONE,		EVENT_TYPE_ADC_DONE },
+	{ EVT_SOUND_FINISH,	EVENT_TYPE_SOUND_FINISH },
+};
+
+static enum event_type_t __event_class_check(lua_State * L, int idx)
+{
+	const char * name = luaL_checkstring(L, idx);
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(__event_class); i++)
+	{
+		if(strcmp(__event_class[i].name, name) == 0)
+			return __event_class[i].type;
+	}
+	return luaL_argerror(L, idx, "unsubscribable event type");
+}
+
+static void * __event_device_check(lua_State * L, int idx, enum event_type_t type)
+{
+	const char * name = luaL_optstring(L, idx, NULL);
+	void * device = NULL;
+
+	if(!name)
+		return NULL;
+	switch(type)
+	{
+	case EVENT_TYPE_UART_RX:
+		device = search_uart(name);
+		break;
+	case EVENT_TYPE_ADC_DONE:
+		device = search_adc(name);
+		break;
+	default:
+		luaL_argerror(L, idx, "no device filter for this event type");
+		break;
+	}
+	if(!device)
+		luaL_argerror(L, idx, "no such device");
+	return device;
+}
+
+/*
+ * An empty pump starts idle time, the work the loop does next on its own,
+ * timers and frames, ends it here rather than at the next event.
+ */
+static int l_event_busy(lua_State * L)
+{
+	idle_exit();
+	return 0;
+}
+
+static int l_event_subscribe(lua_State * L)
+{
+	struct event_base_t * eb = runtime_get()->__event_base;
+	enum event_type_t type = __event_class_check(L, 1);
+	void * device;
+	int pin;
+
+	if(lua_isnoneornil(L, 2) && lua_isnoneornil(L, 3))
+	{
+		event_base_subscribe(eb, type);
+	}
+	else
+	{
+		device = __event_device_check(L, 2, type);
+		pin = luaL_optinteger(L, 3, -1);
+		if(!event_base_subscribe_filter(eb, type, device, pin))
+			return luaL_error(L, "too many event filters");
+	}
+	return 0;
+}
+
+static int l_event_unsubscribe(lua_State * L)
+{
+	event_base_unsubscribe(runtime_get()->__event_base, __event_class_check(L, 1));
+	return 0;
+}
+
+static int l_event_stats(lua_State * L)
+{
+	struct event_base_t * eb = runtime_get()->__event_base;
+
+	lua_newtable(L);
+	lua_pushinteger(L, eb ? eb->overflow : 0);
+	lua_setfield(L, -2, "overflow");
+	lua_pushinteger(L, eb ? eb->coalesce : 0);
+	lua_setfield(L, -2, "coalesce");
+	return 1;
+}
+
 static const luaL_Reg l_event[] = {
-	{"new",		l_event_new},
-	{"pump",	l_event_pump},
-	{NULL,		NULL}
+	{"new",			l_event_new},
+	{"pump",		l_event_pump},
+	{"busy",		l_event_busy},
+	{"subscribe",	l_event_subscribe},
+	{"unsubscribe",	l_event_unsubscribe},
+	{"stats",		l_event_stats},
+	{NULL,			NULL}
 };
 
 int luaopen_event(lua_State * L)
@@ -340,12 +532,17 @@ int luaopen_event(lua_State * L)
 	luahelper_set_strfield(L, "TOUCH_BEGIN",			EVT_TOUCH_BEGIN);
 	luahelper_set_strfield(L, "TOUCH_MOVE",				EVT_TOUCH_MOVE);
 	luahelper_set_strfield(L, "TOUCH_END",				EVT_TOUCH_END);
+	luahelper_set_strfield(L, "TOUCH_FRAME",			EVT_TOUCH_FRAME);
 	luahelper_set_strfield(L, "JOYSTICK_LEFTSTICK",		EVT_JOYSTICK_LEFTSTICK);
 	luahelper_set_strfield(L, "JOYSTICK_RIGHTSTICK",	EVT_JOYSTICK_RIGHTSTICK);
 	luahelper_set_strfield(L, "JOYSTICK_LEFTTRIGGER",	EVT_JOYSTICK_LEFTTRIGGER);
 	luahelper_set_strfield(L, "JOYSTICK_RIGHTTRIGGER",	EVT_JOYSTICK_RIGHTTRIGGER);
 	luahelper_set_strfield(L, "JOYSTICK_BUTTONDOWN",	EVT_JOYSTICK_BUTTONDOWN);
 	luahelper_set_strfield(L, "JOYSTICK_BUTTONUP",		EVT_JOYSTICK_BUTTONUP);
+	luahelper_set_strfield(L, "UART_RX",				EVT_UART_RX);
+	luahelper_set_strfield(L, "GPIO_EDGE",				EVT_GPIO_EDGE);
+	luahelper_set_strfield(L, "ADC_DONE",				EVT_ADC_DONE);
+	luahelper_set_strfield(L, "SOUND_FINISH",			EVT_SOUND_FINISH);
 	luahelper_set_strfield(L, "ENTER_FRAME",			EVT_ENTER_FRAME);
 	luahelper_set_strfield(L, "ANIMATE_COMPLETE",		EVT_ANIMATE_COMPLETE);
 	return 1;
@@ -29,20 +29,13 @@
 #include <gpio/gpio.h>
 #include <framework/hardware/l-hardware.h>
 
-struct lgpio_t {
-	struct gpiochip_t * chip;
-	int offset;
-};
-
 static int l_gpio_new(lua_State * L)
 {
-	int offset = luaL_checkinteger(L, 1);
-	struct gpiochip_t * chip = search_gpiochip(offset);
-	if(chip && (offset >= 0) && (offset < chip->ngpio))
+	struct gpio_desc_t desc;
+	if(gpio_desc_init(&desc, luaL_checkinteger(L, 1)))
 	{
-		struct lgpio_t * gpio = lua_newuserdata(L, sizeof(struct lgpio_t));
-		gpio->chip = chip;
-		gpio->offset = offset;
+		struct gpio_desc_t * gpio = lua_newuserdata(L, sizeof(struct gpio_desc_t));
+		*gpio = desc;
 		luaL_setmetatable(L, MT_HARDWARE_GPIO);
 		return 1;
 	}
@@ -56,7 +49,7 @@ static const luaL_Reg l_gpio[] = {
 
 static int m_gpio_set_cfg(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	int cfg = luaL_checkinteger(L, 2);
 	gpio->chip->set_cfg(gpio->chip, gpio->offset, cfg);
 	lua_settop(L, 1);
@@ -65,7 +58,7 @@ static int m_gpio_set_cfg(lua_State * L)
 
 static int m_gpio_get_cfg(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	int cfg = gpio->chip->get_cfg(gpio->chip, gpio->offset);
 	lua_pushinteger(L, cfg);
 	return 1;
@@ -73,7 +66,7 @@ static int m_gpio_get_cfg(lua_State * L)
 
 static int m_gpio_set_pull(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_pull_t pull = (enum gpio_pull_t)luaL_checkinteger(L, 2);
 	gpio->chip->set_pull(gpio->chip, gpio->offset, pull);
 	lua_settop(L, 1);
@@ -82,7 +75,7 @@ static int m_gpio_set_pull(lua_State * L)
 
 static int m_gpio_get_pull(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_pull_t pull = gpio->chip->get_pull(gpio->chip, gpio->offset);
 	lua_pushinteger(L, pull);
 	return 1;
@@ -90,7 +83,7 @@ static int m_gpio_get_pull(lua_State * L)
 
 static int m_gpio_set_drv(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_drv_t drv = (enum gpio_pull_t)luaL_checkinteger(L, 2);
 	gpio->chip->set_drv(gpio->chip, gpio->offset, drv);
 	lua_settop(L, 1);
@@ -99,7 +92,7 @@ static int m_gpio_set_drv(lua_State * L)
 
 static int m_gpio_get_drv(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_drv_t drv = gpio->chip->get_drv(gpio->chip, gpio->offset);
 	lua_pushinteger(L, drv);
 	return 1;
@@ -107,7 +100,7 @@ static int m_gpio_get_drv(lua_State * L)
 
 static int m_gpio_set_rate(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_rate_t rate = (enum gpio_pull_t)luaL_checkinteger(L, 2);
 	gpio->chip->set_rate(gpio->chip, gpio->offset, rate);
 	lua_settop(L, 1);
@@ -116,7 +109,7 @@ static int m_gpio_set_rate(lua_State * L)
 
 static int m_gpio_get_rate(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_rate_t rate = gpio->chip->get_rate(gpio->chip, gpio->offset);
 	lua_pushinteger(L, rate);
 	return 1;
@@ -124,7 +117,7 @@ static int m_gpio_get_rate(lua_State * L)
 
 static int m_gpio_set_dir(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_direction_t dir = (enum gpio_pull_t)luaL_checkinteger(L, 2);
 	gpio->chip->set_dir(gpio->chip, gpio->offset, dir);
 	lua_settop(L, 1);
@@ -133,7 +126,7 @@ static int m_gpio_set_dir(lua_State * L)
 
 static int m_gpio_get_dir(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	enum gpio_direction_t dir = gpio->chip->get_dir(gpio->chip, gpio->offset);
 	lua_pushinteger(L, dir);
 	return 1;
@@ -141,7 +134,7 @@ static int m_gpio_get_dir(lua_State * L)
 
 static int m_gpio_set_value(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	int value = luaL_checkinteger(L, 2);
 	gpio->chip->set_value(gpio->chip, gpio->offset, value);
 	lua_settop(L, 1);
@@ -150,12 +143,28 @@ static int m_gpio_set_value(lua_State * L)
 
 static int m_gpio_get_value(lua_State * L)
 {
-	struct lgpio_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
 	int value = gpio->chip->get_value(gpio->chip, gpio->offset);
 	lua_pushinteger(L, value);
 	return 1;
 }
 
+static int m_gpio_enable_event(lua_State * L)
+{
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	enum irq_type_t type = (enum irq_type_t)luaL_optinteger(L, 2, IRQ_TYPE_EDGE_BOTH);
+	lua_pushboolean(L, gpio_event_enable(gpio->gpio, type));
+	return 1;
+}
+
+static int m_gpio_disable_event(lua_State * L)
+{
+	struct gpio_desc_t * gpio = luaL_checkudata(L, 1, MT_HARDWARE_GPIO);
+	gpio_event_disable(gpio->gpio);
+	lua_settop(L, 1);
+	return 1;
+}
+
 static const luaL_Reg m_gpio[] = {
 	{"setCfg",		m_gpio_set_cfg},
 	{"getCfg",		m_gpio_get_cfg},
@@ -169,6 +178,8 @@ static const luaL_Reg m_gpio[] = {
 	{"getDir",		m_gpio_get_dir},
 	{"setValue",	m_gpio_set_value},
 	{"getValue",	m_gpio_get_value},
+	{"enableEvent",	m_gpio_enable_event},
+	{"disableEvent",m_gpio_disable_event},
 	{NULL,	NULL}
 };
 
@@ -190,6 +201,10 @@ int luaopen_hardware_gpio(lua_State * L)
     /* gpio_direction_t */
 	luahelper_set_intfield(L, "DIR_INPUT",		GPIO_DIRECTION_INPUT);
 	luahelper_set_intfield(L, "DIR_OUTPUT",		GPIO_DIRECTION_OUTPUT);
+    /* irq_type_t */
+	luahelper_set_intfield(L, "EDGE_FALLING",	IRQ_TYPE_EDGE_FALLING);
+	luahelper_set_intfield(L, "EDGE_RISING",	IRQ_TYPE_EDGE_RISING);
+	luahelper_set_intfield(L, "EDGE_BOTH",		IRQ_TYPE_EDGE_BOTH);
 	luahelper_create_metatable(L, MT_HARDWARE_GPIO, m_gpio);
 	return 1;
 }
@@ -62,6 +62,16 @@ static int m_i2c_gc(lua_State * L)
 static int m_i2c_read(lua_State * L)
 {
 	struct li2c_t * i2c = luaL_checkudata(L, 1, MT_HARDWARE_I2C);
+	if(lbuffer_test(L, 2))
+	{
+		size_t len;
+		void * p = lbuffer_checkrange(L, 2, &len);
+		if((len > 0) && (i2c_master_recv(i2c->dev, p, len) == len))
+			lua_pushinteger(L, len);
+		else
+			lua_pushnil(L);
+		return 1;
+	}
 	int count = luaL_checkinteger(L, 2);
 	if(count <= 0)
 	{
@@ -90,8 +100,8 @@ static int m_i2c_read(lua_State * L)
 static int m_i2c_write(lua_State * L)
 {
 	struct li2c_t * i2c = luaL_checkudata(L, 1, MT_HARDWARE_I2C);
-	int count;
-	const char * buf = luaL_checklstring(L, 2, (size_t *)&count);
+	size_t count;
+	const void * buf = lbuffer_checkbytes(L, 2, &count);
 	if(count > 0)
 		lua_pushboolean(L, (i2c_master_send(i2c->dev, (void *)buf, count) == count));
 	else
@@ -117,6 +117,41 @@ static int m_ledstrip_get_color(lua_State * L)
 	return 3;
 }
 
+static int m_ledstrip_set_colors(lua_State * L)
+{
+	struct ledstrip_t * strip = luaL_checkudata(L, 1, MT_HARDWARE_LEDSTRIP);
+	size_t len;
+	const u8_t * p = lbuffer_checkbytes(L, 2, &len);
+	int start = luaL_optinteger(L, 3, 0);
+	int count = ledstrip_get_count(strip);
+	int i;
+	for(i = start; (i < count) && (len >= 3); i++, p += 3, len -= 3)
+		ledstrip_set_color(strip, i, (p[0] << 16) | (p[1] << 8) | (p[2] << 0));
+	lua_settop(L, 1);
+	return 1;
+}
+
+static int m_ledstrip_get_colors(lua_State * L)
+{
+	struct ledstrip_t * strip = luaL_checkudata(L, 1, MT_HARDWARE_LEDSTRIP);
+	struct lbuffer_t * buf = lbuffer_check(L, 2);
+	int start = luaL_optinteger(L, 3, 0);
+	int count = ledstrip_get_count(strip);
+	u8_t * p = buf->data;
+	size_t len = buf->size;
+	uint32_t color;
+	int i;
+	for(i = start; (i < count) && (len >= 3); i++, p += 3, len -= 3)
+	{
+		color = ledstrip_get_color(strip, i);
+		p[0] = (color >> 16) & 0xff;
+		p[1] = (color >> 8) & 0xff;
+		p[2] = (color >> 0) & 0xff;
+	}
+	lua_settop(L, 2);
+	return 1;
+}
+
 static int m_ledstrip_refresh(lua_State * L)
 {
 	struct ledstrip_t * strip = luaL_checkudata(L, 1, MT_HARDWARE_LEDSTRIP);
@@ -131,6 +166,8 @@ static const luaL_Reg m_ledstrip[] = {
 	{"getCount",	m_ledstrip_get_count},
 	{"setColor",	m_ledstrip_set_color},
 	{"getColor",	m_ledstrip_get_color},
+	{"setColors",	m_ledstrip_set_colors},
+	{"getColors",	m_ledstrip_get_colors},
 	{"refresh",		m_ledstrip_refresh},
 	{NULL,	NULL}
 };
@@ -76,7 +76,8 @@ static int m_nvmem_set(lua_State * L)
 	struct nvmem_t * m = luaL_checkudata(L, 1, MT_HARDWARE_NVMEM);
 	const char * key = luaL_checkstring(L, 2);
 	const char * value = luaL_optstring(L, 3, NULL);
-	nvmem_set(m, key, value);
+	if(!nvmem_set(m, key, value))
+		return luaL_error(L, "no room for '%s'", key);
 	lua_settop(L, 1);
 	return 1;
 }
@@ -101,17 +102,37 @@ static int m_nvmem_clear(lua_State * L)
 static int m_nvmem_sync(lua_State * L)
 {
 	struct nvmem_t * m = luaL_checkudata(L, 1, MT_HARDWARE_NVMEM);
-	nvmem_sync(m);
+	if(!nvmem_sync(m))
+		return luaL_error(L, "sync failed");
 	lua_settop(L, 1);
 	return 1;
 }
 
+static int m_nvmem_capacity(lua_State * L)
+{
+	struct nvmem_t * m = luaL_checkudata(L, 1, MT_HARDWARE_NVMEM);
+	lua_pushinteger(L, nvmem_capacity(m));
+	return 1;
+}
+
+static int m_nvmem_read(lua_State * L)
+{
+	struct nvmem_t * m = luaL_checkudata(L, 1, MT_HARDWARE_NVMEM);
+	int offset = luaL_checkinteger(L, 2);
+	size_t len;
+	void * p = lbuffer_checkrange(L, 3, &len);
+	lua_pushinteger(L, nvmem_read(m, p, offset, len));
+	return 1;
+}
+
 static const luaL_Reg m_nvmem[] = {
 	{"__tostring",	m_nvmem_tostring},
 	{"set",			m_nvmem_set},
 	{"get",			m_nvmem_get},
 	{"clear",		m_nvmem_clear},
 	{"sync",		m_nvmem_sync},
+	{"capacity",	m_nvmem_capacity},
+	{"read",		m_nvmem_read},
 	{NULL,	NULL}
 };
 
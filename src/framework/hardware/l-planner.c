@@ -0,0 +1,160 @@
+/*
+ * framework/hardware/l-planner.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <stepper/planner.h>
+#include <framework/hardware/l-hardware.h>
+
+struct lplanner_t {
+	struct stepper_planner_t * p;
+};
+
+static int l_planner_new(lua_State * L)
+{
+	struct stepper_t * axis[STEPPER_PLANNER_MAX_AXES];
+	struct lplanner_t * lp;
+	int depth = luaL_optinteger(L, 2, 16);
+	int naxis, i;
+
+	luaL_checktype(L, 1, LUA_TTABLE);
+	naxis = lua_rawlen(L, 1);
+	if((naxis <= 0) || (naxis > STEPPER_PLANNER_MAX_AXES))
+		return luaL_argerror(L, 1, "bad axis count");
+	for(i = 0; i < naxis; i++)
+	{
+		lua_rawgeti(L, 1, i + 1);
+		axis[i] = search_stepper(luaL_checkstring(L, -1));
+		lua_pop(L, 1);
+		if(!axis[i])
+			return 0;
+	}
+
+	lp = lua_newuserdata(L, sizeof(struct lplanner_t));
+	lp->p = stepper_planner_alloc(axis, naxis, depth);
+	if(!lp->p)
+		return 0;
+	luaL_setmetatable(L, MT_HARDWARE_PLANNER);
+	return 1;
+}
+
+static const luaL_Reg l_planner[] = {
+	{"new",		l_planner_new},
+	{NULL,	NULL}
+};
+
+static int m_planner_gc(lua_State * L)
+{
+	struct lplanner_t * lp = luaL_checkudata(L, 1, MT_HARDWARE_PLANNER);
+	if(lp->p)
+	{
+		stepper_planner_free(lp->p);
+		lp->p = NULL;
+	}
+	return 0;
+}
+
+static int m_planner_profile(lua_State * L)
+{
+	struct lplanner_t * lp = luaL_checkudata(L, 1, MT_HARDWARE_PLANNER);
+	int vmax = luaL_checkinteger(L, 2);
+	int accel = luaL_checkinteger(L, 3);
+	int jerk = luaL_optinteger(L, 4, 0);
+	enum stepper_profile_t profile = (jerk > 0) ? STEPPER_PROFILE_SCURVE : STEPPER_PROFILE_TRAPEZOID;
+	lua_pushboolean(L, stepper_planner_set_profile(lp->p, profile, vmax, accel, jerk));
+	return 1;
+}
+
+static int m_planner_line(lua_State * L)
+{
+	struct lplanner_t * lp = luaL_checkudata(L, 1, MT_HARDWARE_PLANNER);
+	int delta[STEPPER_PLANNER_MAX_AXES];
+	int speed = luaL_optinteger(L, 3, 0);
+	int i;
+
+	luaL_checktype(L, 2, LUA_TTABLE);
+	for(i = 0; i < lp->p->naxis; i++)
+	{
+		lua_rawgeti(L, 2, i + 1);
+		delta[i] = luaL_optinteger(L, -1, 0);
+		lua_pop(L, 1);
+	}
+	lua_pushboolean(L, stepper_planner_line(lp->p, delta, speed));
+	return 1;
+}
+
+static int m_planner_busying(lua_State * L)
+{
+	struct lplanner_t * lp = luaL_checkudata(L, 1, MT_HARDWARE_PLANNER);
+	lua_pushboolean(L, stepper_planner_busying(lp->p));
+	return 1;
+}
+
+static int m_planner_stop(lua_State * L)
+{
+	struct lplanner_t * lp = luaL_checkudata(L, 1, MT_HARDWARE_PLANNER);
+	stepper_planner_stop(lp->p);
+	return 0;
+}
+
+static int m_planner_stats(lua_State * L)
+{
+	struct lplanner_t * lp = luaL_checkudata(L, 1, MT_HARDWARE_PLANNER);
+	struct stepper_planner_t * p = lp->p;
+	lua_newtable(L);
+	lua_pushinteger(L, p->steps);
+	lua_setfield(L, -2, "steps");
+	lua_pushinteger(L, p->segments);
+	lua_setfield(L, -2, "segments");
+	lua_pushinteger(L, p->missed);
+	lua_setfield(L, -2, "missed");
+	lua_pushnumber(L, (lua_Number)p->jitter_max / 1000000000.0);
+	lua_setfield(L, -2, "jitter_max");
+	lua_pushnumber(L, p->steps ? (lua_Number)(p->jitter_sum / (s64_t)p->steps) / 1000000000.0 : 0);
+	lua_setfield(L, -2, "jitter_avg");
+	lua_pushinteger(L, p->rate_max);
+	lua_setfield(L, -2, "rate_max");
+	if(lua_toboolean(L, 2))
+		stepper_planner_reset_stats(p);
+	return 1;
+}
+
+static const luaL_Reg m_planner[] = {
+	{"__gc",		m_planner_gc},
+	{"profile",		m_planner_profile},
+	{"line",		m_planner_line},
+	{"busying",		m_planner_busying},
+	{"stop",		m_planner_stop},
+	{"stats",		m_planner_stats},
+	{NULL,	NULL}
+};
+
+int luaopen_hardware_planner(lua_State * L)
+{
+	luaL_newlib(L, l_planner);
+	luahelper_create_metatable(L, MT_HARDWARE_PLANNER, m_planner);
+	return 1;
+}
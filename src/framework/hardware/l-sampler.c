@@ -0,0 +1,275 @@
+/*
+ * framework/hardware/l-sampler.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot/sampler.h>
+#include <adc/adc.h>
+#include <compass/compass.h>
+#include <gmeter/gmeter.h>
+#include <gyroscope/gyroscope.h>
+#include <pressure/pressure.h>
+#include <thermometer/thermometer.h>
+#include <framework/hardware/l-hardware.h>
+
+struct lsampler_t {
+	struct sampler_t * s;
+	void * dev;
+	int channel;
+	lua_Number scale;
+};
+
+static bool_t sampler_read_gmeter(struct sampler_t * s, s32_t * v)
+{
+	struct lsampler_t * ls = s->data;
+	return gmeter_get_acceleration(ls->dev, (int *)&v[0], (int *)&v[1], (int *)&v[2]);
+}
+
+static bool_t sampler_read_gyroscope(struct sampler_t * s, s32_t * v)
+{
+	struct lsampler_t * ls = s->data;
+	return gyroscope_get_palstance(ls->dev, (int *)&v[0], (int *)&v[1], (int *)&v[2]);
+}
+
+static bool_t sampler_read_compass(struct sampler_t * s, s32_t * v)
+{
+	struct lsampler_t * ls = s->data;
+	return compass_get_magnetic(ls->dev, (int *)&v[0], (int *)&v[1], (int *)&v[2]);
+}
+
+static bool_t sampler_read_thermometer(struct sampler_t * s, s32_t * v)
+{
+	struct lsampler_t * ls = s->data;
+	v[0] = thermometer_get_temperature(ls->dev);
+	return TRUE;
+}
+
+static bool_t sampler_read_pressure(struct sampler_t * s, s32_t * v)
+{
+	struct lsampler_t * ls = s->data;
+	v[0] = pressure_get_pascal(ls->dev);
+	return TRUE;
+}
+
+static bool_t sampler_read_adc(struct sampler_t * s, s32_t * v)
+{
+	struct lsampler_t * ls = s->data;
+	v[0] = adc_read_voltage(ls->dev, ls->channel);
+	return TRUE;
+}
+
+static void * sampler_search_gmeter(const char * name)
+{
+	return name ? search_gmeter(name) : search_first_gmeter();
+}
+
+static void * sampler_search_gyroscope(const char * name)
+{
+	return name ? search_gyroscope(name) : search_first_gyroscope();
+}
+
+static void * sampler_search_compass(const char * name)
+{
+	return name ? search_compass(name) : search_first_compass();
+}
+
+static void * sampler_search_thermometer(const char * name)
+{
+	return name ? search_thermometer(name) : search_first_thermometer();
+}
+
+static void * sampler_search_pressure(const char * name)
+{
+	return name ? search_pressure(name) : search_first_pressure();
+}
+
+static void * sampler_search_adc(const char * name)
+{
+	return search_adc(name);
+}
+
+static const struct {
+	const char * kind;
+	int channel;
+	lua_Number scale;
+	void * (*search)(const char *);
+	bool_t (*read)(struct sampler_t *, s32_t *);
+} __sampler_source[] = {
+	{ "gmeter",			3,	1000000,	sampler_search_gmeter,		sampler_read_gmeter },
+	{ "gyroscope",		3,	1000000,	sampler_search_gyroscope,	sampler_read_gyroscope },
+	{ "compass",		3,	1000000,	sampler_search_compass,		sampler_read_compass },
+	{ "thermometer",	1,	1000,		sampler_search_thermometer,	sampler_read_thermometer },
+	{ "pressure",		1,	1,			sampler_search_pressure,	sampler_read_pressure },
+	{ "adc",			1,	1000000,	sampler_search_adc,			sampler_read_adc },
+};
+
+static int l_sampler_new(lua_State * L)
+{
+	const char * kind = luaL_checkstring(L, 1);
+	const char * name = luaL_optstring(L, 2, NULL);
+	struct lsampler_t * ls;
+	void * dev;
+	int i;
+
+	for(i = 0; i < ARRAY_SIZE(__sampler_source); i++)
+	{
+		if(strcmp(__sampler_source[i].kind, kind) == 0)
+			break;
+	}
+	if(i >= ARRAY_SIZE(__sampler_source))
+		return luaL_argerror(L, 1, "unsupported sensor");
+	dev = __sampler_source[i].search(name);
+	if(!dev)
+		return 0;
+
+	ls = lua_newuserdata(L, sizeof(struct lsampler_t));
+	ls->dev = dev;
+	ls->channel = luaL_optinteger(L, 3, 0);
+	ls->scale = __sampler_source[i].scale;
+	ls->s = sampler_alloc(__sampler_source[i].channel, __sampler_source[i].read, ls);
+	if(!ls->s)
+		return 0;
+	luaL_setmetatable(L, MT_HARDWARE_SAMPLER);
+	return 1;
+}
+
+static const luaL_Reg l_sampler[] = {
+	{"new",		l_sampler_new},
+	{NULL,	NULL}
+};
+
+static int m_sampler_gc(lua_State * L)
+{
+	struct lsampler_t * ls = luaL_checkudata(L, 1, MT_HARDWARE_SAMPLER);
+	if(ls->s)
+	{
+		sampler_free(ls->s);
+		ls->s = NULL;
+	}
+	return 0;
+}
+
+static int m_sampler_start(lua_State * L)
+{
+	struct lsampler_t * ls = luaL_checkudata(L, 1, MT_HARDWARE_SAMPLER);
+	int rate = luaL_checkinteger(L, 2);
+	int depth = luaL_optinteger(L, 3, rate > 256 ? rate : 256);
+	lua_pushboolean(L, sampler_start(ls->s, rate, depth));
+	return 1;
+}
+
+static int m_sampler_stop(lua_State * L)
+{
+	struct lsampler_t * ls = luaL_checkudata(L, 1, MT_HARDWARE_SAMPLER);
+	sampler_stop(ls->s);
+	return 0;
+}
+
+static int m_sampler_available(lua_State * L)
+{
+	struct lsampler_t * ls = luaL_checkudata(L, 1, MT_HARDWARE_SAMPLER);
+	lua_pushinteger(L, sampler_available(ls->s));
+	return 1;
+}
+
+/*
+ * Drain into column arrays, t.time holds the timestamps in seconds and
+ * t[1] to t[channel] the values, which avoids a table per sample.
+ */
+static int m_sampler_drain(lua_State * L)
+{
+	struct lsampler_t * ls = luaL_checkudata(L, 1, MT_HARDWARE_SAMPLER);
+	int avail = sampler_available(ls->s);
+	int max = luaL_optinteger(L, 2, avail);
+	struct sampler_record_t r[32];
+	int total = 0;
+	int n, i, c;
+
+	if(max < 0)
+		max = 0;
+	else if(max > avail)
+		max = avail;
+
+	lua_createtable(L, ls->s->channel, 1);
+	lua_createtable(L, max, 0);
+	for(c = 0; c < ls->s->channel; c++)
+	{
+		lua_createtable(L, max, 0);
+		lua_rawseti(L, -3, c + 1);
+	}
+	while((total < max) && (n = sampler_drain(ls->s, r, (max - total < 32) ? max - total : 32)) > 0)
+	{
+		for(i = 0; i < n; i++)
+		{
+			total++;
+			lua_pushnumber(L, (lua_Number)r[i].time / 1000000000);
+			lua_rawseti(L, -2, total);
+			for(c = 0; c < ls->s->channel; c++)
+			{
+				lua_rawgeti(L, -2, c + 1);
+				lua_pushnumber(L, (lua_Number)r[i].value[c] / ls->scale);
+				lua_rawseti(L, -2, total);
+				lua_pop(L, 1);
+			}
+		}
+	}
+	lua_setfield(L, -2, "time");
+	lua_pushinteger(L, total);
+	lua_insert(L, -2);
+	return 2;
+}
+
+static int m_sampler_stats(lua_State * L)
+{
+	struct lsampler_t * ls = luaL_checkudata(L, 1, MT_HARDWARE_SAMPLER);
+	lua_newtable(L);
+	lua_pushinteger(L, ls->s->count);
+	lua_setfield(L, -2, "count");
+	lua_pushinteger(L, ls->s->overrun);
+	lua_setfield(L, -2, "overrun");
+	lua_pushinteger(L, ls->s->missed);
+	lua_setfield(L, -2, "missed");
+	lua_pushinteger(L, ls->s->error);
+	lua_setfield(L, -2, "error");
+	return 1;
+}
+
+static const luaL_Reg m_sampler[] = {
+	{"__gc",		m_sampler_gc},
+	{"start",		m_sampler_start},
+	{"stop",		m_sampler_stop},
+	{"available",	m_sampler_available},
+	{"drain",		m_sampler_drain},
+	{"stats",		m_sampler_stats},
+	{NULL,	NULL}
+};
+
+int luaopen_hardware_sampler(lua_State * L)
+{
+	luaL_newlib(L, l_sampler);
+	luahelper_create_metatable(L, MT_HARDWARE_SAMPLER, m_sampler);
+	return 1;
+}
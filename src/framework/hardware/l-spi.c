@@ -65,6 +65,16 @@ static int m_spi_gc(lua_State * L)
 static int m_spi_read(lua_State * L)
 {
 	struct lspi_t * spi = luaL_checkudata(L, 1, MT_HARDWARE_SPI);
+	if(lbuffer_test(L, 2))
+	{
+		size_t len;
+		void * p = lbuffer_checkrange(L, 2, &len);
+		if((len > 0) && !(spi_device_write_then_read(spi->dev, 0, 0, p, len) < 0))
+			lua_pushinteger(L, len);
+		else
+			lua_pushnil(L);
+		return 1;
+	}
 	int count = luaL_checkinteger(L, 2);
 	if(count <= 0)
 	{
@@ -93,8 +103,8 @@ static int m_spi_read(lua_State * L)
 static int m_spi_write(lua_State * L)
 {
 	struct lspi_t * spi = luaL_checkudata(L, 1, MT_HARDWARE_SPI);
-	int count;
-	const char * buf = luaL_checklstring(L, 2, (size_t *)&count);
+	size_t count;
+	const void * buf = lbuffer_checkbytes(L, 2, &count);
 	if(count > 0)
 		lua_pushboolean(L, (spi_device_write_then_read(spi->dev, (void *)buf, count, 0, 0) < 0) ? 0 : 1);
 	else
@@ -102,6 +112,16 @@ static int m_spi_write(lua_State * L)
 	return 1;
 }
 
+static int m_spi_transfer(lua_State * L)
+{
+	struct lspi_t * spi = luaL_checkudata(L, 1, MT_HARDWARE_SPI);
+	size_t txlen, rxlen;
+	const void * txbuf = lbuffer_checkbytes(L, 2, &txlen);
+	void * rxbuf = lbuffer_checkrange(L, 3, &rxlen);
+	lua_pushboolean(L, (spi_device_write_then_read(spi->dev, (void *)txbuf, txlen, rxbuf, rxlen) < 0) ? 0 : 1);
+	return 1;
+}
+
 static int m_spi_select(lua_State * L)
 {
 	struct lspi_t * spi = luaL_checkudata(L, 1, MT_HARDWARE_SPI);
@@ -122,6 +142,7 @@ static const luaL_Reg m_spi[] = {
 	{"__gc",		m_spi_gc},
 	{"read",		m_spi_read},
 	{"write",		m_spi_write},
+	{"transfer",	m_spi_transfer},
 	{"select",		m_spi_select},
 	{"deselect",	m_spi_deselect},
 	{NULL,	NULL}
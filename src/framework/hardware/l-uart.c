@@ -106,6 +106,17 @@ static int m_uart_get(lua_State * L)
 static int m_uart_read(lua_State * L)
 {
 	struct uart_t * uart = luaL_checkudata(L, 1, MT_HARDWARE_UART);
+	if(lbuffer_test(L, 2))
+	{
+		size_t len;
+		void * p = lbuffer_checkrange(L, 2, &len);
+		ssize_t n = uart_read(uart, p, len);
+		if(n >= 0)
+			lua_pushinteger(L, n);
+		else
+			lua_pushnil(L);
+		return 1;
+	}
 	size_t count = luaL_checkinteger(L, 2);
 	if(count <= 0)
 	{
@@ -135,7 +146,7 @@ static int m_uart_write(lua_State * L)
 {
 	struct uart_t * uart = luaL_checkudata(L, 1, MT_HARDWARE_UART);
 	size_t count;
-	const char * buf = luaL_checklstring(L, 2, &count);
+	const void * buf = lbuffer_checkbytes(L, 2, &count);
 	if(count > 0)
 		lua_pushboolean(L, (uart_write(uart, (const u8_t *)buf, count) == count));
 	else
@@ -143,12 +154,29 @@ static int m_uart_write(lua_State * L)
 	return 1;
 }
 
+static int m_uart_enable_event(lua_State * L)
+{
+	struct uart_t * uart = luaL_checkudata(L, 1, MT_HARDWARE_UART);
+	lua_pushboolean(L, uart_event_enable(uart));
+	return 1;
+}
+
+static int m_uart_disable_event(lua_State * L)
+{
+	struct uart_t * uart = luaL_checkudata(L, 1, MT_HARDWARE_UART);
+	uart_event_disable(uart);
+	lua_settop(L, 1);
+	return 1;
+}
+
 static const luaL_Reg m_uart[] = {
 	{"__tostring",	m_uart_tostring},
 	{"set",			m_uart_set},
 	{"get",			m_uart_get},
 	{"read",		m_uart_read},
 	{"write",		m_uart_write},
+	{"enableEvent",	m_uart_enable_event},
+	{"disableEvent",m_uart_disable_event},
 	{NULL,	NULL}
 };
 
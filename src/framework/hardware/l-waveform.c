@@ -0,0 +1,241 @@
+/*
+ * framework/hardware/l-waveform.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <math.h>
+#include <dac/waveform.h>
+#include <framework/hardware/l-hardware.h>
+
+#define LWAVEFORM_SINE_SIZE		(256)
+
+struct lwaveform_t {
+	struct dac_waveform_t * w;
+};
+
+/*
+ * Phase in degrees to 1/2^32 of a period, negative and out of range angles
+ * wrap into [0, 360) before the conversion.
+ */
+static u32_t lwaveform_phase(lua_Number phase)
+{
+	phase = fmod(phase, 360.0);
+	if(phase < 0)
+		phase += 360.0;
+	if(!(phase >= 0) || !(phase < 360.0))
+		phase = 0;
+	return (u32_t)(phase / 360.0 * 4294967296.0);
+}
+
+/*
+ * Frequency in hertz to millihertz, negative ones are taken as zero.
+ */
+static u32_t lwaveform_mhz(lua_Number freq)
+{
+	freq = freq * 1000;
+	if(!(freq > 0))
+		return 0;
+	if(freq >= 4294967295.0)
+		return 0xffffffff;
+	return (u32_t)freq;
+}
+
+static int l_waveform_new(lua_State * L)
+{
+	struct dac_t * dac = search_dac(luaL_checkstring(L, 1));
+	int channel = luaL_optinteger(L, 2, 0);
+	struct lwaveform_t * lw;
+
+	if(!dac)
+		return 0;
+	lw = lua_newuserdata(L, sizeof(struct lwaveform_t));
+	lw->w = dac_waveform_alloc(dac, channel);
+	if(!lw->w)
+		return 0;
+	luaL_setmetatable(L, MT_HARDWARE_WAVEFORM);
+	return 1;
+}
+
+static const luaL_Reg l_waveform[] = {
+	{"new",		l_waveform_new},
+	{NULL,	NULL}
+};
+
+static int m_waveform_gc(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	if(lw->w)
+	{
+		dac_waveform_free(lw->w);
+		lw->w = NULL;
+	}
+	return 0;
+}
+
+static int m_waveform_start(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	int rate = luaL_checkinteger(L, 2);
+	int size = luaL_optinteger(L, 3, rate / 50 > 64 ? rate / 50 : 64);
+	lua_pushboolean(L, dac_waveform_start(lw->w, rate, size));
+	return 1;
+}
+
+/*
+ * dds(rate, frequency [, table [, phase]]), a full scale sine without table
+ */
+static int m_waveform_dds(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	int rate = luaL_checkinteger(L, 2);
+	lua_Number freq = luaL_checknumber(L, 3);
+	lua_Number phase = luaL_optnumber(L, 5, 0);
+	u32_t max = lw->w->max;
+	u32_t * table;
+	int len, i;
+
+	/*
+	 * The table is userdata, an element that fails to convert raises
+	 * with nothing to leak.
+	 */
+	if(lua_istable(L, 4))
+	{
+		len = lua_rawlen(L, 4);
+		table = lua_newuserdata(L, sizeof(u32_t) * (len > 0 ? len : 1));
+		for(i = 0; i < len; i++)
+		{
+			lua_rawgeti(L, 4, i + 1);
+			table[i] = (u32_t)luaL_optinteger(L, -1, 0);
+			lua_pop(L, 1);
+		}
+	}
+	else
+	{
+		len = LWAVEFORM_SINE_SIZE;
+		table = lua_newuserdata(L, sizeof(u32_t) * len);
+		for(i = 0; i < len; i++)
+			table[i] = (u32_t)((sin(2 * M_PI * i / len) + 1.0) * 0.5 * max + 0.5);
+	}
+	lua_pushboolean(L, dac_waveform_start_dds(lw->w, rate, table, len, lwaveform_mhz(freq), lwaveform_phase(phase)));
+	return 1;
+}
+
+static int m_waveform_stop(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	dac_waveform_stop(lw->w);
+	return 0;
+}
+
+static int m_waveform_write(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	u32_t buf[64];
+	int len, done = 0, c, n, i;
+
+	luaL_checktype(L, 2, LUA_TTABLE);
+	len = lua_rawlen(L, 2);
+	while(done < len)
+	{
+		c = (len - done > 64) ? 64 : len - done;
+		for(i = 0; i < c; i++)
+		{
+			lua_rawgeti(L, 2, done + i + 1);
+			buf[i] = (u32_t)luaL_optinteger(L, -1, 0);
+			lua_pop(L, 1);
+		}
+		n = dac_waveform_write(lw->w, buf, c);
+		done += n;
+		if(n < c)
+			break;
+	}
+	lua_pushinteger(L, done);
+	return 1;
+}
+
+static int m_waveform_flush(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	dac_waveform_flush(lw->w);
+	return 0;
+}
+
+static int m_waveform_space(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	lua_pushinteger(L, dac_waveform_space(lw->w));
+	return 1;
+}
+
+static int m_waveform_frequency(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	lua_Number freq = luaL_checknumber(L, 2);
+	dac_waveform_set_frequency(lw->w, lwaveform_mhz(freq));
+	return 0;
+}
+
+static int m_waveform_phase(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	lua_Number phase = luaL_checknumber(L, 2);
+	dac_waveform_set_phase(lw->w, lwaveform_phase(phase));
+	return 0;
+}
+
+static int m_waveform_stats(lua_State * L)
+{
+	struct lwaveform_t * lw = luaL_checkudata(L, 1, MT_HARDWARE_WAVEFORM);
+	lua_newtable(L);
+	lua_pushinteger(L, lw->w->count);
+	lua_setfield(L, -2, "count");
+	lua_pushinteger(L, lw->w->underrun);
+	lua_setfield(L, -2, "underrun");
+	lua_pushinteger(L, lw->w->missed);
+	lua_setfield(L, -2, "missed");
+	return 1;
+}
+
+static const luaL_Reg m_waveform[] = {
+	{"__gc",		m_waveform_gc},
+	{"start",		m_waveform_start},
+	{"dds",			m_waveform_dds},
+	{"stop",		m_waveform_stop},
+	{"write",		m_waveform_write},
+	{"flush",		m_waveform_flush},
+	{"space",		m_waveform_space},
+	{"frequency",	m_waveform_frequency},
+	{"phase",		m_waveform_phase},
+	{"stats",		m_waveform_stats},
+	{NULL,	NULL}
+};
+
+int luaopen_hardware_waveform(lua_State * L)
+{
+	luaL_newlib(L, l_waveform);
+	luahelper_create_metatable(L, MT_HARDWARE_WAVEFORM, m_waveform);
+	return 1;
+}
@@ -0,0 +1,130 @@
+/*
+ * framework/random/l-random.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <rng/random.h>
+#include <framework/buffer/l-buffer.h>
+#include <framework/random/l-random.h>
+
+/*
+ * Random.bytes(n), a string of n random bytes
+ */
+static int l_random_bytes(lua_State * L)
+{
+	lua_Integer n = luaL_checkinteger(L, 1);
+	luaL_Buffer b;
+	char * p;
+
+	luaL_argcheck(L, n >= 0, 1, "negative length");
+	p = luaL_buffinitsize(L, &b, n);
+	getrandom(p, n, 0);
+	luaL_pushresultsize(&b, n);
+	return 1;
+}
+
+/*
+ * Random.fill(buffer [, offset [, length]]), fills a buffer or a slice of
+ * it in place without creating strings
+ */
+static int l_random_fill(lua_State * L)
+{
+	size_t len;
+	void * p = lbuffer_checkrange(L, 1, &len);
+
+	getrandom(p, len, 0);
+	lua_pushinteger(L, len);
+	return 1;
+}
+
+/*
+ * Random.integer([m,] n), uniform in [m, n], m defaults to one
+ */
+static int l_random_integer(lua_State * L)
+{
+	lua_Integer lo, hi;
+	u64_t range, v, limit;
+
+	if(lua_isnoneornil(L, 2))
+	{
+		lo = 1;
+		hi = luaL_checkinteger(L, 1);
+	}
+	else
+	{
+		lo = luaL_checkinteger(L, 1);
+		hi = luaL_checkinteger(L, 2);
+	}
+	luaL_argcheck(L, lo <= hi, 2, "interval is empty");
+	range = (u64_t)hi - (u64_t)lo + 1;
+	if(range == 0)
+	{
+		getrandom(&v, sizeof(v), 0);
+	}
+	else
+	{
+		limit = ~(u64_t)0 - (~(u64_t)0 % range);
+		do {
+			getrandom(&v, sizeof(v), 0);
+		} while(v >= limit);
+		v %= range;
+	}
+	lua_pushinteger(L, (lua_Integer)((u64_t)lo + v));
+	return 1;
+}
+
+/*
+ * Random.number(), uniform in [0, 1)
+ */
+static int l_random_number(lua_State * L)
+{
+	u64_t v;
+
+	getrandom(&v, sizeof(v), 0);
+	lua_pushnumber(L, (lua_Number)(v >> 11) * (1.0 / 9007199254740992.0));
+	return 1;
+}
+
+static int l_random_seeded(lua_State * L)
+{
+	lua_pushboolean(L, random_seeded());
+	return 1;
+}
+
+static const luaL_Reg l_random[] = {
+	{"bytes",	l_random_bytes},
+	{"fill",	l_random_fill},
+	{"integer",	l_random_integer},
+	{"number",	l_random_number},
+	{"seeded",	l_random_seeded},
+	{NULL,	NULL}
+};
+
+int luaopen_random(lua_State * L)
+{
+	luaL_newlib(L, l_random);
+	return 1;
+}
@@ -26,6 +26,7 @@
  *
  */
 
+#include <xboot/idle.h>
 #include <xfs/xfs.h>
 #include <shell/readline.h>
 #include <framework/luahelper.h>
@@ -34,7 +35,10 @@
 #include <framework/event/l-event.h>
 #include <framework/event/l-event-dispatcher.h>
 #include <framework/stopwatch/l-stopwatch.h>
+#include <framework/aes/l-aes.h>
 #include <framework/base64/l-base64.h>
+#include <framework/buffer/l-buffer.h>
+#include <framework/random/l-random.h>
 #include <framework/display/l-display.h>
 #include <framework/hardware/l-hardware.h>
 #include <framework/vm.h>
@@ -64,6 +68,9 @@ static void luaopen_prelibs(lua_State * L)
 	const luaL_Reg prelibs[] = {
 		{ "builtin.json",			luaopen_cjson_safe },
 		{ "builtin.base64",			luaopen_base64 },
+		{ "builtin.buffer",			luaopen_buffer },
+		{ "builtin.random",			luaopen_random },
+		{ "builtin.aes",			luaopen_aes },
 
 		{ "builtin.stopwatch",		luaopen_stopwatch },
 		{ "builtin.matrix",			luaopen_matrix },
@@ -92,9 +99,11 @@ static void luaopen_prelibs(lua_State * L)
 		{ "hardware.light",			luaopen_hardware_light },
 		{ "hardware.motor",			luaopen_hardware_motor },
 		{ "hardware.nvmem",			luaopen_hardware_nvmem },
+		{ "hardware.planner",		luaopen_hardware_planner },
 		{ "hardware.pressure",		luaopen_hardware_pressure },
 		{ "hardware.proximity",		luaopen_hardware_proximity },
 		{ "hardware.pwm",			luaopen_hardware_pwm },
+		{ "hardware.sampler",		luaopen_hardware_sampler },
 		{ "hardware.servo",			luaopen_hardware_servo },
 		{ "hardware.spi",			luaopen_hardware_spi },
 		{ "hardware.stepper",		luaopen_hardware_stepper },
@@ -102,6 +111,7 @@ static void luaopen_prelibs(lua_State * L)
 		{ "hardware.uart",			luaopen_hardware_uart },
 		{ "hardware.vibrator",		luaopen_hardware_vibrator },
 		{ "hardware.watchdog",		luaopen_hardware_watchdog },
+		{ "hardware.waveform",		luaopen_hardware_waveform },
 
 		{ NULL, NULL },
 	};
@@ -291,11 +301,23 @@ static int l_panic(lua_State *L)
 	return 0;
 }
 
+/*
+ * A script that computes without pumping events still gives the idle hooks
+ * a turn, the debugger replaces this hook while it steps.
+ */
+static void l_idle_hook(lua_State * L, lua_Debug * ar)
+{
+	idle_poll();
+}
+
 static lua_State * l_newstate(void * ud)
 {
 	lua_State * L = lua_newstate(l_alloc, ud);
 	if(L)
+	{
 		lua_atpanic(L, &l_panic);
+		lua_sethook(L, l_idle_hook, LUA_MASKCOUNT, 4096);
+	}
 	return L;
 }
 
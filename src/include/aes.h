@@ -0,0 +1,76 @@
+#ifndef __AES_H__
+#define __AES_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <types.h>
+#include <stdint.h>
+#include <string.h>
+
+#define AES_BLOCK_SIZE		(16)
+#define AES_MAX_ROUNDS		(14)
+
+/*
+ * Round keys are stored in byte order as the hardware backends consume
+ * them, the decryption schedule is the one of the equivalent inverse
+ * cipher, already passed through inverse mix columns.
+ */
+struct aes_ctx_t {
+	uint32_t ek[4 * (AES_MAX_ROUNDS + 1)];
+	uint32_t dk[4 * (AES_MAX_ROUNDS + 1)];
+	int rounds;
+};
+
+struct aes_ctr_t {
+	struct aes_ctx_t aes;
+	uint8_t ctr[AES_BLOCK_SIZE];
+	uint8_t ks[AES_BLOCK_SIZE];
+	int pos;
+};
+
+struct aes_cbc_t {
+	struct aes_ctx_t aes;
+	uint8_t iv[AES_BLOCK_SIZE];
+};
+
+struct aes_gcm_t {
+	struct aes_ctx_t aes;
+	uint64_t hh[16];
+	uint64_t hl[16];
+	uint8_t h[AES_BLOCK_SIZE];
+	uint8_t j0[AES_BLOCK_SIZE];
+	uint8_t ctr[AES_BLOCK_SIZE];
+	uint8_t ks[AES_BLOCK_SIZE];
+	uint8_t y[AES_BLOCK_SIZE];
+	uint64_t alen;
+	uint64_t clen;
+	int pos;
+	int data;
+};
+
+int aes_set_key(struct aes_ctx_t * ctx, const uint8_t * key, int len);
+void aes_encrypt(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int blks);
+void aes_decrypt(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int blks);
+const char * aes_impl(void);
+
+int aes_ctr_init(struct aes_ctr_t * c, const uint8_t * key, int len, const uint8_t * iv);
+void aes_ctr_update(struct aes_ctr_t * c, const uint8_t * in, uint8_t * out, int len);
+
+int aes_cbc_init(struct aes_cbc_t * c, const uint8_t * key, int len, const uint8_t * iv);
+void aes_cbc_encrypt(struct aes_cbc_t * c, const uint8_t * in, uint8_t * out, int blks);
+void aes_cbc_decrypt(struct aes_cbc_t * c, const uint8_t * in, uint8_t * out, int blks);
+
+int aes_gcm_init(struct aes_gcm_t * g, const uint8_t * key, int len, const uint8_t * iv, int ivlen);
+void aes_gcm_aad(struct aes_gcm_t * g, const uint8_t * aad, int len);
+void aes_gcm_encrypt(struct aes_gcm_t * g, const uint8_t * in, uint8_t * out, int len);
+void aes_gcm_decrypt(struct aes_gcm_t * g, const uint8_t * in, uint8_t * out, int len);
+void aes_gcm_tag(struct aes_gcm_t * g, uint8_t * tag);
+int aes_gcm_verify(struct aes_gcm_t * g, const uint8_t * tag, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AES_H__ */
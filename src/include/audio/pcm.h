@@ -0,0 +1,100 @@
+#ifndef __PCM_H__
+#define __PCM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <audio/sound.h>
+
+/*
+ * Gains are Q15 fixed point, PCM_GAIN_UNITY is the pass through gain.
+ */
+#define PCM_GAIN_UNITY		(32768)
+
+static inline int pcm_sample_bytes(enum pcm_format_t fmt)
+{
+	switch(fmt)
+	{
+	case PCM_FORMAT_BIT8:
+		return 1;
+	case PCM_FORMAT_BIT16:
+		return 2;
+	case PCM_FORMAT_BIT24:
+		return 3;
+	case PCM_FORMAT_BIT32:
+		return 4;
+	default:
+		break;
+	}
+	return 2;
+}
+
+/*
+ * Read one little endian sample, left aligned to 32 bits.
+ */
+static inline s32_t pcm_get_sample(const u8_t * p, enum pcm_format_t fmt)
+{
+	switch(fmt)
+	{
+	case PCM_FORMAT_BIT8:
+		return (s32_t)((u32_t)p[0] << 24);
+	case PCM_FORMAT_BIT16:
+		return (s32_t)(((u32_t)p[0] << 16) | ((u32_t)p[1] << 24));
+	case PCM_FORMAT_BIT24:
+		return (s32_t)(((u32_t)p[0] << 8) | ((u32_t)p[1] << 16) | ((u32_t)p[2] << 24));
+	case PCM_FORMAT_BIT32:
+		return (s32_t)(((u32_t)p[0] << 0) | ((u32_t)p[1] << 8) | ((u32_t)p[2] << 16) | ((u32_t)p[3] << 24));
+	default:
+		break;
+	}
+	return 0;
+}
+
+/*
+ * Write one left aligned sample as little endian.
+ */
+static inline void pcm_put_sample(u8_t * p, enum pcm_format_t fmt, s32_t v)
+{
+	switch(fmt)
+	{
+	case PCM_FORMAT_BIT8:
+		p[0] = (u32_t)v >> 24;
+		break;
+	case PCM_FORMAT_BIT16:
+		p[0] = (u32_t)v >> 16;
+		p[1] = (u32_t)v >> 24;
+		break;
+	case PCM_FORMAT_BIT24:
+		p[0] = (u32_t)v >> 8;
+		p[1] = (u32_t)v >> 16;
+		p[2] = (u32_t)v >> 24;
+		break;
+	case PCM_FORMAT_BIT32:
+		p[0] = (u32_t)v >> 0;
+		p[1] = (u32_t)v >> 8;
+		p[2] = (u32_t)v >> 16;
+		p[3] = (u32_t)v >> 24;
+		break;
+	default:
+		break;
+	}
+}
+
+static inline s16_t pcm_sat16(s32_t v)
+{
+	if(v > 32767)
+		return 32767;
+	if(v < -32768)
+		return -32768;
+	return (s16_t)v;
+}
+
+void pcm_scale(void * buf, int len, enum pcm_format_t fmt, int gain);
+void pcm_mix_s16(s16_t * dst, const s16_t * src, int n, int ch, int gl, int gr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PCM_H__ */
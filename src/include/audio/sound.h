@@ -44,6 +44,8 @@ struct sound_info_t {
 	int length;
 };
 
+struct sound_stream_t;
+
 struct sound_t
 {
 	/* Sound information */
@@ -55,6 +57,12 @@ struct sound_t
 	/* Sound volume */
 	int volume;
 
+	/* Sound volume as Q15 gain */
+	int gain;
+
+	/* Sound pan, -100 is full left and 100 is full right */
+	int pan;
+
 	/* Sound position */
 	int position;
 
@@ -67,6 +75,9 @@ struct sound_t
 	/* Sound close */
 	void (*close)(struct sound_t * snd);
 
+	/* Decoded and converted output stage */
+	struct sound_stream_t * stream;
+
 	/* Private data */
 	void * priv;
 };
@@ -77,6 +88,8 @@ struct sound_info_t * sound_get_info(struct sound_t * snd);
 enum sound_status_t sound_get_status(struct sound_t * snd);
 void sound_set_volume(struct sound_t * snd, int percent);
 int sound_get_volume(struct sound_t * snd);
+void sound_set_pan(struct sound_t * snd, int pan);
+int sound_get_pan(struct sound_t * snd);
 void sound_set_position(struct sound_t * snd, int position);
 int sound_get_position(struct sound_t * snd);
 void sound_play(struct sound_t * snd);
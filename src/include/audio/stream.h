@@ -0,0 +1,63 @@
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <fifo.h>
+#include <audio/sound.h>
+
+#define SOUND_STREAM_MAX_CHANNELS	(8)
+
+/*
+ * Decoded audio is staged in a ring buffer ahead of the playback callback.
+ * The refill side pulls large blocks from the decoder, converts them to the
+ * output rate, format and channel count and queues them, the callback side
+ * only copies out of the ring.
+ */
+struct sound_stream_t
+{
+	/* Source sound */
+	struct sound_t * snd;
+
+	/* Converted output ring buffer */
+	struct fifo_t * fifo;
+
+	/* Output format */
+	enum pcm_rate_t rate;
+	enum pcm_format_t fmt;
+	int channel;
+
+	/* Decode and convert staging blocks */
+	u8_t * src;
+	u8_t * dst;
+	int passthrough;
+
+	/* Resampler step and phase, source frames per output frame in Q16 */
+	u32_t step;
+	u32_t phase;
+
+	/* Resampler history, the two source frames around the phase */
+	s32_t prev[SOUND_STREAM_MAX_CHANNELS];
+	s32_t next[SOUND_STREAM_MAX_CHANNELS];
+	int primed;
+
+	/* Decoder reached the end of the sound */
+	int eof;
+};
+
+struct sound_stream_t * sound_stream_alloc(struct sound_t * snd);
+void sound_stream_free(struct sound_stream_t * s);
+bool_t sound_stream_config(struct sound_stream_t * s, enum pcm_rate_t rate, enum pcm_format_t fmt, int ch);
+void sound_stream_reset(struct sound_stream_t * s);
+int sound_stream_refill(struct sound_stream_t * s);
+int sound_stream_read(struct sound_stream_t * s, void * buf, int count);
+int sound_stream_fill(struct sound_stream_t * s);
+bool_t sound_stream_finished(struct sound_stream_t * s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STREAM_H__ */
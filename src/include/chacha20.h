@@ -0,0 +1,31 @@
+#ifndef __CHACHA20_H__
+#define __CHACHA20_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <types.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CHACHA20_KEY_SIZE	(32)
+#define CHACHA20_NONCE_SIZE	(12)
+#define CHACHA20_BLOCK_SIZE	(64)
+
+struct chacha20_ctx_t {
+	uint32_t state[16];
+	uint8_t buf[CHACHA20_BLOCK_SIZE];
+	int pos;
+};
+
+void chacha20_init(struct chacha20_ctx_t * ctx, const uint8_t * key, const uint8_t * nonce, uint32_t counter);
+void chacha20_block(uint32_t * state, uint8_t * out);
+void chacha20_keystream(struct chacha20_ctx_t * ctx, void * out, int len);
+void chacha20_xor(struct chacha20_ctx_t * ctx, void * out, const void * in, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CHACHA20_H__ */
@@ -7,6 +7,22 @@ extern "C" {
 
 #include <xboot.h>
 
+enum {
+	NOTIFIER_CLK_RATE_CHANGE,
+};
+
+struct clk_notifier_data_t {
+	struct clk_t * clk;
+	u64_t orate;
+	u64_t nrate;
+};
+
+/*
+ * The parent, rate and notifier fields are owned by the framework and set
+ * up by register_clk. Rates are cached per node and dropped for the whole
+ * subtree when a rate or parent changes, a struct clk_t returned by
+ * search_clk can be held as a handle until the clock is unregistered.
+ */
 struct clk_t
 {
 	char * name;
@@ -19,6 +35,13 @@ struct clk_t
 	void (*set_rate)(struct clk_t * clk, u64_t prate, u64_t rate);
 	u64_t (*get_rate)(struct clk_t * clk, u64_t prate);
 
+	struct clk_t * parent;
+	bool_t pvalid;
+	bool_t rvalid;
+	u64_t rate;
+	u64_t orate;
+	struct notifier_chain_t nc;
+
 	void * priv;
 };
 
@@ -34,6 +57,17 @@ bool_t clk_status(const char * name);
 void clk_set_rate(const char * name, u64_t rate);
 u64_t clk_get_rate(const char * name);
 
+struct clk_t * clk_handle_get_parent(struct clk_t * clk);
+void clk_handle_set_parent(struct clk_t * clk, struct clk_t * pclk);
+void clk_handle_enable(struct clk_t * clk);
+void clk_handle_disable(struct clk_t * clk);
+bool_t clk_handle_status(struct clk_t * clk);
+void clk_handle_set_rate(struct clk_t * clk, u64_t rate);
+u64_t clk_handle_get_rate(struct clk_t * clk);
+void clk_handle_recalc_rate(struct clk_t * clk);
+bool_t clk_handle_register_notifier(struct clk_t * clk, struct notifier_t * n);
+bool_t clk_handle_unregister_notifier(struct clk_t * clk, struct notifier_t * n);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,76 @@
+#ifndef __CPUFREQ_H__
+#define __CPUFREQ_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+
+struct cpufreq_opp_t {
+	u64_t frequency;
+	int voltage;
+};
+
+/*
+ * Load based governor. Busy and idle time come from the idle hooks of the
+ * polling loops, a timer turns them into a load figure every interval and
+ * picks a target operating point, which is then applied from the next idle
+ * hook in thread context so that slow regulators may sleep. Load at or
+ * above the up threshold jumps to the top point, load under the down
+ * threshold steps down to the slowest point that keeps the load under the
+ * up threshold. Boost requests, e.g. on missed frame deadlines, pin the
+ * top point for a while.
+ */
+struct cpufreq_t
+{
+	char * name;
+
+	/* Operating points sorted by ascending frequency, cur is the running one */
+	struct cpufreq_opp_t * opp;
+	int nopp;
+	int cur;
+
+	/* Switch between two points, returns FALSE if hardware refused */
+	bool_t (*transition)(struct cpufreq_t * f, int from, int to);
+
+	/* Governor, set up by register_cpufreq */
+	struct timer_t timer;
+	ktime_t interval;
+	spinlock_t lock;
+	int up;
+	int down;
+	int target;
+	int load;
+	int simulate;
+	ktime_t boost;
+
+	/* Idle accounting within the current window */
+	int idle;
+	ktime_t idle_stamp;
+	ktime_t window_stamp;
+	s64_t idle_ns;
+
+	/* Time spent at each point in nanoseconds */
+	u64_t * residency;
+	ktime_t residency_stamp;
+	u32_t transitions;
+
+	void * priv;
+};
+
+struct cpufreq_t * search_cpufreq(const char * name);
+struct cpufreq_t * search_first_cpufreq(void);
+bool_t register_cpufreq(struct device_t ** device, struct cpufreq_t * f, int ms, int up, int down);
+bool_t unregister_cpufreq(struct cpufreq_t * f);
+
+void cpufreq_idle_enter(void);
+void cpufreq_idle_exit(void);
+void cpufreq_boost(int ms);
+void cpufreq_frame_hint(s64_t frame_ns, s64_t deadline_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CPUFREQ_H__ */
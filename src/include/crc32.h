@@ -10,6 +10,8 @@ extern "C" {
 #include <string.h>
 
 uint32_t crc32_sum(uint32_t crc, const uint8_t * buf, int len);
+uint32_t crc32_sum_generic(uint32_t crc, const uint8_t * buf, int len);
+const char * crc32_impl(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,79 @@
+#ifndef __DAC_WAVEFORM_H__
+#define __DAC_WAVEFORM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+#include <dac/dac.h>
+
+enum dac_waveform_mode_t {
+	DAC_WAVEFORM_STREAM	= 0,
+	DAC_WAVEFORM_DDS	= 1,
+};
+
+/*
+ * Fixed rate output of one dac channel from the timer base, samples are
+ * raw dac codes. Stream mode plays two blocks in turn, the idle block is
+ * refilled by dac_waveform_write or, when set, by the refill callback
+ * from the timer right after it has been played. A tick without a ready
+ * block holds the last level and counts an underrun once per gap.
+ *
+ * DDS mode walks a power of two table with a 32 bits phase accumulator,
+ * frequency and phase may change while running.
+ */
+struct dac_waveform_t {
+	struct dac_t * dac;
+	int channel;
+	u32_t max;
+
+	struct timer_t timer;
+	ktime_t interval;
+	spinlock_t lock;
+	enum dac_waveform_mode_t mode;
+	int rate;
+	int running;
+	u32_t level;
+
+	/* Stream blocks */
+	u32_t * block[2];
+	int len[2];
+	int ready[2];
+	int size;
+	int cur;
+	int pos;
+	int fill;
+	int fillpos;
+	int starved;
+	void (*refill)(struct dac_waveform_t * w, u32_t * buf, int len);
+	void * data;
+
+	/* Direct digital synthesis */
+	const u32_t * table;
+	int shift;
+	u32_t acc;
+	u32_t tuning;
+
+	/* Statistics */
+	u32_t count;
+	u32_t underrun;
+	u32_t missed;
+};
+
+struct dac_waveform_t * dac_waveform_alloc(struct dac_t * dac, int channel);
+void dac_waveform_free(struct dac_waveform_t * w);
+bool_t dac_waveform_start(struct dac_waveform_t * w, int rate, int size);
+bool_t dac_waveform_start_dds(struct dac_waveform_t * w, int rate, const u32_t * table, int len, u32_t mhz, u32_t phase);
+void dac_waveform_stop(struct dac_waveform_t * w);
+int dac_waveform_write(struct dac_waveform_t * w, const u32_t * samples, int n);
+void dac_waveform_flush(struct dac_waveform_t * w);
+int dac_waveform_space(struct dac_waveform_t * w);
+void dac_waveform_set_frequency(struct dac_waveform_t * w, u32_t mhz);
+void dac_waveform_set_phase(struct dac_waveform_t * w, u32_t phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DAC_WAVEFORM_H__ */
@@ -0,0 +1,46 @@
+#ifndef __FASTMATH_H__
+#define __FASTMATH_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <types.h>
+#include <stdint.h>
+
+/*
+ * Bounded error float approximations for graphics and motion code, for
+ * callers that opt in instead of the full precision libm functions. Worst
+ * errors against the double libm, as reported by 'bench fastmath':
+ *
+ *   fast_sinf, fast_cosf   1e-7 absolute for |x| <= 8192, the range
+ *                          reduction then degrades to 1e-6 at 65536,
+ *                          beyond which they call sinf and cosf
+ *   fast_atan2f            3e-7 radians
+ *   fast_expf              1e-7 relative, 0 below -87 and inf above 88.72
+ *   fast_sqrtf             correctly rounded where there is a sqrt instruction
+ *
+ * Infinities and nans are not special cased, they give nan or inf. The
+ * array variants compute n results from x into y, which may alias, four at
+ * a time in sse2 or neon registers on x64 and arm64. They match the scalar
+ * functions within the bounds above, not necessarily bit for bit.
+ */
+float fast_sinf(float x);
+float fast_cosf(float x);
+float fast_atan2f(float y, float x);
+float fast_expf(float x);
+float fast_sqrtf(float x);
+
+void fast_sinfv(float * y, const float * x, int n);
+void fast_cosfv(float * y, const float * x, int n);
+void fast_atan2fv(float * r, const float * y, const float * x, int n);
+void fast_expfv(float * y, const float * x, int n);
+void fast_sqrtfv(float * y, const float * x, int n);
+
+const char * fastmath_impl(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FASTMATH_H__ */
@@ -0,0 +1,20 @@
+#ifndef __FRAMEWORK_L_AES_H__
+#define __FRAMEWORK_L_AES_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <framework/luahelper.h>
+
+#define	MT_AES_CTR	"mt_aes_ctr"
+#define	MT_AES_CBC	"mt_aes_cbc"
+#define	MT_AES_GCM	"mt_aes_gcm"
+
+int luaopen_aes(lua_State * L);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAMEWORK_L_AES_H__ */
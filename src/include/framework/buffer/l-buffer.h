@@ -0,0 +1,33 @@
+#ifndef __FRAMEWORK_L_BUFFER_H__
+#define __FRAMEWORK_L_BUFFER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <framework/luahelper.h>
+
+#define	MT_BUFFER	"mt_buffer"
+
+/*
+ * Fixed capacity byte buffer. A root buffer owns its storage, which is
+ * allocated inline behind the header, a slice points into its parent and
+ * keeps the parent alive through the user value.
+ */
+struct lbuffer_t {
+	unsigned char * data;
+	size_t size;
+};
+
+struct lbuffer_t * lbuffer_new(lua_State * L, size_t size);
+struct lbuffer_t * lbuffer_check(lua_State * L, int idx);
+struct lbuffer_t * lbuffer_test(lua_State * L, int idx);
+const void * lbuffer_checkbytes(lua_State * L, int idx, size_t * len);
+void * lbuffer_checkrange(lua_State * L, int idx, size_t * len);
+int luaopen_buffer(lua_State * L);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAMEWORK_L_BUFFER_H__ */
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <framework/luahelper.h>
+#include <framework/buffer/l-buffer.h>
 
 #define	MT_HARDWARE_ADC			"mt_hardware_adc"
 #define	MT_HARDWARE_BATTERY		"mt_hardware_battery"
@@ -23,9 +24,11 @@ extern "C" {
 #define	MT_HARDWARE_LIGHT		"mt_hardware_light"
 #define	MT_HARDWARE_MOTOR		"mt_hardware_motor"
 #define	MT_HARDWARE_NVMEM		"mt_hardware_nvmem"
+#define	MT_HARDWARE_PLANNER		"mt_hardware_planner"
 #define	MT_HARDWARE_PRESSURE	"mt_hardware_pressure"
 #define	MT_HARDWARE_PROXIMITY	"mt_hardware_proximity"
 #define	MT_HARDWARE_PWM			"mt_hardware_pwm"
+#define	MT_HARDWARE_SAMPLER		"mt_hardware_sampler"
 #define	MT_HARDWARE_SERVO		"mt_hardware_servo"
 #define	MT_HARDWARE_SPI			"mt_hardware_spi"
 #define	MT_HARDWARE_STEPPER		"mt_hardware_stepper"
@@ -33,6 +36,7 @@ extern "C" {
 #define	MT_HARDWARE_UART		"mt_hardware_uart"
 #define	MT_HARDWARE_VIBRATOR	"mt_hardware_vibrator"
 #define	MT_HARDWARE_WATCHDOG	"mt_hardware_watchdog"
+#define	MT_HARDWARE_WAVEFORM	"mt_hardware_waveform"
 
 int luaopen_hardware_adc(lua_State * L);
 int luaopen_hardware_battery(lua_State * L);
@@ -50,9 +54,11 @@ int luaopen_hardware_ledtrigger(lua_State * L);
 int luaopen_hardware_light(lua_State * L);
 int luaopen_hardware_motor(lua_State * L);
 int luaopen_hardware_nvmem(lua_State * L);
+int luaopen_hardware_planner(lua_State * L);
 int luaopen_hardware_pressure(lua_State * L);
 int luaopen_hardware_proximity(lua_State * L);
 int luaopen_hardware_pwm(lua_State * L);
+int luaopen_hardware_sampler(lua_State * L);
 int luaopen_hardware_servo(lua_State * L);
 int luaopen_hardware_spi(lua_State * L);
 int luaopen_hardware_stepper(lua_State * L);
@@ -60,6 +66,7 @@ int luaopen_hardware_thermometer(lua_State * L);
 int luaopen_hardware_uart(lua_State * L);
 int luaopen_hardware_vibrator(lua_State * L);
 int luaopen_hardware_watchdog(lua_State * L);
+int luaopen_hardware_waveform(lua_State * L);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,16 @@
+#ifndef __FRAMEWORK_L_RANDOM_H__
+#define __FRAMEWORK_L_RANDOM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <framework/luahelper.h>
+
+int luaopen_random(lua_State * L);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAMEWORK_L_RANDOM_H__ */
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <xboot.h>
+#include <interrupt/interrupt.h>
 
 enum gpio_pull_t {
 	GPIO_PULL_UP			= 0,
@@ -50,9 +51,28 @@ struct gpiochip_t
 	int  (*get_value)(struct gpiochip_t * chip, int offset);
 	int  (*to_irq)(struct gpiochip_t * chip, int offset);
 
+	/*
+	 * Optional port access, bit n of mask and value stands for offset n.
+	 * Chips that can update or sample all of their pins with a single
+	 * register access provide these, NULL falls back to per pin calls.
+	 */
+	void (*set_port)(struct gpiochip_t * chip, u32_t mask, u32_t value);
+	u32_t (*get_port)(struct gpiochip_t * chip);
+
 	void * priv;
 };
 
+/*
+ * A gpio descriptor caches the chip and offset of a gpio number, so that
+ * hot paths such as bit banged buses skip the chip lookup on every access.
+ * The chip must outlive the descriptor.
+ */
+struct gpio_desc_t {
+	struct gpiochip_t * chip;
+	int offset;
+	int gpio;
+};
+
 struct gpiochip_t * search_gpiochip(int gpio);
 bool_t register_gpiochip(struct device_t ** device, struct gpiochip_t * chip);
 bool_t unregister_gpiochip(struct gpiochip_t * chip);
@@ -73,6 +93,45 @@ int gpio_get_value(int gpio);
 void gpio_direction_output(int gpio, int value);
 int gpio_direction_input(int gpio);
 int gpio_to_irq(int gpio);
+bool_t gpio_event_enable(int gpio, enum irq_type_t type);
+void gpio_event_disable(int gpio);
+
+bool_t gpio_desc_init(struct gpio_desc_t * desc, int gpio);
+void gpio_desc_set_cfg(struct gpio_desc_t * desc, int cfg);
+void gpio_desc_set_pull(struct gpio_desc_t * desc, enum gpio_pull_t pull);
+void gpio_desc_set_direction(struct gpio_desc_t * desc, enum gpio_direction_t dir);
+void gpio_desc_direction_output(struct gpio_desc_t * desc, int value);
+int gpio_desc_direction_input(struct gpio_desc_t * desc);
+
+void gpiochip_set_port(struct gpiochip_t * chip, u32_t mask, u32_t value);
+u32_t gpiochip_get_port(struct gpiochip_t * chip, u32_t mask);
+
+static inline void gpio_desc_set_value(struct gpio_desc_t * desc, int value)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(chip && chip->set_value)
+		chip->set_value(chip, desc->offset, value);
+}
+
+static inline int gpio_desc_get_value(struct gpio_desc_t * desc)
+{
+	struct gpiochip_t * chip = desc->chip;
+
+	if(chip && chip->get_value)
+		return chip->get_value(chip, desc->offset);
+	return 0;
+}
+
+/*
+ * Port bit of a descriptor, zero if it can not take part in port access.
+ */
+static inline u32_t gpio_desc_mask(struct gpio_desc_t * desc)
+{
+	if(desc->chip && (desc->offset < 32))
+		return 1 << desc->offset;
+	return 0;
+}
 
 #ifdef __cplusplus
 }
@@ -21,9 +21,32 @@ struct i2c_algo_bit_data_t {
 	 */
 	int udelay;
 	void * priv;
+
+	/*
+	 * Asynchronous engine, a timer runs the transfer one clock phase per
+	 * tick instead of spinning in udelay for the whole transfer.
+	 */
+	struct timer_t timer;
+	struct i2c_msg_t * msgs;
+	int num;
+	int busy;
+	void (*complete)(void * data, int ret);
+	void * data;
+	ktime_t interval;
+	ktime_t timeout;
+	int state;
+	int phase;
+	int bit;
+	int count;
+	int index;
+	int ack;
+	u8_t shift;
+	int ret;
 };
 
+void i2c_algo_bit_init(struct i2c_algo_bit_data_t * bdat);
 int i2c_algo_bit_xfer(struct i2c_algo_bit_data_t * bdat, struct i2c_msg_t * msgs, int num);
+int i2c_algo_bit_xfer_async(struct i2c_algo_bit_data_t * bdat, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data);
 
 #ifdef __cplusplus
 }
@@ -33,6 +33,9 @@ struct i2c_t
 	/* Master xfer */
 	int (*xfer)(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num);
 
+	/* Master xfer without waiting, complete gets the xfer result, may be null */
+	int (*xfer_async)(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data);
+
 	/* Private data */
 	void * priv;
 };
@@ -43,6 +46,12 @@ struct i2c_device_t {
 	int flags;
 };
 
+struct i2c_reg_read_t {
+	u8_t reg;
+	void * buf;
+	int len;
+};
+
 struct i2c_t * search_i2c(const char * name);
 bool_t register_i2c(struct device_t ** device, struct i2c_t * i2c);
 bool_t unregister_i2c(struct i2c_t * i2c);
@@ -52,6 +61,8 @@ void i2c_device_free(struct i2c_device_t * client);
 int i2c_transfer(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num);
 int i2c_master_send(const struct i2c_device_t * dev, void * buf, int count);
 int i2c_master_recv(const struct i2c_device_t * dev, void * buf, int count);
+int i2c_transfer_async(struct i2c_t * i2c, struct i2c_msg_t * msgs, int num, void (*complete)(void * data, int ret), void * data);
+int i2c_device_read_regs(const struct i2c_device_t * dev, struct i2c_reg_read_t * regs, int num);
 
 #ifdef __cplusplus
 }
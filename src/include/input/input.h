@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <xboot.h>
+#include <tsfilter.h>
 
 enum input_type_t {
 	INPUT_TYPE_KEYBOARD		= 1,
@@ -38,6 +39,7 @@ struct input_t * search_input(const char * name);
 bool_t register_input(struct device_t ** device, struct input_t * input);
 bool_t unregister_input(struct input_t * input);
 int input_ioctl(struct input_t * input, int cmd, void * arg);
+struct tsfilter_t * input_tsfilter_alloc(struct dtnode_t * n, int interval);
 
 #ifdef __cplusplus
 }
@@ -45,6 +45,9 @@ bool_t request_irq(int irq, void (*func)(void *), enum irq_type_t type, void * d
 bool_t free_irq(int irq);
 void enable_irq(int irq);
 void disable_irq(int irq);
+void interrupt_enter(void);
+void interrupt_exit(void);
+bool_t in_interrupt(void);
 void interrupt_handle_exception(void * regs);
 
 #ifdef __cplusplus
@@ -29,6 +29,7 @@ int ledstrip_get_count(struct ledstrip_t * strip);
 void ledstrip_set_color(struct ledstrip_t * strip, int i, uint32_t color);
 uint32_t ledstrip_get_color(struct ledstrip_t * strip, int i);
 void ledstrip_refresh(struct ledstrip_t * strip);
+void ledstrip_gamma_lut(u8_t * lut, double gamma, int level);
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,7 @@ void kvdb_set(struct kvdb_t * db, const char * key, const char * value);
 char * kvdb_get(struct kvdb_t * db, const char * key, const char * def);
 void kvdb_from_string(struct kvdb_t * db, char * str);
 char * kvdb_to_string(struct kvdb_t * db);
+bool_t kvdb_foreach(struct kvdb_t * db, bool_t (*fn)(const char * key, const char * value, void * data), void * data);
 int kvdb_summary(struct kvdb_t * db, void * buf);
 
 #ifdef __cplusplus
@@ -8,6 +8,18 @@ extern "C" {
 #include <xboot.h>
 #include <nvmem/kvdb.h>
 
+/*
+ * The kvdb is kept as an append only record log. The capacity is split in
+ * two halves, each starting with a header that carries a generation, the
+ * live half is the valid one with the newest generation. A sync appends
+ * the changes since the last sync as one batch of records behind the log,
+ * every record has its own crc seeded by the generation and the last one
+ * of a batch is flagged as commit, so a torn write or a half written batch
+ * is simply dropped at the next mount. When the log is full the database
+ * is compacted into the other half, whose header is written last. A set
+ * is refused once the compacted database would not fit in a half, and a
+ * legacy image too large for one keeps the legacy format.
+ */
 struct nvmem_t
 {
 	char * name;
@@ -15,6 +27,23 @@ struct nvmem_t
 	int (*capacity)(struct nvmem_t * m);
 	int (*read)(struct nvmem_t * m, void * buf, int offset, int count);
 	int (*write)(struct nvmem_t * m, void * buf, int offset, int count);
+
+	/* Record log, set up by register_nvmem */
+	int half;
+	int hsize;
+	u32_t gen;
+	int tail;
+	u8_t * pending;
+	int plen;
+	int psize;
+	bool_t compact;
+	bool_t legacy;
+
+	/* Statistics */
+	u32_t writes;
+	u32_t wbytes;
+	u32_t compactions;
+
 	void * priv;
 };
 
@@ -26,10 +55,10 @@ bool_t unregister_nvmem(struct nvmem_t * m);
 int nvmem_capacity(struct nvmem_t * m);
 int nvmem_read(struct nvmem_t * m, void * buf, int offset, int count);
 int nvmem_write(struct nvmem_t * m, void * buf, int offset, int count);
-void nvmem_set(struct nvmem_t * m, const char * key, const char * value);
+bool_t nvmem_set(struct nvmem_t * m, const char * key, const char * value);
 char * nvmem_get(struct nvmem_t * m, const char * key, const char * def);
 void nvmem_clear(struct nvmem_t * m);
-void nvmem_sync(struct nvmem_t * m);
+bool_t nvmem_sync(struct nvmem_t * m);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,112 @@
+#ifndef __REGMAP_H__
+#define __REGMAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+#include <rbtree.h>
+#include <i2c/i2c.h>
+#include <spi/spi.h>
+
+#define REGCACHE_BLOCK_SIZE	(16)
+
+enum regcache_type_t {
+	REGCACHE_NONE	= 0,
+	REGCACHE_FLAT	= 1,
+	REGCACHE_RBTREE	= 2,
+};
+
+struct regmap_range_t {
+	unsigned int min;
+	unsigned int max;
+};
+
+struct regmap_reg_t {
+	unsigned int reg;
+	unsigned int val;
+};
+
+/*
+ * Register addresses go first on the wire, most significant byte first,
+ * followed by the values. The flag masks are or'ed into the top address
+ * byte, bulk_flag_mask only for transfers of more than one register, as
+ * some parts only auto increment the address on request. Parts that do not
+ * auto increment at all set use_single_rw.
+ *
+ * Volatile registers always go to the bus and are never cached, status,
+ * data and read only identification registers belong there so that a
+ * cache sync never writes them back.
+ */
+struct regmap_config_t {
+	int reg_bits;
+	int val_bits;
+	bool_t little_endian;
+	unsigned int max_register;
+	unsigned int read_flag_mask;
+	unsigned int write_flag_mask;
+	unsigned int bulk_flag_mask;
+	bool_t use_single_rw;
+
+	enum regcache_type_t cache_type;
+	const struct regmap_range_t * volatile_table;
+	int num_volatile;
+	const struct regmap_reg_t * defaults;
+	int num_defaults;
+};
+
+struct regcache_block_t {
+	struct rb_node node;
+	unsigned int base;
+	u16_t valid;
+	u16_t dirty;
+	unsigned int val[REGCACHE_BLOCK_SIZE];
+};
+
+struct regmap_t {
+	struct regmap_config_t cfg;
+	int reg_bytes;
+	int val_bytes;
+
+	/* Bus access, reg holds the encoded address */
+	bool_t (*read)(struct regmap_t * map, const u8_t * reg, int rlen, void * val, int vlen);
+	bool_t (*write)(struct regmap_t * map, const void * buf, int len);
+	void * bus;
+
+	/* Flat caches index blocks directly, rbtree caches allocate on demand */
+	struct regcache_block_t * flat;
+	struct rb_root tree;
+	bool_t cache_only;
+	bool_t cache_bypass;
+	bool_t cache_dirty;
+
+	/* Bus transactions and cache hits */
+	u32_t reads;
+	u32_t writes;
+	u32_t hits;
+};
+
+struct regmap_t * regmap_alloc_i2c(struct i2c_device_t * dev, const struct regmap_config_t * cfg);
+struct regmap_t * regmap_alloc_spi(struct spi_device_t * dev, const struct regmap_config_t * cfg);
+void regmap_free(struct regmap_t * map);
+
+bool_t regmap_read(struct regmap_t * map, unsigned int reg, unsigned int * val);
+bool_t regmap_write(struct regmap_t * map, unsigned int reg, unsigned int val);
+bool_t regmap_update_bits(struct regmap_t * map, unsigned int reg, unsigned int mask, unsigned int val);
+bool_t regmap_raw_read(struct regmap_t * map, unsigned int reg, void * buf, int len);
+bool_t regmap_bulk_read(struct regmap_t * map, unsigned int reg, unsigned int * val, int count);
+bool_t regmap_bulk_write(struct regmap_t * map, unsigned int reg, const unsigned int * val, int count);
+bool_t regmap_multi_reg_write(struct regmap_t * map, const struct regmap_reg_t * regs, int count);
+
+void regmap_cache_only(struct regmap_t * map, bool_t enable);
+void regmap_cache_bypass(struct regmap_t * map, bool_t enable);
+void regmap_mark_dirty(struct regmap_t * map);
+bool_t regmap_sync(struct regmap_t * map);
+void regmap_drop(struct regmap_t * map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REGMAP_H__ */
@@ -0,0 +1,24 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+
+#define GRND_NONBLOCK	(1 << 0)
+#define GRND_RANDOM		(1 << 1)
+
+void random_add_entropy(const void * buf, int len, int bits);
+void random_add_interrupt(void);
+void random_add_jitter(int samples);
+bool_t random_seeded(void);
+int getrandom(void * buf, size_t len, unsigned int flags);
+u32_t random_u32(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RANDOM_H__ */
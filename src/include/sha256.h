@@ -21,6 +21,8 @@ void sha256_init(struct sha256_ctx_t * ctx);
 void sha256_update(struct sha256_ctx_t * ctx, const void * data, int len);
 const uint8_t * sha256_final(struct sha256_ctx_t * ctx);
 const uint8_t * sha256_hash(const void * data, int len, uint8_t * digest);
+int sha256_verify(struct sha256_ctx_t * ctx, const uint8_t * digest);
+const char * sha256_impl(void);
 
 #ifdef __cplusplus
 }
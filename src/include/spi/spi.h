@@ -43,6 +43,14 @@ struct spi_t
 
 	/* Private data */
 	void * priv;
+
+	/* Message queue, set up by register_spi */
+	struct list_head queue;
+	struct timer_t timer;
+	spinlock_t lock;
+	int busy;
+	int pumping;
+	int kicked;
 };
 
 struct spi_device_t {
@@ -52,8 +60,51 @@ struct spi_device_t {
 	int mode;
 	int bits;
 	int speed;
+	int claimed;
+};
+
+/*
+ * A message is a list of transfers run back to back under one chip select
+ * assertion. Transfers may override the device bits and speed, cs_change
+ * toggles the chip select after the transfer, delay_us waits after it.
+ */
+struct spi_transfer_t {
+	struct list_head list;
+	void * txbuf;
+	void * rxbuf;
+	int len;
+	int bits;
+	int speed;
+	int cs_change;
+	int delay_us;
+};
+
+struct spi_message_t {
+	struct list_head transfers;
+	struct list_head queue;
+	struct spi_device_t * dev;
+
+	/* Called from the queue timer once the message is done */
+	void (*complete)(struct spi_message_t * m);
+	void * context;
+
+	/* Zero when done, negative on failure, positive while queued */
+	volatile int status;
+	int actual;
 };
 
+static inline void spi_message_init(struct spi_message_t * m)
+{
+	memset(m, 0, sizeof(struct spi_message_t));
+	init_list_head(&m->transfers);
+	init_list_head(&m->queue);
+}
+
+static inline void spi_message_add_tail(struct spi_transfer_t * t, struct spi_message_t * m)
+{
+	list_add_tail(&t->list, &m->transfers);
+}
+
 struct spi_t * search_spi(const char * name);
 bool_t register_spi(struct device_t ** device, struct spi_t * spi);
 bool_t unregister_spi(struct spi_t * spi);
@@ -66,6 +117,11 @@ void spi_device_free(struct spi_device_t * dev);
 int spi_device_write_then_read(struct spi_device_t * dev, void * txbuf, int txlen, void * rxbuf, int rxlen);
 void spi_device_select(struct spi_device_t * dev);
 void spi_device_deselect(struct spi_device_t * dev);
+int spi_sync(struct spi_device_t * dev, struct spi_message_t * m);
+int spi_async(struct spi_device_t * dev, struct spi_message_t * m);
+int spi_cancel(struct spi_device_t * dev, struct spi_message_t * m);
+void * spi_dma_alloc(int size);
+void spi_dma_free(void * buf);
 
 #ifdef __cplusplus
 }
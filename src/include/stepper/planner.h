@@ -0,0 +1,94 @@
+#ifndef __STEPPER_PLANNER_H__
+#define __STEPPER_PLANNER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+#include <stepper/stepper.h>
+
+#define STEPPER_PLANNER_MAX_AXES	(4)
+#define STEPPER_PLANNER_MAX_RAMP	(65536)
+
+enum stepper_profile_t {
+	STEPPER_PROFILE_TRAPEZOID	= 0,
+	STEPPER_PROFILE_SCURVE		= 1,
+};
+
+/*
+ * A linear move of all axes, timed by its dominant axis. Speeds are kept
+ * as ramp positions, the number of steps it takes to accelerate from
+ * rest to that speed, so ramps are plain table walks in the timer.
+ */
+struct stepper_segment_t {
+	int delta[STEPPER_PLANNER_MAX_AXES];
+	int dir[STEPPER_PLANNER_MAX_AXES];
+	int steps;
+	int knominal;
+	int kmaxentry;
+	int kentry;
+	int kexit;
+	int kpeak;
+	int accel;
+	int decel;
+};
+
+/*
+ * Coordinated motion of up to STEPPER_PLANNER_MAX_AXES steppers from one
+ * timer. Lines are queued into a ring of segments, each new line re-plans
+ * the entry and exit speeds of the queued segments so that motion only
+ * slows down where the path bends or ends. Step intervals come from a ramp
+ * table computed once per profile, trapezoidal or jerk limited s-curve.
+ */
+struct stepper_planner_t {
+	struct stepper_t * axis[STEPPER_PLANNER_MAX_AXES];
+	int naxis;
+
+	/* Ramp table, interval in ns after each step from rest */
+	enum stepper_profile_t profile;
+	int vmax;
+	int accel;
+	int jerk;
+	u32_t * ramp;
+	int nramp;
+	u32_t cruise;
+
+	/* Segment ring, out is the running segment */
+	struct stepper_segment_t * seg;
+	unsigned int depth;
+	unsigned int in;
+	unsigned int out;
+	int last[STEPPER_PLANNER_MAX_AXES];
+	int vlast;
+
+	struct timer_t timer;
+	spinlock_t lock;
+	int active;
+	int running;
+	int index;
+	int err[STEPPER_PLANNER_MAX_AXES];
+	ktime_t stamp;
+
+	/* Statistics, jitter is the lateness of a step against its schedule */
+	u64_t steps;
+	u32_t segments;
+	u32_t missed;
+	s64_t jitter_max;
+	s64_t jitter_sum;
+	u32_t rate_max;
+};
+
+struct stepper_planner_t * stepper_planner_alloc(struct stepper_t ** axis, int naxis, int depth);
+void stepper_planner_free(struct stepper_planner_t * p);
+bool_t stepper_planner_set_profile(struct stepper_planner_t * p, enum stepper_profile_t profile, int vmax, int accel, int jerk);
+bool_t stepper_planner_line(struct stepper_planner_t * p, const int * delta, int speed);
+int stepper_planner_busying(struct stepper_planner_t * p);
+void stepper_planner_stop(struct stepper_planner_t * p);
+void stepper_planner_reset_stats(struct stepper_planner_t * p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STEPPER_PLANNER_H__ */
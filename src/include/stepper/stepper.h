@@ -16,6 +16,9 @@ struct stepper_t
 	void (*move)(struct stepper_t * m, int step, int speed);
 	int (*busying)(struct stepper_t * m);
 
+	/* Single step without timing, for external motion control */
+	void (*step)(struct stepper_t * m, int dir);
+
 	void * priv;
 };
 
@@ -27,6 +30,7 @@ void stepper_enable(struct stepper_t * m);
 void stepper_disable(struct stepper_t * m);
 void stepper_move(struct stepper_t * m, int step, int speed);
 int stepper_busying(struct stepper_t * m);
+void stepper_step(struct stepper_t * m, int dir);
 
 #ifdef __cplusplus
 }
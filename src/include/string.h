@@ -85,6 +85,50 @@ static inline __attribute__((always_inline)) unsigned long __fls(unsigned long w
 	return (sizeof(word) * 8) - 1 - __builtin_clzl(word);
 }
 
+/*
+ * Word at a time helpers for the generic string routines. A word holds a
+ * zero byte when string_word_haszero() is non zero, the byte itself is then
+ * found by a byte loop, so only string_word_before() depends on byte order.
+ * Words are only loaded aligned, so a load never crosses into another page.
+ */
+typedef unsigned long __attribute__((may_alias)) string_word_t;
+
+#define STRING_WORD_SIZE	(sizeof(string_word_t))
+#define STRING_WORD_ONES	(~0UL / 0xff)
+#define STRING_WORD_HIGHS	(STRING_WORD_ONES << 7)
+
+static inline __attribute__((always_inline)) int string_word_aligned(const void * p)
+{
+	return ((unsigned long)p & (STRING_WORD_SIZE - 1)) == 0;
+}
+
+static inline __attribute__((always_inline)) unsigned long string_word_haszero(unsigned long w)
+{
+	return (w - STRING_WORD_ONES) & ~w & STRING_WORD_HIGHS;
+}
+
+static inline __attribute__((always_inline)) unsigned long string_word_repeat(int c)
+{
+	return STRING_WORD_ONES * (unsigned char)c;
+}
+
+/*
+ * Ones in the bytes of the aligned word holding p that come before p, or'ed
+ * into that word they can neither be zero nor match.
+ */
+static inline __attribute__((always_inline)) unsigned long string_word_before(const void * p)
+{
+	unsigned long k = ((unsigned long)p & (STRING_WORD_SIZE - 1)) * 8;
+
+	if (k == 0)
+		return 0;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return ~0UL << (sizeof(unsigned long) * 8 - k);
+#else
+	return ~0UL >> (sizeof(unsigned long) * 8 - k);
+#endif
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -9,19 +9,65 @@ extern "C" {
 #include <stddef.h>
 #include <math.h>
 #include <malloc.h>
-#include <median.h>
-#include <mean.h>
+
+#define TSFILTER_MEDIAN_MAX		(9)
+
+/*
+ * Touch pipeline: median spike rejection, a jitter dead band, smoothing
+ * whose weight follows the speed of the contact, prediction of the position
+ * at the next frame and finally calibration. Everything runs in integer
+ * arithmetic on a single allocation.
+ */
+struct tsfilter_config_t {
+	/* Median window length in samples, 1 disables it */
+	int median;
+
+	/* Dead band in raw units, 0 disables it */
+	int jitter;
+
+	/* Weight of a new sample in percent, at rest and at or above speed */
+	int slow;
+	int fast;
+
+	/* Speed in raw units per ms where the fast weight is reached */
+	int speed;
+
+	/* Nominal sample interval in us, used when no timestamp is given */
+	int interval;
+
+	/* Display refresh rate in Hz, 0 when unknown */
+	int refresh;
+
+	/* Longest prediction horizon in us, 0 disables prediction */
+	int predict;
+};
+
+struct tsfilter_axis_t {
+	int win[TSFILTER_MEDIAN_MAX];
+	int sorted[TSFILTER_MEDIAN_MAX];
+	int hold;
+	int last;
+	int s;
+	int v;
+};
 
 struct tsfilter_t {
-	struct median_filter_t * mx, * my;
-	struct mean_filter_t * nx, * ny;
+	struct tsfilter_config_t cfg;
+	struct tsfilter_axis_t ax, ay;
+	int position;
+	int filled;
+	int count;
+	s64_t time;
 	int cal[7];
 };
 
+void tsfilter_config_default(struct tsfilter_config_t * cfg);
+struct tsfilter_t * tsfilter_alloc_config(const struct tsfilter_config_t * cfg);
 struct tsfilter_t * tsfilter_alloc(int ml, int nl);
 void tsfilter_free(struct tsfilter_t * filter);
 void tsfilter_setcal(struct tsfilter_t * filter, int * cal);
 void tsfilter_update(struct tsfilter_t * filter, int * x, int * y);
+void tsfilter_update_at(struct tsfilter_t * filter, int * x, int * y, s64_t us);
 void tsfilter_clear(struct tsfilter_t * filter);
 
 #ifdef __cplusplus
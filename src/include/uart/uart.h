@@ -36,6 +36,8 @@ bool_t uart_set(struct uart_t * uart, int baud, int data, int parity, int stop);
 bool_t uart_get(struct uart_t * uart, int * baud, int * data, int * parity, int * stop);
 ssize_t uart_read(struct uart_t * uart, u8_t * buf, size_t count);
 ssize_t uart_write(struct uart_t * uart, const u8_t * buf, size_t count);
+bool_t uart_event_enable(struct uart_t * uart);
+void uart_event_disable(struct uart_t * uart);
 
 #ifdef __cplusplus
 }
@@ -18,40 +18,41 @@ enum device_type_t {
 	DEVICE_TYPE_CLOCKSOURCE		= 7,
 	DEVICE_TYPE_COMPASS			= 8,
 	DEVICE_TYPE_CONSOLE			= 9,
-	DEVICE_TYPE_DAC				= 10,
-	DEVICE_TYPE_DISK			= 11,
-	DEVICE_TYPE_FRAMEBUFFER		= 12,
-	DEVICE_TYPE_GMETER			= 13,
-	DEVICE_TYPE_GPIOCHIP		= 14,
-	DEVICE_TYPE_GYROSCOPE		= 15,
-	DEVICE_TYPE_HYGROMETER		= 16,
-	DEVICE_TYPE_I2C				= 17,
-	DEVICE_TYPE_INPUT			= 18,
-	DEVICE_TYPE_IRQCHIP			= 19,
-	DEVICE_TYPE_LASERSCAN		= 20,
-	DEVICE_TYPE_LED				= 21,
-	DEVICE_TYPE_LEDSTRIP		= 22,
-	DEVICE_TYPE_LEDTRIGGER		= 23,
-	DEVICE_TYPE_LIGHT			= 24,
-	DEVICE_TYPE_MOTOR			= 25,
-	DEVICE_TYPE_NVMEM			= 26,
-	DEVICE_TYPE_PRESSURE		= 27,
-	DEVICE_TYPE_PROXIMITY		= 28,
-	DEVICE_TYPE_PWM				= 29,
-	DEVICE_TYPE_REGULATOR		= 30,
-	DEVICE_TYPE_RESETCHIP		= 31,
-	DEVICE_TYPE_RNG				= 32,
-	DEVICE_TYPE_RTC				= 33,
-	DEVICE_TYPE_SDHCI			= 34,
-	DEVICE_TYPE_SERVO			= 35,
-	DEVICE_TYPE_SPI				= 36,
-	DEVICE_TYPE_STEPPER			= 37,
-	DEVICE_TYPE_THERMOMETER		= 38,
-	DEVICE_TYPE_UART			= 39,
-	DEVICE_TYPE_VIBRATOR		= 40,
-	DEVICE_TYPE_WATCHDOG		= 41,
+	DEVICE_TYPE_CPUFREQ			= 10,
+	DEVICE_TYPE_DAC				= 11,
+	DEVICE_TYPE_DISK			= 12,
+	DEVICE_TYPE_FRAMEBUFFER		= 13,
+	DEVICE_TYPE_GMETER			= 14,
+	DEVICE_TYPE_GPIOCHIP		= 15,
+	DEVICE_TYPE_GYROSCOPE		= 16,
+	DEVICE_TYPE_HYGROMETER		= 17,
+	DEVICE_TYPE_I2C				= 18,
+	DEVICE_TYPE_INPUT			= 19,
+	DEVICE_TYPE_IRQCHIP			= 20,
+	DEVICE_TYPE_LASERSCAN		= 21,
+	DEVICE_TYPE_LED				= 22,
+	DEVICE_TYPE_LEDSTRIP		= 23,
+	DEVICE_TYPE_LEDTRIGGER		= 24,
+	DEVICE_TYPE_LIGHT			= 25,
+	DEVICE_TYPE_MOTOR			= 26,
+	DEVICE_TYPE_NVMEM			= 27,
+	DEVICE_TYPE_PRESSURE		= 28,
+	DEVICE_TYPE_PROXIMITY		= 29,
+	DEVICE_TYPE_PWM				= 30,
+	DEVICE_TYPE_REGULATOR		= 31,
+	DEVICE_TYPE_RESETCHIP		= 32,
+	DEVICE_TYPE_RNG				= 33,
+	DEVICE_TYPE_RTC				= 34,
+	DEVICE_TYPE_SDHCI			= 35,
+	DEVICE_TYPE_SERVO			= 36,
+	DEVICE_TYPE_SPI				= 37,
+	DEVICE_TYPE_STEPPER			= 38,
+	DEVICE_TYPE_THERMOMETER		= 39,
+	DEVICE_TYPE_UART			= 40,
+	DEVICE_TYPE_VIBRATOR		= 41,
+	DEVICE_TYPE_WATCHDOG		= 42,
 
-	DEVICE_TYPE_MAX_COUNT		= 42,
+	DEVICE_TYPE_MAX_COUNT		= 43,
 };
 
 enum {
@@ -22,6 +22,7 @@ enum event_type_t {
 	EVENT_TYPE_TOUCH_BEGIN				= 0x0400,
 	EVENT_TYPE_TOUCH_MOVE				= 0x0401,
 	EVENT_TYPE_TOUCH_END				= 0x0402,
+	EVENT_TYPE_TOUCH_FRAME				= 0x0403,
 
 	EVENT_TYPE_JOYSTICK_LEFTSTICK		= 0x0500,
 	EVENT_TYPE_JOYSTICK_RIGHTSTICK		= 0x0501,
@@ -29,8 +30,29 @@ enum event_type_t {
 	EVENT_TYPE_JOYSTICK_RIGHTTRIGGER	= 0x0503,
 	EVENT_TYPE_JOYSTICK_BUTTONDOWN		= 0x0504,
 	EVENT_TYPE_JOYSTICK_BUTTONUP		= 0x0505,
+
+	EVENT_TYPE_UART_RX					= 0x0600,
+
+	EVENT_TYPE_GPIO_EDGE				= 0x0700,
+
+	EVENT_TYPE_ADC_DONE					= 0x0800,
+
+	EVENT_TYPE_SOUND_FINISH				= 0x0900,
 };
 
+/*
+ * Events are grouped in classes by the high byte of the type, an event base
+ * only queues the classes it has subscribed. Input classes are subscribed by
+ * default, the driver classes must be subscribed explicitly.
+ */
+#define EVENT_CLASS(type)				((u32_t)(type) >> 8)
+#define EVENT_CLASS_MASK(type)			(1 << EVENT_CLASS(type))
+#define EVENT_CLASS_MASK_INPUT			(EVENT_CLASS_MASK(EVENT_TYPE_KEY_DOWN) | \
+										EVENT_CLASS_MASK(EVENT_TYPE_ROTARY_TURN) | \
+										EVENT_CLASS_MASK(EVENT_TYPE_MOUSE_DOWN) | \
+										EVENT_CLASS_MASK(EVENT_TYPE_TOUCH_BEGIN) | \
+										EVENT_CLASS_MASK(EVENT_TYPE_JOYSTICK_LEFTSTICK))
+
 enum {
 	MOUSE_BUTTON_LEFT					= 0x01,
 	MOUSE_BUTTON_MIDDLE					= 0x02,
@@ -57,6 +79,11 @@ enum {
 	JOYSTICK_BUTTON_RSTICK				= 0x0f,
 };
 
+struct event_touch_contact_t {
+	s32_t x, y;
+	u32_t id;
+};
+
 struct event_t {
 	void * device;
 	enum event_type_t type;
@@ -116,6 +143,11 @@ struct event_t {
 			u32_t id;
 		} touch_end;
 
+		struct {
+			u32_t count;
+			struct event_touch_contact_t contact[CONFIG_EVENT_TOUCH_CONTACTS];
+		} touch_frame;
+
 		/* Joystick */
 		struct {
 			s32_t x, y;
@@ -140,16 +172,66 @@ struct event_t {
 		struct {
 			u32_t button;
 		} joystick_button_up;
+
+		/* Uart */
+		struct {
+			u32_t count;
+		} uart_rx;
+
+		/* Gpio */
+		struct {
+			u32_t gpio;
+			u32_t value;
+		} gpio_edge;
+
+		/* Adc */
+		struct {
+			u32_t channel;
+			u32_t value;
+		} adc_done;
+
+		/* Sound, the title is copied as the sound may be freed before the pump */
+		struct {
+			u32_t position;
+			char title[32];
+		} sound_finish;
 	} e;
 };
 
+/*
+ * A subscribed class with filters only queues the events of a matching
+ * device, and of a matching pin or channel for gpio and adc. A NULL device
+ * or a negative pin matches any.
+ */
+struct event_filter_t {
+	u32_t cls;
+	void * device;
+	int pin;
+};
+
+/*
+ * Mouse and touch motion is held back per device and contact, a newer move
+ * of the same contact replaces the pending one. Any other event flushes the
+ * pending motion into the fifo first, keeping the order, and pump_event
+ * picks it up once the fifo runs empty.
+ */
 struct event_base_t {
 	struct fifo_t * fifo;
+	u32_t mask;
+	struct event_filter_t filter[CONFIG_EVENT_FILTER_LENGTH];
+	int nfilter;
+	struct event_t motion[CONFIG_EVENT_MOTION_LENGTH];
+	int nmotion;
+	u32_t overflow;
+	u32_t coalesce;
 	struct list_head entry;
 };
 
 struct event_base_t * __event_base_alloc(void);
 void __event_base_free(struct event_base_t * eb);
+void event_base_subscribe(struct event_base_t * eb, enum event_type_t type);
+void event_base_unsubscribe(struct event_base_t * eb, enum event_type_t type);
+bool_t event_base_subscribe_filter(struct event_base_t * eb, enum event_type_t type, void * device, int pin);
 
 void push_event(struct event_t * event);
 void push_event_key_down(void * device, u32_t key);
@@ -163,12 +245,17 @@ void push_event_mouse_wheel(void * device, s32_t dx, s32_t dy);
 void push_event_touch_begin(void * device, s32_t x, s32_t y, u32_t id);
 void push_event_touch_move(void * device, s32_t x, s32_t y, u32_t id);
 void push_event_touch_end(void * device, s32_t x, s32_t y, u32_t id);
+void push_event_touch_frame(void * device, struct event_touch_contact_t * contact, u32_t count);
 void push_event_joystick_left_stick(void * device, s32_t x, s32_t y);
 void push_event_joystick_right_stick(void * device, s32_t x, s32_t y);
 void push_event_joystick_left_trigger(void * device, s32_t v);
 void push_event_joystick_right_trigger(void * device, s32_t v);
 void push_event_joystick_button_down(void * device, u32_t button);
 void push_event_joystick_button_up(void * device, u32_t button);
+void push_event_uart_rx(void * device, u32_t count);
+void push_event_gpio_edge(void * device, u32_t gpio, u32_t value);
+void push_event_adc_done(void * device, u32_t channel, u32_t value);
+void push_event_sound_finish(void * device, const char * title, u32_t position);
 bool_t pump_event(struct event_base_t * eb, struct event_t * event);
 
 #ifdef __cplusplus
@@ -0,0 +1,35 @@
+#ifndef __IDLE_H__
+#define __IDLE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+
+/*
+ * Deferred work for a system without threads. The loops that wait for
+ * input call idle_poll on every pass, idle_enter when they run out of work
+ * and idle_exit when work arrives, the lua vm calls idle_poll while a script
+ * runs. Hooks run in that thread context, never from an interrupt, so they
+ * may take buses and read files but must not block for long.
+ */
+struct idle_hook_t {
+	struct list_head list;
+	void (*poll)(void * data);
+	void (*enter)(void * data);
+	void (*exit)(void * data);
+	void * data;
+};
+
+bool_t register_idle_hook(struct idle_hook_t * h);
+bool_t unregister_idle_hook(struct idle_hook_t * h);
+void idle_poll(void);
+void idle_enter(void);
+void idle_exit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __IDLE_H__ */
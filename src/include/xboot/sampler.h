@@ -0,0 +1,63 @@
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <xboot.h>
+#include <xboot/idle.h>
+
+#define SAMPLER_MAX_CHANNELS	(4)
+
+/*
+ * Periodic sensor sampling from the timer base. The timer only stamps each
+ * tick, the idle poll hook then reads one sample of up to
+ * SAMPLER_MAX_CHANNELS values in thread context, where the bus may be taken,
+ * and queues it with the tick's timestamp in a ring buffer. Consumers drain
+ * the ring in bulk. A full ring drops the new sample and counts an overrun.
+ * Ticks that come too late to keep the rate, or that are stamped again
+ * before the poll read the previous one, are counted as missed.
+ */
+struct sampler_record_t {
+	s64_t time;
+	s32_t value[SAMPLER_MAX_CHANNELS];
+};
+
+struct sampler_t {
+	/* Sensor read, fills channel values and returns FALSE on failure */
+	bool_t (*read)(struct sampler_t * s, s32_t * value);
+	void * data;
+	int channel;
+
+	struct timer_t timer;
+	struct idle_hook_t idle;
+	ktime_t interval;
+	s64_t stamp;
+	int due;
+	struct sampler_record_t * ring;
+	unsigned int depth;
+	unsigned int in;
+	unsigned int out;
+	spinlock_t lock;
+	int running;
+
+	/* Statistics */
+	u32_t count;
+	u32_t overrun;
+	u32_t missed;
+	u32_t error;
+};
+
+struct sampler_t * sampler_alloc(int channel, bool_t (*read)(struct sampler_t *, s32_t *), void * data);
+void sampler_free(struct sampler_t * s);
+bool_t sampler_start(struct sampler_t * s, int rate, int depth);
+void sampler_stop(struct sampler_t * s);
+int sampler_available(struct sampler_t * s);
+int sampler_drain(struct sampler_t * s, struct sampler_record_t * r, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SAMPLER_H__ */
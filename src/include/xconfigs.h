@@ -44,6 +44,18 @@ extern "C" {
 #define CONFIG_EVENT_FIFO_LENGTH			(8)
 #endif
 
+#if !defined(CONFIG_EVENT_MOTION_LENGTH)
+#define CONFIG_EVENT_MOTION_LENGTH			(10)
+#endif
+
+#if !defined(CONFIG_EVENT_TOUCH_CONTACTS)
+#define CONFIG_EVENT_TOUCH_CONTACTS			(10)
+#endif
+
+#if !defined(CONFIG_EVENT_FILTER_LENGTH)
+#define CONFIG_EVENT_FILTER_LENGTH			(8)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
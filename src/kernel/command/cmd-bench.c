@@ -0,0 +1,1102 @@
+/*
+ * kernel/command/cmd-bench.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <audio/pcm.h>
+#include <tsfilter.h>
+#include <median.h>
+#include <mean.h>
+#include <crc8.h>
+#include <crc16.h>
+#include <crc32.h>
+#include <sha256.h>
+#include <chacha20.h>
+#include <aes.h>
+#include <math.h>
+#include <fastmath.h>
+#include <spi/spi.h>
+#include <rng/rng.h>
+#include <rng/random.h>
+#include <cpufreq/cpufreq.h>
+#include <command/command.h>
+
+struct bench_case_t {
+	const char * name;
+	const char * desc;
+	void (*run)(int argc, char ** argv);
+	int explicit;
+};
+
+static void bench_rate(const char * name, u64_t count, const char * unit, ktime_t t0, ktime_t t1)
+{
+	s64_t ns = ktime_to_ns(ktime_sub(t1, t0));
+
+	if(ns <= 0)
+		ns = 1;
+	printf("    %-16s %12llu %s/s\r\n", name, (unsigned long long)(count * 1000000000ULL / ns), unit);
+}
+
+static void bench_pcm(int argc, char ** argv)
+{
+	const struct {
+		const char * name;
+		enum pcm_format_t fmt;
+	} fmts[] = {
+		{ "pcm-s8",		PCM_FORMAT_BIT8 },
+		{ "pcm-s16",	PCM_FORMAT_BIT16 },
+		{ "pcm-s24",	PCM_FORMAT_BIT24 },
+		{ "pcm-s32",	PCM_FORMAT_BIT32 },
+	};
+	int size = 3 * 4 * 1024;
+	int loop = 256;
+	ktime_t t0, t1;
+	u8_t * buf;
+	int i, j;
+
+	buf = malloc(size);
+	if(!buf)
+		return;
+	for(i = 0; i < size; i++)
+		buf[i] = i * 251;
+
+	for(i = 0; i < ARRAY_SIZE(fmts); i++)
+	{
+		t0 = ktime_get();
+		for(j = 0; j < loop; j++)
+			pcm_scale(buf, size, fmts[i].fmt, (PCM_GAIN_UNITY >> 1) + (j & 0xff));
+		t1 = ktime_get();
+		bench_rate(fmts[i].name, (u64_t)loop * (size / pcm_sample_bytes(fmts[i].fmt)), "samples", t0, t1);
+	}
+	free(buf);
+}
+
+/*
+ * Touch replay, a generated trace of a resting contact followed by a steady
+ * drag, both with sensor noise and spikes. The ground truth is known, so the
+ * jitter at rest and the lag while dragging can be measured.
+ */
+#define TOUCH_REST			(200)
+#define TOUCH_DRAG			(120)
+#define TOUCH_INTERVAL		(10000)
+#define TOUCH_SPEED			(4)
+
+struct touch_sample_t {
+	int x, y;
+	int tx, ty;
+};
+
+static void bench_touch_trace(struct touch_sample_t * t)
+{
+	u32_t seed = 0x12345678;
+	int i, n;
+
+	for(i = 0; i < TOUCH_REST + TOUCH_DRAG; i++)
+	{
+		t[i].tx = 2000 + ((i < TOUCH_REST) ? 0 : (i - TOUCH_REST) * TOUCH_SPEED * TOUCH_INTERVAL / 1000);
+		t[i].ty = 2000;
+		seed = seed * 1103515245 + 12345;
+		n = (int)((seed >> 16) % 7) - 3;
+		t[i].x = t[i].tx + n + ((i % 37) == 36 ? 60 : 0);
+		seed = seed * 1103515245 + 12345;
+		n = (int)((seed >> 16) % 7) - 3;
+		t[i].y = t[i].ty + n;
+	}
+}
+
+static void bench_touch_report(const char * name, struct touch_sample_t * t, int * ox, int * oy, ktime_t t0, ktime_t t1)
+{
+	s64_t sq = 0, lag = 0;
+	int rest = 0, drag = 0;
+	int i, dx, dy;
+
+	for(i = 20; i < TOUCH_REST; i++, rest++)
+	{
+		dx = ox[i] - t[i].tx;
+		dy = oy[i] - t[i].ty;
+		sq += dx * dx + dy * dy;
+	}
+	for(i = TOUCH_REST + 20; i < TOUCH_REST + TOUCH_DRAG; i++, drag++)
+		lag += t[i].tx - ox[i];
+	printf("    %-18s jitter %4d.%02d, lag %5lld us, %4lld ns/sample\r\n", name,
+		(int)sqrt((double)sq / rest), (int)(sqrt((double)sq / rest) * 100) % 100,
+		lag * 1000 / (drag * TOUCH_SPEED), ktime_to_ns(ktime_sub(t1, t0)) / (TOUCH_REST + TOUCH_DRAG));
+}
+
+static void bench_touch_run(struct tsfilter_t * filter, struct touch_sample_t * t, int * ox, int * oy, ktime_t * t0, ktime_t * t1)
+{
+	int i;
+
+	*t0 = ktime_get();
+	for(i = 0; i < TOUCH_REST + TOUCH_DRAG; i++)
+	{
+		ox[i] = t[i].x;
+		oy[i] = t[i].y;
+		tsfilter_update_at(filter, &ox[i], &oy[i], (s64_t)i * TOUCH_INTERVAL);
+	}
+	*t1 = ktime_get();
+}
+
+static void bench_touch(int argc, char ** argv)
+{
+	struct touch_sample_t t[TOUCH_REST + TOUCH_DRAG];
+	int ox[TOUCH_REST + TOUCH_DRAG], oy[TOUCH_REST + TOUCH_DRAG];
+	struct median_filter_t * mx, * my;
+	struct mean_filter_t * nx, * ny;
+	struct tsfilter_config_t cfg;
+	struct tsfilter_t * filter;
+	ktime_t t0, t1;
+	int i;
+
+	bench_touch_trace(t);
+
+	mx = median_alloc(5);
+	my = median_alloc(5);
+	nx = mean_alloc(5);
+	ny = mean_alloc(5);
+	if(mx && my && nx && ny)
+	{
+		t0 = ktime_get();
+		for(i = 0; i < TOUCH_REST + TOUCH_DRAG; i++)
+		{
+			ox[i] = mean_update(nx, median_update(mx, t[i].x));
+			oy[i] = mean_update(ny, median_update(my, t[i].y));
+		}
+		t1 = ktime_get();
+		bench_touch_report("median-mean", t, ox, oy, t0, t1);
+	}
+	if(mx)
+		median_free(mx);
+	if(my)
+		median_free(my);
+	if(nx)
+		mean_free(nx);
+	if(ny)
+		mean_free(ny);
+
+	for(i = 0; i < 2; i++)
+	{
+		tsfilter_config_default(&cfg);
+		if(i == 1)
+		{
+			cfg.jitter = 2;
+			cfg.slow = 20;
+			cfg.fast = 80;
+			cfg.speed = 2;
+			cfg.refresh = 60;
+			cfg.predict = 8000;
+		}
+		filter = tsfilter_alloc_config(&cfg);
+		if(!filter)
+			continue;
+		bench_touch_run(filter, t, ox, oy, &t0, &t1);
+		bench_touch_report((i == 0) ? "tsfilter" : "tsfilter-adaptive", t, ox, oy, t0, t1);
+		tsfilter_free(filter);
+	}
+}
+
+/*
+ * Spi loopback, best run with mosi wired to miso. The named bus and chip
+ * select are driven through spi_sync one message at a time, then through
+ * spi_async with a few messages kept in flight, which is what the queue
+ * buys. It clocks pattern data into whatever sits on that chip select, so
+ * it only runs when asked for by name and never from 'all'.
+ */
+#define SPI_BENCH_SIZE		(4096)
+#define SPI_BENCH_LOOP		(64)
+#define SPI_BENCH_DEPTH		(4)
+#define SPI_BENCH_SPEED		(25000000)
+
+struct spi_bench_slot_t {
+	struct spi_message_t m;
+	struct spi_transfer_t t;
+	volatile int * left;
+	volatile int * done;
+};
+
+static void bench_spi_complete(struct spi_message_t * m)
+{
+	struct spi_bench_slot_t * slot = (struct spi_bench_slot_t *)m->context;
+
+	(*slot->done)++;
+	if(*slot->left > 0)
+	{
+		(*slot->left)--;
+		spi_async(m->dev, m);
+	}
+}
+
+/*
+ * Returns FALSE if queued messages could not be drained, the buffers are
+ * then still in use and must not be freed.
+ */
+static bool_t bench_spi_bus(struct spi_t * spi, int cs, u8_t * tx, u8_t * rx)
+{
+	static struct spi_bench_slot_t slot[SPI_BENCH_DEPTH];
+	static volatile int left, done;
+	struct spi_device_t * dev;
+	ktime_t t0, t1, timeout;
+	irq_flags_t flags;
+	char name[32];
+	int i, ok, issued;
+
+	dev = spi_device_alloc(spi->name, cs, 0, 0, 8, SPI_BENCH_SPEED);
+	if(!dev)
+		return TRUE;
+
+	memset(rx, 0, SPI_BENCH_SIZE);
+	for(i = 0; i < SPI_BENCH_DEPTH; i++)
+	{
+		spi_message_init(&slot[i].m);
+		memset(&slot[i].t, 0, sizeof(struct spi_transfer_t));
+		slot[i].t.txbuf = tx;
+		slot[i].t.rxbuf = rx;
+		slot[i].t.len = SPI_BENCH_SIZE;
+		slot[i].left = &left;
+		slot[i].done = &done;
+		slot[i].m.context = &slot[i];
+		slot[i].m.complete = bench_spi_complete;
+		spi_message_add_tail(&slot[i].t, &slot[i].m);
+	}
+
+	ok = 1;
+	t0 = ktime_get();
+	for(i = 0; i < SPI_BENCH_LOOP; i++)
+	{
+		if(spi_sync(dev, &slot[0].m) != SPI_BENCH_SIZE)
+		{
+			ok = 0;
+			break;
+		}
+	}
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "%s-sync", spi->name);
+	if(ok)
+		bench_rate(name, (u64_t)SPI_BENCH_LOOP * SPI_BENCH_SIZE, "bytes", t0, t1);
+	else
+		printf("    %-16s transfer failed\r\n", name);
+	printf("    %-16s %s\r\n", spi->name, (memcmp(tx, rx, SPI_BENCH_SIZE) == 0) ? "loopback ok" : "no loopback");
+
+	left = SPI_BENCH_LOOP - SPI_BENCH_DEPTH;
+	done = 0;
+	t0 = ktime_get();
+	for(i = 0; i < SPI_BENCH_DEPTH; i++)
+		spi_async(dev, &slot[i].m);
+	timeout = ktime_add_ms(t0, 5000);
+	while((done < SPI_BENCH_LOOP) && ktime_before(ktime_get(), timeout));
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "%s-async", spi->name);
+	if(done >= SPI_BENCH_LOOP)
+	{
+		bench_rate(name, (u64_t)SPI_BENCH_LOOP * SPI_BENCH_SIZE, "bytes", t0, t1);
+		spi_device_free(dev);
+		return TRUE;
+	}
+
+	local_irq_save(flags);
+	issued = SPI_BENCH_LOOP - left;
+	left = 0;
+	local_irq_restore(flags);
+	printf("    %-16s timeout, %d of %d done\r\n", name, done, SPI_BENCH_LOOP);
+	timeout = ktime_add_ms(ktime_get(), 1000);
+	while((done < issued) && ktime_before(ktime_get(), timeout));
+	if(done < issued)
+		return FALSE;
+	spi_device_free(dev);
+	return TRUE;
+}
+
+static void bench_spi(int argc, char ** argv)
+{
+	struct spi_t * spi;
+	u8_t * tx, * rx;
+	int i;
+
+	if(argc < 2)
+	{
+		printf("    usage: bench spi <bus> <cs>\r\n");
+		return;
+	}
+	spi = search_spi(argv[0]);
+	if(!spi)
+	{
+		printf("    no spi bus '%s'\r\n", argv[0]);
+		return;
+	}
+
+	tx = spi_dma_alloc(SPI_BENCH_SIZE);
+	rx = spi_dma_alloc(SPI_BENCH_SIZE);
+	if(tx && rx)
+	{
+		for(i = 0; i < SPI_BENCH_SIZE; i++)
+			tx[i] = i * 251 + 7;
+		if(!bench_spi_bus(spi, strtol(argv[1], NULL, 0), tx, rx))
+			return;
+	}
+	if(tx)
+		spi_dma_free(tx);
+	if(rx)
+		spi_dma_free(rx);
+}
+
+/*
+ * Crc, throughput over a 64KB buffer, crc32 both through the selected
+ * implementation and the portable slicing one.
+ */
+#define CRC_BENCH_SIZE		(64 * 1024)
+#define CRC_BENCH_LOOP		(64)
+
+static void bench_crc(int argc, char ** argv)
+{
+	char name[32];
+	ktime_t t0, t1;
+	u8_t * buf;
+	u32_t crc = 0;
+	int i;
+
+	buf = malloc(CRC_BENCH_SIZE + 1);
+	if(!buf)
+		return;
+	for(i = 0; i < CRC_BENCH_SIZE + 1; i++)
+		buf[i] = i * 251 + 7;
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		crc += crc8_sum(crc, buf, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("crc8", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		crc += crc16_sum(crc, buf, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("crc16", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		crc = crc32_sum_generic(crc, buf + (i & 1), CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("crc32-slice8", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		crc = crc32_sum(crc, buf + (i & 1), CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "crc32-%s", crc32_impl());
+	bench_rate(name, (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+	free(buf);
+}
+
+/*
+ * Sha256, throughput of the selected block function over a 64KB buffer,
+ * and of small updates as an image loader would issue them.
+ */
+static void bench_sha256(int argc, char ** argv)
+{
+	struct sha256_ctx_t ctx;
+	char name[32];
+	ktime_t t0, t1;
+	u8_t * buf;
+	int i, j;
+
+	buf = malloc(CRC_BENCH_SIZE);
+	if(!buf)
+		return;
+	for(i = 0; i < CRC_BENCH_SIZE; i++)
+		buf[i] = i * 251 + 7;
+
+	t0 = ktime_get();
+	sha256_init(&ctx);
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		sha256_update(&ctx, buf, CRC_BENCH_SIZE);
+	sha256_final(&ctx);
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "sha256-%s", sha256_impl());
+	bench_rate(name, (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	sha256_init(&ctx);
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+	{
+		for(j = 0; j < CRC_BENCH_SIZE; j += 500)
+			sha256_update(&ctx, buf + j, (CRC_BENCH_SIZE - j < 500) ? CRC_BENCH_SIZE - j : 500);
+	}
+	sha256_final(&ctx);
+	t1 = ktime_get();
+	bench_rate("sha256-chunked", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+	free(buf);
+}
+
+/*
+ * Aes, mode throughput for 128 and 256 bit keys over a 64KB buffer with
+ * the selected block implementation.
+ */
+static void bench_aes(int argc, char ** argv)
+{
+	const int klens[] = { 16, 32 };
+	struct aes_ctr_t ctr;
+	struct aes_cbc_t cbc;
+	struct aes_gcm_t gcm;
+	u8_t key[32], iv[AES_BLOCK_SIZE];
+	char name[32];
+	ktime_t t0, t1;
+	u8_t * buf;
+	int i, k;
+
+	buf = malloc(CRC_BENCH_SIZE);
+	if(!buf)
+		return;
+	for(i = 0; i < CRC_BENCH_SIZE; i++)
+		buf[i] = i * 251 + 7;
+	for(i = 0; i < sizeof(key); i++)
+		key[i] = i;
+	memset(iv, 0, sizeof(iv));
+	printf("    implementation %s\r\n", aes_impl());
+
+	for(k = 0; k < ARRAY_SIZE(klens); k++)
+	{
+		aes_ctr_init(&ctr, key, klens[k], iv);
+		t0 = ktime_get();
+		for(i = 0; i < CRC_BENCH_LOOP; i++)
+			aes_ctr_update(&ctr, buf, buf, CRC_BENCH_SIZE);
+		t1 = ktime_get();
+		snprintf(name, sizeof(name), "aes%d-ctr", klens[k] * 8);
+		bench_rate(name, (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+		aes_cbc_init(&cbc, key, klens[k], iv);
+		t0 = ktime_get();
+		for(i = 0; i < CRC_BENCH_LOOP; i++)
+			aes_cbc_encrypt(&cbc, buf, buf, CRC_BENCH_SIZE / AES_BLOCK_SIZE);
+		t1 = ktime_get();
+		snprintf(name, sizeof(name), "aes%d-cbc-enc", klens[k] * 8);
+		bench_rate(name, (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+		aes_cbc_init(&cbc, key, klens[k], iv);
+		t0 = ktime_get();
+		for(i = 0; i < CRC_BENCH_LOOP; i++)
+			aes_cbc_decrypt(&cbc, buf, buf, CRC_BENCH_SIZE / AES_BLOCK_SIZE);
+		t1 = ktime_get();
+		snprintf(name, sizeof(name), "aes%d-cbc-dec", klens[k] * 8);
+		bench_rate(name, (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+		aes_gcm_init(&gcm, key, klens[k], iv, 12);
+		t0 = ktime_get();
+		for(i = 0; i < CRC_BENCH_LOOP; i++)
+			aes_gcm_encrypt(&gcm, buf, buf, CRC_BENCH_SIZE);
+		aes_gcm_tag(&gcm, iv);
+		t1 = ktime_get();
+		snprintf(name, sizeof(name), "aes%d-gcm", klens[k] * 8);
+		bench_rate(name, (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+	}
+	free(buf);
+}
+
+/*
+ * Mem, memcpy, memmove, memset and memcmp checked against the expected
+ * bytes for all sizes up to MEM_CHECK_SIZE at every alignment, then their
+ * throughput over a 64KB buffer.
+ */
+#define MEM_CHECK_SIZE		(160)
+#define MEM_CHECK_BUF		(MEM_CHECK_SIZE + 96)
+
+static inline u8_t bench_mem_pattern(int i, int seed)
+{
+	return (u8_t)(i * 251 + seed * 31 + 7);
+}
+
+static int bench_mem_check(u8_t * a, u8_t * b)
+{
+	const int deltas[] = { -33, -8, -1, 1, 3, 8, 33 };
+	int n, s, d, k, i, r, x, err = 0;
+	u8_t e;
+
+	for(n = 0; n <= MEM_CHECK_SIZE; n++)
+	{
+		for(s = 0; s < 16; s++)
+		{
+			for(d = 0; d < 16; d++)
+			{
+				for(i = 0; i < MEM_CHECK_BUF; i++)
+				{
+					a[i] = bench_mem_pattern(i, 1);
+					b[i] = bench_mem_pattern(i, 2);
+				}
+				if(memcpy(b + d, a + s, n) != b + d)
+					err++;
+				for(i = 0; i < MEM_CHECK_BUF; i++)
+				{
+					e = (i >= d && i < d + n) ? bench_mem_pattern(s + i - d, 1) : bench_mem_pattern(i, 2);
+					if(b[i] != e)
+					{
+						err++;
+						break;
+					}
+				}
+				if(memcmp(a + s, b + d, n) != 0)
+					err++;
+				if(n > 0)
+				{
+					k = (s * 16 + d) % n;
+					b[d + k] ^= 1 << (d & 7);
+					r = memcmp(a + s, b + d, n);
+					x = a[s + k] - b[d + k];
+					if((r < 0) != (x < 0) || (r > 0) != (x > 0))
+						err++;
+				}
+			}
+
+			for(i = 0; i < MEM_CHECK_BUF; i++)
+				b[i] = bench_mem_pattern(i, 2);
+			if(memset(b + s, n + s, n) != b + s)
+				err++;
+			for(i = 0; i < MEM_CHECK_BUF; i++)
+			{
+				e = (i >= s && i < s + n) ? (u8_t)(n + s) : bench_mem_pattern(i, 2);
+				if(b[i] != e)
+				{
+					err++;
+					break;
+				}
+			}
+
+			for(k = 0; k < ARRAY_SIZE(deltas); k++)
+			{
+				for(i = 0; i < MEM_CHECK_BUF; i++)
+					a[i] = bench_mem_pattern(i, 3);
+				d = 40 + s + deltas[k];
+				if(memmove(a + d, a + 40 + s, n) != a + d)
+					err++;
+				for(i = 0; i < MEM_CHECK_BUF; i++)
+				{
+					e = (i >= d && i < d + n) ? bench_mem_pattern(40 + s + i - d, 3) : bench_mem_pattern(i, 3);
+					if(a[i] != e)
+					{
+						err++;
+						break;
+					}
+				}
+			}
+		}
+	}
+	return err;
+}
+
+static void bench_mem(int argc, char ** argv)
+{
+	ktime_t t0, t1;
+	u8_t * src, * dst;
+	int err, i, j;
+
+	src = malloc(CRC_BENCH_SIZE + 64);
+	dst = malloc(CRC_BENCH_SIZE + 64);
+	if(!src || !dst)
+	{
+		free(src);
+		free(dst);
+		return;
+	}
+	err = bench_mem_check(src, dst);
+	if(err)
+		printf("    check failed, %d mismatches\r\n", err);
+	else
+		printf("    check ok, sizes 0 to %d at all alignments\r\n", MEM_CHECK_SIZE);
+	for(i = 0; i < CRC_BENCH_SIZE + 64; i++)
+		src[i] = i * 251 + 7;
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		memcpy(dst, src, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("memcpy", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		memcpy(dst + 1, src + 6, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("memcpy-unaligned", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+	{
+		for(j = 0; j < CRC_BENCH_SIZE; j += 32)
+			memcpy(dst + j, src + j, 32);
+	}
+	t1 = ktime_get();
+	bench_rate("memcpy-32", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		memmove(dst + 8, dst, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("memmove-back", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		memmove(dst + 3, dst, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("memmove-back-odd", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	t0 = ktime_get();
+	for(i = 0; i < CRC_BENCH_LOOP; i++)
+		memset(dst, i, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("memset", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+
+	memcpy(dst, src, CRC_BENCH_SIZE);
+	t0 = ktime_get();
+	for(i = 0, err = 0; i < CRC_BENCH_LOOP; i++)
+		err += memcmp(dst, src, CRC_BENCH_SIZE);
+	t1 = ktime_get();
+	bench_rate("memcmp", (u64_t)CRC_BENCH_LOOP * CRC_BENCH_SIZE, "bytes", t0, t1);
+	free(src);
+	free(dst);
+}
+
+/*
+ * String, the generic string routines per size class, from a short key
+ * through a path to a json body. The strings start one byte past a word
+ * boundary, so each call also walks the unaligned head.
+ */
+#define STRING_BENCH_TOTAL	(1024 * 1024)
+
+static const char * bench_string_names[] = {
+	"strlen", "strnlen", "strchr", "memchr", "strcmp", "strncmp", "strcpy",
+};
+
+static void bench_string_run(int r, char * a, char * b, int len, int loop)
+{
+	int i;
+
+	switch(r)
+	{
+	case 0:
+		for(i = 0; i < loop; i++)
+			strlen(a);
+		break;
+	case 1:
+		for(i = 0; i < loop; i++)
+			strnlen(a, len + 1);
+		break;
+	case 2:
+		for(i = 0; i < loop; i++)
+			strchr(a, '#');
+		break;
+	case 3:
+		for(i = 0; i < loop; i++)
+			memchr(a, '#', len);
+		break;
+	case 4:
+		for(i = 0; i < loop; i++)
+			strcmp(a, b);
+		break;
+	case 5:
+		for(i = 0; i < loop; i++)
+			strncmp(a, b, len);
+		break;
+	case 6:
+		for(i = 0; i < loop; i++)
+			strcpy(b, a);
+		break;
+	default:
+		break;
+	}
+}
+
+static void bench_string(int argc, char ** argv)
+{
+	const int sizes[] = { 8, 64, 1024 };
+	char name[32];
+	ktime_t t0, t1;
+	char * a, * b;
+	int loop;
+	int i, r;
+
+	a = malloc(1024 + 16);
+	b = malloc(1024 + 16);
+	if(!a || !b)
+	{
+		free(a);
+		free(b);
+		return;
+	}
+	for(r = 0; r < ARRAY_SIZE(bench_string_names); r++)
+	{
+		for(i = 0; i < ARRAY_SIZE(sizes); i++)
+		{
+			memset(a, 'x', sizes[i] + 1);
+			a[sizes[i] + 1] = '\0';
+			strcpy(b + 1, a + 1);
+			loop = STRING_BENCH_TOTAL / sizes[i];
+			t0 = ktime_get();
+			bench_string_run(r, a + 1, b + 1, sizes[i], loop);
+			t1 = ktime_get();
+			snprintf(name, sizeof(name), "%s-%d", bench_string_names[r], sizes[i]);
+			bench_rate(name, (u64_t)loop * sizes[i], "bytes", t0, t1);
+		}
+	}
+	free(a);
+	free(b);
+}
+
+/*
+ * Fastmath, the worst error of each approximation and its array variant
+ * against the double libm over the documented range, then results per
+ * second of the libm float function, the fast one and the array one.
+ */
+#define FASTMATH_BENCH_SIZE	(4096)
+#define FASTMATH_BENCH_LOOP	(64)
+
+static const struct bench_fastmath_t {
+	const char * name;
+	float lo, hi;
+	int rel;
+	double (*ref)(double);
+	float (*libm)(float);
+	float (*fast)(float);
+	void (*fastv)(float *, const float *, int);
+} bench_fastmath_funcs[] = {
+	{ "sinf",	-8192.0f,	8192.0f,	0,	sin,	sinf,	fast_sinf,	fast_sinfv },
+	{ "cosf",	-8192.0f,	8192.0f,	0,	cos,	cosf,	fast_cosf,	fast_cosfv },
+	{ "expf",	-87.0f,		88.72f,		1,	exp,	expf,	fast_expf,	fast_expfv },
+	{ "sqrtf",	0.0f,		1000000.0f,	1,	sqrt,	sqrtf,	fast_sqrtf,	fast_sqrtfv },
+};
+
+static void bench_fastmath_err(double * worst, double r, float v, int rel)
+{
+	double e = fabs((double)v - r);
+
+	if(rel)
+		e = (r != 0.0) ? e / fabs(r) : 0.0;
+	if(e > *worst)
+		*worst = e;
+}
+
+static void bench_fastmath_rates(const char * fn, float * y, float * x, float * z, const struct bench_fastmath_t * f)
+{
+	char name[32];
+	ktime_t t0, t1;
+	int i, j;
+
+	t0 = ktime_get();
+	for(j = 0; j < FASTMATH_BENCH_LOOP; j++)
+	{
+		for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+			y[i] = f ? f->libm(x[i]) : atan2f(x[i], z[i]);
+	}
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "%s-libm", fn);
+	bench_rate(name, (u64_t)FASTMATH_BENCH_LOOP * FASTMATH_BENCH_SIZE, "calls", t0, t1);
+
+	t0 = ktime_get();
+	for(j = 0; j < FASTMATH_BENCH_LOOP; j++)
+	{
+		for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+			y[i] = f ? f->fast(x[i]) : fast_atan2f(x[i], z[i]);
+	}
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "%s-fast", fn);
+	bench_rate(name, (u64_t)FASTMATH_BENCH_LOOP * FASTMATH_BENCH_SIZE, "calls", t0, t1);
+
+	t0 = ktime_get();
+	for(j = 0; j < FASTMATH_BENCH_LOOP; j++)
+	{
+		if(f)
+			f->fastv(y, x, FASTMATH_BENCH_SIZE);
+		else
+			fast_atan2fv(y, x, z, FASTMATH_BENCH_SIZE);
+	}
+	t1 = ktime_get();
+	snprintf(name, sizeof(name), "%s-array", fn);
+	bench_rate(name, (u64_t)FASTMATH_BENCH_LOOP * FASTMATH_BENCH_SIZE, "calls", t0, t1);
+}
+
+static void bench_fastmath(int argc, char ** argv)
+{
+	const struct bench_fastmath_t * f;
+	float * x, * y, * z;
+	double e, ev, r, a, m;
+	int i, j, k;
+
+	x = malloc(FASTMATH_BENCH_SIZE * sizeof(float));
+	y = malloc(FASTMATH_BENCH_SIZE * sizeof(float));
+	z = malloc(FASTMATH_BENCH_SIZE * sizeof(float));
+	if(!x || !y || !z)
+	{
+		free(x);
+		free(y);
+		free(z);
+		return;
+	}
+	printf("    implementation %s\r\n", fastmath_impl());
+
+	for(k = 0; k < ARRAY_SIZE(bench_fastmath_funcs); k++)
+	{
+		f = &bench_fastmath_funcs[k];
+		e = ev = 0.0;
+		for(j = 0; j < FASTMATH_BENCH_LOOP; j++)
+		{
+			for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+				x[i] = f->lo + (f->hi - f->lo) * (double)(j * FASTMATH_BENCH_SIZE + i) / (FASTMATH_BENCH_LOOP * FASTMATH_BENCH_SIZE - 1);
+			f->fastv(y, x, FASTMATH_BENCH_SIZE);
+			for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+			{
+				r = f->ref(x[i]);
+				bench_fastmath_err(&e, r, f->fast(x[i]), f->rel);
+				bench_fastmath_err(&ev, r, y[i], f->rel);
+			}
+		}
+		printf("    %-16s %s error %e, array %e over [%g, %g]\r\n", f->name, f->rel ? "relative" : "absolute", e, ev, f->lo, f->hi);
+		for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+			x[i] = f->lo + (f->hi - f->lo) * i / (FASTMATH_BENCH_SIZE - 1);
+		bench_fastmath_rates(f->name, y, x, z, f);
+	}
+
+	/* Atan2 around the circle, with radii from 1e-3 to 1e3 */
+	e = ev = 0.0;
+	for(j = 0; j < FASTMATH_BENCH_LOOP; j++)
+	{
+		for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+		{
+			a = M_PI * (2.0 * (j * FASTMATH_BENCH_SIZE + i) / (FASTMATH_BENCH_LOOP * FASTMATH_BENCH_SIZE) - 1.0);
+			m = pow(10.0, (i % 7) - 3);
+			x[i] = m * sin(a);
+			z[i] = m * cos(a);
+		}
+		fast_atan2fv(y, x, z, FASTMATH_BENCH_SIZE);
+		for(i = 0; i < FASTMATH_BENCH_SIZE; i++)
+		{
+			r = atan2(x[i], z[i]);
+			bench_fastmath_err(&e, r, fast_atan2f(x[i], z[i]), 0);
+			bench_fastmath_err(&ev, r, y[i], 0);
+		}
+	}
+	printf("    %-16s absolute error %e, array %e around the circle\r\n", "atan2f", e, ev);
+	bench_fastmath_rates("atan2f", y, x, z, NULL);
+	free(x);
+	free(y);
+	free(z);
+}
+
+/*
+ * Random, the chacha20 block checked against the rfc 7539 vector, whole
+ * and split across calls, then the generator per request size against
+ * the first hardware rng, which bounds the cost of reseeding from it.
+ */
+#define RANDOM_BENCH_TOTAL	(256 * 1024)
+
+static const u8_t bench_chacha20_nonce[CHACHA20_NONCE_SIZE] = {
+	0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x4a, 0x00, 0x00, 0x00, 0x00,
+};
+
+static const u8_t bench_chacha20_block[CHACHA20_BLOCK_SIZE] = {
+	0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4,
+	0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0, 0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e,
+	0xd2, 0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05, 0xd9, 0x8b, 0x02, 0xa2,
+	0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e, 0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e,
+};
+
+static bool_t bench_chacha20_check(void)
+{
+	struct chacha20_ctx_t ctx;
+	u8_t key[CHACHA20_KEY_SIZE];
+	u8_t out[CHACHA20_BLOCK_SIZE];
+	int i;
+
+	for(i = 0; i < sizeof(key); i++)
+		key[i] = i;
+	chacha20_init(&ctx, key, bench_chacha20_nonce, 1);
+	chacha20_keystream(&ctx, out, sizeof(out));
+	if(memcmp(out, bench_chacha20_block, sizeof(out)) != 0)
+		return FALSE;
+	chacha20_init(&ctx, key, bench_chacha20_nonce, 1);
+	chacha20_keystream(&ctx, &out[0], 7);
+	chacha20_keystream(&ctx, &out[7], sizeof(out) - 7);
+	return (memcmp(out, bench_chacha20_block, sizeof(out)) == 0) ? TRUE : FALSE;
+}
+
+static void bench_random(int argc, char ** argv)
+{
+	const int sizes[] = { 16, 256, 4096 };
+	struct rng_t * rng;
+	char name[32];
+	ktime_t t0, t1;
+	u8_t * buf;
+	int total, len;
+	int i;
+
+	printf("    %-16s %s\r\n", "chacha20", bench_chacha20_check() ? "rfc 7539 vector ok" : "rfc 7539 vector failed");
+	buf = malloc(4096);
+	if(!buf)
+		return;
+	if(!random_seeded())
+		printf("    not seeded yet, waiting for entropy\r\n");
+	for(i = 0; i < ARRAY_SIZE(sizes); i++)
+	{
+		t0 = ktime_get();
+		for(total = 0; total < RANDOM_BENCH_TOTAL; total += sizes[i])
+		{
+			if(getrandom(buf, sizes[i], 0) < 0)
+				break;
+		}
+		t1 = ktime_get();
+		snprintf(name, sizeof(name), "getrandom-%d", sizes[i]);
+		bench_rate(name, total, "bytes", t0, t1);
+	}
+	rng = search_first_rng();
+	if(rng)
+	{
+		t0 = ktime_get();
+		for(total = 0; total < 4096; total += len)
+		{
+			len = rng_read_data(rng, buf, 4096 - total, 1);
+			if(len <= 0)
+				break;
+		}
+		t1 = ktime_get();
+		snprintf(name, sizeof(name), "rng-%s", rng->name);
+		bench_rate(name, total, "bytes", t0, t1);
+	}
+	free(buf);
+}
+
+/*
+ * Cpufreq, the policy driven through the simulate load, full load must
+ * reach the top point and no load the bottom one, then the time spent.
+ */
+static int bench_cpufreq_settle(struct cpufreq_t * f, int load, int opp)
+{
+	ktime_t timeout;
+
+	f->simulate = load;
+	timeout = ktime_add_ms(ktime_get(), 2000);
+	while(ktime_before(ktime_get(), timeout))
+	{
+		cpufreq_idle_enter();
+		cpufreq_idle_exit();
+		if(f->cur == opp)
+			return 1;
+	}
+	return 0;
+}
+
+static void bench_cpufreq(int argc, char ** argv)
+{
+	struct cpufreq_t * f;
+	ktime_t t0, t1;
+	int simulate;
+	int up, down;
+
+	f = search_first_cpufreq();
+	if(!f)
+		return;
+	simulate = f->simulate;
+	t0 = ktime_get();
+	up = bench_cpufreq_settle(f, 100, f->nopp - 1);
+	t1 = ktime_get();
+	printf("    %-16s %s in %lldms\r\n", "full-load", up ? "top point" : "stuck", (long long)ktime_ms_delta(t1, t0));
+	t0 = ktime_get();
+	down = bench_cpufreq_settle(f, 0, 0);
+	t1 = ktime_get();
+	printf("    %-16s %s in %lldms\r\n", "no-load", down ? "bottom point" : "stuck", (long long)ktime_ms_delta(t1, t0));
+	f->simulate = simulate;
+	printf("    %s %s\r\n", f->name, (up && down) ? "policy ok" : "policy failed");
+}
+
+static struct bench_case_t bench_cases[] = {
+	{ "pcm",	"pcm volume scaling per sample format",	bench_pcm },
+	{ "touch",	"touch filter jitter and lag on a replayed trace",	bench_touch },
+	{ "spi",	"spi loopback on <bus> <cs>, sync and queued, not in all",	bench_spi, 1 },
+	{ "random",	"chacha20 checked, getrandom throughput against the hardware rng",	bench_random },
+	{ "cpufreq",	"cpufreq policy checked through the simulate load",	bench_cpufreq },
+	{ "crc",	"crc8, crc16 and crc32 throughput per implementation",	bench_crc },
+	{ "sha256",	"sha256 throughput, bulk and in loader sized chunks",	bench_sha256 },
+	{ "aes",	"aes ctr, cbc and gcm throughput per key size",	bench_aes },
+	{ "mem",	"memcpy, memmove, memset and memcmp checked, then throughput",	bench_mem },
+	{ "string",	"string routines per routine and size class",	bench_string },
+	{ "fastmath",	"fast float math error and throughput against libm",	bench_fastmath },
+};
+
+static void usage(void)
+{
+	int i;
+
+	printf("usage:\r\n");
+	printf("    bench [all | <case> ...]\r\n");
+	printf("    bench spi <bus> <cs>\r\n");
+	printf("cases:\r\n");
+	for(i = 0; i < ARRAY_SIZE(bench_cases); i++)
+		printf("    %-8s %s\r\n", bench_cases[i].name, bench_cases[i].desc);
+}
+
+static int do_bench(int argc, char ** argv)
+{
+	int all = 0;
+	int i, j;
+
+	if(argc < 2)
+	{
+		usage();
+		return 0;
+	}
+	if(strcmp(argv[1], "all") == 0)
+		all = 1;
+
+	for(i = 0; i < ARRAY_SIZE(bench_cases); i++)
+	{
+		for(j = 1; j < argc; j++)
+		{
+			if(all ? !bench_cases[i].explicit : (strcmp(argv[j], bench_cases[i].name) == 0))
+			{
+				printf("%s:\r\n", bench_cases[i].name);
+				bench_cases[i].run(argc - j - 1, &argv[j + 1]);
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static struct command_t cmd_bench = {
+	.name	= "bench",
+	.desc	= "run built-in micro benchmarks",
+	.usage	= usage,
+	.exec	= do_bench,
+};
+
+static __init void bench_cmd_init(void)
+{
+	register_command(&cmd_bench);
+}
+
+static __exit void bench_cmd_exit(void)
+{
+	unregister_command(&cmd_bench);
+}
+
+command_initcall(bench_cmd_init);
+command_exitcall(bench_cmd_exit);
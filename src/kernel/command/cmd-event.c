@@ -40,6 +40,7 @@ static int do_event(int argc, char ** argv)
 {
 	struct input_t * input;
 	struct event_t e;
+	int i;
 
 	while(1)
 	{
@@ -93,6 +94,13 @@ static int do_event(int argc, char ** argv)
 				printf("[%s]: [TouchEnd] [%d][%d][%d]\r\n", input->name, e.e.touch_end.x, e.e.touch_end.y, e.e.touch_end.id);
 				break;
 
+			case EVENT_TYPE_TOUCH_FRAME:
+				printf("[%s]: [TouchFrame] [%d]", input->name, e.e.touch_frame.count);
+				for(i = 0; i < e.e.touch_frame.count; i++)
+					printf(" [%d][%d][%d]", e.e.touch_frame.contact[i].x, e.e.touch_frame.contact[i].y, e.e.touch_frame.contact[i].id);
+				printf("\r\n");
+				break;
+
 			default:
 				printf("[%s]: [Unkown]\r\n", input->name);
 				break;
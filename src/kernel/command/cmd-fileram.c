@@ -26,21 +26,49 @@
  *
  */
 
+#include <sha256.h>
 #include <command/command.h>
 
 static void usage(void)
 {
 	printf("usage:\r\n");
-	printf("    fileram -f <file> <addr>\r\n");
+	printf("    fileram -f <file> <addr> [sha256]\r\n");
 	printf("    fileram -r <addr> <size> <file>\r\n");
 }
 
+static int hex_to_digest(const char * s, u8_t * digest)
+{
+	int i, c, v = 0;
+
+	if(strlen(s) != SHA256_DIGEST_SIZE * 2)
+		return 0;
+	for(i = 0; i < SHA256_DIGEST_SIZE * 2; i++)
+	{
+		c = s[i];
+		if(c >= '0' && c <= '9')
+			c -= '0';
+		else if(c >= 'a' && c <= 'f')
+			c -= 'a' - 10;
+		else if(c >= 'A' && c <= 'F')
+			c -= 'A' - 10;
+		else
+			return 0;
+		v = (v << 4) | c;
+		if(i & 1)
+			digest[i >> 1] = v & 0xff;
+	}
+	return 1;
+}
+
 static int do_fileram(int argc, char ** argv)
 {
+	struct sha256_ctx_t ctx;
+	u8_t digest[SHA256_DIGEST_SIZE];
 	char * filename;
 	s32_t fd;
 	u32_t addr, size = 0;
 	s32_t n;
+	int verify = 0;
 
 	if(argc != 4 && argc != 5)
 	{
@@ -50,15 +78,20 @@ static int do_fileram(int argc, char ** argv)
 
 	if( !strcmp((const char *)argv[1],"-f") )
 	{
-		if(argc != 4)
+		if(argc == 5)
 		{
-			usage();
-			return -1;
+			if(!hex_to_digest(argv[4], digest))
+			{
+				usage();
+				return -1;
+			}
+			verify = 1;
 		}
 
 		filename = (char *)argv[2];
 		addr = strtoul((const char *)argv[3], NULL, 0);
 		size = 0;
+		sha256_init(&ctx);
 
 		fd = open(filename, O_RDONLY, (S_IRUSR|S_IRGRP|S_IROTH));
 		if(fd < 0)
@@ -72,11 +105,18 @@ static int do_fileram(int argc, char ** argv)
 	        n = read(fd, (void *)(addr + size), SZ_512K);
 	        if(n <= 0)
 	        	break;
+			if(verify)
+				sha256_update(&ctx, (void *)((virtual_addr_t)(addr + size)), n);
 			size += n;
 	    }
 
 		close(fd);
 		printf("copy file %s to ram 0x%08lx ~ 0x%08lx.\r\n", filename, addr, addr + size);
+		if(verify && !sha256_verify(&ctx, digest))
+		{
+			printf("sha256 of the loaded image does not match\r\n");
+			return -1;
+		}
 	}
 	else if( !strcmp((const char *)argv[1], "-r") )
 	{
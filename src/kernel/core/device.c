@@ -92,6 +92,9 @@ static struct kobj_t * search_device_kobj(struct device_t * dev)
 	case DEVICE_TYPE_CONSOLE:
 		name = "console";
 		break;
+	case DEVICE_TYPE_CPUFREQ:
+		name = "cpufreq";
+		break;
 	case DEVICE_TYPE_DAC:
 		name = "dac";
 		break;
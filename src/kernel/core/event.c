@@ -53,6 +53,11 @@ struct event_base_t * __event_base_alloc(void)
 		free(eb);
 		return NULL;
 	}
+	eb->mask = EVENT_CLASS_MASK_INPUT;
+	eb->nfilter = 0;
+	eb->nmotion = 0;
+	eb->overflow = 0;
+	eb->coalesce = 0;
 
 	spin_lock_irqsave(&__event_base_lock, flags);
 	list_add_tail(&eb->entry, &(__event_base.entry));
@@ -84,19 +89,183 @@ void __event_base_free(struct event_base_t * eb)
 	}
 }
 
+static void event_base_drop_filter(struct event_base_t * eb, u32_t cls)
+{
+	int i, j;
+
+	for(i = 0, j = 0; i < eb->nfilter; i++)
+	{
+		if(eb->filter[i].cls != cls)
+			eb->filter[j++] = eb->filter[i];
+	}
+	eb->nfilter = j;
+}
+
+void event_base_subscribe(struct event_base_t * eb, enum event_type_t type)
+{
+	irq_flags_t flags;
+
+	if(!eb)
+		return;
+
+	spin_lock_irqsave(&__event_base_lock, flags);
+	eb->mask |= EVENT_CLASS_MASK(type);
+	event_base_drop_filter(eb, EVENT_CLASS(type));
+	spin_unlock_irqrestore(&__event_base_lock, flags);
+}
+
+void event_base_unsubscribe(struct event_base_t * eb, enum event_type_t type)
+{
+	irq_flags_t flags;
+
+	if(!eb)
+		return;
+
+	spin_lock_irqsave(&__event_base_lock, flags);
+	eb->mask &= ~EVENT_CLASS_MASK(type);
+	event_base_drop_filter(eb, EVENT_CLASS(type));
+	spin_unlock_irqrestore(&__event_base_lock, flags);
+}
+
+bool_t event_base_subscribe_filter(struct event_base_t * eb, enum event_type_t type, void * device, int pin)
+{
+	irq_flags_t flags;
+	bool_t ret = FALSE;
+
+	if(!eb)
+		return FALSE;
+
+	spin_lock_irqsave(&__event_base_lock, flags);
+	if(eb->nfilter < CONFIG_EVENT_FILTER_LENGTH)
+	{
+		eb->filter[eb->nfilter].cls = EVENT_CLASS(type);
+		eb->filter[eb->nfilter].device = device;
+		eb->filter[eb->nfilter].pin = pin;
+		eb->nfilter++;
+		eb->mask |= EVENT_CLASS_MASK(type);
+		ret = TRUE;
+	}
+	spin_unlock_irqrestore(&__event_base_lock, flags);
+
+	return ret;
+}
+
+static inline int event_pin(struct event_t * event)
+{
+	switch(event->type)
+	{
+	case EVENT_TYPE_GPIO_EDGE:
+		return event->e.gpio_edge.gpio;
+	case EVENT_TYPE_ADC_DONE:
+		return event->e.adc_done.channel;
+	default:
+		break;
+	}
+	return -1;
+}
+
+static bool_t event_base_accept(struct event_base_t * eb, struct event_t * event)
+{
+	struct event_filter_t * f;
+	u32_t cls = EVENT_CLASS(event->type);
+	bool_t filtered = FALSE;
+	int i;
+
+	for(i = 0; i < eb->nfilter; i++)
+	{
+		f = &eb->filter[i];
+		if(f->cls != cls)
+			continue;
+		if((!f->device || (f->device == event->device)) && ((f->pin < 0) || (f->pin == event_pin(event))))
+			return TRUE;
+		filtered = TRUE;
+	}
+	return !filtered;
+}
+
+static inline u32_t event_motion_id(struct event_t * event)
+{
+	switch(event->type)
+	{
+	case EVENT_TYPE_MOUSE_MOVE:
+	case EVENT_TYPE_TOUCH_FRAME:
+		return 0;
+	case EVENT_TYPE_TOUCH_MOVE:
+		return event->e.touch_move.id;
+	default:
+		break;
+	}
+	return ~0;
+}
+
+/*
+ * Queue whole events only, a partial write would desync the fifo.
+ */
+static void event_base_put(struct event_base_t * eb, struct event_t * event)
+{
+	if(eb->fifo->size - __fifo_len(eb->fifo) < sizeof(struct event_t))
+		eb->overflow++;
+	else
+		__fifo_put(eb->fifo, (u8_t *)event, sizeof(struct event_t));
+}
+
+static void event_base_flush_motion(struct event_base_t * eb)
+{
+	int i;
+
+	for(i = 0; i < eb->nmotion; i++)
+		event_base_put(eb, &eb->motion[i]);
+	eb->nmotion = 0;
+}
+
+static void event_base_push(struct event_base_t * eb, struct event_t * event)
+{
+	struct event_t * m;
+	u32_t id = event_motion_id(event);
+	int i;
+
+	if(id == ~0)
+	{
+		event_base_flush_motion(eb);
+		event_base_put(eb, event);
+		return;
+	}
+
+	for(i = 0; i < eb->nmotion; i++)
+	{
+		m = &eb->motion[i];
+		if((m->device == event->device) && (m->type == event->type) && (event_motion_id(m) == id))
+		{
+			memcpy(m, event, sizeof(struct event_t));
+			eb->coalesce++;
+			return;
+		}
+	}
+
+	if(eb->nmotion >= CONFIG_EVENT_MOTION_LENGTH)
+		event_base_flush_motion(eb);
+	memcpy(&eb->motion[eb->nmotion++], event, sizeof(struct event_t));
+}
+
 void push_event(struct event_t * event)
 {
 	struct event_base_t * pos, * n;
+	irq_flags_t flags;
+	u32_t mask;
 
 	if(!event)
 		return;
 
 	event->timestamp = ktime_get();
+	mask = EVENT_CLASS_MASK(event->type);
 
+	spin_lock_irqsave(&__event_base_lock, flags);
 	list_for_each_entry_safe(pos, n, &(__event_base.entry), entry)
 	{
-		fifo_put(pos->fifo, (u8_t *)event, sizeof(struct event_t));
+		if((pos->mask & mask) && event_base_accept(pos, event))
+			event_base_push(pos, event);
 	}
+	spin_unlock_irqrestore(&__event_base_lock, flags);
 }
 
 void push_event_key_down(void * device, u32_t key)
@@ -221,6 +390,20 @@ void push_event_touch_end(void * device, s32_t x, s32_t y, u32_t id)
 	push_event(&event);
 }
 
+void push_event_touch_frame(void * device, struct event_touch_contact_t * contact, u32_t count)
+{
+	struct event_t event;
+
+	if(count > CONFIG_EVENT_TOUCH_CONTACTS)
+		count = CONFIG_EVENT_TOUCH_CONTACTS;
+	event.device = device;
+	event.type = EVENT_TYPE_TOUCH_FRAME;
+	event.e.touch_frame.count = count;
+	if(count > 0)
+		memcpy(event.e.touch_frame.contact, contact, sizeof(struct event_touch_contact_t) * count);
+	push_event(&event);
+}
+
 void push_event_joystick_left_stick(void * device, s32_t x, s32_t y)
 {
 	struct event_t event;
@@ -283,6 +466,49 @@ void push_event_joystick_button_up(void * device, u32_t button)
 	push_event(&event);
 }
 
+void push_event_uart_rx(void * device, u32_t count)
+{
+	struct event_t event;
+
+	event.device = device;
+	event.type = EVENT_TYPE_UART_RX;
+	event.e.uart_rx.count = count;
+	push_event(&event);
+}
+
+void push_event_gpio_edge(void * device, u32_t gpio, u32_t value)
+{
+	struct event_t event;
+
+	event.device = device;
+	event.type = EVENT_TYPE_GPIO_EDGE;
+	event.e.gpio_edge.gpio = gpio;
+	event.e.gpio_edge.value = value;
+	push_event(&event);
+}
+
+void push_event_adc_done(void * device, u32_t channel, u32_t value)
+{
+	struct event_t event;
+
+	event.device = device;
+	event.type = EVENT_TYPE_ADC_DONE;
+	event.e.adc_done.channel = channel;
+	event.e.adc_done.value = value;
+	push_event(&event);
+}
+
+void push_event_sound_finish(void * device, const char * title, u32_t position)
+{
+	struct event_t event;
+
+	event.device = device;
+	event.type = EVENT_TYPE_SOUND_FINISH;
+	event.e.sound_finish.position = position;
+	strlcpy(event.e.sound_finish.title, title ? title : "sound", sizeof(event.e.sound_finish.title));
+	push_event(&event);
+}
+
 bool_t pump_event(struct event_base_t * eb, struct event_t * event)
 {
 	irq_flags_t flags;
@@ -292,7 +518,9 @@ bool_t pump_event(struct event_base_t * eb, struct event_t * event)
 		return FALSE;
 
 	spin_lock_irqsave(&__event_base_lock, flags);
-	ret = (fifo_get(eb->fifo, (u8_t *)event, sizeof(struct event_t)) == sizeof(struct event_t));
+	if((__fifo_len(eb->fifo) < sizeof(struct event_t)) && (eb->nmotion > 0))
+		event_base_flush_motion(eb);
+	ret = (__fifo_get(eb->fifo, (u8_t *)event, sizeof(struct event_t)) == sizeof(struct event_t));
 	spin_unlock_irqrestore(&__event_base_lock, flags);
 
 	return ret;
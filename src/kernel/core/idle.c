@@ -0,0 +1,109 @@
+/*
+ * kernel/core/idle.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <xboot/idle.h>
+
+static LIST_HEAD(__idle_list);
+static spinlock_t __idle_lock = SPIN_LOCK_INIT();
+static int __idle_state = 0;
+static int __idle_polling = 0;
+
+bool_t register_idle_hook(struct idle_hook_t * h)
+{
+	irq_flags_t flags;
+
+	if(!h || (!h->poll && !h->enter && !h->exit))
+		return FALSE;
+
+	spin_lock_irqsave(&__idle_lock, flags);
+	list_add_tail(&h->list, &__idle_list);
+	spin_unlock_irqrestore(&__idle_lock, flags);
+	return TRUE;
+}
+
+bool_t unregister_idle_hook(struct idle_hook_t * h)
+{
+	irq_flags_t flags;
+
+	if(!h)
+		return FALSE;
+
+	spin_lock_irqsave(&__idle_lock, flags);
+	list_del(&h->list);
+	spin_unlock_irqrestore(&__idle_lock, flags);
+	return TRUE;
+}
+
+/*
+ * The list only changes from thread context, which these walks already own,
+ * so the hooks are called without the lock held and may unregister
+ * themselves. A poll that reaches the vm again is not nested.
+ */
+void idle_poll(void)
+{
+	struct idle_hook_t * pos, * n;
+
+	if(__idle_polling)
+		return;
+	__idle_polling = 1;
+	list_for_each_entry_safe(pos, n, &__idle_list, list)
+	{
+		if(pos->poll)
+			pos->poll(pos->data);
+	}
+	__idle_polling = 0;
+}
+
+void idle_enter(void)
+{
+	struct idle_hook_t * pos, * n;
+
+	if(__idle_state)
+		return;
+	__idle_state = 1;
+	list_for_each_entry_safe(pos, n, &__idle_list, list)
+	{
+		if(pos->enter)
+			pos->enter(pos->data);
+	}
+}
+
+void idle_exit(void)
+{
+	struct idle_hook_t * pos, * n;
+
+	if(!__idle_state)
+		return;
+	__idle_state = 0;
+	list_for_each_entry_safe(pos, n, &__idle_list, list)
+	{
+		if(pos->exit)
+			pos->exit(pos->data);
+	}
+}
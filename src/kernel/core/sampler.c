@@ -0,0 +1,199 @@
+/*
+ * kernel/core/sampler.c
+ *
+ * Copyright(c) 2007-2018 Jianjun Jiang <8192542@qq.com>
+ * Official site: http://xboot.org
+ * Mobile phone: +86-18665388956
+ * QQ: 8192542
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#include <xboot.h>
+#include <xboot/sampler.h>
+
+static void sampler_idle_poll(void * data)
+{
+	struct sampler_t * s = (struct sampler_t *)(data);
+	struct sampler_record_t * r;
+	s32_t value[SAMPLER_MAX_CHANNELS];
+	irq_flags_t flags;
+	s64_t stamp;
+	int due;
+
+	spin_lock_irqsave(&s->lock, flags);
+	due = s->due;
+	stamp = s->stamp;
+	s->due = 0;
+	spin_unlock_irqrestore(&s->lock, flags);
+	if(!due)
+		return;
+
+	if(s->read(s, value))
+	{
+		spin_lock_irqsave(&s->lock, flags);
+		if(s->in - s->out < s->depth)
+		{
+			r = &s->ring[s->in & (s->depth - 1)];
+			r->time = stamp;
+			memcpy(r->value, value, sizeof(s32_t) * s->channel);
+			s->in++;
+			s->count++;
+		}
+		else
+		{
+			s->overrun++;
+		}
+		spin_unlock_irqrestore(&s->lock, flags);
+	}
+	else
+	{
+		s->error++;
+	}
+}
+
+static int sampler_timer_function(struct timer_t * timer, void * data)
+{
+	struct sampler_t * s = (struct sampler_t *)(data);
+	irq_flags_t flags;
+	ktime_t now;
+
+	if(!s->running)
+		return 0;
+
+	spin_lock_irqsave(&s->lock, flags);
+	if(s->due)
+		s->missed++;
+	s->stamp = ktime_to_ns(ktime_get());
+	s->due = 1;
+	spin_unlock_irqrestore(&s->lock, flags);
+
+	/*
+	 * Step from the previous deadline so the rate does not drift, and
+	 * restart from now when the deadline has already passed.
+	 */
+	now = ktime_get();
+	timer_forward(timer, timer->expires, s->interval);
+	if(ktime_before(timer->expires, now))
+	{
+		s->missed++;
+		timer_forward(timer, now, s->interval);
+	}
+	return 1;
+}
+
+struct sampler_t * sampler_alloc(int channel, bool_t (*read)(struct sampler_t *, s32_t *), void * data)
+{
+	struct sampler_t * s;
+
+	if(!read || (channel <= 0) || (channel > SAMPLER_MAX_CHANNELS))
+		return NULL;
+
+	s = malloc(sizeof(struct sampler_t));
+	if(!s)
+		return NULL;
+
+	memset(s, 0, sizeof(struct sampler_t));
+	s->read = read;
+	s->data = data;
+	s->channel = channel;
+	spin_lock_init(&s->lock);
+	timer_init(&s->timer, sampler_timer_function, s);
+	s->idle.poll = sampler_idle_poll;
+	s->idle.data = s;
+	return s;
+}
+
+void sampler_free(struct sampler_t * s)
+{
+	if(s)
+	{
+		sampler_stop(s);
+		free(s->ring);
+		free(s);
+	}
+}
+
+bool_t sampler_start(struct sampler_t * s, int rate, int depth)
+{
+	struct sampler_record_t * ring;
+	irq_flags_t flags;
+
+	if(!s || (rate <= 0) || (depth <= 0))
+		return FALSE;
+
+	sampler_stop(s);
+	if(depth & (depth - 1))
+		depth = roundup_pow_of_two(depth);
+	if(depth != s->depth)
+	{
+		ring = malloc(sizeof(struct sampler_record_t) * depth);
+		if(!ring)
+			return FALSE;
+		spin_lock_irqsave(&s->lock, flags);
+		free(s->ring);
+		s->ring = ring;
+		s->depth = depth;
+		spin_unlock_irqrestore(&s->lock, flags);
+	}
+
+	s->in = s->out = 0;
+	s->count = s->overrun = s->missed = s->error = 0;
+	s->due = 0;
+	s->interval = ns_to_ktime(1000000000ULL / rate);
+	s->running = 1;
+	register_idle_hook(&s->idle);
+	timer_start_now(&s->timer, s->interval);
+	return TRUE;
+}
+
+void sampler_stop(struct sampler_t * s)
+{
+	if(s && s->running)
+	{
+		s->running = 0;
+		timer_cancel(&s->timer);
+		unregister_idle_hook(&s->idle);
+	}
+}
+
+int sampler_available(struct sampler_t * s)
+{
+	if(!s)
+		return 0;
+	return s->in - s->out;
+}
+
+int sampler_drain(struct sampler_t * s, struct sampler_record_t * r, int n)
+{
+	irq_flags_t flags;
+	int i;
+
+	if(!s || !r || (n <= 0))
+		return 0;
+
+	spin_lock_irqsave(&s->lock, flags);
+	if(n > s->in - s->out)
+		n = s->in - s->out;
+	for(i = 0; i < n; i++, s->out++)
+		memcpy(&r[i], &s->ring[s->out & (s->depth - 1)], sizeof(struct sampler_record_t));
+	spin_unlock_irqrestore(&s->lock, flags);
+	return n;
+}
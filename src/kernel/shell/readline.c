@@ -27,6 +27,7 @@
  */
 
 #include <xboot.h>
+#include <xboot/idle.h>
 #include <shell/readline.h>
 
 enum esc_state_t {
@@ -639,14 +640,20 @@ char * readline(const char * prompt)
 
 	for(;;)
 	{
+		idle_poll();
 		if(rl_getcode(rl, &code))
 		{
+			idle_exit();
 			if(readline_handle(rl, code))
 			{
 				printf("\r\n");
 				break;
 			}
 		}
+		else
+		{
+			idle_enter();
+		}
 	}
 
 	if(rl->len > 0)
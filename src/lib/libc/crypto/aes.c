@@ -0,0 +1,992 @@
+/*
+ * libc/crypto/aes.c
+ */
+
+#include <aes.h>
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
+	0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0,
+	0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc,
+	0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a,
+	0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0,
+	0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b,
+	0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85,
+	0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5,
+	0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17,
+	0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88,
+	0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c,
+	0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9,
+	0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6,
+	0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e,
+	0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94,
+	0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68,
+	0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+static const uint8_t inv_sbox[256] = {
+	0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38,
+	0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+	0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87,
+	0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+	0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d,
+	0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+	0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2,
+	0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+	0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16,
+	0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+	0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda,
+	0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+	0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a,
+	0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+	0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02,
+	0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+	0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea,
+	0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+	0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85,
+	0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+	0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89,
+	0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+	0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20,
+	0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+	0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31,
+	0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+	0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d,
+	0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+	0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0,
+	0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+	0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26,
+	0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+};
+
+/*
+ * One forward and one inverse round table, columns are little endian
+ * words with row zero in the low byte, the other three tables are byte
+ * rotations. Derived from the sboxes on first use.
+ */
+static uint32_t te0[256];
+static uint32_t td0[256];
+static int aes_tables_ready = 0;
+
+#define ROTL(x, n)		(((x) << (n)) | ((x) >> (32 - (n))))
+#define B0(x)			((x) & 0xff)
+#define B1(x)			(((x) >> 8) & 0xff)
+#define B2(x)			(((x) >> 16) & 0xff)
+#define B3(x)			((x) >> 24)
+#define GET32(p)		((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) | ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+#define PUT32(p, v)		do { (p)[0] = (v); (p)[1] = (v) >> 8; (p)[2] = (v) >> 16; (p)[3] = (v) >> 24; } while(0)
+
+static inline uint8_t gmul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while(b)
+	{
+		if(b & 1)
+			r ^= a;
+		a = (a << 1) ^ ((a & 0x80) ? 0x1b : 0);
+		b >>= 1;
+	}
+	return r;
+}
+
+static void aes_tables_init(void)
+{
+	uint8_t s, is;
+	int i;
+
+	for(i = 0; i < 256; i++)
+	{
+		s = sbox[i];
+		is = inv_sbox[i];
+		te0[i] = (uint32_t)gmul(s, 2) | ((uint32_t)s << 8) | ((uint32_t)s << 16) | ((uint32_t)gmul(s, 3) << 24);
+		td0[i] = (uint32_t)gmul(is, 14) | ((uint32_t)gmul(is, 9) << 8) | ((uint32_t)gmul(is, 13) << 16) | ((uint32_t)gmul(is, 11) << 24);
+	}
+	aes_tables_ready = 1;
+}
+
+#define TE(a, b, c, d)	(te0[B0(a)] ^ ROTL(te0[B1(b)], 8) ^ ROTL(te0[B2(c)], 16) ^ ROTL(te0[B3(d)], 24))
+#define TD(a, b, c, d)	(td0[B0(a)] ^ ROTL(td0[B1(b)], 8) ^ ROTL(td0[B2(c)], 16) ^ ROTL(td0[B3(d)], 24))
+#define SE(a, b, c, d)	((uint32_t)sbox[B0(a)] | ((uint32_t)sbox[B1(b)] << 8) | ((uint32_t)sbox[B2(c)] << 16) | ((uint32_t)sbox[B3(d)] << 24))
+#define SD(a, b, c, d)	((uint32_t)inv_sbox[B0(a)] | ((uint32_t)inv_sbox[B1(b)] << 8) | ((uint32_t)inv_sbox[B2(c)] << 16) | ((uint32_t)inv_sbox[B3(d)] << 24))
+
+static void aes_encrypt_generic(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n)
+{
+	const uint32_t * rk;
+	uint32_t s0, s1, s2, s3;
+	uint32_t t0, t1, t2, t3;
+	int r;
+
+	while(n-- > 0)
+	{
+		rk = ctx->ek;
+		s0 = GET32(in + 0) ^ rk[0];
+		s1 = GET32(in + 4) ^ rk[1];
+		s2 = GET32(in + 8) ^ rk[2];
+		s3 = GET32(in + 12) ^ rk[3];
+		for(r = 1; r < ctx->rounds; r++)
+		{
+			rk += 4;
+			t0 = TE(s0, s1, s2, s3) ^ rk[0];
+			t1 = TE(s1, s2, s3, s0) ^ rk[1];
+			t2 = TE(s2, s3, s0, s1) ^ rk[2];
+			t3 = TE(s3, s0, s1, s2) ^ rk[3];
+			s0 = t0;
+			s1 = t1;
+			s2 = t2;
+			s3 = t3;
+		}
+		rk += 4;
+		t0 = SE(s0, s1, s2, s3) ^ rk[0];
+		t1 = SE(s1, s2, s3, s0) ^ rk[1];
+		t2 = SE(s2, s3, s0, s1) ^ rk[2];
+		t3 = SE(s3, s0, s1, s2) ^ rk[3];
+		PUT32(out + 0, t0);
+		PUT32(out + 4, t1);
+		PUT32(out + 8, t2);
+		PUT32(out + 12, t3);
+		in += 16;
+		out += 16;
+	}
+}
+
+static void aes_decrypt_generic(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n)
+{
+	const uint32_t * rk;
+	uint32_t s0, s1, s2, s3;
+	uint32_t t0, t1, t2, t3;
+	int r;
+
+	while(n-- > 0)
+	{
+		rk = ctx->dk;
+		s0 = GET32(in + 0) ^ rk[0];
+		s1 = GET32(in + 4) ^ rk[1];
+		s2 = GET32(in + 8) ^ rk[2];
+		s3 = GET32(in + 12) ^ rk[3];
+		for(r = 1; r < ctx->rounds; r++)
+		{
+			rk += 4;
+			t0 = TD(s0, s3, s2, s1) ^ rk[0];
+			t1 = TD(s1, s0, s3, s2) ^ rk[1];
+			t2 = TD(s2, s1, s0, s3) ^ rk[2];
+			t3 = TD(s3, s2, s1, s0) ^ rk[3];
+			s0 = t0;
+			s1 = t1;
+			s2 = t2;
+			s3 = t3;
+		}
+		rk += 4;
+		t0 = SD(s0, s3, s2, s1) ^ rk[0];
+		t1 = SD(s1, s0, s3, s2) ^ rk[1];
+		t2 = SD(s2, s1, s0, s3) ^ rk[2];
+		t3 = SD(s3, s2, s1, s0) ^ rk[3];
+		PUT32(out + 0, t0);
+		PUT32(out + 4, t1);
+		PUT32(out + 8, t2);
+		PUT32(out + 12, t3);
+		in += 16;
+		out += 16;
+	}
+}
+
+#if defined(__ARM64__)
+/*
+ * Armv8 crypto extensions, aese and aesd fold the round key addition in
+ * front of the byte substitution, so the last key is added by hand.
+ */
+typedef uint8_t aes_v16u8_t __attribute__((vector_size(16)));
+typedef uint8_t aes_v16u8_u_t __attribute__((vector_size(16), aligned(1), may_alias));
+
+static int aes_hw_probe(void)
+{
+	uint64_t isar0;
+
+	__asm__ __volatile__("mrs %0, id_aa64isar0_el1" : "=r"(isar0));
+	return ((isar0 >> 4) & 0xf) ? 1 : 0;
+}
+
+#define AES_CE_LOAD(p)		(*((const aes_v16u8_u_t *)(p)))
+#define AES_CE_STORE(p, v)	(*((aes_v16u8_u_t *)(p)) = (v))
+
+__attribute__((target("+crypto")))
+static void aes_encrypt_hw(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n)
+{
+	const uint8_t * rk = (const uint8_t *)ctx->ek;
+	aes_v16u8_t s0, s1, s2, s3, k;
+	int nr = ctx->rounds;
+	int r;
+
+	for(; n >= 4; n -= 4, in += 64, out += 64)
+	{
+		s0 = AES_CE_LOAD(in + 0);
+		s1 = AES_CE_LOAD(in + 16);
+		s2 = AES_CE_LOAD(in + 32);
+		s3 = AES_CE_LOAD(in + 48);
+		for(r = 0; r < nr - 1; r++)
+		{
+			k = AES_CE_LOAD(rk + r * 16);
+			__asm__("aese %0.16b, %1.16b\n\taesmc %0.16b, %0.16b" : "+w"(s0) : "w"(k));
+			__asm__("aese %0.16b, %1.16b\n\taesmc %0.16b, %0.16b" : "+w"(s1) : "w"(k));
+			__asm__("aese %0.16b, %1.16b\n\taesmc %0.16b, %0.16b" : "+w"(s2) : "w"(k));
+			__asm__("aese %0.16b, %1.16b\n\taesmc %0.16b, %0.16b" : "+w"(s3) : "w"(k));
+		}
+		k = AES_CE_LOAD(rk + r * 16);
+		__asm__("aese %0.16b, %1.16b" : "+w"(s0) : "w"(k));
+		__asm__("aese %0.16b, %1.16b" : "+w"(s1) : "w"(k));
+		__asm__("aese %0.16b, %1.16b" : "+w"(s2) : "w"(k));
+		__asm__("aese %0.16b, %1.16b" : "+w"(s3) : "w"(k));
+		k = AES_CE_LOAD(rk + nr * 16);
+		AES_CE_STORE(out + 0, s0 ^ k);
+		AES_CE_STORE(out + 16, s1 ^ k);
+		AES_CE_STORE(out + 32, s2 ^ k);
+		AES_CE_STORE(out + 48, s3 ^ k);
+	}
+	for(; n > 0; n--, in += 16, out += 16)
+	{
+		s0 = AES_CE_LOAD(in);
+		for(r = 0; r < nr - 1; r++)
+		{
+			k = AES_CE_LOAD(rk + r * 16);
+			__asm__("aese %0.16b, %1.16b\n\taesmc %0.16b, %0.16b" : "+w"(s0) : "w"(k));
+		}
+		k = AES_CE_LOAD(rk + r * 16);
+		__asm__("aese %0.16b, %1.16b" : "+w"(s0) : "w"(k));
+		AES_CE_STORE(out, s0 ^ AES_CE_LOAD(rk + nr * 16));
+	}
+}
+
+__attribute__((target("+crypto")))
+static void aes_decrypt_hw(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n)
+{
+	const uint8_t * rk = (const uint8_t *)ctx->dk;
+	aes_v16u8_t s0, s1, s2, s3, k;
+	int nr = ctx->rounds;
+	int r;
+
+	for(; n >= 4; n -= 4, in += 64, out += 64)
+	{
+		s0 = AES_CE_LOAD(in + 0);
+		s1 = AES_CE_LOAD(in + 16);
+		s2 = AES_CE_LOAD(in + 32);
+		s3 = AES_CE_LOAD(in + 48);
+		for(r = 0; r < nr - 1; r++)
+		{
+			k = AES_CE_LOAD(rk + r * 16);
+			__asm__("aesd %0.16b, %1.16b\n\taesimc %0.16b, %0.16b" : "+w"(s0) : "w"(k));
+			__asm__("aesd %0.16b, %1.16b\n\taesimc %0.16b, %0.16b" : "+w"(s1) : "w"(k));
+			__asm__("aesd %0.16b, %1.16b\n\taesimc %0.16b, %0.16b" : "+w"(s2) : "w"(k));
+			__asm__("aesd %0.16b, %1.16b\n\taesimc %0.16b, %0.16b" : "+w"(s3) : "w"(k));
+		}
+		k = AES_CE_LOAD(rk + r * 16);
+		__asm__("aesd %0.16b, %1.16b" : "+w"(s0) : "w"(k));
+		__asm__("aesd %0.16b, %1.16b" : "+w"(s1) : "w"(k));
+		__asm__("aesd %0.16b, %1.16b" : "+w"(s2) : "w"(k));
+		__asm__("aesd %0.16b, %1.16b" : "+w"(s3) : "w"(k));
+		k = AES_CE_LOAD(rk + nr * 16);
+		AES_CE_STORE(out + 0, s0 ^ k);
+		AES_CE_STORE(out + 16, s1 ^ k);
+		AES_CE_STORE(out + 32, s2 ^ k);
+		AES_CE_STORE(out + 48, s3 ^ k);
+	}
+	for(; n > 0; n--, in += 16, out += 16)
+	{
+		s0 = AES_CE_LOAD(in);
+		for(r = 0; r < nr - 1; r++)
+		{
+			k = AES_CE_LOAD(rk + r * 16);
+			__asm__("aesd %0.16b, %1.16b\n\taesimc %0.16b, %0.16b" : "+w"(s0) : "w"(k));
+		}
+		k = AES_CE_LOAD(rk + r * 16);
+		__asm__("aesd %0.16b, %1.16b" : "+w"(s0) : "w"(k));
+		AES_CE_STORE(out, s0 ^ AES_CE_LOAD(rk + nr * 16));
+	}
+}
+#elif defined(__X64__)
+/*
+ * Aes-ni, four blocks are kept in flight to cover the latency of the
+ * round instructions. Pclmulqdq is probed as well for ghash.
+ */
+typedef long long aes_v2di_t __attribute__((vector_size(16)));
+typedef int aes_v4si_t __attribute__((vector_size(16)));
+typedef char aes_v16qi_t __attribute__((vector_size(16)));
+typedef long long aes_v2di_u_t __attribute__((vector_size(16), aligned(1), may_alias));
+
+static int aes_hw_probe(void)
+{
+	uint32_t a, b, c, d;
+
+	__asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1), "c"(0));
+	return (c & (1 << 25)) ? ((c & (1 << 1)) ? 3 : 1) : 0;
+}
+
+#define AES_NI_LOAD(p)		(*((const aes_v2di_u_t *)(p)))
+#define AES_NI_STORE(p, v)	(*((aes_v2di_u_t *)(p)) = (v))
+
+__attribute__((target("aes,sse2")))
+static void aes_encrypt_hw(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n)
+{
+	const uint8_t * rk = (const uint8_t *)ctx->ek;
+	aes_v2di_t s0, s1, s2, s3, k;
+	int nr = ctx->rounds;
+	int r;
+
+	for(; n >= 4; n -= 4, in += 64, out += 64)
+	{
+		k = AES_NI_LOAD(rk);
+		s0 = AES_NI_LOAD(in + 0) ^ k;
+		s1 = AES_NI_LOAD(in + 16) ^ k;
+		s2 = AES_NI_LOAD(in + 32) ^ k;
+		s3 = AES_NI_LOAD(in + 48) ^ k;
+		for(r = 1; r < nr; r++)
+		{
+			k = AES_NI_LOAD(rk + r * 16);
+			s0 = __builtin_ia32_aesenc128(s0, k);
+			s1 = __builtin_ia32_aesenc128(s1, k);
+			s2 = __builtin_ia32_aesenc128(s2, k);
+			s3 = __builtin_ia32_aesenc128(s3, k);
+		}
+		k = AES_NI_LOAD(rk + nr * 16);
+		AES_NI_STORE(out + 0, __builtin_ia32_aesenclast128(s0, k));
+		AES_NI_STORE(out + 16, __builtin_ia32_aesenclast128(s1, k));
+		AES_NI_STORE(out + 32, __builtin_ia32_aesenclast128(s2, k));
+		AES_NI_STORE(out + 48, __builtin_ia32_aesenclast128(s3, k));
+	}
+	for(; n > 0; n--, in += 16, out += 16)
+	{
+		s0 = AES_NI_LOAD(in) ^ AES_NI_LOAD(rk);
+		for(r = 1; r < nr; r++)
+			s0 = __builtin_ia32_aesenc128(s0, AES_NI_LOAD(rk + r * 16));
+		AES_NI_STORE(out, __builtin_ia32_aesenclast128(s0, AES_NI_LOAD(rk + nr * 16)));
+	}
+}
+
+__attribute__((target("aes,sse2")))
+static void aes_decrypt_hw(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n)
+{
+	const uint8_t * rk = (const uint8_t *)ctx->dk;
+	aes_v2di_t s0, s1, s2, s3, k;
+	int nr = ctx->rounds;
+	int r;
+
+	for(; n >= 4; n -= 4, in += 64, out += 64)
+	{
+		k = AES_NI_LOAD(rk);
+		s0 = AES_NI_LOAD(in + 0) ^ k;
+		s1 = AES_NI_LOAD(in + 16) ^ k;
+		s2 = AES_NI_LOAD(in + 32) ^ k;
+		s3 = AES_NI_LOAD(in + 48) ^ k;
+		for(r = 1; r < nr; r++)
+		{
+			k = AES_NI_LOAD(rk + r * 16);
+			s0 = __builtin_ia32_aesdec128(s0, k);
+			s1 = __builtin_ia32_aesdec128(s1, k);
+			s2 = __builtin_ia32_aesdec128(s2, k);
+			s3 = __builtin_ia32_aesdec128(s3, k);
+		}
+		k = AES_NI_LOAD(rk + nr * 16);
+		AES_NI_STORE(out + 0, __builtin_ia32_aesdeclast128(s0, k));
+		AES_NI_STORE(out + 16, __builtin_ia32_aesdeclast128(s1, k));
+		AES_NI_STORE(out + 32, __builtin_ia32_aesdeclast128(s2, k));
+		AES_NI_STORE(out + 48, __builtin_ia32_aesdeclast128(s3, k));
+	}
+	for(; n > 0; n--, in += 16, out += 16)
+	{
+		s0 = AES_NI_LOAD(in) ^ AES_NI_LOAD(rk);
+		for(r = 1; r < nr; r++)
+			s0 = __builtin_ia32_aesdec128(s0, AES_NI_LOAD(rk + r * 16));
+		AES_NI_STORE(out, __builtin_ia32_aesdeclast128(s0, AES_NI_LOAD(rk + nr * 16)));
+	}
+}
+
+/*
+ * Ghash with carry-less multiply on byte reversed operands, shifted left
+ * by one to account for the reflected bit order, then reduced modulo
+ * x^128 + x^7 + x^2 + x + 1.
+ */
+#define GHASH_SLL(x, n)		((aes_v2di_t)__builtin_ia32_pslldi128((aes_v4si_t)(x), (n)))
+#define GHASH_SRL(x, n)		((aes_v2di_t)__builtin_ia32_psrldi128((aes_v4si_t)(x), (n)))
+
+__attribute__((target("pclmul,ssse3")))
+static void ghash_blocks_hw(struct aes_gcm_t * g, const uint8_t * p, int n)
+{
+	const aes_v16qi_t rev = { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 };
+	aes_v2di_t h, x, a, b, c, d, t;
+
+	h = (aes_v2di_t)__builtin_ia32_pshufb128((aes_v16qi_t)AES_NI_LOAD(g->h), rev);
+	x = (aes_v2di_t)__builtin_ia32_pshufb128((aes_v16qi_t)AES_NI_LOAD(g->y), rev);
+	for(; n > 0; n--, p += 16)
+	{
+		x ^= (aes_v2di_t)__builtin_ia32_pshufb128((aes_v16qi_t)AES_NI_LOAD(p), rev);
+
+		a = __builtin_ia32_pclmulqdq128(x, h, 0x00);
+		d = __builtin_ia32_pclmulqdq128(x, h, 0x11);
+		b = __builtin_ia32_pclmulqdq128(x, h, 0x10) ^ __builtin_ia32_pclmulqdq128(x, h, 0x01);
+		a ^= __builtin_ia32_pslldqi128(b, 64);
+		d ^= __builtin_ia32_psrldqi128(b, 64);
+
+		b = GHASH_SRL(a, 31);
+		c = GHASH_SRL(d, 31);
+		a = GHASH_SLL(a, 1);
+		d = GHASH_SLL(d, 1);
+		t = __builtin_ia32_psrldqi128(b, 96);
+		c = __builtin_ia32_pslldqi128(c, 32);
+		b = __builtin_ia32_pslldqi128(b, 32);
+		a |= b;
+		d |= c | t;
+
+		b = GHASH_SLL(a, 31) ^ GHASH_SLL(a, 30) ^ GHASH_SLL(a, 25);
+		c = __builtin_ia32_psrldqi128(b, 32);
+		b = __builtin_ia32_pslldqi128(b, 96);
+		a ^= b;
+		t = GHASH_SRL(a, 1) ^ GHASH_SRL(a, 2) ^ GHASH_SRL(a, 7) ^ c;
+		x = d ^ a ^ t;
+	}
+	AES_NI_STORE(g->y, (aes_v2di_t)__builtin_ia32_pshufb128((aes_v16qi_t)x, rev));
+}
+#endif
+
+/*
+ * Portable ghash, shoup's method with a sixteen entry table of multiples
+ * of h per nibble.
+ */
+static const uint64_t ghash_last4[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+};
+
+static inline uint64_t get64be(const uint8_t * p)
+{
+	return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+		((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] << 8) | ((uint64_t)p[7] << 0);
+}
+
+static inline void put64be(uint8_t * p, uint64_t v)
+{
+	int i;
+
+	for(i = 7; i >= 0; i--, v >>= 8)
+		p[i] = v & 0xff;
+}
+
+static void ghash_table_init(struct aes_gcm_t * g)
+{
+	uint64_t vh = get64be(&g->h[0]);
+	uint64_t vl = get64be(&g->h[8]);
+	uint64_t t;
+	int i, j;
+
+	g->hh[0] = 0;
+	g->hl[0] = 0;
+	g->hh[8] = vh;
+	g->hl[8] = vl;
+	for(i = 4; i > 0; i >>= 1)
+	{
+		t = (vl & 1) * 0xe1000000U;
+		vl = (vh << 63) | (vl >> 1);
+		vh = (vh >> 1) ^ (t << 32);
+		g->hh[i] = vh;
+		g->hl[i] = vl;
+	}
+	for(i = 2; i <= 8; i <<= 1)
+	{
+		for(j = 1; j < i; j++)
+		{
+			g->hh[i + j] = g->hh[i] ^ g->hh[j];
+			g->hl[i + j] = g->hl[i] ^ g->hl[j];
+		}
+	}
+}
+
+static void ghash_mult(struct aes_gcm_t * g, uint8_t * x)
+{
+	uint64_t zh, zl;
+	int lo, hi, rem;
+	int i;
+
+	lo = x[15] & 0xf;
+	zh = g->hh[lo];
+	zl = g->hl[lo];
+	for(i = 15; i >= 0; i--)
+	{
+		lo = x[i] & 0xf;
+		hi = (x[i] >> 4) & 0xf;
+		if(i != 15)
+		{
+			rem = zl & 0xf;
+			zl = (zh << 60) | (zl >> 4);
+			zh = (zh >> 4) ^ (ghash_last4[rem] << 48) ^ g->hh[lo];
+			zl ^= g->hl[lo];
+		}
+		rem = zl & 0xf;
+		zl = (zh << 60) | (zl >> 4);
+		zh = (zh >> 4) ^ (ghash_last4[rem] << 48) ^ g->hh[hi];
+		zl ^= g->hl[hi];
+	}
+	put64be(&x[0], zh);
+	put64be(&x[8], zl);
+}
+
+static void ghash_blocks_generic(struct aes_gcm_t * g, const uint8_t * p, int n)
+{
+	int i;
+
+	for(; n > 0; n--, p += 16)
+	{
+		for(i = 0; i < 16; i++)
+			g->y[i] ^= p[i];
+		ghash_mult(g, g->y);
+	}
+}
+
+/*
+ * The backends are picked on the first key setup.
+ */
+static void (*aes_encrypt_blocks)(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n) = aes_encrypt_generic;
+static void (*aes_decrypt_blocks)(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int n) = aes_decrypt_generic;
+static void (*ghash_blocks)(struct aes_gcm_t * g, const uint8_t * p, int n) = ghash_blocks_generic;
+static const char * aes_name = "ttable";
+
+static void aes_select(void)
+{
+#if defined(__ARM64__)
+	if(aes_hw_probe())
+	{
+		aes_encrypt_blocks = aes_encrypt_hw;
+		aes_decrypt_blocks = aes_decrypt_hw;
+		aes_name = "armv8-ce";
+	}
+#elif defined(__X64__)
+	int hw = aes_hw_probe();
+
+	if(hw & 1)
+	{
+		aes_encrypt_blocks = aes_encrypt_hw;
+		aes_decrypt_blocks = aes_decrypt_hw;
+		aes_name = "aes-ni";
+	}
+	if(hw & 2)
+		ghash_blocks = ghash_blocks_hw;
+#endif
+	aes_tables_init();
+}
+
+const char * aes_impl(void)
+{
+	if(!aes_tables_ready)
+		aes_select();
+	return aes_name;
+}
+
+static inline uint32_t aes_imc(uint32_t w)
+{
+	return td0[sbox[B0(w)]] ^ ROTL(td0[sbox[B1(w)]], 8) ^ ROTL(td0[sbox[B2(w)]], 16) ^ ROTL(td0[sbox[B3(w)]], 24);
+}
+
+/*
+ * Key lengths of 16, 24 and 32 bytes select aes-128, aes-192 and aes-256,
+ * returns zero for anything else.
+ */
+int aes_set_key(struct aes_ctx_t * ctx, const uint8_t * key, int len)
+{
+	uint32_t * w = ctx->ek;
+	uint32_t t, rcon = 0x01;
+	int nk = len / 4;
+	int nr, i, j;
+
+	if((len != 16) && (len != 24) && (len != 32))
+		return 0;
+	if(!aes_tables_ready)
+		aes_select();
+
+	nr = nk + 6;
+	for(i = 0; i < nk; i++)
+		w[i] = GET32(key + i * 4);
+	for(; i < 4 * (nr + 1); i++)
+	{
+		t = w[i - 1];
+		if((i % nk) == 0)
+		{
+			t = (t >> 8) | (t << 24);
+			t = SE(t, t, t, t) ^ rcon;
+			rcon = ((rcon << 1) ^ ((rcon & 0x80) ? 0x1b : 0)) & 0xff;
+		}
+		else if((nk > 6) && ((i % nk) == 4))
+		{
+			t = SE(t, t, t, t);
+		}
+		w[i] = w[i - nk] ^ t;
+	}
+
+	for(i = 0; i <= nr; i++)
+	{
+		for(j = 0; j < 4; j++)
+		{
+			t = ctx->ek[(nr - i) * 4 + j];
+			ctx->dk[i * 4 + j] = ((i == 0) || (i == nr)) ? t : aes_imc(t);
+		}
+	}
+	ctx->rounds = nr;
+	return 1;
+}
+
+void aes_encrypt(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int blks)
+{
+	if(blks > 0)
+		aes_encrypt_blocks(ctx, in, out, blks);
+}
+
+void aes_decrypt(const struct aes_ctx_t * ctx, const uint8_t * in, uint8_t * out, int blks)
+{
+	if(blks > 0)
+		aes_decrypt_blocks(ctx, in, out, blks);
+}
+
+/*
+ * Counter blocks are generated this many at a time, so the hardware
+ * backends see enough independent blocks to interleave.
+ */
+#define AES_BATCH		(8)
+
+static inline void ctr_inc128(uint8_t * ctr)
+{
+	int i;
+
+	for(i = 15; i >= 0; i--)
+	{
+		if(++ctr[i] != 0)
+			break;
+	}
+}
+
+static inline void ctr_inc32(uint8_t * ctr)
+{
+	int i;
+
+	for(i = 15; i >= 12; i--)
+	{
+		if(++ctr[i] != 0)
+			break;
+	}
+}
+
+typedef unsigned long __attribute__((may_alias)) aes_word_t;
+
+static inline void xor_bytes(uint8_t * r, const uint8_t * a, const uint8_t * b, int len)
+{
+	int i = 0;
+
+	if((((unsigned long)r | (unsigned long)a | (unsigned long)b) & (sizeof(aes_word_t) - 1)) == 0)
+	{
+		for(; i + (int)sizeof(aes_word_t) <= len; i += sizeof(aes_word_t))
+			*((aes_word_t *)&r[i]) = *((const aes_word_t *)&a[i]) ^ *((const aes_word_t *)&b[i]);
+	}
+	for(; i < len; i++)
+		r[i] = a[i] ^ b[i];
+}
+
+int aes_ctr_init(struct aes_ctr_t * c, const uint8_t * key, int len, const uint8_t * iv)
+{
+	if(!aes_set_key(&c->aes, key, len))
+		return 0;
+	memcpy(c->ctr, iv, AES_BLOCK_SIZE);
+	c->pos = AES_BLOCK_SIZE;
+	return 1;
+}
+
+/*
+ * Encrypts and decrypts alike, the stream may be split at any byte.
+ */
+void aes_ctr_update(struct aes_ctr_t * c, const uint8_t * in, uint8_t * out, int len)
+{
+	unsigned long cbuf[AES_BATCH * AES_BLOCK_SIZE / sizeof(unsigned long)];
+	unsigned long kbuf[AES_BATCH * AES_BLOCK_SIZE / sizeof(unsigned long)];
+	uint8_t * ctr = (uint8_t *)cbuf;
+	uint8_t * ks = (uint8_t *)kbuf;
+	int n, i;
+
+	while((len > 0) && (c->pos < AES_BLOCK_SIZE))
+	{
+		*out++ = *in++ ^ c->ks[c->pos++];
+		len--;
+	}
+	while(len >= AES_BLOCK_SIZE)
+	{
+		n = len / AES_BLOCK_SIZE;
+		if(n > AES_BATCH)
+			n = AES_BATCH;
+		for(i = 0; i < n; i++)
+		{
+			memcpy(&ctr[i * AES_BLOCK_SIZE], c->ctr, AES_BLOCK_SIZE);
+			ctr_inc128(c->ctr);
+		}
+		aes_encrypt_blocks(&c->aes, ctr, ks, n);
+		xor_bytes(out, in, ks, n * AES_BLOCK_SIZE);
+		in += n * AES_BLOCK_SIZE;
+		out += n * AES_BLOCK_SIZE;
+		len -= n * AES_BLOCK_SIZE;
+	}
+	if(len > 0)
+	{
+		aes_encrypt_blocks(&c->aes, c->ctr, c->ks, 1);
+		ctr_inc128(c->ctr);
+		xor_bytes(out, in, c->ks, len);
+		c->pos = len;
+	}
+}
+
+int aes_cbc_init(struct aes_cbc_t * c, const uint8_t * key, int len, const uint8_t * iv)
+{
+	if(!aes_set_key(&c->aes, key, len))
+		return 0;
+	memcpy(c->iv, iv, AES_BLOCK_SIZE);
+	return 1;
+}
+
+void aes_cbc_encrypt(struct aes_cbc_t * c, const uint8_t * in, uint8_t * out, int blks)
+{
+	uint8_t tmp[AES_BLOCK_SIZE];
+
+	for(; blks > 0; blks--, in += AES_BLOCK_SIZE, out += AES_BLOCK_SIZE)
+	{
+		xor_bytes(tmp, c->iv, in, AES_BLOCK_SIZE);
+		aes_encrypt_blocks(&c->aes, tmp, c->iv, 1);
+		memcpy(out, c->iv, AES_BLOCK_SIZE);
+	}
+}
+
+/*
+ * Decryption has no chaining dependency, so it runs in batches. The
+ * ciphertext is staged first as in and out may be the same buffer.
+ */
+void aes_cbc_decrypt(struct aes_cbc_t * c, const uint8_t * in, uint8_t * out, int blks)
+{
+	uint8_t ct[AES_BATCH * AES_BLOCK_SIZE];
+	int n, i;
+
+	while(blks > 0)
+	{
+		n = (blks > AES_BATCH) ? AES_BATCH : blks;
+		memcpy(ct, in, n * AES_BLOCK_SIZE);
+		aes_decrypt_blocks(&c->aes, ct, out, n);
+		xor_bytes(out, out, c->iv, AES_BLOCK_SIZE);
+		for(i = 1; i < n; i++)
+			xor_bytes(&out[i * AES_BLOCK_SIZE], &out[i * AES_BLOCK_SIZE], &ct[(i - 1) * AES_BLOCK_SIZE], AES_BLOCK_SIZE);
+		memcpy(c->iv, &ct[(n - 1) * AES_BLOCK_SIZE], AES_BLOCK_SIZE);
+		in += n * AES_BLOCK_SIZE;
+		out += n * AES_BLOCK_SIZE;
+		blks -= n;
+	}
+}
+
+/*
+ * Additional data and ciphertext are xored into the hash state byte by
+ * byte until a block is complete, so both may arrive in any split.
+ */
+static const uint8_t gcm_zero[AES_BLOCK_SIZE] = { 0 };
+
+static void gcm_hash(struct aes_gcm_t * g, const uint8_t * p, int len)
+{
+	int n;
+
+	while((len > 0) && (g->pos > 0))
+	{
+		g->y[g->pos++] ^= *p++;
+		len--;
+		if(g->pos == AES_BLOCK_SIZE)
+		{
+			ghash_blocks(g, gcm_zero, 1);
+			g->pos = 0;
+		}
+	}
+	n = len / AES_BLOCK_SIZE;
+	if(n > 0)
+	{
+		ghash_blocks(g, p, n);
+		p += n * AES_BLOCK_SIZE;
+		len -= n * AES_BLOCK_SIZE;
+	}
+	while(len-- > 0)
+		g->y[g->pos++] ^= *p++;
+}
+
+static void gcm_flush(struct aes_gcm_t * g)
+{
+	if(g->pos > 0)
+	{
+		ghash_blocks(g, gcm_zero, 1);
+		g->pos = 0;
+	}
+}
+
+int aes_gcm_init(struct aes_gcm_t * g, const uint8_t * key, int len, const uint8_t * iv, int ivlen)
+{
+	uint8_t lb[AES_BLOCK_SIZE];
+
+	if(!aes_set_key(&g->aes, key, len) || (ivlen <= 0))
+		return 0;
+	aes_encrypt_blocks(&g->aes, gcm_zero, g->h, 1);
+	ghash_table_init(g);
+	memset(g->y, 0, AES_BLOCK_SIZE);
+	g->pos = 0;
+	if(ivlen == 12)
+	{
+		memcpy(g->j0, iv, 12);
+		g->j0[12] = 0;
+		g->j0[13] = 0;
+		g->j0[14] = 0;
+		g->j0[15] = 1;
+	}
+	else
+	{
+		gcm_hash(g, iv, ivlen);
+		gcm_flush(g);
+		put64be(&lb[0], 0);
+		put64be(&lb[8], (uint64_t)ivlen * 8);
+		ghash_blocks(g, lb, 1);
+		memcpy(g->j0, g->y, AES_BLOCK_SIZE);
+		memset(g->y, 0, AES_BLOCK_SIZE);
+	}
+	memcpy(g->ctr, g->j0, AES_BLOCK_SIZE);
+	ctr_inc32(g->ctr);
+	g->alen = 0;
+	g->clen = 0;
+	g->data = 0;
+	return 1;
+}
+
+/*
+ * All additional data has to be given before the first byte of payload.
+ */
+void aes_gcm_aad(struct aes_gcm_t * g, const uint8_t * aad, int len)
+{
+	if(g->data || (len <= 0))
+		return;
+	g->alen += len;
+	gcm_hash(g, aad, len);
+}
+
+static void gcm_crypt(struct aes_gcm_t * g, const uint8_t * in, uint8_t * out, int len, int enc)
+{
+	unsigned long cbuf[AES_BATCH * AES_BLOCK_SIZE / sizeof(unsigned long)];
+	unsigned long kbuf[AES_BATCH * AES_BLOCK_SIZE / sizeof(unsigned long)];
+	uint8_t * ctr = (uint8_t *)cbuf;
+	uint8_t * ks = (uint8_t *)kbuf;
+	uint8_t a, b;
+	int n, i;
+
+	if(!g->data)
+	{
+		gcm_flush(g);
+		g->data = 1;
+	}
+	if(len <= 0)
+		return;
+	g->clen += len;
+
+	while((len > 0) && (g->pos > 0))
+	{
+		a = *in++;
+		b = a ^ g->ks[g->pos];
+		*out++ = b;
+		g->y[g->pos++] ^= enc ? b : a;
+		len--;
+		if(g->pos == AES_BLOCK_SIZE)
+		{
+			ghash_blocks(g, gcm_zero, 1);
+			g->pos = 0;
+		}
+	}
+	while(len >= AES_BLOCK_SIZE)
+	{
+		n = len / AES_BLOCK_SIZE;
+		if(n > AES_BATCH)
+			n = AES_BATCH;
+		for(i = 0; i < n; i++)
+		{
+			memcpy(&ctr[i * AES_BLOCK_SIZE], g->ctr, AES_BLOCK_SIZE);
+			ctr_inc32(g->ctr);
+		}
+		aes_encrypt_blocks(&g->aes, ctr, ks, n);
+		if(!enc)
+			ghash_blocks(g, in, n);
+		xor_bytes(out, in, ks, n * AES_BLOCK_SIZE);
+		if(enc)
+			ghash_blocks(g, out, n);
+		in += n * AES_BLOCK_SIZE;
+		out += n * AES_BLOCK_SIZE;
+		len -= n * AES_BLOCK_SIZE;
+	}
+	if(len > 0)
+	{
+		aes_encrypt_blocks(&g->aes, g->ctr, g->ks, 1);
+		ctr_inc32(g->ctr);
+		for(i = 0; i < len; i++)
+		{
+			a = in[i];
+			b = a ^ g->ks[i];
+			out[i] = b;
+			g->y[i] ^= enc ? b : a;
+		}
+		g->pos = len;
+	}
+}
+
+void aes_gcm_encrypt(struct aes_gcm_t * g, const uint8_t * in, uint8_t * out, int len)
+{
+	gcm_crypt(g, in, out, len, 1);
+}
+
+void aes_gcm_decrypt(struct aes_gcm_t * g, const uint8_t * in, uint8_t * out, int len)
+{
+	gcm_crypt(g, in, out, len, 0);
+}
+
+/*
+ * Finishes the stream and writes the sixteen byte tag.
+ */
+void aes_gcm_tag(struct aes_gcm_t * g, uint8_t * tag)
+{
+	uint8_t lb[AES_BLOCK_SIZE];
+
+	gcm_flush(g);
+	g->data = 1;
+	put64be(&lb[0], g->alen * 8);
+	put64be(&lb[8], g->clen * 8);
+	ghash_blocks(g, lb, 1);
+	aes_encrypt_blocks(&g->aes, g->j0, lb, 1);
+	xor_bytes(tag, lb, g->y, AES_BLOCK_SIZE);
+}
+
+/*
+ * Finishes the stream and compares the leading len bytes of the tag in
+ * constant time, returns one on a match.
+ */
+int aes_gcm_verify(struct aes_gcm_t * g, const uint8_t * tag, int len)
+{
+	uint8_t t[AES_BLOCK_SIZE];
+	uint8_t diff = 0;
+	int i;
+
+	if((len < 4) || (len > AES_BLOCK_SIZE))
+		return 0;
+	aes_gcm_tag(g, t);
+	for(i = 0; i < len; i++)
+		diff |= t[i] ^ tag[i];
+	return (diff == 0) ? 1 : 0;
+}
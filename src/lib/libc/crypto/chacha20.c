@@ -0,0 +1,127 @@
+/*
+ * libc/crypto/chacha20.c
+ */
+
+#include <chacha20.h>
+
+#define rol(value, bits)	(((value) << (bits)) | ((value) >> (32 - (bits))))
+
+#define QR(a, b, c, d)							\
+	do {										\
+		a += b; d ^= a; d = rol(d, 16);			\
+		c += d; b ^= c; b = rol(b, 12);			\
+		a += b; d ^= a; d = rol(d, 8);			\
+		c += d; b ^= c; b = rol(b, 7);			\
+	} while(0)
+
+static inline uint32_t get_le32(const uint8_t * p)
+{
+	return ((uint32_t)p[0] << 0) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_le32(uint8_t * p, uint32_t v)
+{
+	p[0] = (v >> 0) & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = (v >> 24) & 0xff;
+}
+
+void chacha20_init(struct chacha20_ctx_t * ctx, const uint8_t * key, const uint8_t * nonce, uint32_t counter)
+{
+	int i;
+
+	ctx->state[0] = 0x61707865;
+	ctx->state[1] = 0x3320646e;
+	ctx->state[2] = 0x79622d32;
+	ctx->state[3] = 0x6b206574;
+	for(i = 0; i < 8; i++)
+		ctx->state[4 + i] = get_le32(&key[i * 4]);
+	ctx->state[12] = counter;
+	for(i = 0; i < 3; i++)
+		ctx->state[13 + i] = get_le32(&nonce[i * 4]);
+	ctx->pos = CHACHA20_BLOCK_SIZE;
+}
+
+/*
+ * One 64 bytes block of key stream, advances the block counter.
+ */
+void chacha20_block(uint32_t * state, uint8_t * out)
+{
+	uint32_t x0 = state[0], x1 = state[1], x2 = state[2], x3 = state[3];
+	uint32_t x4 = state[4], x5 = state[5], x6 = state[6], x7 = state[7];
+	uint32_t x8 = state[8], x9 = state[9], x10 = state[10], x11 = state[11];
+	uint32_t x12 = state[12], x13 = state[13], x14 = state[14], x15 = state[15];
+	int i;
+
+	for(i = 0; i < 10; i++)
+	{
+		QR(x0, x4, x8, x12);
+		QR(x1, x5, x9, x13);
+		QR(x2, x6, x10, x14);
+		QR(x3, x7, x11, x15);
+		QR(x0, x5, x10, x15);
+		QR(x1, x6, x11, x12);
+		QR(x2, x7, x8, x13);
+		QR(x3, x4, x9, x14);
+	}
+	put_le32(&out[0], x0 + state[0]);
+	put_le32(&out[4], x1 + state[1]);
+	put_le32(&out[8], x2 + state[2]);
+	put_le32(&out[12], x3 + state[3]);
+	put_le32(&out[16], x4 + state[4]);
+	put_le32(&out[20], x5 + state[5]);
+	put_le32(&out[24], x6 + state[6]);
+	put_le32(&out[28], x7 + state[7]);
+	put_le32(&out[32], x8 + state[8]);
+	put_le32(&out[36], x9 + state[9]);
+	put_le32(&out[40], x10 + state[10]);
+	put_le32(&out[44], x11 + state[11]);
+	put_le32(&out[48], x12 + state[12]);
+	put_le32(&out[52], x13 + state[13]);
+	put_le32(&out[56], x14 + state[14]);
+	put_le32(&out[60], x15 + state[15]);
+	state[12]++;
+}
+
+void chacha20_keystream(struct chacha20_ctx_t * ctx, void * out, int len)
+{
+	uint8_t * p = out;
+	int n;
+
+	while((len > 0) && (ctx->pos < CHACHA20_BLOCK_SIZE))
+	{
+		*p++ = ctx->buf[ctx->pos++];
+		len--;
+	}
+	while(len >= CHACHA20_BLOCK_SIZE)
+	{
+		chacha20_block(ctx->state, p);
+		p += CHACHA20_BLOCK_SIZE;
+		len -= CHACHA20_BLOCK_SIZE;
+	}
+	if(len > 0)
+	{
+		chacha20_block(ctx->state, ctx->buf);
+		for(n = 0; n < len; n++)
+			p[n] = ctx->buf[n];
+		ctx->pos = len;
+	}
+}
+
+void chacha20_xor(struct chacha20_ctx_t * ctx, void * out, const void * in, int len)
+{
+	const uint8_t * s = in;
+	uint8_t * d = out;
+
+	while(len > 0)
+	{
+		if(ctx->pos >= CHACHA20_BLOCK_SIZE)
+		{
+			chacha20_block(ctx->state, ctx->buf);
+			ctx->pos = 0;
+		}
+		*d++ = *s++ ^ ctx->buf[ctx->pos++];
+		len--;
+	}
+}
@@ -39,11 +39,47 @@ static const uint16_t crc16_table[256] = {
 	0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
 };
 
-uint16_t crc16_sum(uint16_t crc, const uint8_t * buf, int len)
+/*
+ * Slicing by eight, crc16_slice[k] is the crc of a byte followed by k
+ * zero bytes. The tables are derived from crc16_table on first use.
+ */
+static uint16_t crc16_slice[8][256];
+static int crc16_slice_ready = 0;
+
+static void crc16_slice_init(void)
 {
-	int i;
+	uint16_t c;
+	int i, k;
 
-	for(i = 0; i < len; i++)
+	for(i = 0; i < 256; i++)
+	{
+		c = crc16_table[i];
+		crc16_slice[0][i] = c;
+		for(k = 1; k < 8; k++)
+		{
+			c = crc16_table[c >> 8] ^ (c << 8);
+			crc16_slice[k][i] = c;
+		}
+	}
+	crc16_slice_ready = 1;
+}
+
+uint16_t crc16_sum(uint16_t crc, const uint8_t * buf, int len)
+{
+	if(len >= 16)
+	{
+		if(!crc16_slice_ready)
+			crc16_slice_init();
+		do {
+			crc = crc16_slice[7][buf[0] ^ (crc >> 8)] ^ crc16_slice[6][buf[1] ^ (crc & 0xff)] ^
+				crc16_slice[5][buf[2]] ^ crc16_slice[4][buf[3]] ^
+				crc16_slice[3][buf[4]] ^ crc16_slice[2][buf[5]] ^
+				crc16_slice[1][buf[6]] ^ crc16_slice[0][buf[7]];
+			buf += 8;
+			len -= 8;
+		} while(len >= 8);
+	}
+	while(len-- > 0)
 		crc = crc16_table[((crc >> 8) ^ *buf++) & 0xff] ^ (crc << 8);
 	return crc;
 }
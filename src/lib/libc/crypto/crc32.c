@@ -71,29 +71,218 @@ static const uint32_t crc32_table[256] = {
 	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
 };
 
-uint32_t crc32_sum(uint32_t crc, const uint8_t * buf, int len)
+/*
+ * Slicing by eight, crc32_slice[k] advances a byte through k more zero
+ * bytes. The tables are derived from crc32_table on first use.
+ */
+static uint32_t crc32_slice[8][256];
+static int crc32_slice_ready = 0;
+
+static void crc32_slice_init(void)
+{
+	uint32_t c;
+	int i, k;
+
+	for(i = 0; i < 256; i++)
+	{
+		c = crc32_table[i];
+		crc32_slice[0][i] = c;
+		for(k = 1; k < 8; k++)
+		{
+			c = crc32_table[c & 0xff] ^ (c >> 8);
+			crc32_slice[k][i] = c;
+		}
+	}
+	crc32_slice_ready = 1;
+}
+
+static uint32_t crc32_bytes(uint32_t crc, const uint8_t * buf, int len)
+{
+	while(len-- > 0)
+		crc = crc32_table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+static uint32_t crc32_generic(uint32_t crc, const uint8_t * buf, int len)
+{
+	uint32_t a, b;
+
+	if(!crc32_slice_ready)
+		crc32_slice_init();
+	while(len >= 8)
+	{
+		a = ((uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24)) ^ crc;
+		b = (uint32_t)buf[4] | ((uint32_t)buf[5] << 8) | ((uint32_t)buf[6] << 16) | ((uint32_t)buf[7] << 24);
+		crc = crc32_slice[7][a & 0xff] ^ crc32_slice[6][(a >> 8) & 0xff] ^
+			crc32_slice[5][(a >> 16) & 0xff] ^ crc32_slice[4][a >> 24] ^
+			crc32_slice[3][b & 0xff] ^ crc32_slice[2][(b >> 8) & 0xff] ^
+			crc32_slice[1][(b >> 16) & 0xff] ^ crc32_slice[0][b >> 24];
+		buf += 8;
+		len -= 8;
+	}
+	return crc32_bytes(crc, buf, len);
+}
+
+#if defined(__ARM64__)
+/*
+ * The armv8 crc32 instructions use the same reflected polynomial, they are
+ * optional before armv8.1, so probe ID_AA64ISAR0_EL1 first.
+ */
+static int crc32_hw_probe(void)
 {
-	crc = crc ^ 0xffffffff;
+	uint64_t isar0;
+
+	__asm__ __volatile__("mrs %0, id_aa64isar0_el1" : "=r"(isar0));
+	return ((isar0 >> 16) & 0xf) ? 1 : 0;
+}
 
+__attribute__((target("+crc")))
+static uint32_t crc32_hw(uint32_t crc, const uint8_t * buf, int len)
+{
+	while((len > 0) && ((unsigned long)buf & 0x7))
+	{
+		__asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"((uint32_t)*buf));
+		buf++;
+		len--;
+	}
 	while(len >= 8)
 	{
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
+		__asm__("crc32x %w0, %w0, %x1" : "+r"(crc) : "r"(*((const uint64_t *)buf)));
+		buf += 8;
 		len -= 8;
 	}
+	while(len-- > 0)
+	{
+		__asm__("crc32b %w0, %w0, %w1" : "+r"(crc) : "r"((uint32_t)*buf));
+		buf++;
+	}
+	return crc;
+}
+#elif defined(__X64__)
+/*
+ * Carry-less multiply folding, four lanes of 128 bits are folded 64 bytes
+ * ahead, then into one lane and reduced to 32 bits with barrett reduction.
+ * Short buffers and the tail below 16 bytes use the slicing path.
+ */
+typedef long long crc32_v2di_t __attribute__((vector_size(16)));
+typedef int crc32_v4si_t __attribute__((vector_size(16)));
+typedef long long crc32_v2di_u_t __attribute__((vector_size(16), aligned(1), may_alias));
+
+static int crc32_hw_probe(void)
+{
+	uint32_t a, b, c, d;
+
+	__asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1), "c"(0));
+	return (c & (1 << 1)) ? 1 : 0;
+}
+
+#define CRC32_CLMUL(a, b, imm)	__builtin_ia32_pclmulqdq128((a), (b), (imm))
+#define CRC32_LOAD(p)			((crc32_v2di_t)(*((const crc32_v2di_u_t *)(p))))
+
+__attribute__((target("pclmul,sse2")))
+static uint32_t crc32_hw(uint32_t crc, const uint8_t * buf, int len)
+{
+	const crc32_v2di_t k1k2 = { 0x0154442bd4LL, 0x01c6e41596LL };
+	const crc32_v2di_t k3k4 = { 0x01751997d0LL, 0x00ccaa009eLL };
+	const crc32_v2di_t k5k0 = { 0x0163cd6124LL, 0x0000000000LL };
+	const crc32_v2di_t poly = { 0x01db710641LL, 0x01f7011641LL };
+	const crc32_v2di_t mask = (crc32_v2di_t)((crc32_v4si_t){ ~0, 0, ~0, 0 });
+	crc32_v2di_t x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	if(len < 64)
+		return crc32_generic(crc, buf, len);
+
+	x1 = CRC32_LOAD(buf + 0x00) ^ (crc32_v2di_t)((crc32_v4si_t){ (int)crc, 0, 0, 0 });
+	x2 = CRC32_LOAD(buf + 0x10);
+	x3 = CRC32_LOAD(buf + 0x20);
+	x4 = CRC32_LOAD(buf + 0x30);
+	buf += 64;
+	len -= 64;
+
+	x0 = k1k2;
+	while(len >= 64)
+	{
+		x5 = CRC32_CLMUL(x1, x0, 0x00);
+		x6 = CRC32_CLMUL(x2, x0, 0x00);
+		x7 = CRC32_CLMUL(x3, x0, 0x00);
+		x8 = CRC32_CLMUL(x4, x0, 0x00);
+		x1 = CRC32_CLMUL(x1, x0, 0x11) ^ x5 ^ CRC32_LOAD(buf + 0x00);
+		x2 = CRC32_CLMUL(x2, x0, 0x11) ^ x6 ^ CRC32_LOAD(buf + 0x10);
+		x3 = CRC32_CLMUL(x3, x0, 0x11) ^ x7 ^ CRC32_LOAD(buf + 0x20);
+		x4 = CRC32_CLMUL(x4, x0, 0x11) ^ x8 ^ CRC32_LOAD(buf + 0x30);
+		buf += 64;
+		len -= 64;
+	}
+
+	x0 = k3k4;
+	x1 = CRC32_CLMUL(x1, x0, 0x11) ^ CRC32_CLMUL(x1, x0, 0x00) ^ x2;
+	x1 = CRC32_CLMUL(x1, x0, 0x11) ^ CRC32_CLMUL(x1, x0, 0x00) ^ x3;
+	x1 = CRC32_CLMUL(x1, x0, 0x11) ^ CRC32_CLMUL(x1, x0, 0x00) ^ x4;
+	while(len >= 16)
+	{
+		x1 = CRC32_CLMUL(x1, x0, 0x11) ^ CRC32_CLMUL(x1, x0, 0x00) ^ CRC32_LOAD(buf);
+		buf += 16;
+		len -= 16;
+	}
+
+	x2 = CRC32_CLMUL(x1, x0, 0x10);
+	x1 = __builtin_ia32_psrldqi128(x1, 64) ^ x2;
+	x2 = __builtin_ia32_psrldqi128(x1, 32);
+	x1 = CRC32_CLMUL(x1 & mask, k5k0, 0x00) ^ x2;
+
+	x2 = CRC32_CLMUL(x1 & mask, poly, 0x10);
+	x2 = CRC32_CLMUL(x2 & mask, poly, 0x00);
+	x1 = x1 ^ x2;
+	crc = (uint32_t)((crc32_v4si_t)x1)[1];
+
+	return crc32_generic(crc, buf, len);
+}
+#endif
 
-	if(len)
+/*
+ * The implementation is picked on the first call, crc32_update works on
+ * the inverted crc.
+ */
+static uint32_t crc32_select(uint32_t crc, const uint8_t * buf, int len);
+static uint32_t (*crc32_update)(uint32_t crc, const uint8_t * buf, int len) = crc32_select;
+static const char * crc32_name = "slice8";
+
+static uint32_t crc32_select(uint32_t crc, const uint8_t * buf, int len)
+{
+	uint32_t (*update)(uint32_t crc, const uint8_t * buf, int len) = crc32_generic;
+
+#if defined(__ARM64__)
+	if(crc32_hw_probe())
+	{
+		update = crc32_hw;
+		crc32_name = "armv8-crc";
+	}
+#elif defined(__X64__)
+	if(crc32_hw_probe())
 	{
-		do {
-			crc = crc32_table[((int)crc ^ (*buf++)) & 0xff] ^ (crc >> 8);
-		} while(--len);
+		update = crc32_hw;
+		crc32_name = "pclmul";
 	}
+#endif
+	if(!crc32_slice_ready)
+		crc32_slice_init();
+	crc32_update = update;
+	return update(crc, buf, len);
+}
 
-	return crc ^ 0xffffffff;
+uint32_t crc32_sum(uint32_t crc, const uint8_t * buf, int len)
+{
+	return crc32_update(crc ^ 0xffffffff, buf, len) ^ 0xffffffff;
+}
+
+uint32_t crc32_sum_generic(uint32_t crc, const uint8_t * buf, int len)
+{
+	return crc32_generic(crc ^ 0xffffffff, buf, len) ^ 0xffffffff;
+}
+
+const char * crc32_impl(void)
+{
+	if(crc32_update == crc32_select)
+		crc32_select(0, NULL, 0);
+	return crc32_name;
 }
@@ -39,11 +39,47 @@ static const uint8_t crc8_table[256] = {
 	0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3,
 };
 
-uint8_t crc8_sum(uint8_t crc, const uint8_t * buf, int len)
+/*
+ * Slicing by eight, crc8_slice[k] is the crc of a byte followed by k
+ * zero bytes. The tables are derived from crc8_table on first use.
+ */
+static uint8_t crc8_slice[8][256];
+static int crc8_slice_ready = 0;
+
+static void crc8_slice_init(void)
 {
-	int i;
+	uint8_t c;
+	int i, k;
 
-	for(i = 0; i < len; i++)
+	for(i = 0; i < 256; i++)
+	{
+		c = crc8_table[i];
+		crc8_slice[0][i] = c;
+		for(k = 1; k < 8; k++)
+		{
+			c = crc8_table[c];
+			crc8_slice[k][i] = c;
+		}
+	}
+	crc8_slice_ready = 1;
+}
+
+uint8_t crc8_sum(uint8_t crc, const uint8_t * buf, int len)
+{
+	if(len >= 16)
+	{
+		if(!crc8_slice_ready)
+			crc8_slice_init();
+		do {
+			crc = crc8_slice[7][buf[0] ^ crc] ^ crc8_slice[6][buf[1]] ^
+				crc8_slice[5][buf[2]] ^ crc8_slice[4][buf[3]] ^
+				crc8_slice[3][buf[4]] ^ crc8_slice[2][buf[5]] ^
+				crc8_slice[1][buf[6]] ^ crc8_slice[0][buf[7]];
+			buf += 8;
+			len -= 8;
+		} while(len >= 8);
+	}
+	while(len-- > 0)
 		crc = crc8_table[crc ^ *buf++];
 	return crc;
 }
@@ -27,65 +27,273 @@ static const uint32_t K[64] =
 	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
 };
 
-static void sha256_transform(struct sha256_ctx_t * ctx)
+#define S0(x)		(ror(x, 2) ^ ror(x, 13) ^ ror(x, 22))
+#define S1(x)		(ror(x, 6) ^ ror(x, 11) ^ ror(x, 25))
+#define G0(x)		(ror(x, 7) ^ ror(x, 18) ^ shr(x, 3))
+#define G1(x)		(ror(x, 17) ^ ror(x, 19) ^ shr(x, 10))
+#define CH(x, y, z)	((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x, y, z)	(((x) & (y)) | ((z) & ((x) | (y))))
+
+/*
+ * The schedule is kept in a sixteen word ring, and the working variables
+ * rotate through the macro arguments instead of being moved every round.
+ */
+#define W(t)		(W[(t) & 15])
+#define WX(t)		(W(t) += G1(W((t) - 2)) + W((t) - 7) + G0(W((t) - 15)))
+#define ROUND(a, b, c, d, e, f, g, h, t, w)	do { \
+	uint32_t t1 = h + S1(e) + CH(e, f, g) + K[t] + (w); \
+	d += t1; \
+	h = t1 + S0(a) + MAJ(a, b, c); \
+} while(0)
+#define ROUND8(t, w)	do { \
+	ROUND(A, B, C, D, E, F, G, H, (t) + 0, w((t) + 0)); \
+	ROUND(H, A, B, C, D, E, F, G, (t) + 1, w((t) + 1)); \
+	ROUND(G, H, A, B, C, D, E, F, (t) + 2, w((t) + 2)); \
+	ROUND(F, G, H, A, B, C, D, E, (t) + 3, w((t) + 3)); \
+	ROUND(E, F, G, H, A, B, C, D, (t) + 4, w((t) + 4)); \
+	ROUND(D, E, F, G, H, A, B, C, (t) + 5, w((t) + 5)); \
+	ROUND(C, D, E, F, G, H, A, B, (t) + 6, w((t) + 6)); \
+	ROUND(B, C, D, E, F, G, H, A, (t) + 7, w((t) + 7)); \
+} while(0)
+
+static void sha256_blocks_generic(uint32_t * state, const uint8_t * p, int n)
 {
-	uint32_t W[64];
+	uint32_t W[16];
 	uint32_t A, B, C, D, E, F, G, H;
-	uint8_t * p = ctx->buf;
 	int t;
 
-	for(t = 0; t < 16; ++t)
+	while(n-- > 0)
+	{
+		for(t = 0; t < 16; t++, p += 4)
+			W[t] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | ((uint32_t)p[3] << 0);
+
+		A = state[0];
+		B = state[1];
+		C = state[2];
+		D = state[3];
+		E = state[4];
+		F = state[5];
+		G = state[6];
+		H = state[7];
+
+		ROUND8(0, W);
+		ROUND8(8, W);
+		for(t = 16; t < 64; t += 16)
+		{
+			ROUND8(t + 0, WX);
+			ROUND8(t + 8, WX);
+		}
+
+		state[0] += A;
+		state[1] += B;
+		state[2] += C;
+		state[3] += D;
+		state[4] += E;
+		state[5] += F;
+		state[6] += G;
+		state[7] += H;
+	}
+}
+
+#if defined(__ARM64__)
+/*
+ * Armv8 crypto extensions, state is kept as abcd and efgh, four rounds
+ * per sha256h and sha256h2 pair. Optional, so probe ID_AA64ISAR0_EL1.
+ */
+typedef uint32_t sha256_v4u32_t __attribute__((vector_size(16)));
+typedef uint32_t sha256_v4u32_u_t __attribute__((vector_size(16), aligned(1), may_alias));
+
+static int sha256_hw_probe(void)
+{
+	uint64_t isar0;
+
+	__asm__ __volatile__("mrs %0, id_aa64isar0_el1" : "=r"(isar0));
+	return ((isar0 >> 12) & 0xf) ? 1 : 0;
+}
+
+#define SHA256_CE_ROUNDS(g, m0, m1, m2, m3)	do { \
+	wk = m0 + *((const sha256_v4u32_u_t *)&K[(g) * 4]); \
+	if((g) < 12) \
+	{ \
+		__asm__("sha256su0 %0.4s, %1.4s" : "+w"(m0) : "w"(m1)); \
+		__asm__("sha256su1 %0.4s, %1.4s, %2.4s" : "+w"(m0) : "w"(m2), "w"(m3)); \
+	} \
+	tmp = s0; \
+	__asm__("sha256h %q0, %q1, %2.4s" : "+w"(s0) : "w"(s1), "w"(wk)); \
+	__asm__("sha256h2 %q0, %q1, %2.4s" : "+w"(s1) : "w"(tmp), "w"(wk)); \
+} while(0)
+
+__attribute__((target("+crypto")))
+static void sha256_blocks_hw(uint32_t * state, const uint8_t * p, int n)
+{
+	sha256_v4u32_t s0, s1, a0, a1, tmp, wk;
+	sha256_v4u32_t m0, m1, m2, m3;
+
+	s0 = *((const sha256_v4u32_u_t *)&state[0]);
+	s1 = *((const sha256_v4u32_u_t *)&state[4]);
+	while(n-- > 0)
 	{
-		uint32_t tmp =  *p++ << 24;
-		tmp |= *p++ << 16;
-		tmp |= *p++ << 8;
-		tmp |= *p++;
-		W[t] = tmp;
+		a0 = s0;
+		a1 = s1;
+		m0 = *((const sha256_v4u32_u_t *)(p + 0));
+		m1 = *((const sha256_v4u32_u_t *)(p + 16));
+		m2 = *((const sha256_v4u32_u_t *)(p + 32));
+		m3 = *((const sha256_v4u32_u_t *)(p + 48));
+		__asm__("rev32 %0.16b, %0.16b" : "+w"(m0));
+		__asm__("rev32 %0.16b, %0.16b" : "+w"(m1));
+		__asm__("rev32 %0.16b, %0.16b" : "+w"(m2));
+		__asm__("rev32 %0.16b, %0.16b" : "+w"(m3));
+
+		SHA256_CE_ROUNDS(0, m0, m1, m2, m3);
+		SHA256_CE_ROUNDS(1, m1, m2, m3, m0);
+		SHA256_CE_ROUNDS(2, m2, m3, m0, m1);
+		SHA256_CE_ROUNDS(3, m3, m0, m1, m2);
+		SHA256_CE_ROUNDS(4, m0, m1, m2, m3);
+		SHA256_CE_ROUNDS(5, m1, m2, m3, m0);
+		SHA256_CE_ROUNDS(6, m2, m3, m0, m1);
+		SHA256_CE_ROUNDS(7, m3, m0, m1, m2);
+		SHA256_CE_ROUNDS(8, m0, m1, m2, m3);
+		SHA256_CE_ROUNDS(9, m1, m2, m3, m0);
+		SHA256_CE_ROUNDS(10, m2, m3, m0, m1);
+		SHA256_CE_ROUNDS(11, m3, m0, m1, m2);
+		SHA256_CE_ROUNDS(12, m0, m1, m2, m3);
+		SHA256_CE_ROUNDS(13, m1, m2, m3, m0);
+		SHA256_CE_ROUNDS(14, m2, m3, m0, m1);
+		SHA256_CE_ROUNDS(15, m3, m0, m1, m2);
+
+		s0 += a0;
+		s1 += a1;
+		p += 64;
 	}
+	*((sha256_v4u32_u_t *)&state[0]) = s0;
+	*((sha256_v4u32_u_t *)&state[4]) = s1;
+}
+#elif defined(__X64__)
+/*
+ * Sha extensions, state is kept as abef and cdgh, sha256rnds2 does two
+ * rounds with the low half of the message plus constant.
+ */
+typedef int sha256_v4si_t __attribute__((vector_size(16)));
+typedef long long sha256_v2di_t __attribute__((vector_size(16)));
+typedef short sha256_v8hi_t __attribute__((vector_size(16)));
+typedef char sha256_v16qi_t __attribute__((vector_size(16)));
+typedef int sha256_v4si_u_t __attribute__((vector_size(16), aligned(1), may_alias));
+
+static int sha256_hw_probe(void)
+{
+	uint32_t a, b, c, d;
+
+	__asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(0), "c"(0));
+	if(a < 7)
+		return 0;
+	__asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1), "c"(0));
+	if(!(c & (1 << 9)) || !(c & (1 << 19)))
+		return 0;
+	__asm__ __volatile__("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(7), "c"(0));
+	return (b & (1 << 29)) ? 1 : 0;
+}
+
+#define SHA256_NI_ALIGNR(a, b)	((sha256_v4si_t)__builtin_ia32_palignr128((sha256_v2di_t)(a), (sha256_v2di_t)(b), 32))
+#define SHA256_NI_ROUNDS(g, m0, m1, m2, m3)	do { \
+	wk = m0 + *((const sha256_v4si_u_t *)&K[(g) * 4]); \
+	s1 = __builtin_ia32_sha256rnds2(s1, s0, wk); \
+	s0 = __builtin_ia32_sha256rnds2(s0, s1, __builtin_ia32_pshufd(wk, 0x0e)); \
+	if(((g) >= 3) && ((g) <= 14)) \
+		m1 = __builtin_ia32_sha256msg2(m1 + SHA256_NI_ALIGNR(m0, m3), m0); \
+	if(((g) >= 1) && ((g) <= 12)) \
+		m3 = __builtin_ia32_sha256msg1(m3, m0); \
+} while(0)
 
-	for(; t < 64; t++)
+__attribute__((target("sha,sse4.1,ssse3")))
+static void sha256_blocks_hw(uint32_t * state, const uint8_t * p, int n)
+{
+	const sha256_v16qi_t mask = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+	sha256_v4si_t s0, s1, a0, a1, tmp, wk;
+	sha256_v4si_t m0, m1, m2, m3;
+
+	tmp = __builtin_ia32_pshufd(*((const sha256_v4si_u_t *)&state[0]), 0xb1);
+	s1 = __builtin_ia32_pshufd(*((const sha256_v4si_u_t *)&state[4]), 0x1b);
+	s0 = (sha256_v4si_t)__builtin_ia32_palignr128((sha256_v2di_t)tmp, (sha256_v2di_t)s1, 64);
+	s1 = (sha256_v4si_t)__builtin_ia32_pblendw128((sha256_v8hi_t)s1, (sha256_v8hi_t)tmp, 0xf0);
+
+	while(n-- > 0)
 	{
-		uint32_t s0 = ror(W[t-15], 7) ^ ror(W[t-15], 18) ^ shr(W[t-15], 3);
-		uint32_t s1 = ror(W[t-2], 17) ^ ror(W[t-2], 19) ^ shr(W[t-2], 10);
-		W[t] = W[t-16] + s0 + W[t-7] + s1;
+		a0 = s0;
+		a1 = s1;
+		m0 = (sha256_v4si_t)__builtin_ia32_pshufb128((sha256_v16qi_t)*((const sha256_v4si_u_t *)(p + 0)), mask);
+		m1 = (sha256_v4si_t)__builtin_ia32_pshufb128((sha256_v16qi_t)*((const sha256_v4si_u_t *)(p + 16)), mask);
+		m2 = (sha256_v4si_t)__builtin_ia32_pshufb128((sha256_v16qi_t)*((const sha256_v4si_u_t *)(p + 32)), mask);
+		m3 = (sha256_v4si_t)__builtin_ia32_pshufb128((sha256_v16qi_t)*((const sha256_v4si_u_t *)(p + 48)), mask);
+
+		SHA256_NI_ROUNDS(0, m0, m1, m2, m3);
+		SHA256_NI_ROUNDS(1, m1, m2, m3, m0);
+		SHA256_NI_ROUNDS(2, m2, m3, m0, m1);
+		SHA256_NI_ROUNDS(3, m3, m0, m1, m2);
+		SHA256_NI_ROUNDS(4, m0, m1, m2, m3);
+		SHA256_NI_ROUNDS(5, m1, m2, m3, m0);
+		SHA256_NI_ROUNDS(6, m2, m3, m0, m1);
+		SHA256_NI_ROUNDS(7, m3, m0, m1, m2);
+		SHA256_NI_ROUNDS(8, m0, m1, m2, m3);
+		SHA256_NI_ROUNDS(9, m1, m2, m3, m0);
+		SHA256_NI_ROUNDS(10, m2, m3, m0, m1);
+		SHA256_NI_ROUNDS(11, m3, m0, m1, m2);
+		SHA256_NI_ROUNDS(12, m0, m1, m2, m3);
+		SHA256_NI_ROUNDS(13, m1, m2, m3, m0);
+		SHA256_NI_ROUNDS(14, m2, m3, m0, m1);
+		SHA256_NI_ROUNDS(15, m3, m0, m1, m2);
+
+		s0 += a0;
+		s1 += a1;
+		p += 64;
 	}
 
-	A = ctx->state[0];
-	B = ctx->state[1];
-	C = ctx->state[2];
-	D = ctx->state[3];
-	E = ctx->state[4];
-	F = ctx->state[5];
-	G = ctx->state[6];
-	H = ctx->state[7];
+	tmp = __builtin_ia32_pshufd(s0, 0x1b);
+	s1 = __builtin_ia32_pshufd(s1, 0xb1);
+	s0 = (sha256_v4si_t)__builtin_ia32_pblendw128((sha256_v8hi_t)tmp, (sha256_v8hi_t)s1, 0xf0);
+	s1 = (sha256_v4si_t)__builtin_ia32_palignr128((sha256_v2di_t)s1, (sha256_v2di_t)tmp, 64);
+	*((sha256_v4si_u_t *)&state[0]) = s0;
+	*((sha256_v4si_u_t *)&state[4]) = s1;
+}
+#endif
+
+/*
+ * The block function is picked on the first call.
+ */
+static void sha256_blocks_select(uint32_t * state, const uint8_t * p, int n);
+static void (*sha256_blocks)(uint32_t * state, const uint8_t * p, int n) = sha256_blocks_select;
+static const char * sha256_name = "generic";
 
-	for(t = 0; t < 64; t++)
+static void sha256_select(void)
+{
+	void (*blocks)(uint32_t * state, const uint8_t * p, int n) = sha256_blocks_generic;
+
+#if defined(__ARM64__)
+	if(sha256_hw_probe())
+	{
+		blocks = sha256_blocks_hw;
+		sha256_name = "armv8-ce";
+	}
+#elif defined(__X64__)
+	if(sha256_hw_probe())
 	{
-		uint32_t s0 = ror(A, 2) ^ ror(A, 13) ^ ror(A, 22);
-		uint32_t maj = (A & B) ^ (A & C) ^ (B & C);
-		uint32_t t2 = s0 + maj;
-		uint32_t s1 = ror(E, 6) ^ ror(E, 11) ^ ror(E, 25);
-		uint32_t ch = (E & F) ^ ((~E) & G);
-		uint32_t t1 = H + s1 + ch + K[t] + W[t];
-
-		H = G;
-		G = F;
-		F = E;
-		E = D + t1;
-		D = C;
-		C = B;
-		B = A;
-		A = t1 + t2;
+		blocks = sha256_blocks_hw;
+		sha256_name = "sha-ni";
 	}
+#endif
+	sha256_blocks = blocks;
+}
+
+static void sha256_blocks_select(uint32_t * state, const uint8_t * p, int n)
+{
+	sha256_select();
+	sha256_blocks(state, p, n);
+}
 
-	ctx->state[0] += A;
-	ctx->state[1] += B;
-	ctx->state[2] += C;
-	ctx->state[3] += D;
-	ctx->state[4] += E;
-	ctx->state[5] += F;
-	ctx->state[6] += G;
-	ctx->state[7] += H;
+const char * sha256_impl(void)
+{
+	if(sha256_blocks == sha256_blocks_select)
+		sha256_select();
+	return sha256_name;
 }
 
 void sha256_init(struct sha256_ctx_t * ctx)
@@ -105,35 +313,51 @@ void sha256_update(struct sha256_ctx_t * ctx, const void * data, int len)
 {
 	int i = (int)(ctx->count & 63);
 	const uint8_t * p = (const uint8_t *)data;
+	int n;
 
+	if(len <= 0)
+		return;
 	ctx->count += len;
-	while(len--)
+	if(i)
 	{
-		ctx->buf[i++] = *p++;
-		if(i == 64)
-		{
-			sha256_transform(ctx);
-			i = 0;
-		}
+		n = 64 - i;
+		if(n > len)
+			n = len;
+		memcpy(&ctx->buf[i], p, n);
+		p += n;
+		len -= n;
+		if(i + n < 64)
+			return;
+		sha256_blocks(ctx->state, ctx->buf, 1);
+	}
+	if(len >= 64)
+	{
+		n = len >> 6;
+		sha256_blocks(ctx->state, p, n);
+		p += n << 6;
+		len &= 63;
 	}
+	if(len)
+		memcpy(ctx->buf, p, len);
 }
 
 const uint8_t * sha256_final(struct sha256_ctx_t * ctx)
 {
 	uint8_t * p = ctx->buf;
 	uint64_t cnt = ctx->count * 8;
-	int i;
+	int i = (int)(ctx->count & 63);
 
-	sha256_update(ctx, (uint8_t *)"\x80", 1);
-	while ((ctx->count & 63) != 56)
-	{
-		sha256_update(ctx, (uint8_t *)"\0", 1);
-	}
-	for(i = 0; i < 8; ++i)
+	p[i++] = 0x80;
+	if(i > 56)
 	{
-		uint8_t tmp = (uint8_t)(cnt >> ((7 - i) * 8));
-		sha256_update(ctx, &tmp, 1);
+		memset(&p[i], 0, 64 - i);
+		sha256_blocks(ctx->state, p, 1);
+		i = 0;
 	}
+	memset(&p[i], 0, 56 - i);
+	for(i = 0; i < 8; i++)
+		p[56 + i] = (uint8_t)(cnt >> ((7 - i) * 8));
+	sha256_blocks(ctx->state, p, 1);
 
 	for(i = 0; i < 8; i++)
 	{
@@ -147,6 +371,22 @@ const uint8_t * sha256_final(struct sha256_ctx_t * ctx)
 	return ctx->buf;
 }
 
+/*
+ * Finish the hash and compare it against the expected digest, without
+ * leaking through timing how many leading bytes matched. Loaders feed
+ * sha256_update with each chunk as it is read, and verify at the end.
+ */
+int sha256_verify(struct sha256_ctx_t * ctx, const uint8_t * digest)
+{
+	const uint8_t * p = sha256_final(ctx);
+	uint8_t diff = 0;
+	int i;
+
+	for(i = 0; i < SHA256_DIGEST_SIZE; i++)
+		diff |= p[i] ^ digest[i];
+	return (diff == 0) ? 1 : 0;
+}
+
 /*
  * Compute sha256 (256-bits) message digest
  */
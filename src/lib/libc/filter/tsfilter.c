@@ -2,23 +2,63 @@
  * libc/filter/tsfilter.c
  */
 
+#include <string.h>
+#include <stdlib.h>
 #include <tsfilter.h>
 
-struct tsfilter_t * tsfilter_alloc(int ml, int nl)
+void tsfilter_config_default(struct tsfilter_config_t * cfg)
 {
-	struct tsfilter_t * filter;
+	if(cfg)
+	{
+		cfg->median = 5;
+		cfg->jitter = 0;
+		cfg->slow = 33;
+		cfg->fast = 33;
+		cfg->speed = 1;
+		cfg->interval = 10000;
+		cfg->refresh = 0;
+		cfg->predict = 0;
+	}
+}
 
-	if(ml <= 0 || nl <= 0)
-		return NULL;
+struct tsfilter_t * tsfilter_alloc_config(const struct tsfilter_config_t * cfg)
+{
+	struct tsfilter_t * filter;
 
 	filter = malloc(sizeof(struct tsfilter_t));
 	if(!filter)
 		return NULL;
 
-	filter->mx = median_alloc(ml);
-	filter->my = median_alloc(ml);
-	filter->nx = mean_alloc(nl);
-	filter->ny = mean_alloc(nl);
+	memset(filter, 0, sizeof(struct tsfilter_t));
+	if(cfg)
+		memcpy(&filter->cfg, cfg, sizeof(struct tsfilter_config_t));
+	else
+		tsfilter_config_default(&filter->cfg);
+
+	if(filter->cfg.median < 1)
+		filter->cfg.median = 1;
+	if(filter->cfg.median > TSFILTER_MEDIAN_MAX)
+		filter->cfg.median = TSFILTER_MEDIAN_MAX;
+	filter->cfg.median |= 0x1;
+	if(filter->cfg.jitter < 0)
+		filter->cfg.jitter = 0;
+	if(filter->cfg.slow < 1)
+		filter->cfg.slow = 1;
+	if(filter->cfg.slow > 100)
+		filter->cfg.slow = 100;
+	if(filter->cfg.fast < filter->cfg.slow)
+		filter->cfg.fast = filter->cfg.slow;
+	if(filter->cfg.fast > 100)
+		filter->cfg.fast = 100;
+	if(filter->cfg.speed < 1)
+		filter->cfg.speed = 1;
+	if(filter->cfg.interval < 1)
+		filter->cfg.interval = 10000;
+	if(filter->cfg.refresh < 0)
+		filter->cfg.refresh = 0;
+	if(filter->cfg.predict < 0)
+		filter->cfg.predict = 0;
+
 	filter->cal[0] = 1;
 	filter->cal[1] = 0;
 	filter->cal[2] = 0;
@@ -27,34 +67,27 @@ struct tsfilter_t * tsfilter_alloc(int ml, int nl)
 	filter->cal[5] = 0;
 	filter->cal[6] = 1;
 
-	if(!filter->mx || !filter->my || !filter->nx || !filter->ny)
-	{
-		if(filter->mx)
-			median_free(filter->mx);
-		if(filter->my)
-			median_free(filter->my);
-		if(filter->nx)
-			mean_free(filter->nx);
-		if(filter->ny)
-			mean_free(filter->ny);
-	}
 	return filter;
 }
 
+/*
+ * Median and mean window lengths of the former filter chain, the mean maps
+ * to a fixed smoothing weight.
+ */
+struct tsfilter_t * tsfilter_alloc(int ml, int nl)
+{
+	struct tsfilter_config_t cfg;
+
+	tsfilter_config_default(&cfg);
+	cfg.median = ml;
+	cfg.slow = cfg.fast = (nl > 0) ? 200 / (nl + 1) : 100;
+	return tsfilter_alloc_config(&cfg);
+}
+
 void tsfilter_free(struct tsfilter_t * filter)
 {
 	if(filter)
-	{
-		if(filter->mx)
-			median_free(filter->mx);
-		if(filter->my)
-			median_free(filter->my);
-		if(filter->nx)
-			mean_free(filter->nx);
-		if(filter->ny)
-			mean_free(filter->ny);
 		free(filter);
-	}
 }
 
 void tsfilter_setcal(struct tsfilter_t * filter, int * cal)
@@ -71,29 +104,116 @@ void tsfilter_setcal(struct tsfilter_t * filter, int * cal)
 	}
 }
 
-void tsfilter_update(struct tsfilter_t * filter, int * x, int * y)
+/*
+ * The window is kept sorted next to the ring, every sample drops the oldest
+ * value and inserts the new one in place.
+ */
+static int tsfilter_median(struct tsfilter_t * filter, struct tsfilter_axis_t * a, int value)
 {
-	int tx, ty;
+	int n = filter->filled;
+	int i;
+
+	if(n == filter->cfg.median)
+	{
+		for(i = 0; a->sorted[i] != a->win[filter->position]; i++);
+		for(n--; i < n; i++)
+			a->sorted[i] = a->sorted[i + 1];
+	}
+	a->win[filter->position] = value;
+	for(i = n; (i > 0) && (a->sorted[i - 1] > value); i--)
+		a->sorted[i] = a->sorted[i - 1];
+	a->sorted[i] = value;
+	return a->sorted[n >> 1];
+}
+
+/*
+ * Positions are Q8 raw units, velocities Q8 raw units per ms and rate is
+ * the sample rate in Q16 samples per ms.
+ */
+static int tsfilter_axis(struct tsfilter_t * filter, struct tsfilter_axis_t * a, int value, int rate, int * speed)
+{
+	int m = tsfilter_median(filter, a, value);
+	int v;
+
+	if(filter->count == 1)
+	{
+		a->hold = a->last = m;
+		a->s = m << 8;
+		a->v = 0;
+		*speed = 0;
+		return m;
+	}
+
+	if(abs(m - a->hold) > filter->cfg.jitter)
+		a->hold = m;
+	v = ((s64_t)(a->hold - a->last) * rate) >> 8;
+	a->last = a->hold;
+	a->v += (v - a->v) >> 1;
+	*speed += abs(a->v) >> 8;
+	return a->hold;
+}
+
+void tsfilter_update_at(struct tsfilter_t * filter, int * x, int * y, s64_t us)
+{
+	struct tsfilter_config_t * cfg = &filter->cfg;
+	int dt, rate, speed = 0, w, h, period, mx, my;
+	s64_t tx, ty;
+
+	if(filter->count < 2)
+		filter->count++;
+	dt = (filter->count > 1) ? (int)(us - filter->time) : cfg->interval;
+	if(dt <= 0)
+		dt = cfg->interval;
+	filter->time = us;
+	rate = (1000 << 16) / dt;
+
+	mx = tsfilter_axis(filter, &filter->ax, *x, rate, &speed);
+	my = tsfilter_axis(filter, &filter->ay, *y, rate, &speed);
+	if(filter->filled < cfg->median)
+		filter->filled++;
+	if(++filter->position >= cfg->median)
+		filter->position = 0;
+
+	if(speed >= cfg->speed)
+		w = cfg->fast;
+	else
+		w = cfg->slow + (cfg->fast - cfg->slow) * speed / cfg->speed;
+	w = (w << 8) / 100;
+	filter->ax.s += ((mx << 8) - filter->ax.s) * w >> 8;
+	filter->ay.s += ((my << 8) - filter->ay.s) * w >> 8;
+
+	/*
+	 * Predict up to the next frame boundary. The input layer has no vblank
+	 * signal, so the frame grid is taken as anchored at time zero.
+	 */
+	h = cfg->predict;
+	if((h > 0) && (cfg->refresh > 0))
+	{
+		period = 1000000 / cfg->refresh;
+		if(period - (int)(us % period) < h)
+			h = period - (int)(us % period);
+	}
+	h = (h << 6) / 1000;
+	tx = filter->ax.s + (((s64_t)filter->ax.v * h) >> 6);
+	ty = filter->ay.s + (((s64_t)filter->ay.v * h) >> 6);
+	tx = (tx + 0x80) >> 8;
+	ty = (ty + 0x80) >> 8;
 
-	tx = median_update(filter->mx, *x);
-	ty = median_update(filter->my, *y);
-	tx = mean_update(filter->nx, tx);
-	ty = mean_update(filter->ny, ty);
 	*x = (filter->cal[2] + filter->cal[0] * tx + filter->cal[1] * ty) / filter->cal[6];
 	*y = (filter->cal[5] + filter->cal[3] * tx + filter->cal[4] * ty) / filter->cal[6];
 }
 
+void tsfilter_update(struct tsfilter_t * filter, int * x, int * y)
+{
+	tsfilter_update_at(filter, x, y, filter->time + filter->cfg.interval);
+}
+
 void tsfilter_clear(struct tsfilter_t * filter)
 {
 	if(filter)
 	{
-		if(filter->mx)
-			median_clear(filter->mx);
-		if(filter->my)
-			median_clear(filter->my);
-		if(filter->nx)
-			mean_clear(filter->nx);
-		if(filter->ny)
-			mean_clear(filter->ny);
+		filter->position = 0;
+		filter->filled = 0;
+		filter->count = 0;
 	}
 }
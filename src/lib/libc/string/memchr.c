@@ -12,6 +12,17 @@
 void * memchr(const void * s, int c, size_t n)
 {
 	const unsigned char *p = s;
+	const string_word_t * w;
+	unsigned long m = string_word_repeat(c);
+
+	for (; n && !string_word_aligned(p); p++, n--)
+	{
+		if ((unsigned char)c == *p)
+			return (void *)p;
+	}
+	for (w = (const string_word_t *)p; n >= STRING_WORD_SIZE && !string_word_haszero(*w ^ m); ++w)
+		n -= STRING_WORD_SIZE;
+	p = (const unsigned char *)w;
 
 	while (n-- != 0)
 	{
@@ -11,6 +11,17 @@
 void * memscan(void * addr, int c, size_t size)
 {
 	unsigned char * p = addr;
+	const string_word_t * w;
+	unsigned long m = string_word_repeat(c);
+
+	for (; size && !string_word_aligned(p); p++, size--)
+	{
+		if (*p == c)
+			return (void *)p;
+	}
+	for (w = (const string_word_t *)p; size >= STRING_WORD_SIZE && !string_word_haszero(*w ^ m); ++w)
+		size -= STRING_WORD_SIZE;
+	p = (unsigned char *)w;
 
 	while (size)
 	{
@@ -11,6 +11,15 @@
  */
 char * strchr(const char * s, int c)
 {
+	const string_word_t * w = (const string_word_t *)((unsigned long)s & ~(STRING_WORD_SIZE - 1));
+	unsigned long pre = string_word_before(s);
+	unsigned long m = string_word_repeat(c);
+
+	if (!string_word_haszero(*w | pre) && !string_word_haszero((*w ^ m) | pre))
+	{
+		for (++w; !string_word_haszero(*w) && !string_word_haszero(*w ^ m); ++w);
+		s = (const char *)w;
+	}
 	for (; *s != (char)c; ++s)
 		if (*s == '\0')
 			return NULL;
@@ -7,8 +7,22 @@
 
 static int __strcmp(const char * s1, const char * s2)
 {
+	const string_word_t * w1, * w2;
 	int res;
 
+	if ((((unsigned long)s1 ^ (unsigned long)s2) & (STRING_WORD_SIZE - 1)) == 0)
+	{
+		for (; !string_word_aligned(s1); s1++, s2++)
+		{
+			if ((res = *s1 - *s2) != 0 || !*s1)
+				return res;
+		}
+		w1 = (const string_word_t *)s1;
+		w2 = (const string_word_t *)s2;
+		for (; *w1 == *w2 && !string_word_haszero(*w1); w1++, w2++);
+		s1 = (const char *)w1;
+		s2 = (const char *)w2;
+	}
 	while (1)
 	{
 		if ((res = *s1 - *s2++) != 0 || !*s1++)
@@ -11,7 +11,23 @@
 char * strcpy(char * dest, const char * src)
 {
 	char * tmp = dest;
+	const string_word_t * s;
+	string_word_t * d;
 
+	if ((((unsigned long)dest ^ (unsigned long)src) & (STRING_WORD_SIZE - 1)) == 0)
+	{
+		for (; !string_word_aligned(src); dest++, src++)
+		{
+			if ((*dest = *src) == '\0')
+				return tmp;
+		}
+		s = (const string_word_t *)src;
+		d = (string_word_t *)dest;
+		for (; !string_word_haszero(*s); s++, d++)
+			*d = *s;
+		src = (const char *)s;
+		dest = (char *)d;
+	}
 	while ((*dest++ = *src++) != '\0');
 	return tmp;
 }
@@ -10,9 +10,15 @@
  */
 size_t strlen(const char * s)
 {
-	const char * sc;
+	const string_word_t * w = (const string_word_t *)((unsigned long)s & ~(STRING_WORD_SIZE - 1));
+	const char * sc = s;
 
-	for (sc = s; *sc != '\0'; ++sc);
+	if (!string_word_haszero(*w | string_word_before(s)))
+	{
+		for (++w; !string_word_haszero(*w); ++w);
+		sc = (const char *)w;
+	}
+	for (; *sc != '\0'; ++sc);
 	return sc - s;
 }
 EXPORT_SYMBOL(strlen);
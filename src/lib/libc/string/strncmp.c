@@ -7,8 +7,23 @@
 
 static int __strncmp(const char * s1, const char * s2, size_t n)
 {
+	const string_word_t * w1, * w2;
 	int __res = 0;
 
+	if ((((unsigned long)s1 ^ (unsigned long)s2) & (STRING_WORD_SIZE - 1)) == 0)
+	{
+		for (; n && !string_word_aligned(s1); s1++, s2++, n--)
+		{
+			if ((__res = *s1 - *s2) != 0 || !*s1)
+				return __res;
+		}
+		w1 = (const string_word_t *)s1;
+		w2 = (const string_word_t *)s2;
+		for (; n >= STRING_WORD_SIZE && *w1 == *w2 && !string_word_haszero(*w1); w1++, w2++)
+			n -= STRING_WORD_SIZE;
+		s1 = (const char *)w1;
+		s2 = (const char *)w2;
+	}
 	while (n)
 	{
 		if ((__res = *s1 - *s2++) != 0 || !*s1++)
@@ -11,8 +11,14 @@
 size_t strnlen(const char * s, size_t n)
 {
 	const char * sc;
+	const string_word_t * w;
 
-	for (sc = s; n-- && *sc != '\0'; ++sc);
+	for (sc = s; n && !string_word_aligned(sc); ++sc, n--)
+		if (*sc == '\0')
+			return sc - s;
+	for (w = (const string_word_t *)sc; n >= STRING_WORD_SIZE && !string_word_haszero(*w); ++w)
+		n -= STRING_WORD_SIZE;
+	for (sc = (const char *)w; n-- && *sc != '\0'; ++sc);
 	return sc - s;
 }
 EXPORT_SYMBOL(strnlen);
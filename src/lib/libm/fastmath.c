@@ -0,0 +1,371 @@
+#include <math.h>
+#include <fastmath.h>
+
+/*
+ * Adding 1.5 * 2^23 rounds a float of magnitude below 2^22 to the nearest
+ * integer, which then sits in the low mantissa bits of the sum. Scalar and
+ * vector code share this, so neither needs a conversion instruction.
+ */
+#define FM_ROUND		(12582912.0f)
+#define FM_ROUND_BITS	(0x4b400000)
+
+/* pi / 2 in three parts, k * FM_PIO2_1 and k * FM_PIO2_2 are exact below 8192 */
+#define FM_2_PI			(6.36619772e-1f)
+#define FM_PIO2_1		(1.5703125f)
+#define FM_PIO2_2		(4.837512969970703125e-4f)
+#define FM_PIO2_3		(7.54978995489188216e-8f)
+
+/* beyond this the reduction loses the documented bound, libm takes over */
+#define FM_SINCOS_MAX	(65536.0f)
+
+/* sin and cos on [-pi/4, pi/4] */
+#define FM_S1			(-1.6666654611e-1f)
+#define FM_S2			(8.3321608736e-3f)
+#define FM_S3			(-1.9515295891e-4f)
+#define FM_C1			(4.166664568298827e-2f)
+#define FM_C2			(-1.388731625493765e-3f)
+#define FM_C3			(2.443315711809948e-5f)
+
+/* atan on [0, 1], abramowitz and stegun 4.4.49 */
+#define FM_A2			(-0.3333314528f)
+#define FM_A4			(0.1999355085f)
+#define FM_A6			(-0.1420889944f)
+#define FM_A8			(0.1065626393f)
+#define FM_A10			(-0.0752896400f)
+#define FM_A12			(0.0429096138f)
+#define FM_A14			(-0.0161657367f)
+#define FM_A16			(0.0028662257f)
+#define FM_PI			(3.14159265f)
+#define FM_PI_2			(1.57079633f)
+
+/* exp on [-ln2 / 2, ln2 / 2] after taking out k * ln2, evaluated in pairs */
+#define FM_EXP_HI		(88.72f)
+#define FM_EXP_LO		(-87.0f)
+#define FM_LOG2E		(1.44269504f)
+#define FM_LN2_HI		(0.693359375f)
+#define FM_LN2_LO		(-2.12194440e-4f)
+#define FM_P0			(1.9875691500e-4f)
+#define FM_P1			(1.3981999507e-3f)
+#define FM_P2			(8.3334519073e-3f)
+#define FM_P3			(4.1665795894e-2f)
+#define FM_P4			(1.6666665459e-1f)
+#define FM_P5			(5.0000001201e-1f)
+
+static inline float fm_sin_poly(float r, float z)
+{
+	return r + r * z * (FM_S1 + z * (FM_S2 + z * FM_S3));
+}
+
+static inline float fm_cos_poly(float z)
+{
+	return 1.0f - 0.5f * z + z * z * (FM_C1 + z * (FM_C2 + z * FM_C3));
+}
+
+/*
+ * Reduce by the nearest multiple k of pi / 2, quadrant k + q selects sin or
+ * cos of the remainder and its sign, q is 0 for sin and 1 for cos.
+ */
+static inline float fm_sincos(float x, int q)
+{
+	float t = x * FM_2_PI + FM_ROUND;
+	float k = t - FM_ROUND;
+	float r = ((x - k * FM_PIO2_1) - k * FM_PIO2_2) - k * FM_PIO2_3;
+	float z = r * r;
+	float y;
+	uint32_t n;
+
+	GET_FLOAT_WORD(n, t);
+	n += q;
+	y = (n & 1) ? fm_cos_poly(z) : fm_sin_poly(r, z);
+	return (n & 2) ? -y : y;
+}
+
+float fast_sinf(float x)
+{
+	if(fabsf(x) > FM_SINCOS_MAX)
+		return sinf(x);
+	return fm_sincos(x, 0);
+}
+EXPORT_SYMBOL(fast_sinf);
+
+float fast_cosf(float x)
+{
+	if(fabsf(x) > FM_SINCOS_MAX)
+		return cosf(x);
+	return fm_sincos(x, 1);
+}
+EXPORT_SYMBOL(fast_cosf);
+
+float fast_atan2f(float y, float x)
+{
+	uint32_t hx, hy, ir;
+	float ax, ay, mx, mn, t, z, r;
+
+	GET_FLOAT_WORD(hx, x);
+	GET_FLOAT_WORD(hy, y);
+	SET_FLOAT_WORD(ax, hx & 0x7fffffff);
+	SET_FLOAT_WORD(ay, hy & 0x7fffffff);
+	mx = (ax > ay) ? ax : ay;
+	mn = (ax > ay) ? ay : ax;
+	t = mn / ((mx == 0.0f) ? 1.0f : mx);
+	z = t * t;
+	r = t * (1.0f + z * (FM_A2 + z * (FM_A4 + z * (FM_A6 + z * (FM_A8 + z * (FM_A10 + z * (FM_A12 + z * (FM_A14 + z * FM_A16))))))));
+	if(ay > ax)
+		r = FM_PI_2 - r;
+	if(hx >> 31)
+		r = FM_PI - r;
+	GET_FLOAT_WORD(ir, r);
+	SET_FLOAT_WORD(r, ir | (hy & 0x80000000));
+	return r;
+}
+EXPORT_SYMBOL(fast_atan2f);
+
+float fast_expf(float x)
+{
+	float t, k, r, z, y;
+	uint32_t n, b;
+
+	if(x > FM_EXP_HI)
+		return INFINITY;
+	if(x < FM_EXP_LO)
+		return 0.0f;
+	t = x * FM_LOG2E + FM_ROUND;
+	k = t - FM_ROUND;
+	r = (x - k * FM_LN2_HI) - k * FM_LN2_LO;
+	z = r * r;
+	y = ((FM_P4 * r + FM_P5) + z * (FM_P2 * r + FM_P3) + z * z * (FM_P0 * r + FM_P1)) * z + r + 1.0f;
+	GET_FLOAT_WORD(n, t);
+	GET_FLOAT_WORD(b, y);
+	SET_FLOAT_WORD(y, b + ((n - FM_ROUND_BITS) << 23));
+	return y;
+}
+EXPORT_SYMBOL(fast_expf);
+
+float fast_sqrtf(float x)
+{
+#if defined(__ARM64__)
+	__asm__("fsqrt %s0, %s1" : "=w"(x) : "w"(x));
+	return x;
+#elif defined(__X64__)
+	__asm__("sqrtss %1, %0" : "=x"(x) : "x"(x));
+	return x;
+#else
+	return sqrtf(x);
+#endif
+}
+EXPORT_SYMBOL(fast_sqrtf);
+
+#if defined(__X64__) || defined(__ARM64__)
+/*
+ * Four lanes in generic vectors, which gcc maps to sse2 on x64 and neon on
+ * arm64. Arm64 loads and stores go through ld1 and st1, they only need the
+ * element alignment while the mmu is off, where ldr q would fault.
+ */
+typedef float fm_v4sf_t __attribute__((vector_size(16)));
+typedef uint32_t fm_v4su_t __attribute__((vector_size(16)));
+typedef float fm_v4sf_u_t __attribute__((vector_size(16), aligned(4), may_alias));
+
+#define FM_V(c)			((fm_v4sf_t){ (c), (c), (c), (c) })
+#define FM_VU(c)		((fm_v4su_t){ (c), (c), (c), (c) })
+
+static inline fm_v4sf_t fm_load(const float * p)
+{
+#if defined(__ARM64__)
+	fm_v4sf_t v;
+
+	__asm__("ld1 {%0.4s}, %1" : "=w"(v) : "Q"(*(const fm_v4sf_u_t *)p));
+	return v;
+#else
+	return *(const fm_v4sf_u_t *)p;
+#endif
+}
+
+static inline void fm_store(float * p, fm_v4sf_t v)
+{
+#if defined(__ARM64__)
+	__asm__("st1 {%1.4s}, %0" : "=Q"(*(fm_v4sf_u_t *)p) : "w"(v));
+#else
+	*(fm_v4sf_u_t *)p = v;
+#endif
+}
+
+static inline fm_v4sf_t fm_select(fm_v4su_t m, fm_v4sf_t a, fm_v4sf_t b)
+{
+	return (fm_v4sf_t)((m & (fm_v4su_t)a) | (~m & (fm_v4su_t)b));
+}
+
+static inline fm_v4sf_t fm_sincos_v(fm_v4sf_t x, uint32_t q)
+{
+	fm_v4sf_t t = x * FM_V(FM_2_PI) + FM_V(FM_ROUND);
+	fm_v4sf_t k = t - FM_V(FM_ROUND);
+	fm_v4sf_t r = ((x - k * FM_V(FM_PIO2_1)) - k * FM_V(FM_PIO2_2)) - k * FM_V(FM_PIO2_3);
+	fm_v4sf_t z = r * r;
+	fm_v4sf_t s = r + r * z * (FM_V(FM_S1) + z * (FM_V(FM_S2) + z * FM_V(FM_S3)));
+	fm_v4sf_t c = FM_V(1.0f) - FM_V(0.5f) * z + z * z * (FM_V(FM_C1) + z * (FM_V(FM_C2) + z * FM_V(FM_C3)));
+	fm_v4su_t n = (fm_v4su_t)t + FM_VU(q);
+	fm_v4sf_t y = fm_select(-(n & FM_VU(1)), c, s);
+
+	return (fm_v4sf_t)((fm_v4su_t)y ^ ((n & FM_VU(2)) << 30));
+}
+
+static inline int fm_sincos_inrange_v(fm_v4sf_t x)
+{
+	fm_v4sf_t ax = (fm_v4sf_t)((fm_v4su_t)x & ~FM_VU(0x80000000));
+	fm_v4su_t m = (fm_v4su_t)(ax > FM_V(FM_SINCOS_MAX));
+
+	return !(m[0] | m[1] | m[2] | m[3]);
+}
+
+static inline fm_v4sf_t fm_atan2_v(fm_v4sf_t y, fm_v4sf_t x)
+{
+	fm_v4su_t sign = FM_VU(0x80000000);
+	fm_v4sf_t ax = (fm_v4sf_t)((fm_v4su_t)x & ~sign);
+	fm_v4sf_t ay = (fm_v4sf_t)((fm_v4su_t)y & ~sign);
+	fm_v4su_t swap = (fm_v4su_t)(ay > ax);
+	fm_v4sf_t mx = fm_select(swap, ay, ax);
+	fm_v4sf_t mn = fm_select(swap, ax, ay);
+	fm_v4sf_t t = mn / fm_select((fm_v4su_t)(mx == FM_V(0.0f)), FM_V(1.0f), mx);
+	fm_v4sf_t z = t * t;
+	fm_v4sf_t r;
+
+	r = FM_V(FM_A14) + z * FM_V(FM_A16);
+	r = FM_V(FM_A12) + z * r;
+	r = FM_V(FM_A10) + z * r;
+	r = FM_V(FM_A8) + z * r;
+	r = FM_V(FM_A6) + z * r;
+	r = FM_V(FM_A4) + z * r;
+	r = FM_V(FM_A2) + z * r;
+	r = t * (FM_V(1.0f) + z * r);
+	r = fm_select(swap, FM_V(FM_PI_2) - r, r);
+	r = fm_select(-((fm_v4su_t)x >> 31), FM_V(FM_PI) - r, r);
+	return (fm_v4sf_t)((fm_v4su_t)r | ((fm_v4su_t)y & sign));
+}
+
+static inline fm_v4sf_t fm_exp_v(fm_v4sf_t x)
+{
+	fm_v4su_t hi = (fm_v4su_t)(x > FM_V(FM_EXP_HI));
+	fm_v4su_t lo = (fm_v4su_t)(x < FM_V(FM_EXP_LO));
+	fm_v4sf_t t, k, r, z, y;
+
+	x = fm_select(hi, FM_V(FM_EXP_HI), x);
+	x = fm_select(lo, FM_V(FM_EXP_LO), x);
+	t = x * FM_V(FM_LOG2E) + FM_V(FM_ROUND);
+	k = t - FM_V(FM_ROUND);
+	r = (x - k * FM_V(FM_LN2_HI)) - k * FM_V(FM_LN2_LO);
+	z = r * r;
+	y = (FM_V(FM_P4) * r + FM_V(FM_P5)) + z * (FM_V(FM_P2) * r + FM_V(FM_P3)) + z * z * (FM_V(FM_P0) * r + FM_V(FM_P1));
+	y = y * z + r + FM_V(1.0f);
+	y = (fm_v4sf_t)((fm_v4su_t)y + (((fm_v4su_t)t - FM_VU(FM_ROUND_BITS)) << 23));
+	y = fm_select(hi, FM_V(INFINITY), y);
+	return (fm_v4sf_t)((fm_v4su_t)y & ~lo);
+}
+
+static inline fm_v4sf_t fm_sqrt_v(fm_v4sf_t x)
+{
+#if defined(__ARM64__)
+	__asm__("fsqrt %0.4s, %1.4s" : "=w"(x) : "w"(x));
+	return x;
+#else
+	return __builtin_ia32_sqrtps(x);
+#endif
+}
+#endif
+
+void fast_sinfv(float * y, const float * x, int n)
+{
+	int i = 0;
+#if defined(__X64__) || defined(__ARM64__)
+	fm_v4sf_t v;
+	int j;
+
+	for(; i + 4 <= n; i += 4)
+	{
+		v = fm_load(x + i);
+		if(fm_sincos_inrange_v(v))
+			fm_store(y + i, fm_sincos_v(v, 0));
+		else
+		{
+			for(j = i; j < i + 4; j++)
+				y[j] = fast_sinf(x[j]);
+		}
+	}
+#endif
+	for(; i < n; i++)
+		y[i] = fast_sinf(x[i]);
+}
+EXPORT_SYMBOL(fast_sinfv);
+
+void fast_cosfv(float * y, const float * x, int n)
+{
+	int i = 0;
+#if defined(__X64__) || defined(__ARM64__)
+	fm_v4sf_t v;
+	int j;
+
+	for(; i + 4 <= n; i += 4)
+	{
+		v = fm_load(x + i);
+		if(fm_sincos_inrange_v(v))
+			fm_store(y + i, fm_sincos_v(v, 1));
+		else
+		{
+			for(j = i; j < i + 4; j++)
+				y[j] = fast_cosf(x[j]);
+		}
+	}
+#endif
+	for(; i < n; i++)
+		y[i] = fast_cosf(x[i]);
+}
+EXPORT_SYMBOL(fast_cosfv);
+
+void fast_atan2fv(float * r, const float * y, const float * x, int n)
+{
+	int i = 0;
+
+#if defined(__X64__) || defined(__ARM64__)
+	for(; i + 4 <= n; i += 4)
+		fm_store(r + i, fm_atan2_v(fm_load(y + i), fm_load(x + i)));
+#endif
+	for(; i < n; i++)
+		r[i] = fast_atan2f(y[i], x[i]);
+}
+EXPORT_SYMBOL(fast_atan2fv);
+
+void fast_expfv(float * y, const float * x, int n)
+{
+	int i = 0;
+
+#if defined(__X64__) || defined(__ARM64__)
+	for(; i + 4 <= n; i += 4)
+		fm_store(y + i, fm_exp_v(fm_load(x + i)));
+#endif
+	for(; i < n; i++)
+		y[i] = fast_expf(x[i]);
+}
+EXPORT_SYMBOL(fast_expfv);
+
+void fast_sqrtfv(float * y, const float * x, int n)
+{
+	int i = 0;
+
+#if defined(__X64__) || defined(__ARM64__)
+	for(; i + 4 <= n; i += 4)
+		fm_store(y + i, fm_sqrt_v(fm_load(x + i)));
+#endif
+	for(; i < n; i++)
+		y[i] = fast_sqrtf(x[i]);
+}
+EXPORT_SYMBOL(fast_sqrtfv);
+
+const char * fastmath_impl(void)
+{
+#if defined(__ARM64__)
+	return "neon";
+#elif defined(__X64__)
+	return "sse2";
+#else
+	return "generic";
+#endif
+}
+EXPORT_SYMBOL(fastmath_impl);
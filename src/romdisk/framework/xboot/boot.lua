@@ -4,6 +4,7 @@
 Json = require "builtin.json"
 Stopwatch = require "builtin.stopwatch"
 Base64 = require "builtin.base64"
+Buffer = require "builtin.buffer"
 Matrix = require "builtin.matrix"
 Easing = require "builtin.easing"
 Object = require "builtin.object"
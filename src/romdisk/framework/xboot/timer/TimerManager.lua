@@ -93,6 +93,7 @@ function M:schedule(dt)
 			v.__time = v.__time + dt
 
 			if v.__time >= v.delay then
+				Event.busy()
 				v.__count = v.__count + 1
 				v.listener(v, {time = v.__time, count = v.__count})
 